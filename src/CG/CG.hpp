@@ -84,6 +84,7 @@ double              distancePointSimplex( array3D const &, std::vector<array3D>
 
 
 std::vector<double> distanceCloudTriangle( std::vector<array3D> const &, array3D const &, array3D const &, array3D const &, std::vector<array3D> &, std::vector<int> & );
+void                distanceCloudTriangle( int, double const *, double const *, double const *, array3D const &, array3D const &, array3D const &, double *, double *, double *, double *, int * );
 std::vector<double> distanceCloudSimplex( std::vector<array3D> const &, std::vector<array3D> const &, std::vector<array3D> &, std::vector<int> & );
 
 
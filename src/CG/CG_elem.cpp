@@ -30,6 +30,10 @@
 # include <assert.h>
 # include <lapacke.h>
 
+# if defined(__AVX2__) || defined(__AVX512F__)
+# include <immintrin.h>
+# endif
+
 namespace bitpit{
 
 /*!
@@ -366,6 +370,11 @@ double distancePointTriangle(
 
 /*!
  * Computes distances of point cloud to triangle
+ *
+ * The points are processed in blocks which are copied in structure-of-arrays
+ * form on the stack and passed to the batched kernel, therefore no memory
+ * is allocated apart from the output vectors.
+ *
  * @param[in] P point cloud coordinates
  * @param[in] Q1 first triangle vertex
  * @param[in] Q2 second triangle vertex
@@ -383,120 +392,363 @@ std::vector<double> distanceCloudTriangle(
         std::vector< int >                   &flag
         ) {
 
+    const int                   BLOCK_SIZE = 64 ;
+
     int                         N( P.size() ) ;
+    std::vector<double>         d(N);
 
-    std::array< std::array<double,3>, 3 > r = {{Q1, Q2, Q3}} ;
-    double                      *A = new double [6]  ; 
-    double                      *ptrlambda = new double [ 3*N ] ;
+    double                      x[BLOCK_SIZE], y[BLOCK_SIZE], z[BLOCK_SIZE] ;
+    double                      xPx[BLOCK_SIZE], xPy[BLOCK_SIZE], xPz[BLOCK_SIZE] ;
 
-    // Local variables
-    std::vector<double>      d(N);
-    std::array< double, 3 >  n;
-    int                 i, j, k, vertex0, vertex1;
+    xP.resize(N) ;
+    flag.resize(N) ;
 
-    std::array< double, 3 >  lambda ;
-    int                 count, oneNegative, flagLocal ;
-    std::array<int,2>        twoNegative ;
+    for( int begin=0; begin<N; begin+=BLOCK_SIZE ){
+        int n = std::min( BLOCK_SIZE, N - begin ) ;
 
+        for( int i=0; i<n; ++i ){
+            x[i] = P[begin+i][0] ;
+            y[i] = P[begin+i][1] ;
+            z[i] = P[begin+i][2] ;
+        }
 
-    xP.resize(N) ;
-    flag.resize(N) ;
+        distanceCloudTriangle( n, x, y, z, Q1, Q2, Q3, d.data() + begin, xPx, xPy, xPz, flag.data() + begin ) ;
 
-    // Project P onto the plane supporting the triangle
-    n = crossProduct(Q2 - Q1, Q3 - Q1);
-    n = n/norm(n, 2);
+        for( int i=0; i<n; ++i ){
+            xP[begin+i][0] = xPx[i] ;
+            xP[begin+i][1] = xPy[i] ;
+            xP[begin+i][2] = xPz[i] ;
+        }
+    }
 
-    k = 0 ;
-    for( i=0; i<2; ++i){ //columns
-        for( j=0; j<3; ++j){ //rows
+    return d ;
 
-            A[k] =  r[i][j] - r[2][j] ;
-            ++k ;
+};
 
-        };
-    };
+namespace {
 
+/*!
+ * Triangle data shared by all the points processed by the batched
+ * point-triangle distance kernel.
+ */
+struct TriangleData {
+    std::array<std::array<double,3>,3>  vertex ;    /**< Vertices */
+    std::array<std::array<double,3>,3>  edge ;      /**< Edges, edge k goes from vertex k to vertex k+1 */
+    std::array<double,3>                edgeInvL2 ; /**< Inverse of the squared length of the edges */
+    double                              d00 ;       /**< Squared length of the first edge */
+    double                              d01 ;       /**< Dot product between the first edge and the opposite of the third edge */
+    double                              d11 ;       /**< Squared length of the third edge */
+    double                              invDenom ;  /**< Inverse of the determinant of the barycentric system */
+
+    TriangleData( std::array<double,3> const &Q1, std::array<double,3> const &Q2, std::array<double,3> const &Q3 ){
+        vertex[0] = Q1 ;
+        vertex[1] = Q2 ;
+        vertex[2] = Q3 ;
+
+        for( int k=0; k<3; ++k ){
+            edge[k]      = vertex[(k+1)%3] - vertex[k] ;
+            edgeInvL2[k] = 1. / dotProduct(edge[k], edge[k]) ;
+        }
 
-    i=0 ;
-    k=0 ;
-    for( const auto & p :P){
+        std::array<double,3> e1 = Q3 - Q1 ;
+        d00      = dotProduct(edge[0], edge[0]) ;
+        d01      = dotProduct(edge[0], e1) ;
+        d11      = dotProduct(e1, e1) ;
+        invDenom = 1. / (d00 *d11 - d01 *d01) ;
+    }
+};
 
-        d[i]  = distancePointPlane( p, Q1, n, xP[i] );
+/*!
+ * Scalar implementation of the operations used by the batched kernel.
+ */
+struct ScalarPack {
+    typedef double  value ;
+    typedef bool    mask ;
+
+    static const int width = 1 ;
+
+    static value load( double const *p ){ return *p; }
+    static void store( double *p, value a ){ *p = a; }
+    static void storeInt( int *p, value a ){ *p = (int) a; }
+    static value set( double a ){ return a; }
+    static value add( value a, value b ){ return a + b; }
+    static value sub( value a, value b ){ return a - b; }
+    static value mul( value a, value b ){ return a * b; }
+    static value min( value a, value b ){ return ( a < b ) ? a : b; }
+    static value max( value a, value b ){ return ( a > b ) ? a : b; }
+    static value sqrt( value a ){ return std::sqrt(a); }
+    static mask lt( value a, value b ){ return a < b; }
+    static mask le( value a, value b ){ return a <= b; }
+    static mask ge( value a, value b ){ return a >= b; }
+    static mask both( mask a, mask b ){ return a && b; }
+    static value select( mask m, value a, value b ){ return m ? a : b; }
+};
 
-        ptrlambda[k  ] = xP[i][0] -r[2][0] ;
-        ptrlambda[k+1] = xP[i][1] -r[2][1];
-        ptrlambda[k+2] = xP[i][2] -r[2][2];
+# if defined(__AVX2__)
+/*!
+ * AVX2 implementation of the operations used by the batched kernel.
+ */
+struct Avx2Pack {
+    typedef __m256d value ;
+    typedef __m256d mask ;
+
+    static const int width = 4 ;
+
+    static value load( double const *p ){ return _mm256_loadu_pd(p); }
+    static void store( double *p, value a ){ _mm256_storeu_pd(p, a); }
+    static void storeInt( int *p, value a ){ _mm_storeu_si128( reinterpret_cast<__m128i *>(p), _mm256_cvtpd_epi32(a) ); }
+    static value set( double a ){ return _mm256_set1_pd(a); }
+    static value add( value a, value b ){ return _mm256_add_pd(a, b); }
+    static value sub( value a, value b ){ return _mm256_sub_pd(a, b); }
+    static value mul( value a, value b ){ return _mm256_mul_pd(a, b); }
+    static value min( value a, value b ){ return _mm256_min_pd(a, b); }
+    static value max( value a, value b ){ return _mm256_max_pd(a, b); }
+    static value sqrt( value a ){ return _mm256_sqrt_pd(a); }
+    static mask lt( value a, value b ){ return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+    static mask le( value a, value b ){ return _mm256_cmp_pd(a, b, _CMP_LE_OQ); }
+    static mask ge( value a, value b ){ return _mm256_cmp_pd(a, b, _CMP_GE_OQ); }
+    static mask both( mask a, mask b ){ return _mm256_and_pd(a, b); }
+    static value select( mask m, value a, value b ){ return _mm256_blendv_pd(b, a, m); }
+};
+# endif
 
-        k += 3 ;
-        i++ ;
-    };
+# if defined(__AVX512F__)
+/*!
+ * AVX-512 implementation of the operations used by the batched kernel.
+ */
+struct Avx512Pack {
+    typedef __m512d     value ;
+    typedef __mmask8    mask ;
+
+    static const int width = 8 ;
+
+    static value load( double const *p ){ return _mm512_loadu_pd(p); }
+    static void store( double *p, value a ){ _mm512_storeu_pd(p, a); }
+    static void storeInt( int *p, value a ){ _mm256_storeu_si256( reinterpret_cast<__m256i *>(p), _mm512_cvtpd_epi32(a) ); }
+    static value set( double a ){ return _mm512_set1_pd(a); }
+    static value add( value a, value b ){ return _mm512_add_pd(a, b); }
+    static value sub( value a, value b ){ return _mm512_sub_pd(a, b); }
+    static value mul( value a, value b ){ return _mm512_mul_pd(a, b); }
+    static value min( value a, value b ){ return _mm512_min_pd(a, b); }
+    static value max( value a, value b ){ return _mm512_max_pd(a, b); }
+    static value sqrt( value a ){ return _mm512_sqrt_pd(a); }
+    static mask lt( value a, value b ){ return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ); }
+    static mask le( value a, value b ){ return _mm512_cmp_pd_mask(a, b, _CMP_LE_OQ); }
+    static mask ge( value a, value b ){ return _mm512_cmp_pd_mask(a, b, _CMP_GE_OQ); }
+    static mask both( mask a, mask b ){ return a & b; }
+    static value select( mask m, value a, value b ){ return _mm512_mask_blend_pd(m, b, a); }
+};
+# endif
 
-    int info = LAPACKE_dgels( LAPACK_COL_MAJOR, 'N', 3, 2, N, A, 3, ptrlambda, 3 ) ;
-    assert( info == 0 );
-    BITPIT_UNUSED( info ) ;
+/*!
+ * Computes the distance between a pack of points and a triangle.
+ *
+ * The closest point is the projection onto the plane of the triangle when
+ * all the barycentric coordinates of the projection are non-negative,
+ * otherwise it is the closest among the projections onto the three edges.
+ * Both candidates are always evaluated and the result is selected with
+ * masks, so the same code is used for scalar and vector packs.
+ *
+ * @param[in] T triangle data
+ * @param[in] x x coordinates of the points
+ * @param[in] y y coordinates of the points
+ * @param[in] z z coordinates of the points
+ * @param[out] d distances
+ * @param[out] xPx x coordinates of the closest points, if null they are not stored
+ * @param[out] xPy y coordinates of the closest points, if null they are not stored
+ * @param[out] xPz z coordinates of the closest points, if null they are not stored
+ * @param[out] flag region flags, if null they are not stored
+ */
+template<typename Pack>
+inline void distancePackTriangle(
+        TriangleData const &T,
+        double const *x, double const *y, double const *z,
+        double *d, double *xPx, double *xPy, double *xPz, int *flag
+        ) {
 
-    j =0 ;
-    for( k=0; k<N; ++k) {
+    typedef typename Pack::value value ;
+    typedef typename Pack::mask  mask ;
+
+    value px = Pack::load(x) ;
+    value py = Pack::load(y) ;
+    value pz = Pack::load(z) ;
+
+    value zero = Pack::set(0.) ;
+    value one  = Pack::set(1.) ;
+
+    // Closest point on the edges
+    value bestD2, bestX, bestY, bestZ, bestFlag ;
+    for( int k=0; k<3; ++k ){
+        value ex = Pack::set(T.edge[k][0]) ;
+        value ey = Pack::set(T.edge[k][1]) ;
+        value ez = Pack::set(T.edge[k][2]) ;
+
+        value vx = Pack::set(T.vertex[k][0]) ;
+        value vy = Pack::set(T.vertex[k][1]) ;
+        value vz = Pack::set(T.vertex[k][2]) ;
+
+        value wx = Pack::sub(px, vx) ;
+        value wy = Pack::sub(py, vy) ;
+        value wz = Pack::sub(pz, vz) ;
+
+        value t = Pack::add( Pack::add( Pack::mul(wx, ex), Pack::mul(wy, ey) ), Pack::mul(wz, ez) ) ;
+        t = Pack::mul( t, Pack::set(T.edgeInvL2[k]) ) ;
+        t = Pack::min( Pack::max( t, zero ), one ) ;
+
+        value cx = Pack::add( vx, Pack::mul(t, ex) ) ;
+        value cy = Pack::add( vy, Pack::mul(t, ey) ) ;
+        value cz = Pack::add( vz, Pack::mul(t, ez) ) ;
+
+        value rx = Pack::sub(px, cx) ;
+        value ry = Pack::sub(py, cy) ;
+        value rz = Pack::sub(pz, cz) ;
+        value d2 = Pack::add( Pack::add( Pack::mul(rx, rx), Pack::mul(ry, ry) ), Pack::mul(rz, rz) ) ;
+
+        value edgeFlag = Pack::set( -(k+1) ) ;
+        edgeFlag = Pack::select( Pack::le(t, zero), Pack::set( k+1 ), edgeFlag ) ;
+        edgeFlag = Pack::select( Pack::ge(t, one), Pack::set( (k+1)%3+1 ), edgeFlag ) ;
+
+        if( k == 0 ){
+            bestD2   = d2 ;
+            bestX    = cx ;
+            bestY    = cy ;
+            bestZ    = cz ;
+            bestFlag = edgeFlag ;
+        } else {
+            mask closer = Pack::lt(d2, bestD2) ;
+            bestD2   = Pack::select( closer, d2, bestD2 ) ;
+            bestX    = Pack::select( closer, cx, bestX ) ;
+            bestY    = Pack::select( closer, cy, bestY ) ;
+            bestZ    = Pack::select( closer, cz, bestZ ) ;
+            bestFlag = Pack::select( closer, edgeFlag, bestFlag ) ;
+        }
+    }
 
-        lambda[0] = ptrlambda[j] ;
-        lambda[1] = ptrlambda[j+1] ;
-        lambda[2] = 1. -lambda[0] -lambda[1] ;
+    // Projection onto the plane of the triangle
+    value vx = Pack::sub( px, Pack::set(T.vertex[0][0]) ) ;
+    value vy = Pack::sub( py, Pack::set(T.vertex[0][1]) ) ;
+    value vz = Pack::sub( pz, Pack::set(T.vertex[0][2]) ) ;
 
-        j += 3 ;
+    value e0x = Pack::set(T.edge[0][0]) ;
+    value e0y = Pack::set(T.edge[0][1]) ;
+    value e0z = Pack::set(T.edge[0][2]) ;
 
-        i = 0 ;
-        count = 0;
-        twoNegative.fill(0.) ;
+    value e1x = Pack::set(-T.edge[2][0]) ;
+    value e1y = Pack::set(-T.edge[2][1]) ;
+    value e1z = Pack::set(-T.edge[2][2]) ;
 
-        for( const auto& value : lambda){
-            if( value < 0){
-                oneNegative = i;
-                twoNegative[count] = i ;
-                ++count ;
-            }
+    value d20 = Pack::add( Pack::add( Pack::mul(vx, e0x), Pack::mul(vy, e0y) ), Pack::mul(vz, e0z) ) ;
+    value d21 = Pack::add( Pack::add( Pack::mul(vx, e1x), Pack::mul(vy, e1y) ), Pack::mul(vz, e1z) ) ;
 
-            ++i;
-        };
+    value d00 = Pack::set(T.d00) ;
+    value d01 = Pack::set(T.d01) ;
+    value d11 = Pack::set(T.d11) ;
+    value invDenom = Pack::set(T.invDenom) ;
 
-        if( count == 0){
-            flag[k] = 0 ;
-        }
+    value b1 = Pack::mul( Pack::sub( Pack::mul(d11, d20), Pack::mul(d01, d21) ), invDenom ) ;
+    value b2 = Pack::mul( Pack::sub( Pack::mul(d00, d21), Pack::mul(d01, d20) ), invDenom ) ;
+    value b0 = Pack::sub( Pack::sub( one, b1 ), b2 ) ;
 
-        else{
-            if( count == 1){
-                vertex0 = (oneNegative +1) %3 ;
-                vertex1 = (vertex0     +1) %3 ;
+    mask inside = Pack::both( Pack::both( Pack::ge(b0, zero), Pack::ge(b1, zero) ), Pack::ge(b2, zero) ) ;
 
-                d[k]       =  distancePointSegment( P[k],r[vertex0],r[vertex1],xP[k], flagLocal)  ;
+    value cx = Pack::add( Pack::set(T.vertex[0][0]), Pack::add( Pack::mul(b1, e0x), Pack::mul(b2, e1x) ) ) ;
+    value cy = Pack::add( Pack::set(T.vertex[0][1]), Pack::add( Pack::mul(b1, e0y), Pack::mul(b2, e1y) ) ) ;
+    value cz = Pack::add( Pack::set(T.vertex[0][2]), Pack::add( Pack::mul(b1, e0z), Pack::mul(b2, e1z) ) ) ;
 
-                if( flagLocal ==0 ){
-                    flag[k]    = -(vertex0+1) ;
-                }
+    value rx = Pack::sub(px, cx) ;
+    value ry = Pack::sub(py, cy) ;
+    value rz = Pack::sub(pz, cz) ;
+    value d2 = Pack::add( Pack::add( Pack::mul(rx, rx), Pack::mul(ry, ry) ), Pack::mul(rz, rz) ) ;
 
-                else if( flagLocal == 1){
-                    flag[k] = vertex0+1 ; 
-                }
+    bestD2   = Pack::select( inside, d2, bestD2 ) ;
+    bestFlag = Pack::select( inside, zero, bestFlag ) ;
 
-                else if( flagLocal == 2){
-                    flag[k] = vertex1+1 ; 
-                };
-            }
+    // Store results
+    Pack::store( d, Pack::sqrt(bestD2) ) ;
 
-            else{
-                vertex0 = 3 -twoNegative[0] -twoNegative[1] ;
-                flag[k] = (vertex0 +1) ;
-                xP[k]   = r[vertex0] ;
-                d[k]    =  norm2( P[k] - r[vertex0] )  ;
-            };
+    if( xPx != nullptr ){
+        Pack::store( xPx, Pack::select( inside, cx, bestX ) ) ;
+    }
 
-        };
+    if( xPy != nullptr ){
+        Pack::store( xPy, Pack::select( inside, cy, bestY ) ) ;
+    }
 
-    };
+    if( xPz != nullptr ){
+        Pack::store( xPz, Pack::select( inside, cz, bestZ ) ) ;
+    }
 
-    delete[] A ;
-    delete[] ptrlambda ;
+    if( flag != nullptr ){
+        Pack::storeInt( flag, bestFlag ) ;
+    }
 
-    return d ;
+};
+
+}
+
+/*!
+ * Computes distances of point cloud to triangle.
+ *
+ * Batched version which works on coordinates stored as structure of arrays
+ * and on storage provided by the caller, no memory is allocated. Points are
+ * processed with AVX-512 or AVX2 instructions when the library is compiled
+ * with support for them, remaining points are processed with scalar code.
+ * Unlike the other versions of the function, the region of the closest point
+ * is evaluated exactly also for obtuse triangles.
+ *
+ * @param[in] N number of points
+ * @param[in] x x coordinates of the points
+ * @param[in] y y coordinates of the points
+ * @param[in] z z coordinates of the points
+ * @param[in] Q1 first triangle vertex
+ * @param[in] Q2 second triangle vertex
+ * @param[in] Q3 third triangle vertex
+ * @param[out] d distances, must have room for N values
+ * @param[out] xPx x coordinates of the closest points, if null they are not evaluated
+ * @param[out] xPy y coordinates of the closest points, if null they are not evaluated
+ * @param[out] xPz z coordinates of the closest points, if null they are not evaluated
+ * @param[out] flag point projecting onto triangle's interior (flag = 0), triangle's vertices (flag = 1, 2, 3) or triangle's edges (flag = -1, -2, -3), if null they are not evaluated
+ */
+void distanceCloudTriangle(
+        int                                  N,
+        double                         const *x,
+        double                         const *y,
+        double                         const *z,
+        std::array< double, 3 >        const &Q1,
+        std::array< double, 3 >        const &Q2,
+        std::array< double, 3 >        const &Q3,
+        double                               *d,
+        double                               *xPx,
+        double                               *xPy,
+        double                               *xPz,
+        int                                  *flag
+        ) {
+
+    TriangleData T( Q1, Q2, Q3 ) ;
+
+    int i = 0 ;
+
+# if defined(__AVX512F__)
+    for( ; i+Avx512Pack::width<=N; i+=Avx512Pack::width ){
+        distancePackTriangle<Avx512Pack>( T, x+i, y+i, z+i, d+i,
+                                          xPx ? xPx+i : nullptr, xPy ? xPy+i : nullptr, xPz ? xPz+i : nullptr,
+                                          flag ? flag+i : nullptr ) ;
+    }
+# endif
+
+# if defined(__AVX2__)
+    for( ; i+Avx2Pack::width<=N; i+=Avx2Pack::width ){
+        distancePackTriangle<Avx2Pack>( T, x+i, y+i, z+i, d+i,
+                                        xPx ? xPx+i : nullptr, xPy ? xPy+i : nullptr, xPz ? xPz+i : nullptr,
+                                        flag ? flag+i : nullptr ) ;
+    }
+# endif
+
+    for( ; i<N; ++i ){
+        distancePackTriangle<ScalarPack>( T, x+i, y+i, z+i, d+i,
+                                          xPx ? xPx+i : nullptr, xPy ? xPy+i : nullptr, xPz ? xPz+i : nullptr,
+                                          flag ? flag+i : nullptr ) ;
+    }
 
 };
 
@@ -0,0 +1,282 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+
+#include "ASCIIParser.hpp"
+
+namespace bitpit{
+
+namespace ascii{
+
+/*!
+ * Skips blank characters, new line characters are not skipped.
+ * @param[in]   begin   begin of the range
+ * @param[in]   end     end of the range
+ * @return pointer to the first non-blank character
+ */
+const char * skipBlanks( const char *begin, const char *end ){
+
+    while( begin < end && ( *begin == ' ' || *begin == '\t' || *begin == '\r' || *begin == '\v' || *begin == '\f' ) ){
+        ++begin ;
+    }
+
+    return begin ;
+
+}
+
+/*!
+ * Finds the beginning of the next line.
+ * @param[in]   begin   begin of the range
+ * @param[in]   end     end of the range
+ * @return pointer past the next new line character, end if there is no
+ * new line character in the range
+ */
+const char * nextLine( const char *begin, const char *end ){
+
+    if( begin >= end ){
+        return end ;
+    }
+
+    const char *newLine = static_cast<const char *>( std::memchr( begin, '\n', end - begin ) ) ;
+
+    return ( newLine != nullptr ) ? newLine + 1 : end ;
+
+}
+
+/*!
+ * Finds the end of the word starting at the specified position.
+ * @param[in]   begin   begin of the word
+ * @param[in]   end     end of the range
+ * @return pointer past the last character of the word
+ */
+const char * wordEnd( const char *begin, const char *end ){
+
+    while( begin < end && *begin != ' ' && *begin != '\t' && *begin != '\r' && *begin != '\n' && *begin != '\v' && *begin != '\f' ){
+        ++begin ;
+    }
+
+    return begin ;
+
+}
+
+/*!
+ * Checks if the word starting at the specified position matches the
+ * given one.
+ * @param[in]   begin   begin of the word
+ * @param[in]   end     end of the range
+ * @param[in]   word    null-terminated word to compare
+ * @return true if the words match
+ */
+bool isWord( const char *begin, const char *end, const char *word ){
+
+    const char *last = wordEnd( begin, end ) ;
+    std::size_t length = std::strlen( word ) ;
+
+    return ( (std::size_t) ( last - begin ) == length && std::memcmp( begin, word, length ) == 0 ) ;
+
+}
+
+namespace{
+
+/*!
+ * Parses a floating point number with strtod.
+ * @param[in]       start   begin of the number
+ * @param[in]       end     end of the range
+ * @param[out]      begin   position past the parsed number
+ * @param[out]      value   parsed value
+ * @return true if a number has been parsed, false otherwise
+ */
+bool parseDoubleFallback( const char *start, const char *end, const char *&begin, double &value ){
+
+    // strtod needs a null-terminated string, numbers are copied to a buffer
+    char buffer[128] ;
+    const char *last = ascii::wordEnd( start, end ) ;
+    std::size_t length = last - start ;
+    if( length == 0 || length >= sizeof( buffer ) ){
+        return false ;
+    }
+
+    std::memcpy( buffer, start, length ) ;
+    buffer[length] = '\0' ;
+
+    char *parsedEnd ;
+    double result = std::strtod( buffer, &parsedEnd ) ;
+    if( parsedEnd == buffer ){
+        return false ;
+    }
+
+    value = result ;
+    begin = start + ( parsedEnd - buffer ) ;
+    return true ;
+
+}
+
+}
+
+/*!
+ * Parses a floating point number, leading blanks are skipped.
+ *
+ * Numbers with at most 19 significant digits and a decimal exponent
+ * between -22 and 22 whose mantissa is exactly representable are
+ * converted with a single multiplication or division, which is correctly
+ * rounded. All other numbers are converted with strtod, so the result is
+ * always the same as the one of the standard library.
+ *
+ * @param[in,out]   begin   on input the position where parsing starts, on
+ * output the position past the parsed number
+ * @param[in]       end     end of the range
+ * @param[out]      value   parsed value
+ * @return true if a number has been parsed, false otherwise
+ */
+bool parseDouble( const char *&begin, const char *end, double &value ){
+
+    static const double POWERS[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    } ;
+
+    const char *p = skipBlanks( begin, end ) ;
+    const char *start = p ;
+
+    bool negative = false ;
+    if( p < end && ( *p == '-' || *p == '+' ) ){
+        negative = ( *p == '-' ) ;
+        ++p ;
+    }
+
+    uint64_t mantissa = 0 ;
+    int nDigits = 0 ;
+    int exponent = 0 ;
+    bool hasDigits = false ;
+
+    while( p < end && *p >= '0' && *p <= '9' ){
+        if( nDigits < 19 ){
+            mantissa = 10 * mantissa + ( *p - '0' ) ;
+            if( mantissa > 0 ) ++nDigits ;
+        } else {
+            ++exponent ;
+            ++nDigits ;
+        }
+        hasDigits = true ;
+        ++p ;
+    }
+
+    if( p < end && *p == '.' ){
+        ++p ;
+        while( p < end && *p >= '0' && *p <= '9' ){
+            if( nDigits < 19 ){
+                mantissa = 10 * mantissa + ( *p - '0' ) ;
+                if( mantissa > 0 ) ++nDigits ;
+                --exponent ;
+            } else {
+                ++nDigits ;
+            }
+            hasDigits = true ;
+            ++p ;
+        }
+    }
+
+    if( !hasDigits ){
+        // Infinities and nans are left to the standard library
+        return parseDoubleFallback( start, end, begin, value ) ;
+    }
+
+    if( p < end && ( *p == 'e' || *p == 'E' ) ){
+        const char *q = p + 1 ;
+        bool negativeExponent = false ;
+        if( q < end && ( *q == '-' || *q == '+' ) ){
+            negativeExponent = ( *q == '-' ) ;
+            ++q ;
+        }
+
+        if( q < end && *q >= '0' && *q <= '9' ){
+            int explicitExponent = 0 ;
+            while( q < end && *q >= '0' && *q <= '9' ){
+                if( explicitExponent < 100000 ){
+                    explicitExponent = 10 * explicitExponent + ( *q - '0' ) ;
+                }
+                ++q ;
+            }
+            exponent += negativeExponent ? -explicitExponent : explicitExponent ;
+            p = q ;
+        }
+    }
+
+    if( nDigits <= 19 && mantissa <= ( uint64_t(1) << 53 ) && exponent >= -22 && exponent <= 22 ){
+        double result = (double) mantissa ;
+        if( exponent < 0 ){
+            result /= POWERS[-exponent] ;
+        } else {
+            result *= POWERS[exponent] ;
+        }
+
+        value = negative ? -result : result ;
+        begin = p ;
+        return true ;
+    }
+
+    return parseDoubleFallback( start, end, begin, value ) ;
+
+}
+
+/*!
+ * Parses an integer number, leading blanks are skipped.
+ * @param[in,out]   begin   on input the position where parsing starts, on
+ * output the position past the parsed number
+ * @param[in]       end     end of the range
+ * @param[out]      value   parsed value
+ * @return true if a number has been parsed, false otherwise
+ */
+bool parseLong( const char *&begin, const char *end, long &value ){
+
+    const char *p = skipBlanks( begin, end ) ;
+
+    bool negative = false ;
+    if( p < end && ( *p == '-' || *p == '+' ) ){
+        negative = ( *p == '-' ) ;
+        ++p ;
+    }
+
+    if( p >= end || *p < '0' || *p > '9' ){
+        return false ;
+    }
+
+    long result = 0 ;
+    while( p < end && *p >= '0' && *p <= '9' ){
+        result = 10 * result + ( *p - '0' ) ;
+        ++p ;
+    }
+
+    value = negative ? -result : result ;
+    begin = p ;
+    return true ;
+
+}
+
+}
+
+}
@@ -0,0 +1,55 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#ifndef __BITPIT_ASCIIPARSER_HPP__
+#define __BITPIT_ASCIIPARSER_HPP__
+
+#include <cstddef>
+
+namespace bitpit{
+
+/*!
+ * @ingroup  GenericIO
+ * @brief Utility functions for parsing ASCII files held in memory
+ *
+ * The functions work on a range of characters [begin, end), usually the
+ * content of a MappedFile. They neither allocate memory nor depend on
+ * the stream state, hence different parts of the same buffer can be
+ * parsed concurrently.
+ */
+namespace ascii{
+
+const char * skipBlanks( const char *begin, const char *end ) ;
+const char * nextLine( const char *begin, const char *end ) ;
+const char * wordEnd( const char *begin, const char *end ) ;
+bool isWord( const char *begin, const char *end, const char *word ) ;
+
+bool parseDouble( const char *&begin, const char *end, double &value ) ;
+bool parseLong( const char *&begin, const char *end, long &value ) ;
+
+}
+
+}
+
+#endif
@@ -39,6 +39,13 @@
 // INCLUDES                                                                   //
 // ========================================================================== //
 
+# include <algorithm>
+# include <array>
+# include <type_traits>
+
+# include "bitpit_common.hpp"
+# include "ASCIIParser.hpp"
+# include "MappedFile.hpp"
 # include "DGF.hpp"
 
 // ========================================================================== //
@@ -48,6 +55,194 @@ using namespace std;
 
 namespace bitpit{
 
+namespace {
+
+/*!
+    Parse vertex coordinates from a line of a dgf data block.
+
+    \param[in] begin begin of the line
+    \param[in] end end of the line
+    \param[in,out] entry coordinates, up to three values are read
+*/
+void parseEntry(
+    const char                          *begin,
+    const char                          *end,
+    std::array<double, 3>               &entry
+) {
+
+for (int k = 0; k < 3; ++k) {
+    if (!ascii::parseDouble(begin, end, entry[k])) { return; }
+} //next k
+
+return; }
+
+/*!
+    Parse a list of values from a line of a dgf data block.
+
+    \param[in] begin begin of the line
+    \param[in] end end of the line
+    \param[in,out] entry list of values, values beyond the current size of
+    the list are appended
+*/
+template<typename T>
+void parseEntry(
+    const char                          *begin,
+    const char                          *end,
+    std::vector<T>                      &entry
+) {
+
+std::size_t n = 0;
+while (true) {
+    T value;
+    bool parsed;
+    if (std::is_integral<T>::value) {
+        long longValue;
+        parsed = ascii::parseLong(begin, end, longValue);
+        value  = (T) longValue;
+    }
+    else {
+        double doubleValue;
+        parsed = ascii::parseDouble(begin, end, doubleValue);
+        value  = (T) doubleValue;
+    }
+    if (!parsed) { break; }
+
+    if (n < entry.size()) { entry[n] = value; }
+    else                  { entry.push_back(value); }
+    ++n;
+} //next value
+
+return; }
+
+/*!
+    Check if the first word of a line terminates a dgf data block.
+
+    \param[in] word first word of the line
+    \param[in] end end of the line
+
+    \result returns true if the word terminates a data block
+*/
+bool isBlockEnd(
+    const char                          *word,
+    const char                          *end
+) {
+
+return (ascii::isWord(word, end, "#")
+     || ascii::isWord(word, end, "VERTEX")
+     || ascii::isWord(word, end, "SIMPLEX")
+     || ascii::isWord(word, end, "VERTEXDATA")
+     || ascii::isWord(word, end, "SIMPLEXDATA"));
+
+}
+
+/*!
+    Read a dgf data block from the content of a dgf file. Lines of the
+    block are located first, then they are parsed concurrently. The entries
+    read and the position where reading stops are the same of
+    dgf::readData().
+
+    \param[in,out] line on input points to the first line of the block, on
+    output points past the block
+    \param[in] end end of the content of the file
+    \param[in,out] N number of entries, incremented by the number of entries
+    read from the block
+    \param[in,out] Data entries of the block
+*/
+template<typename T>
+void readDataASCII(
+    const char                          *&line,
+    const char                          *end,
+    int                                 &N,
+    std::vector<T>                      &Data
+) {
+
+// ========================================================================== //
+// VARIABLES DECLARATION                                                      //
+// ========================================================================== //
+
+// Parameters
+const std::size_t                       LINES_PER_THREAD = 16384;
+
+// Local variables
+std::vector<const char *>               entries;
+int                                     nThreads;
+
+// ========================================================================== //
+// LOCATE ENTRIES                                                             //
+// ========================================================================== //
+while (line < end) {
+    const char *word = ascii::skipBlanks(line, end);
+    const char *next = ascii::nextLine(line, end);
+    if (word < next && *word != '\n') {
+        if (isBlockEnd(word, next)) {
+            if (ascii::isWord(word, next, "#")) { line = next; }
+            break;
+        }
+        entries.push_back(word);
+    }
+    line = next;
+} //next line
+
+// ========================================================================== //
+// PARSE ENTRIES                                                              //
+// ========================================================================== //
+int n = entries.size();
+Data.resize(N + n);
+
+nThreads = threads::getThreadCount();
+nThreads = std::min(nThreads, (int) (n / LINES_PER_THREAD) + 1);
+
+threads::parallelFor(nThreads, n, [&] (std::size_t first, std::size_t last) {
+    for (std::size_t i = first; i < last; ++i) {
+        parseEntry(entries[i], ascii::nextLine(entries[i], end), Data[N + i]);
+    } //next i
+});
+
+N += n;
+
+return; }
+
+/*!
+    Load mesh from the content of a dgf file.
+
+    \param[in] file content of the dgf file
+    \param[in,out] nV number of vertices
+    \param[in,out] nS number of cells
+    \param[in,out] V vertex coordinate list
+    \param[in,out] S cell->vertex connectivity data
+*/
+template<typename coords_t>
+void readMeshASCII(
+    const MappedFile                    &file,
+    int                                 &nV,
+    int                                 &nS,
+    std::vector<coords_t>               &V,
+    std::vector<std::vector<int> >      &S
+) {
+
+const char *end  = file.data() + file.size();
+const char *line = file.data();
+while (line < end) {
+    const char *word = ascii::skipBlanks(line, end);
+    const char *next = ascii::nextLine(line, end);
+    line = next;
+
+    if (ascii::isWord(word, next, "VERTEX")) {
+        readDataASCII(line, end, nV, V);
+    }
+    else if (ascii::isWord(word, next, "SIMPLEX")) {
+        readDataASCII(line, end, nS, S);
+    }
+    else if (ascii::isWord(word, next, "#")) {
+        break;
+    }
+} //next line
+
+return; }
+
+}
+
+
 /*!
     \ingroup DuneGridFormat
     \{
@@ -534,19 +729,19 @@ void DGFObj::load(
 // none
 
 // ========================================================================== //
-// OPEN INPUT STREAM                                                          //
+// MAP DGF FILE                                                               //
 // ========================================================================== //
-open("in");
+MappedFile file;
+if (!file.open(dgf_name)) {
+    err = 1;
+    return;
+}
 
 // ========================================================================== //
 // READ MESH DATA FROM DGF FILE                                               //
 // ========================================================================== //
-err = dgf::readMesh(ifile_handle, nV, nS, V, S);
-
-// ========================================================================== //
-// CLOSE INPUT STREAM                                                         //
-// ========================================================================== //
-close("in");
+readMeshASCII(file, nV, nS, V, S);
+err = 0;
 
 return; };
 
@@ -586,19 +781,19 @@ void DGFObj::load(
 // none
 
 // ========================================================================== //
-// OPEN INPUT STREAM                                                          //
+// MAP DGF FILE                                                               //
 // ========================================================================== //
-open("in");
+MappedFile file;
+if (!file.open(dgf_name)) {
+    err = 1;
+    return;
+}
 
 // ========================================================================== //
 // READ MESH DATA FROM DGF FILE                                               //
 // ========================================================================== //
-err = dgf::readMesh(ifile_handle, nV, nS, V, S);
-
-// ========================================================================== //
-// CLOSE INPUT STREAM                                                         //
-// ========================================================================== //
-close("in");
+readMeshASCII(file, nV, nS, V, S);
+err = 0;
 
 return; };
 
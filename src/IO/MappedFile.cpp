@@ -0,0 +1,178 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#   define BITPIT_MAPPEDFILE_USE_MMAP 1
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#else
+#   define BITPIT_MAPPEDFILE_USE_MMAP 0
+#endif
+
+#include "MappedFile.hpp"
+
+namespace bitpit{
+
+/*!
+ * Default constructor.
+ * No file is associated to the object.
+ */
+MappedFile::MappedFile() : m_data(nullptr), m_size(0), m_mapped(false){
+}
+
+/*!
+ * Constructor.
+ * Opens the specified file, isOpen() tells if the operation succeeded.
+ * @param[in]   name    name of the file
+ */
+MappedFile::MappedFile( const std::string &name ) : MappedFile(){
+
+    open( name ) ;
+
+}
+
+/*!
+ * Destructor.
+ * Releases the content of the file.
+ */
+MappedFile::~MappedFile(){
+
+    close() ;
+
+}
+
+/*!
+ * Opens a file, the file previously associated to the object is closed.
+ * Empty files are opened successfully, data() is then a null pointer.
+ * @param[in]   name    name of the file
+ * @return true if the file has been opened, false otherwise
+ */
+bool MappedFile::open( const std::string &name ){
+
+    close() ;
+
+#if BITPIT_MAPPEDFILE_USE_MMAP
+    int descriptor = ::open( name.c_str(), O_RDONLY ) ;
+    if( descriptor < 0 ){
+        return false ;
+    }
+
+    struct stat status ;
+    if( fstat( descriptor, &status ) != 0 ){
+        ::close( descriptor ) ;
+        return false ;
+    }
+
+    m_size = status.st_size ;
+    if( m_size > 0 ){
+        void *address = mmap( nullptr, m_size, PROT_READ, MAP_PRIVATE, descriptor, 0 ) ;
+        if( address == MAP_FAILED ){
+            ::close( descriptor ) ;
+            m_size = 0 ;
+            return false ;
+        }
+
+        madvise( address, m_size, MADV_SEQUENTIAL ) ;
+        m_data   = static_cast<const char *>( address ) ;
+        m_mapped = true ;
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    ::close( descriptor ) ;
+#else
+    std::ifstream file( name, std::ifstream::in | std::ifstream::binary | std::ifstream::ate ) ;
+    if( !file.good() ){
+        return false ;
+    }
+
+    m_size = file.tellg() ;
+    m_buffer.resize( m_size ) ;
+    file.seekg( 0 ) ;
+    file.read( m_buffer.data(), m_size ) ;
+    if( !file.good() ){
+        std::vector<char>().swap( m_buffer ) ;
+        m_size = 0 ;
+        return false ;
+    }
+
+    m_data = ( m_size > 0 ) ? m_buffer.data() : nullptr ;
+#endif
+
+    return true ;
+
+}
+
+/*!
+ * Closes the file associated to the object.
+ */
+void MappedFile::close(){
+
+#if BITPIT_MAPPEDFILE_USE_MMAP
+    if( m_mapped ){
+        munmap( const_cast<char *>( m_data ), m_size ) ;
+    }
+#endif
+
+    std::vector<char>().swap( m_buffer ) ;
+    m_data   = nullptr ;
+    m_size   = 0 ;
+    m_mapped = false ;
+
+}
+
+/*!
+ * Checks if the content of a file is available.
+ * @return true if a non-empty file has been opened, false otherwise
+ */
+bool MappedFile::isOpen() const{
+
+    return ( m_data != nullptr ) ;
+
+}
+
+/*!
+ * Gets the content of the file.
+ * @return pointer to the first byte of the file
+ */
+const char * MappedFile::data() const{
+
+    return m_data ;
+
+}
+
+/*!
+ * Gets the size of the file.
+ * @return size of the file in bytes
+ */
+std::size_t MappedFile::size() const{
+
+    return m_size ;
+
+}
+
+}
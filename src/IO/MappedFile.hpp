@@ -0,0 +1,71 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#ifndef __BITPIT_MAPPEDFILE_HPP__
+#define __BITPIT_MAPPEDFILE_HPP__
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace bitpit{
+
+/*!
+ * \ingroup GenericIO
+ * \class   MappedFile
+ * \brief   Read-only view of the whole content of a file
+ *
+ * On POSIX systems the file is memory-mapped, so its content is paged in
+ * by the operating system as it is accessed and no copy is made. On other
+ * systems the file is read into memory with a single block read.
+ */
+class MappedFile{
+
+    private:
+        const char           *m_data;          /**< pointer to the content of the file */
+        std::size_t           m_size;          /**< size of the file in bytes */
+        bool                  m_mapped;        /**< true if the file is memory-mapped */
+        std::vector<char>     m_buffer;        /**< content of the file, if not memory-mapped */
+
+    public:
+        MappedFile() ;
+        MappedFile( const std::string &name ) ;
+        MappedFile( const MappedFile& other ) = delete ;
+
+        ~MappedFile() ;
+
+        MappedFile& operator=( const MappedFile& other ) = delete ;
+
+        bool                open( const std::string &name ) ;
+        void                close() ;
+
+        bool                isOpen() const ;
+        const char *        data() const ;
+        std::size_t         size() const ;
+
+};
+
+}
+
+#endif
@@ -38,7 +38,11 @@
 // ========================================================================== //
 // INCLUDES                                                                   //
 // ========================================================================== //
+# include <algorithm>
+
 # include "bitpit_common.hpp"
+# include "ASCIIParser.hpp"
+# include "MappedFile.hpp"
 # include "STL.hpp"
 
 // ========================================================================== //
@@ -48,6 +52,240 @@ using namespace std;
 
 namespace bitpit{
 
+namespace {
+
+/*!
+    Read the next solid from the content of an ascii stl file.
+
+    The solid is located by scanning the first word of each line, then
+    facets are parsed concurrently, each thread filling a contiguous block
+    of the output lists. The content of the solid and the position where
+    reading stops are the same of stl::readSolidASCII().
+
+    \param[in] buffer content of the stl file
+    \param[in] size size of the content
+    \param[in,out] position on input stores the position where the search
+    for the solid starts, on output stores the position past the solid
+    \param[in,out] nV number of vertices, incremented by the number of
+    vertices read from the solid
+    \param[in,out] nT number of facets, incremented by the number of facets
+    read from the solid
+    \param[in,out] V vertex coordinate list
+    \param[in,out] N facet's normals
+    \param[in,out] T facet->vertex connectivity
+    \param[in] zero value used to initialize new coordinates
+
+    \result returns true if a solid has been found
+*/
+template<typename coords_t>
+bool readSolidASCII(
+    const char                          *buffer,
+    std::size_t                          size,
+    std::size_t                         &position,
+    int                                 &nV,
+    int                                 &nT,
+    vector<coords_t>                    &V,
+    vector<coords_t>                    &N,
+    vector<vector<int> >                &T,
+    const coords_t                      &zero
+) {
+
+// ========================================================================== //
+// VARIABLES DECLARATION                                                      //
+// ========================================================================== //
+
+// Parameters
+const std::size_t                       FACETS_PER_THREAD = 16384;
+
+// Local variables
+const char                              *end = buffer + size;
+const char                              *line = buffer + std::min(position, size);
+const char                              *word, *next;
+const char                              *solidEnd = end, *resume = end;
+bool                                    found = false;
+vector<const char *>                    facets;
+int                                     nThreads;
+
+// ========================================================================== //
+// SCAN FILE UNTIL A SOLID IS FOUND                                           //
+// ========================================================================== //
+while (line < end) {
+    word = ascii::skipBlanks(line, end);
+    next = ascii::nextLine(line, end);
+    line = next;
+    if (ascii::isWord(word, end, "solid")) {
+        found = true;
+        break;
+    }
+} //next line
+
+if (!found) {
+    position = size;
+    return(false);
+}
+
+// ========================================================================== //
+// LOCATE FACETS                                                              //
+// ========================================================================== //
+while (line < end) {
+    word = ascii::skipBlanks(line, end);
+    next = ascii::nextLine(line, end);
+    if (word < end && (*word == 'f' || *word == 'e' || *word == 's')) {
+        if (ascii::isWord(word, end, "facet")) {
+            facets.push_back(word);
+        }
+        else if (ascii::isWord(word, end, "endsolid")) {
+            solidEnd = line;
+            resume   = next;
+            break;
+        }
+        else if (ascii::isWord(word, end, "solid")) {
+            solidEnd = line;
+            resume   = line;
+            break;
+        }
+    }
+    line = next;
+} //next line
+
+position = resume - buffer;
+
+// ========================================================================== //
+// READ FACETS                                                                //
+// ========================================================================== //
+int nFacets = facets.size();
+
+V.resize(nV + 3*nFacets, zero);
+N.resize(nT + nFacets, zero);
+T.resize(nT + nFacets, vector<int>(3, -1));
+
+nThreads = threads::getThreadCount();
+nThreads = std::min(nThreads, (int) (nFacets / FACETS_PER_THREAD) + 1);
+
+const int vertexOffset = nV;
+const int facetOffset  = nT;
+threads::parallelFor(nThreads, nFacets, [&] (std::size_t first, std::size_t last) {
+    for (std::size_t i = first; i < last; ++i) {
+        const char *facetEnd = (i + 1 < (std::size_t) nFacets) ? facets[i + 1] : solidEnd;
+        const char *p        = facets[i];
+        const char *lineEnd  = ascii::nextLine(p, facetEnd);
+
+        // Facet normal
+        p = ascii::skipBlanks(ascii::wordEnd(p, lineEnd), lineEnd);
+        if (ascii::isWord(p, lineEnd, "normal")) {
+            p = ascii::wordEnd(p, lineEnd);
+            for (int k = 0; k < 3; ++k) {
+                if (!ascii::parseDouble(p, lineEnd, N[facetOffset + i][k])) break;
+            } //next k
+        }
+
+        // Facet vertices
+        int nv = 0;
+        const char *facetLine = lineEnd;
+        while (facetLine < facetEnd) {
+            const char *facetWord = ascii::skipBlanks(facetLine, facetEnd);
+            const char *facetNext = ascii::nextLine(facetLine, facetEnd);
+            if (ascii::isWord(facetWord, facetNext, "vertex") && nv < 3) {
+                int vertex = vertexOffset + 3*i + nv;
+                p = ascii::wordEnd(facetWord, facetNext);
+                for (int k = 0; k < 3; ++k) {
+                    if (!ascii::parseDouble(p, facetNext, V[vertex][k])) break;
+                } //next k
+                T[facetOffset + i][nv] = vertex;
+                ++nv;
+            }
+            else if (ascii::isWord(facetWord, facetNext, "endfacet")) {
+                break;
+            }
+            facetLine = facetNext;
+        } //next line
+    } //next i
+});
+
+// ========================================================================== //
+// UPDATE COUNTERS                                                            //
+// ========================================================================== //
+nV += 3*nFacets;
+nT += nFacets;
+
+return(true); }
+
+/*!
+    Read solids from an ascii stl file through a memory-mapped view of the
+    file. The cursor of the stream is updated as stl::readSolidASCII() and
+    stl::readASCII() do.
+
+    \param[in,out] file_handle stream from stl file
+    \param[in] file_name name of the stl file
+    \param[in] allSolids if set to true all the solids are read, otherwise
+    only the next solid is read
+    \param[in,out] nV number of vertices
+    \param[in,out] nT number of facets
+    \param[in,out] V vertex coordinate list
+    \param[in,out] N facet's normals
+    \param[in,out] T facet->vertex connectivity
+    \param[in] zero value used to initialize new coordinates
+
+    \result returns an error flag for I/O errors:
+        err = 0: no error(s) encountered
+        err = 1: failed to read from input stream
+*/
+template<typename coords_t>
+unsigned int loadASCII(
+    ifstream                            &file_handle,
+    const string                        &file_name,
+    bool                                 allSolids,
+    int                                 &nV,
+    int                                 &nT,
+    vector<coords_t>                    &V,
+    vector<coords_t>                    &N,
+    vector<vector<int> >                &T,
+    const coords_t                      &zero
+) {
+
+// ========================================================================== //
+// VARIABLES DECLARATION                                                      //
+// ========================================================================== //
+
+// Local variables
+long int                                start_pos;
+std::size_t                             position;
+MappedFile                              file;
+
+// ========================================================================== //
+// CHECK STREAM STATUS                                                        //
+// ========================================================================== //
+if (!file_handle.good()) { return(1); }
+
+file_handle.clear();
+start_pos = file_handle.tellg();
+if (start_pos < 0) { return(1); }
+
+if (!file.open(file_name)) { return(1); }
+
+// ========================================================================== //
+// READ SOLIDS                                                                //
+// ========================================================================== //
+if (allSolids) {
+    position = 0;
+    while (readSolidASCII(file.data(), file.size(), position, nV, nT, V, N, T, zero)) {}
+    position = start_pos;
+}
+else {
+    position = start_pos;
+    readSolidASCII(file.data(), file.size(), position, nV, nT, V, N, T, zero);
+}
+
+// ========================================================================== //
+// UPDATE CURSOR POSITION                                                     //
+// ========================================================================== //
+file_handle.clear();
+file_handle.seekg(position);
+
+return(0); }
+
+}
+
 /*!
  * @ingroup STereoLithography
  * @{
@@ -514,7 +752,7 @@ if (err == 1) { return; }
 // READ STL DATA                                                              //
 // ========================================================================== //
 if (stl_type)   { stl::readBINARY(ifile_handle, nV, nT, V, N, T); }
-else            { stl::readASCII(ifile_handle, nV, nT, V, N, T); }
+else            { err = loadASCII(ifile_handle, stl_name, true, nV, nT, V, N, T, vector<double>(3, 0.0)); }
 
 // ========================================================================== //
 // CLOSE INPUT STREAM                                                         //
@@ -572,7 +810,7 @@ if (err == 1) { return; }
 // READ STL DATA                                                              //
 // ========================================================================== //
 if (stl_type)   { stl::readBINARY(ifile_handle, nV, nT, V, N, T); }
-else            { stl::readASCII(ifile_handle, nV, nT, V, N, T); }
+else            { err = loadASCII(ifile_handle, stl_name, true, nV, nT, V, N, T, array<double,3>{{0., 0., 0.}}); }
 
 // ========================================================================== //
 // CLOSE INPUT STREAM                                                         //
@@ -624,7 +862,7 @@ void STLObj::loadSolid(
 // READ STL DATA                                                              //
 // ========================================================================== //
 if (stl_type)   { stl::readBINARY(ifile_handle, nV, nT, V, N, T); }
-else            { stl::readSolidASCII(ifile_handle, false, nV, nT, V, N, T); }
+else            { loadASCII(ifile_handle, stl_name, false, nV, nT, V, N, T, vector<double>(3, 0.0)); }
 
 return; };
 
@@ -673,7 +911,7 @@ void STLObj::loadSolid(
 // READ STL DATA                                                              //
 // ========================================================================== //
 if (stl_type)   { stl::readBINARY(ifile_handle, nV, nT, V, N, T); }
-else            { stl::readSolidASCII(ifile_handle, false, nV, nT, V, N, T); }
+else            { loadASCII(ifile_handle, stl_name, false, nV, nT, V, N, T, array<double,3>{{0., 0., 0.}}); }
 
 return; };
 
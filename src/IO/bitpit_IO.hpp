@@ -44,6 +44,7 @@
 
 #include "logger.hpp"
 #include "FileHandler.hpp"
+#include "MappedFile.hpp"
 #include "VTK.hpp"
 #include "DGF.hpp"
 #include "GenericIO.hpp"
@@ -76,6 +76,7 @@ namespace bitpit {
         m_rank = 0;
         m_nproc = 1;
         m_serial = true;
+        m_nofGhostLayers = 1;
         createPartitionInfo();
 #if BITPIT_ENABLE_MPI==1
         if (comm != MPI_COMM_NULL) {
@@ -173,6 +174,7 @@ namespace bitpit {
 #else
         m_serial = true;
 #endif
+        m_nofGhostLayers = 1;
 
         setFirstDesc();
         setLastDesc();
@@ -1399,6 +1401,92 @@ namespace bitpit {
         return m_octree.getSizeGhost();
     };
 
+    /*! Get the number of layers of ghost octants around the local octants.
+     * \return Number of layers of ghost octants.
+     */
+    std::size_t
+    ParaTree::getNofGhostLayers() const{
+        return m_nofGhostLayers;
+    };
+
+    /*! Set the number of layers of ghost octants around the local octants.
+     * The ghosts of the n-th layer are the octants of the other processes
+     * that can be reached from a local octant crossing n octants, where two
+     * octants are connected if they share a face, an edge or a node.
+     * If the octree is distributed the ghosts are rebuilt, in this case the
+     * function is collective and has to be called by all the processes.
+     * \param[in] nofGhostLayers Number of layers of ghost octants, it should
+     * be at least one.
+     */
+    void
+    ParaTree::setNofGhostLayers(std::size_t nofGhostLayers){
+        if (nofGhostLayers < 1){
+            throw std::runtime_error ("PABLO needs at least one layer of ghost octants");
+        }
+
+        if (nofGhostLayers == m_nofGhostLayers){
+            return;
+        }
+
+        m_nofGhostLayers = nofGhostLayers;
+#if BITPIT_ENABLE_MPI==1
+        if (!m_serial){
+            setPboundGhosts();
+        }
+#endif
+    };
+
+    /*! Evaluate the memory used by the octree, broken down by component
+     * (local octants, ghosts, intersections, nodes and connectivity,
+     * partition information and adaption/load-balance mappers).
+     * \return Memory used by the octree.
+     */
+    MemoryUsage
+    ParaTree::getMemoryUsage() const{
+        MemoryUsage usage("octree");
+
+        // Local tree
+        usage.addComponent("octants", utils::evalMemorySize(m_octree.m_octants));
+
+        std::size_t ghostBytes = utils::evalMemorySize(m_octree.m_ghosts);
+        ghostBytes += utils::evalMemorySize(m_octree.m_globalIdxGhosts);
+        ghostBytes += utils::evalMemorySize(m_octree.m_lastGhostBros);
+        usage.addComponent("ghosts", ghostBytes);
+
+        usage.addComponent("intersections", utils::evalMemorySize(m_octree.m_intersections));
+
+        std::size_t connectivityBytes = utils::evalMemorySize(m_octree.m_nodes);
+        connectivityBytes += utils::evalMemorySize(m_octree.m_connectivity);
+        for (const u32vector &connect : m_octree.m_connectivity){
+            connectivityBytes += utils::evalMemorySize(connect);
+        }
+        connectivityBytes += utils::evalMemorySize(m_octree.m_ghostsConnectivity);
+        for (const u32vector &connect : m_octree.m_ghostsConnectivity){
+            connectivityBytes += utils::evalMemorySize(connect);
+        }
+        usage.addComponent("connectivity", connectivityBytes);
+
+        // Partition
+        std::size_t partitionBytes = utils::evalMemorySize(m_partitionFirstDesc);
+        partitionBytes += utils::evalMemorySize(m_partitionLastDesc);
+        partitionBytes += utils::evalMemorySize(m_partitionRangeGlobalIdx);
+        partitionBytes += utils::evalMemorySize(m_partitionRangeGlobalIdx0);
+        partitionBytes += utils::evalMemorySize(m_internals);
+        partitionBytes += utils::evalMemorySize(m_pborders);
+        partitionBytes += utils::evalMemorySize(m_bordersPerProc);
+        for (const auto &borders : m_bordersPerProc){
+            partitionBytes += utils::evalMemorySize(borders.second);
+        }
+        usage.addComponent("partition", partitionBytes);
+
+        // Mappers
+        std::size_t mapperBytes = utils::evalMemorySize(m_mapIdx);
+        mapperBytes += utils::evalMemorySize(m_sentIdx);
+        usage.addComponent("mappers", mapperBytes);
+
+        return usage;
+    };
+
     /** Get the local number of nodes.
      * \return Local total number of nodes.
      */
@@ -4020,6 +4108,164 @@ namespace bitpit {
 
         MPI_Barrier(m_comm);
 
+        //COMMUNICATE THE GHOSTS
+        //the ghosts of the first layer are needed to find the octants of the further layers
+        commGhosts();
+        if (m_nofGhostLayers > 1){
+            buildGhostLayers();
+            commGhosts();
+        }
+
+    }
+
+    /*! Add to the border octants sent to each process the local octants of the
+     *  further layers of ghosts of that process, up to the requested number of layers.
+     *  A local octant is in the (k+1)-th layer around a process if it is a neighbour
+     *  of an octant of that process or of an octant in its first k layers. The
+     *  neighbours of a local octant are local octants or ghosts of the first layer,
+     *  hence before adding each layer the processes exchange, for the ghosts of the
+     *  first layer, the list of the processes to which they are sent.
+     *  The border octants and the ghosts of the first layer should be up to date.
+     */
+    void
+    ParaTree::buildGhostLayers() {
+        uint32_t nofOctants = getNumOctants();
+        uint32_t nofGhosts = getNumGhosts();
+
+        //PROCESSES TO WHICH EVERY LOCAL OCTANT IS SENT
+        vector<ivector> octantProcs(nofOctants);
+        map<int,u32vector>::iterator bitend = m_bordersPerProc.end();
+        for(map<int,u32vector>::iterator bit = m_bordersPerProc.begin(); bit != bitend; ++bit){
+            for(uint32_t idx : bit->second){
+                octantProcs[idx].push_back(bit->first);
+            }
+        }
+
+        //GHOSTS OF THE FIRST LAYER PER OWNER
+        //ghosts are stored in the order in which they are sent by their owners
+        map<int,u32vector> firstLayerBorders = m_bordersPerProc;
+        map<int,u32vector> firstLayerGhosts;
+        for(uint32_t g = 0; g < nofGhosts; ++g){
+            firstLayerGhosts[getOwnerRank(m_octree.m_globalIdxGhosts[g])].push_back(g);
+        }
+
+        vector<ivector> ghostProcs(nofGhosts);
+        u32vector neighbours;
+        bvector isghost;
+        for(std::size_t layer = 1; layer < m_nofGhostLayers; ++layer){
+            //COMMUNICATE THE PROCESSES TO WHICH THE GHOSTS OF THE FIRST LAYER ARE SENT
+            //for every border octant sent to a process the buffer contains the number of
+            //processes to which the octant is sent followed by their ranks
+            map<int,ivector> sendBuffers;
+            map<int,int> sendBufferSizePerProc;
+            map<int,u32vector>::iterator fbitend = firstLayerBorders.end();
+            for(map<int,u32vector>::iterator fbit = firstLayerBorders.begin(); fbit != fbitend; ++fbit){
+                ivector & buffer = sendBuffers[fbit->first];
+                for(uint32_t idx : fbit->second){
+                    buffer.push_back(octantProcs[idx].size());
+                    buffer.insert(buffer.end(), octantProcs[idx].begin(), octantProcs[idx].end());
+                }
+                sendBufferSizePerProc[fbit->first] = buffer.size();
+            }
+
+            vector<MPI_Request> req(2*sendBuffers.size());
+            int nReq = 0;
+            map<int,int> recvBufferSizePerProc;
+            for(map<int,ivector>::iterator sit = sendBuffers.begin(); sit != sendBuffers.end(); ++sit){
+                recvBufferSizePerProc[sit->first] = 0;
+                m_errorFlag = MPI_Irecv(&recvBufferSizePerProc[sit->first],1,MPI_INT,sit->first,m_rank,m_comm,&req[nReq]);
+                ++nReq;
+            }
+            for(map<int,ivector>::iterator sit = sendBuffers.begin(); sit != sendBuffers.end(); ++sit){
+                m_errorFlag = MPI_Isend(&sendBufferSizePerProc[sit->first],1,MPI_INT,sit->first,sit->first,m_comm,&req[nReq]);
+                ++nReq;
+            }
+            MPI_Waitall(nReq,req.data(),MPI_STATUSES_IGNORE);
+
+            map<int,ivector> recvBuffers;
+            nReq = 0;
+            for(map<int,ivector>::iterator sit = sendBuffers.begin(); sit != sendBuffers.end(); ++sit){
+                ivector & buffer = recvBuffers[sit->first];
+                buffer.resize(recvBufferSizePerProc[sit->first]);
+                m_errorFlag = MPI_Irecv(buffer.data(),buffer.size(),MPI_INT,sit->first,m_rank,m_comm,&req[nReq]);
+                ++nReq;
+            }
+            for(map<int,ivector>::iterator sit = sendBuffers.begin(); sit != sendBuffers.end(); ++sit){
+                m_errorFlag = MPI_Isend(sit->second.data(),sit->second.size(),MPI_INT,sit->first,sit->first,m_comm,&req[nReq]);
+                ++nReq;
+            }
+            MPI_Waitall(nReq,req.data(),MPI_STATUSES_IGNORE);
+
+            for(map<int,ivector>::iterator rit = recvBuffers.begin(); rit != recvBuffers.end(); ++rit){
+                const ivector & buffer = rit->second;
+                std::size_t pos = 0;
+                for(uint32_t g : firstLayerGhosts[rit->first]){
+                    int nofProcs = buffer[pos];
+                    ghostProcs[g].assign(buffer.begin() + pos + 1, buffer.begin() + pos + 1 + nofProcs);
+                    pos += 1 + nofProcs;
+                }
+            }
+
+            //ADD THE LAYER
+            //the local neighbours of an octant sent to a process are sent to that process as well,
+            //an octant is sent to the processes to which its ghost neighbours are sent
+            vector<ivector> layerProcs(nofOctants);
+            for(uint32_t idx = 0; idx < nofOctants; ++idx){
+                if (octantProcs[idx].empty()) continue;
+
+                for(uint8_t codim = 1; codim <= m_dim; ++codim){
+                    uint8_t nofEntities = m_global.m_nfaces;
+                    if (codim == m_dim){
+                        nofEntities = m_global.m_nnodes;
+                    }
+                    else if (codim == 2){
+                        nofEntities = m_global.m_nedges;
+                    }
+
+                    for(uint8_t i = 0; i < nofEntities; ++i){
+                        findNeighbours(idx, i, codim, neighbours, isghost);
+                        std::size_t nofNeighbours = neighbours.size();
+                        for(std::size_t n = 0; n < nofNeighbours; ++n){
+                            if (isghost[n]){
+                                const ivector & procs = ghostProcs[neighbours[n]];
+                                layerProcs[idx].insert(layerProcs[idx].end(), procs.begin(), procs.end());
+                            }
+                            else{
+                                const ivector & procs = octantProcs[idx];
+                                ivector & neighProcs = layerProcs[neighbours[n]];
+                                neighProcs.insert(neighProcs.end(), procs.begin(), procs.end());
+                            }
+                        }
+                    }
+                }
+            }
+
+            for(uint32_t idx = 0; idx < nofOctants; ++idx){
+                ivector & procs = octantProcs[idx];
+                for(int p : layerProcs[idx]){
+                    if (p != m_rank){
+                        procs.push_back(p);
+                    }
+                }
+                std::sort(procs.begin(), procs.end());
+                procs.erase(std::unique(procs.begin(), procs.end()), procs.end());
+            }
+        }
+
+        //BUILD THE BORDER OCTANTS OF EVERY PROCESS
+        m_bordersPerProc.clear();
+        for(uint32_t idx = 0; idx < nofOctants; ++idx){
+            for(int p : octantProcs[idx]){
+                m_bordersPerProc[p].push_back(idx);
+            }
+        }
+    }
+
+    /*! Communicate the border octants to the processes that need them as ghosts
+     *  and build the ghosts container of the local tree.
+     */
+    void
+    ParaTree::commGhosts() {
         //PACK (mpi) BORDER OCTANTS IN CHAR BUFFERS WITH SIZE (map value) TO BE SENT TO THE RIGHT PROCESS (map key)
         //it visits every element in m_bordersPerProc (one for every neighbor proc)
         //for every element it visits the border octants it contains and pack them in a new structure, sendBuffers
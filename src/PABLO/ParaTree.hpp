@@ -40,6 +40,7 @@
 #include "LocalTree.hpp"
 #include "Map.hpp"
 #include "bitpit_IO.hpp"
+#include "memory_usage.hpp"
 #include <map>
 #include <unordered_map>
 #include <set>
@@ -121,6 +122,7 @@ namespace bitpit {
         int 					m_errorFlag;					/**<MPI error flag*/
         bool 					m_serial;						/**<True if the octree is the same on each processor, False if the octree is distributed*/
         double					m_tol;							/**<Tolerance for geometric operations.*/
+        std::size_t				m_nofGhostLayers;				/**<Number of layers of ghost octants around the local octants*/
 
         //map members
         Map 					m_trans;						/**<Transformation map from m_logical to physical domain*/
@@ -290,6 +292,9 @@ namespace bitpit {
         uint64_t 	getStatus();
         uint32_t 	getNumOctants() const;
         uint32_t 	getNumGhosts() const;
+        std::size_t getNofGhostLayers() const;
+        void 		setNofGhostLayers(std::size_t nofGhostLayers);
+        MemoryUsage getMemoryUsage() const;
         uint32_t 	getNumNodes() const;
         uint8_t 	getLocalMaxDepth() const;
         double	 	getLocalMaxSize();
@@ -412,6 +417,8 @@ namespace bitpit {
         void 		computePartition(uint32_t* partition, uint8_t & level_, dvector* weight);
         void 		updateLoadBalance();
         void 		setPboundGhosts();
+        void 		buildGhostLayers();
+        void 		commGhosts();
         void 		commMarker();
 #endif
         void 		updateAfterCoarse();
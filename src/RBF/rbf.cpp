@@ -24,14 +24,195 @@
 
 #include <lapacke.h>
 
+#include <algorithm>
 #include <cmath>
 #include <set>
+#include <limits>
+#include <memory>
 #include "Operators.hpp"
+#include "thread_pool.hpp"
 #include "SortAlgorithms.hpp"
 #include "rbf.hpp"
 
 namespace bitpit{
 
+namespace {
+
+/*!
+ * @brief Uniform bucket grid used to find the RBF nodes lying within the
+ * support radius of a given point.
+ *
+ * Nodes are sorted by bucket with a counting sort, hence buckets are stored
+ * in compressed form. The bucket size is never smaller than the search
+ * radius, so all the candidates of a query lie in the 3x3x3 block of buckets
+ * surrounding the query point. The number of buckets is kept of the order of
+ * the number of nodes.
+ */
+class NodeGrid {
+
+public:
+    NodeGrid( const std::vector<std::array<double,3>> &, const std::vector<int> &, double ) ;
+
+    const std::vector<int> & getSortedNodes() const ;
+
+    template<class Function>
+    void forEachCandidateRange( const std::array<double,3> &, Function ) const ;
+
+    template<class Function>
+    void forEachCandidate( const std::array<double,3> &, Function ) const ;
+
+private:
+    std::array<double,3>    m_origin ;      /**< Lower corner of the grid */
+    double                  m_spacing ;     /**< Bucket size */
+    std::array<int,3>       m_nBuckets ;    /**< Number of buckets along each direction */
+    std::vector<int>        m_offsets ;     /**< Offsets of the buckets in the node list */
+    std::vector<int>        m_nodes ;       /**< Nodes sorted by bucket */
+
+    std::array<int,3>       getBucket( const std::array<double,3> & ) const ;
+};
+
+/*!
+ * Constructor
+ * @param[in] points coordinates of all RBF nodes
+ * @param[in] nodes indices of the nodes to be stored in the grid
+ * @param[in] radius search radius
+ */
+NodeGrid::NodeGrid( const std::vector<std::array<double,3>> &points, const std::vector<int> &nodes, double radius ){
+
+    std::array<double,3> upper ;
+    m_origin.fill( std::numeric_limits<double>::max() ) ;
+    upper.fill( - std::numeric_limits<double>::max() ) ;
+    for( int node : nodes ){
+        for( int d = 0; d < 3; ++d ){
+            m_origin[d] = std::min( m_origin[d], points[node][d] ) ;
+            upper[d]    = std::max( upper[d], points[node][d] ) ;
+        }
+    }
+
+    long nMaxBuckets = 2 * (long) nodes.size() + 1 ;
+
+    // Buckets smaller than the extent of the nodes divided by the maximum
+    // number of buckets can never be used, starting from a positive spacing
+    // also guarantees that the loop below ends when the radius is not
+    // positive or when all the nodes coincide.
+    double extent = 0. ;
+    for( int d = 0; d < 3 && !nodes.empty(); ++d ){
+        extent = std::max( extent, upper[d] - m_origin[d] ) ;
+    }
+
+    double minSpacing = ( extent > 0. ) ? extent / nMaxBuckets : 1. ;
+
+    m_spacing = std::max( minSpacing, radius ) ;
+    while( true ){
+        long nTotal = 1 ;
+        for( int d = 0; d < 3; ++d ){
+            double nCells = nodes.empty() ? 1. : std::floor( ( upper[d] - m_origin[d] ) / m_spacing ) + 1. ;
+            m_nBuckets[d] = (int) std::min( nCells, (double) nMaxBuckets ) ;
+            nTotal *= m_nBuckets[d] ;
+            if( nTotal > nMaxBuckets ) break ;
+        }
+
+        if( nTotal <= nMaxBuckets ) break ;
+        m_spacing *= 2. ;
+    }
+
+    long nBuckets = (long) m_nBuckets[0] * m_nBuckets[1] * m_nBuckets[2] ;
+    std::vector<int> bucketIds( nodes.size() ) ;
+
+    m_offsets.assign( nBuckets + 1, 0 ) ;
+    for( std::size_t n = 0; n < nodes.size(); ++n ){
+        std::array<int,3> bucket = getBucket( points[nodes[n]] ) ;
+        bucketIds[n] = bucket[0] + m_nBuckets[0] * ( bucket[1] + m_nBuckets[1] * bucket[2] ) ;
+        ++m_offsets[bucketIds[n] + 1] ;
+    }
+
+    for( long b = 0; b < nBuckets; ++b ){
+        m_offsets[b + 1] += m_offsets[b] ;
+    }
+
+    std::vector<int> fill( m_offsets.begin(), m_offsets.end() - 1 ) ;
+    m_nodes.resize( nodes.size() ) ;
+    for( std::size_t n = 0; n < nodes.size(); ++n ){
+        m_nodes[fill[bucketIds[n]]++] = nodes[n] ;
+    }
+}
+
+/*!
+ * Evaluates the bucket that contains the specified point. Points outside
+ * the grid are assigned to the nearest bucket.
+ * @param[in] point point coordinates
+ * @return cartesian indices of the bucket
+ */
+std::array<int,3> NodeGrid::getBucket( const std::array<double,3> &point ) const {
+
+    std::array<int,3> bucket ;
+    for( int d = 0; d < 3; ++d ){
+        double index = std::floor( ( point[d] - m_origin[d] ) / m_spacing ) ;
+        bucket[d] = (int) std::max( 0., std::min( index, (double) ( m_nBuckets[d] - 1 ) ) ) ;
+    }
+
+    return bucket ;
+}
+
+/*!
+ * Gets the nodes stored in the grid, sorted by bucket.
+ * @return nodes sorted by bucket
+ */
+const std::vector<int> & NodeGrid::getSortedNodes() const {
+    return m_nodes ;
+}
+
+/*!
+ * Calls the specified function for all the ranges of sorted nodes (see
+ * getSortedNodes) that may lie within the search radius of the given point.
+ * Buckets contiguous along the first direction are merged, hence the function
+ * is called at most nine times and receives the begin and the end of the
+ * range; the distance check is left to the caller.
+ * @param[in] point point coordinates
+ * @param[in] function function to be called for each range of candidates
+ */
+template<class Function>
+void NodeGrid::forEachCandidateRange( const std::array<double,3> &point, Function function ) const {
+
+    std::array<int,3> bucket = getBucket( point ) ;
+
+    std::array<int,3> lower, upper ;
+    for( int d = 0; d < 3; ++d ){
+        lower[d] = std::max( bucket[d] - 1, 0 ) ;
+        upper[d] = std::min( bucket[d] + 1, m_nBuckets[d] - 1 ) ;
+    }
+
+    for( int k = lower[2]; k <= upper[2]; ++k ){
+        for( int j = lower[1]; j <= upper[1]; ++j ){
+            long row = m_nBuckets[0] * ( j + (long) m_nBuckets[1] * k ) ;
+            int begin = m_offsets[row + lower[0]] ;
+            int end   = m_offsets[row + upper[0] + 1] ;
+            if( begin < end ){
+                function( begin, end ) ;
+            }
+        }
+    }
+}
+
+/*!
+ * Calls the specified function for all the nodes that may lie within the
+ * search radius of the given point. The function receives the index of the
+ * node; the distance check is left to the caller.
+ * @param[in] point point coordinates
+ * @param[in] function function to be called for each candidate
+ */
+template<class Function>
+void NodeGrid::forEachCandidate( const std::array<double,3> &point, Function function ) const {
+
+    forEachCandidateRange( point, [&]( int begin, int end ){
+        for( int n = begin; n < end; ++n ){
+            function( m_nodes[n] ) ;
+        }
+    } ) ;
+}
+
+}
+
 /*!
  * @ingroup RBF
  * @{
@@ -95,6 +276,7 @@ RBF & RBF::operator=(const RBF & other){
 	m_supportRadius = other.m_supportRadius ;
 	
 	m_fPtr = other.m_fPtr;
+	m_compactSupport = other.m_compactSupport;
 	
 	m_mode = other.m_mode;
 	
@@ -137,6 +319,7 @@ void RBF::setFunction( const RBFBasisFunction &bfunc ){
  */
 void RBF::setFunction( double (&bfunc)(const double &) ){
     m_fPtr = bfunc ;
+    m_compactSupport = ( m_fPtr == &rbf::wendlandc2 ) ;
     return ;
 };
 
@@ -150,6 +333,33 @@ int RBF::getDataCount(  ){
 	return m_fields ;
 };
 
+/*!
+ * Evaluates the memory used by the RBF, broken down into nodes, data
+ * attached to the nodes and interpolation weights. Supported in both modes.
+ * @return memory used by the RBF
+ */
+MemoryUsage RBF::getMemoryUsage( ) const{
+
+    MemoryUsage usage("rbf") ;
+
+    std::size_t nodeBytes = utils::evalMemorySize(m_node) ;
+    nodeBytes += utils::evalMemorySize(m_active) ;
+    nodeBytes += utils::evalMemorySize(m_error) ;
+    usage.addComponent("nodes", nodeBytes) ;
+
+    std::size_t valueBytes = utils::evalMemorySize(m_value) ;
+    for( const auto &value : m_value )
+        valueBytes += utils::evalMemorySize(value) ;
+    usage.addComponent("values", valueBytes) ;
+
+    std::size_t weightBytes = utils::evalMemorySize(m_weight) ;
+    for( const auto &weight : m_weight )
+        weightBytes += utils::evalMemorySize(weight) ;
+    usage.addComponent("weights", weightBytes) ;
+
+    return usage ;
+};
+
 
 /*! 
  * Get the number of active nodes. Supported in both nodes
@@ -278,9 +488,16 @@ void	RBF::deactivateAllNodes(){
 
 /*! 
  * Set the support radius of all RBF kernel functions. Supported in both modes.
+ * Radii that are not positive are rejected and the current radius is kept.
  * @param[in] radius support radius
  */
 void RBF::setSupportRadius( const double & radius ){
+	if( !( radius > 0. ) ){
+		std::cout<<"The support radius should be positive."<<std::endl;
+		std::cout<<"Support radius could not be set"<<std::endl;
+		return ;
+	}
+
 	m_supportRadius = radius ;
 	return ;
 };
@@ -579,128 +796,396 @@ std::vector<double> RBF::evalRBF( const std::array<double,3> &point){
 }
 
 /*! 
- * Calculates the RBF weights using all currently active nodes and just given target fields. 
- * Regular LU solver for linear system A*X=B is employed (LAPACKE dgesv). 
- * Supported ONLY in INTERP mode.
+ * Evaluates the RBF on a set of points. Supported in both modes.
+ * Values are written point by point into the storage provided by the
+ * caller, which must hold nPoints*getDataCount() elements: the value of
+ * the j-th field/weight at the p-th point is stored in values[p*getDataCount()+j].
  * 
- * @return integer error flag . If 0-successfull computation, if 1-errors occurred, if -1 dummy method call
+ * Active nodes and their weights are packed in a contiguous list, with the
+ * weights of each node interleaved. If the basis function has compact support,
+ * nodes are sorted by a bucket grid and each point visits only the nodes that
+ * lie in the neighbouring buckets. Points are split among the threads of
+ * the pool shared by the library (see threads::setThreadCount()).
+ * 
+ * @param[in] nPoints number of points
+ * @param[in] points points where to evaluate the RBF
+ * @param[out] values interpolated/parameterized values
  */
-int RBF::solve(){
-	if(m_mode == RBFMode::PARAM)	return -1;
-    int  j, k ;
-    double dist;
+void RBF::evalRBF( std::size_t nPoints, const std::array<double,3> *points, double *values ){
 
-    int nS      = getActiveCount() ;
-    int nrhs    = getDataCount() ;
-
-    int lda     = nS;
-    int ldb     = nS;
-    int info ;
-    int ipiv[nS];
+    int nFields = m_fields ;
+    if( nFields == 0 || nPoints == 0 ) return ;
 
     std::vector<int> activeSet( getActiveSet() ) ;
 
-    double *a = new double [lda * nS];
-    double *b = new double [ldb * nrhs];
-
-
-    k=0 ;
-    for( j=0; j<nrhs; ++j){
-
-        for( const auto & i : activeSet ){
-            b[k] = m_value[j][i];
-            ++k;
-        }
-
+    std::unique_ptr<NodeGrid> grid ;
+    const std::vector<int> *packedOrder = &activeSet ;
+    if( m_compactSupport ){
+        grid.reset( new NodeGrid( m_node, activeSet, m_supportRadius ) ) ;
+        packedOrder = &( grid->getSortedNodes() ) ;
     }
 
-    k=0;
-    for( const auto &i : activeSet ){
-        for( const auto &j : activeSet ){
-
-            dist = norm2(m_node[j] - m_node[i]) / m_supportRadius ;
-            a[k] = evalBasis( dist ) ; 
-            k++;
+    int nPacked = packedOrder->size() ;
+    std::vector<std::array<double,3>> packedNodes( nPacked ) ;
+    std::vector<double> packedWeights( (std::size_t) nPacked * nFields ) ;
+    for( int n = 0; n < nPacked; ++n ){
+        int node = (*packedOrder)[n] ;
+        packedNodes[n] = m_node[node] ;
+        for( int j = 0; j < nFields; ++j ){
+            packedWeights[(std::size_t) n * nFields + j] = m_weight[j][node] ;
         }
     }
 
+    double maxDistance2 = m_compactSupport ? m_supportRadius * m_supportRadius : std::numeric_limits<double>::max() ;
+
+    auto evaluate = [&]( std::size_t begin, std::size_t end ){
+        for( std::size_t p = begin; p < end; ++p ){
+            const std::array<double,3> &point = points[p] ;
+            double *pointValues = values + p * nFields ;
+            std::fill( pointValues, pointValues + nFields, 0. ) ;
+
+            auto addRange = [&]( int first, int last ){
+                for( int n = first; n < last; ++n ){
+                    std::array<double,3> delta = point - packedNodes[n] ;
+                    double distance2 = dotProduct( delta, delta ) ;
+                    if( distance2 > maxDistance2 ) continue ;
+
+                    double basis = evalBasis( std::sqrt( distance2 ) / m_supportRadius ) ;
+                    const double *nodeWeights = packedWeights.data() + (std::size_t) n * nFields ;
+                    for( int j = 0; j < nFields; ++j ){
+                        pointValues[j] += basis * nodeWeights[j] ;
+                    }
+                }
+            } ;
+
+            if( grid ){
+                grid->forEachCandidateRange( point, addRange ) ;
+            } else {
+                addRange( 0, nPacked ) ;
+            }
+        }
+    } ;
 
-    info = LAPACKE_dgesv( LAPACK_COL_MAJOR, nS, nrhs, a, lda, ipiv, b, ldb );
+    threads::parallelFor( threads::getThreadCount(), nPoints, evaluate ) ;
+}
 
-    if( info > 0 ) {
-        printf( "The diagonal element of the triangular factor of a,\n" );
-        printf( "U(%i,%i) is zero, so that a is singular;\n", info, info );
-        printf( "the solution could not be computed.\n" );
-        return 1;
-    }
+/*! 
+ * Calculates the RBF weights using all currently active nodes and just given target fields. 
+ * If the basis function has compact support (i.e. WENDLANDC2), the interpolation
+ * matrix is assembled in sparse form and solved with a preconditioned conjugate
+ * gradient, unless most of its entries are non-zero. Otherwise a regular LU solver
+ * for the dense linear system A*X=B is employed (LAPACKE dgesv). 
+ * Supported ONLY in INTERP mode.
+ * 
+ * @return integer error flag . If 0-successfull computation, if 1-errors occurred, if -1 dummy method call
+ */
+int RBF::solve(){
+	if(m_mode == RBFMode::PARAM)	return -1;
 
+    std::vector<int> activeSet( getActiveSet() ) ;
 
-    m_weight.resize(nrhs) ;
+    if( m_compactSupport ){
+        std::vector<long>   rowOffsets ;
+        std::vector<int>    columns ;
+        std::vector<double> coeffs ;
 
-    k=0 ;
-    for( j=0; j<nrhs; ++j){
-        m_weight[j].resize(m_nodes,0);
+        assembleSparse( activeSet, rowOffsets, columns, coeffs ) ;
 
-        for( const auto &i : activeSet ){
-            m_weight[j][i] = b[k];
-            ++k;
+        double nS = activeSet.size() ;
+        if( 4. * coeffs.size() <= nS * nS ){
+            return solveSparse( activeSet, rowOffsets, columns, coeffs ) ;
         }
     }
 
-
-    delete[] a;
-    delete[] b;
-	
-	return 0;
+    return solveDense( activeSet ) ;
 };
 
 /*! 
  * Determines effective set of nodes to be used using greedy algorithm and calculate weights on them.
  * Automatically choose which set of RBF nodes is active or not, according to the given tolerance.
+ * At each iteration the nodes with the largest error are activated and the weights are
+ * evaluated as the least squares solution of the interpolation problem on all the nodes.
+ * 
+ * The least squares problem is solved through the Cholesky factorization of its normal
+ * equations, which is updated whenever a node is activated, hence the factorization is
+ * never recomputed from scratch. The orthogonal factor of the interpolation matrix is not
+ * stored: the triangular factor only needs the products among the basis functions, which
+ * are evaluated within their support, and the accuracy lost by forming the normal equations
+ * is recovered by a step of iterative refinement on the residuals (corrected semi-normal
+ * equations). The memory used by the factorization grows with the square of the number of
+ * active nodes and does not depend on the total number of nodes; when the basis function
+ * has a compact support, the values of the basis functions of the active nodes within their
+ * support are stored as well, otherwise they are evaluated when needed.
+ * A node whose basis function is linearly dependent on the basis functions of the
+ * already active nodes is activated with a zero weight.
  * Supported ONLY in INTERP mode.
  * @param[in] tolerance error tolerance for adding nodes
+ * @param[in] batchSize number of nodes activated at each iteration, values lower than one are treated as one.
  * @return integer error flag . If 0-successfull computation and tolerance met, if 1-errors occurred, not enough nodes, if -1 dummy method call
  */
-int RBF::greedy( const double &tolerance){
+int RBF::greedy( const double &tolerance, int batchSize ){
 	
 	if(m_mode == RBFMode::PARAM)	return -1;	
 	
-    int                     i, j ;
-    double                  error(1.e18) ;
-    std::vector<double>     local(m_fields) ;
+    int nP   = m_nodes ;
+    int nrhs = m_fields ;
 
-    m_error.resize(m_nodes) ;
+    batchSize = std::max( batchSize, 1 ) ;
 
     for( auto && active : m_active )
         active = false ;
 
-    for( i=0; i<m_nodes; ++i){
+    // Residuals at nodes
+    std::vector<std::vector<double>> residuals( nrhs ) ;
+    for( int j=0; j<nrhs; ++j){
+        residuals[j].assign( m_value[j].begin(), m_value[j].begin() + nP ) ;
+    }
 
-        for( j=0; j<m_fields; ++j){
-        	local[j] = m_value[j][i] ;
+    m_weight.resize(nrhs) ;
+    for( int j=0; j<nrhs; ++j){
+        m_weight[j].assign(m_nodes, 0.) ;
+    }
+
+    // Upper triangular factor of the normal equations stored by columns in
+    // packed form and right hand sides of the normal equations
+    std::vector<int>                    columnNodes ;
+    std::vector<double>                 R ;
+    std::vector<std::vector<double>>    rhs( nrhs ) ;
+
+    // Grid used to find the support of the basis functions
+    std::unique_ptr<NodeGrid> grid ;
+    if( m_compactSupport ){
+        std::vector<int> allNodes( nP ) ;
+        for( int i=0; i<nP; ++i){
+            allNodes[i] = i ;
         }
 
-        m_error[i] = norm2(local) ;
+        grid.reset( new NodeGrid( m_node, allNodes, m_supportRadius ) ) ;
+    }
 
+    // Nodes within the support of the basis function centered in a node and
+    // values of the basis function on them
+    auto evalColumn = [&]( int node, std::vector<int> &support, std::vector<double> &column ){
+        support.clear() ;
+        column.clear() ;
+        if( grid ){
+            grid->forEachCandidate( m_node[node], [&]( int i ){
+                double dist = norm2( m_node[i] - m_node[node] ) ;
+                if( dist <= m_supportRadius ){
+                    support.push_back( i ) ;
+                    column.push_back( evalBasis( dist / m_supportRadius ) ) ;
+                }
+            } ) ;
+        } else {
+            for( int i=0; i<nP; ++i){
+                support.push_back( i ) ;
+                column.push_back( evalBasis( norm2( m_node[i] - m_node[node] ) / m_supportRadius ) ) ;
+            }
+        }
+    } ;
+
+    // Columns of the active nodes, they are stored in compressed form only
+    // when the basis function has a compact support, otherwise they are
+    // evaluated when needed
+    std::vector<std::size_t>    activeOffsets( 1, 0 ) ;
+    std::vector<int>            activeSupport ;
+    std::vector<double>         activeColumns ;
+
+    std::vector<int>    support ;
+    std::vector<double> column ;
+    const int           *columnSupport ;
+    const double        *columnValues ;
+    std::size_t         columnSize ;
+
+    auto loadColumn = [&]( int m ){
+        if( grid ){
+            columnSupport = activeSupport.data() + activeOffsets[m] ;
+            columnValues  = activeColumns.data() + activeOffsets[m] ;
+            columnSize    = activeOffsets[m + 1] - activeOffsets[m] ;
+        } else {
+            evalColumn( columnNodes[m], support, column ) ;
+            columnSupport = support.data() ;
+            columnValues  = column.data() ;
+            columnSize    = support.size() ;
+        }
+    } ;
+
+    // Solution of the normal equations, in place
+    auto solveNormal = [&]( std::vector<double> &x ){
+        int nColumns = columnNodes.size() ;
+        for( int m=0; m<nColumns; ++m){
+            std::size_t columnOffset = (std::size_t) m * ( m + 1 ) / 2 ;
+            for( int l=0; l<m; ++l){
+                x[m] -= R[columnOffset + l] * x[l] ;
+            }
+            x[m] /= R[columnOffset + m] ;
+        }
+
+        for( int m=nColumns-1; m>=0; --m){
+            std::size_t columnOffset = (std::size_t) m * ( m + 1 ) / 2 ;
+            x[m] /= R[columnOffset + m] ;
+            for( int l=0; l<m; ++l){
+                x[l] -= R[columnOffset + l] * x[m] ;
+            }
+        }
+    } ;
+
+    // Residuals of the given weights
+    auto evalResiduals = [&]( const std::vector<std::vector<double>> &weights ){
+        for( int j=0; j<nrhs; ++j){
+            residuals[j].assign( m_value[j].begin(), m_value[j].begin() + nP ) ;
+        }
+
+        for( std::size_t m=0; m<columnNodes.size(); ++m){
+            loadColumn( m ) ;
+            for( std::size_t s=0; s<columnSize; ++s){
+                for( int j=0; j<nrhs; ++j){
+                    residuals[j][columnSupport[s]] -= weights[j][m] * columnValues[s] ;
+                }
+            }
+        }
+    } ;
+
+    std::vector<int>    candidateSupport ;
+    std::vector<double> candidateColumn ;
+    std::vector<double> denseColumn( nP, 0. ) ;
+
+    std::vector<double> r ;
+    std::vector<std::vector<double>> weights( nrhs ), corrections( nrhs ) ;
+
+    m_error.resize(nP) ;
+    double error = 0. ;
+    for( int i=0; i<nP; ++i){
+        double norm = 0. ;
+        for( int j=0; j<nrhs; ++j){
+            norm += residuals[j][i] * residuals[j][i] ;
+        }
+        m_error[i] = std::sqrt( norm ) ;
+        error = std::max( error, m_error[i] ) ;
     }
 
     while( error > tolerance){
-        i = addGreedyPoint() ;
+        std::vector<int> candidates = addGreedyPoints( batchSize ) ;
+        if( candidates.empty() ) {
+            return 1 ;
+        }
 
-        if( i != -1) {
-            m_active[i] = true ;
+        for( int candidate : candidates ){
+            m_active[candidate] = true ;
 
-            //solve() ;
-            solveLSQ() ;
+            // Basis function of the candidate evaluated within its support
+            evalColumn( candidate, candidateSupport, candidateColumn ) ;
 
-            error = evalError() ;
+            double columnNorm2 = 0. ;
+            for( std::size_t s=0; s<candidateSupport.size(); ++s){
+                denseColumn[candidateSupport[s]] = candidateColumn[s] ;
+                columnNorm2 += candidateColumn[s] * candidateColumn[s] ;
+            }
 
-            std::cout << std::scientific ;
-            std::cout << " error now " << error << " active nodes" << getActiveCount() << " / " << m_nodes << std::endl ;
-        } else {
-            return 1 ;
+            // Products with the basis functions of the active nodes, basis
+            // functions with compact support whose centers are farther than
+            // twice the radius do not overlap
+            int k = columnNodes.size() ;
+            r.assign( k, 0. ) ;
+            for( int m=0; m<k; ++m){
+                if( grid && norm2( m_node[columnNodes[m]] - m_node[candidate] ) > 2. * m_supportRadius ) continue ;
+
+                loadColumn( m ) ;
+                for( std::size_t s=0; s<columnSize; ++s){
+                    r[m] += columnValues[s] * denseColumn[columnSupport[s]] ;
+                }
+            }
 
-        };
+            for( int i : candidateSupport ){
+                denseColumn[i] = 0. ;
+            }
+
+            // New column of the triangular factor
+            for( int m=0; m<k; ++m){
+                std::size_t columnOffset = (std::size_t) m * ( m + 1 ) / 2 ;
+                for( int l=0; l<m; ++l){
+                    r[m] -= R[columnOffset + l] * r[l] ;
+                }
+                r[m] /= R[columnOffset + m] ;
+            }
+
+            double rho2 = columnNorm2 ;
+            for( int m=0; m<k; ++m){
+                rho2 -= r[m] * r[m] ;
+            }
+
+            if( rho2 <= 1.e-12 * columnNorm2 ) continue ;
+
+            columnNodes.push_back( candidate ) ;
+            R.insert( R.end(), r.begin(), r.end() ) ;
+            R.push_back( std::sqrt( rho2 ) ) ;
+
+            if( grid ){
+                activeSupport.insert( activeSupport.end(), candidateSupport.begin(), candidateSupport.end() ) ;
+                activeColumns.insert( activeColumns.end(), candidateColumn.begin(), candidateColumn.end() ) ;
+                activeOffsets.push_back( activeSupport.size() ) ;
+            }
+
+            for( int j=0; j<nrhs; ++j){
+                double product = 0. ;
+                for( std::size_t s=0; s<candidateSupport.size(); ++s){
+                    product += candidateColumn[s] * m_value[j][candidateSupport[s]] ;
+                }
+                rhs[j].push_back( product ) ;
+            }
+        }
+
+        // Weights from the normal equations
+        int nColumns = columnNodes.size() ;
+        for( int j=0; j<nrhs; ++j){
+            weights[j] = rhs[j] ;
+            solveNormal( weights[j] ) ;
+        }
+
+        evalResiduals( weights ) ;
+
+        // Iterative refinement
+        for( int j=0; j<nrhs; ++j){
+            corrections[j].assign( nColumns, 0. ) ;
+        }
+
+        for( int m=0; m<nColumns; ++m){
+            loadColumn( m ) ;
+            for( std::size_t s=0; s<columnSize; ++s){
+                for( int j=0; j<nrhs; ++j){
+                    corrections[j][m] += columnValues[s] * residuals[j][columnSupport[s]] ;
+                }
+            }
+        }
+
+        for( int j=0; j<nrhs; ++j){
+            solveNormal( corrections[j] ) ;
+            for( int m=0; m<nColumns; ++m){
+                weights[j][m] += corrections[j][m] ;
+            }
+        }
+
+        evalResiduals( weights ) ;
+
+        for( int j=0; j<nrhs; ++j){
+            for( int m=0; m<nColumns; ++m){
+                m_weight[j][columnNodes[m]] = weights[j][m] ;
+            }
+        }
+
+        // Error
+        error = 0. ;
+        for( int i=0; i<nP; ++i){
+            double norm = 0. ;
+            for( int j=0; j<nrhs; ++j){
+                norm += residuals[j][i] * residuals[j][i] ;
+            }
+            m_error[i] = std::sqrt( norm ) ;
+            error = std::max( error, m_error[i] ) ;
+        }
+
+        std::cout << std::scientific ;
+        std::cout << " error now " << error << " active nodes" << getActiveCount() << " / " << m_nodes << std::endl ;
     };
 
     return 0;
@@ -756,39 +1241,41 @@ double RBF::evalBasis( const double &dist ){
  * @return index with max error; if no index available, or dummy call -1 is returned
  */
 int RBF::addGreedyPoint( ){
-	if(m_mode == RBFMode::PARAM) return -1;
-	
-    int     i(0), index(-1), nA( getActiveCount() ) ;
-    double  maxError(0.), penal ;
-    std::array<double,3>    myCoord ;
 
-    std::vector<int>     active( getActiveSet() );
+    std::vector<int> candidates = addGreedyPoints( 1 ) ;
+    if( candidates.empty() ) return -1 ;
 
-    for( auto error : m_error ){
+    return candidates[0];
 
-        if(!m_active[i] ){
+};
 
-            myCoord = m_node[i] ;
+/*! 
+ * Determines which nodes have to be added to active set. Supported only in INTERP mode.
+ * Inactive nodes are sorted by decreasing error; nodes with the same error are
+ * sorted by index, nodes with zero error are never selected.
+ * @param[in] count maximum number of nodes to be selected
+ * @return indices of the nodes with max error; if no index available, or dummy call an empty list is returned
+ */
+std::vector<int> RBF::addGreedyPoints( int count ){
 
-            if( nA != 0){ 
-                penal = 1.e18 ;
-                for( auto j : active ){
-                    penal = std::min(penal, norm2( myCoord - m_node[j] ))  ;
-                }; 
-            }
+    std::vector<int> candidates ;
+    if(m_mode == RBFMode::PARAM) return candidates;
 
-            if( error > maxError ){
-                maxError = error ;
-                index = i;
-            };
+    for( int i=0; i<m_nodes; ++i){
+        if( !m_active[i] && m_error[i] > 0. ){
+            candidates.push_back( i ) ;
         }
+    }
 
-        ++i;
-
-    };
+    auto compare = [this]( int i, int j ){
+        return ( m_error[i] > m_error[j] ) || ( m_error[i] == m_error[j] && i < j ) ;
+    } ;
 
+    std::size_t nSelected = std::min( candidates.size(), (std::size_t) std::max( count, 0 ) ) ;
+    std::partial_sort( candidates.begin(), candidates.begin() + nSelected, candidates.end(), compare ) ;
+    candidates.resize( nSelected ) ;
 
-    return index;
+    return candidates;
 
 };
 
@@ -912,6 +1399,604 @@ int RBF::solveLSQ(){
 	return(0);
 };
 
+/*! 
+ * Calculates the RBF weights on the specified nodes solving the dense
+ * interpolation system with a regular LU solver (LAPACKE dgesv).
+ * Supported ONLY in INTERP mode.
+ * @param[in] activeSet indices of the active nodes
+ * @return integer error flag . If 0-successfull computation, if 1-errors occurred
+ */
+int RBF::solveDense( const std::vector<int> &activeSet ){
+    int  j, k ;
+    double dist;
+
+    int nS      = activeSet.size() ;
+    int nrhs    = getDataCount() ;
+
+    int lda     = std::max(nS, 1);
+    int ldb     = std::max(nS, 1);
+    int info ;
+
+    std::vector<int>    ipiv( nS ) ;
+    std::vector<double> a( (std::size_t) lda * nS ) ;
+    std::vector<double> b( (std::size_t) ldb * nrhs ) ;
+
+
+    k=0 ;
+    for( j=0; j<nrhs; ++j){
+
+        for( const auto & i : activeSet ){
+            b[k] = m_value[j][i];
+            ++k;
+        }
+
+    }
+
+    k=0;
+    for( const auto &i : activeSet ){
+        for( const auto &j : activeSet ){
+
+            dist = norm2(m_node[j] - m_node[i]) / m_supportRadius ;
+            a[k] = evalBasis( dist ) ; 
+            k++;
+        }
+    }
+
+
+    info = LAPACKE_dgesv( LAPACK_COL_MAJOR, nS, nrhs, a.data(), lda, ipiv.data(), b.data(), ldb );
+
+    if( info > 0 ) {
+        printf( "The diagonal element of the triangular factor of a,\n" );
+        printf( "U(%i,%i) is zero, so that a is singular;\n", info, info );
+        printf( "the solution could not be computed.\n" );
+        return 1;
+    }
+
+
+    m_weight.resize(nrhs) ;
+
+    k=0 ;
+    for( j=0; j<nrhs; ++j){
+        m_weight[j].resize(m_nodes,0);
+
+        for( const auto &i : activeSet ){
+            m_weight[j][i] = b[k];
+            ++k;
+        }
+    }
+
+	return 0;
+};
+
+/*! 
+ * Assembles the interpolation matrix of the specified nodes in compressed
+ * sparse row format. Only the pairs of nodes closer than the support radius
+ * are stored; node pairs are found through a bucket grid, hence the cost of
+ * the assembly is proportional to the number of non-zero entries. Rows and
+ * columns are numbered according to the position of the nodes in the active
+ * set and both the triangular parts of the symmetric matrix are stored.
+ * @param[in] activeSet indices of the active nodes
+ * @param[out] rowOffsets offsets of the rows in the column/coefficient lists
+ * @param[out] columns column indices of the non-zero entries
+ * @param[out] coeffs values of the non-zero entries
+ */
+void RBF::assembleSparse( const std::vector<int> &activeSet, std::vector<long> &rowOffsets, std::vector<int> &columns, std::vector<double> &coeffs ){
+
+    int nS = activeSet.size() ;
+
+    std::vector<int> positions( m_nodes, -1 ) ;
+    for( int n = 0; n < nS; ++n ){
+        positions[activeSet[n]] = n ;
+    }
+
+    NodeGrid grid( m_node, activeSet, m_supportRadius ) ;
+
+    rowOffsets.resize( nS + 1 ) ;
+    rowOffsets[0] = 0 ;
+    columns.clear() ;
+    coeffs.clear() ;
+    for( int n = 0; n < nS; ++n ){
+        const std::array<double,3> &point = m_node[activeSet[n]] ;
+        grid.forEachCandidate( point, [&]( int candidate ){
+            double dist = norm2( m_node[candidate] - point ) / m_supportRadius ;
+            if( dist <= 1. ){
+                columns.push_back( positions[candidate] ) ;
+                coeffs.push_back( evalBasis( dist ) ) ;
+            }
+        } ) ;
+
+        rowOffsets[n + 1] = columns.size() ;
+    }
+};
+
+/*! 
+ * Calculates the RBF weights on the specified nodes solving the sparse
+ * interpolation system with a Jacobi-preconditioned conjugate gradient.
+ * The interpolation matrix of a compactly supported positive definite basis
+ * (e.g. WENDLANDC2) on distinct nodes is symmetric positive definite.
+ * Each data set is solved separately, the iterations stop when the norm of
+ * the residual is reduced below a relative tolerance of 1e-12.
+ * Supported ONLY in INTERP mode.
+ * @param[in] activeSet indices of the active nodes
+ * @param[in] rowOffsets offsets of the rows of the matrix
+ * @param[in] columns column indices of the non-zero entries
+ * @param[in] coeffs values of the non-zero entries
+ * @return integer error flag . If 0-successfull computation, if 1-errors occurred
+ */
+int RBF::solveSparse( const std::vector<int> &activeSet, const std::vector<long> &rowOffsets, const std::vector<int> &columns, const std::vector<double> &coeffs ){
+
+    const double TOLERANCE      = 1.e-12 ;
+    const int    MAX_ITERATIONS = 10000 ;
+
+    int nS      = activeSet.size() ;
+    int nrhs    = getDataCount() ;
+
+    std::vector<double> invDiagonal( nS, 1. ) ;
+    for( int n = 0; n < nS; ++n ){
+        for( long k = rowOffsets[n]; k < rowOffsets[n + 1]; ++k ){
+            if( columns[k] == n && coeffs[k] > 0. ){
+                invDiagonal[n] = 1. / coeffs[k] ;
+            }
+        }
+    }
+
+    std::vector<double> x( nS ), r( nS ), z( nS ), p( nS ), q( nS ) ;
+
+    m_weight.resize(nrhs) ;
+    for( int j = 0; j < nrhs; ++j ){
+
+        double bNorm2 = 0. ;
+        for( int n = 0; n < nS; ++n ){
+            x[n] = 0. ;
+            r[n] = m_value[j][activeSet[n]] ;
+            z[n] = invDiagonal[n] * r[n] ;
+            p[n] = z[n] ;
+            bNorm2 += r[n] * r[n] ;
+        }
+
+        double rz = 0. ;
+        for( int n = 0; n < nS; ++n ){
+            rz += r[n] * z[n] ;
+        }
+
+        double threshold2 = TOLERANCE * TOLERANCE * bNorm2 ;
+        double rNorm2     = bNorm2 ;
+        int    iteration  = 0 ;
+        while( rNorm2 > threshold2 ){
+            if( iteration == MAX_ITERATIONS ) {
+                printf( "The conjugate gradient did not converge after %i iterations;\n", iteration );
+                printf( "the relative residual is %e.\n", std::sqrt( rNorm2 / bNorm2 ) );
+                return 1;
+            }
+
+            double pq = 0. ;
+            for( int n = 0; n < nS; ++n ){
+                double sum = 0. ;
+                for( long k = rowOffsets[n]; k < rowOffsets[n + 1]; ++k ){
+                    sum += coeffs[k] * p[columns[k]] ;
+                }
+                q[n] = sum ;
+                pq  += p[n] * sum ;
+            }
+
+            if( pq <= 0. ) {
+                printf( "The interpolation matrix is not positive definite;\n" );
+                printf( "the solution could not be computed.\n" );
+                return 1;
+            }
+
+            double alpha = rz / pq ;
+            double rzNew = 0. ;
+            rNorm2 = 0. ;
+            for( int n = 0; n < nS; ++n ){
+                x[n]   += alpha * p[n] ;
+                r[n]   -= alpha * q[n] ;
+                z[n]    = invDiagonal[n] * r[n] ;
+                rzNew  += r[n] * z[n] ;
+                rNorm2 += r[n] * r[n] ;
+            }
+
+            double beta = rzNew / rz ;
+            for( int n = 0; n < nS; ++n ){
+                p[n] = z[n] + beta * p[n] ;
+            }
+
+            rz = rzNew ;
+            ++iteration ;
+        }
+
+        m_weight[j].resize(m_nodes,0);
+        for( int n = 0; n < nS; ++n ){
+            m_weight[j][activeSet[n]] = x[n] ;
+        }
+    }
+
+    return 0;
+};
+
+/*!
+ * @class RBFPartitionOfUnity
+ * @brief Partition of unity interpolation with Radial Basis Functions.
+ *
+ * The active RBF nodes are partitioned by a tree: the bounding box of the
+ * nodes is recursively split at the median along its longest side, until
+ * the number of nodes is not greater than the patch node count. Each leaf
+ * of the tree defines a spherical patch, whose radius is the half diagonal
+ * of the bounding box of the leaf times the patch overlap. A local RBF
+ * interpolant is built on the nodes inside each patch, hence the global
+ * system is replaced by many small independent systems, solved in parallel.
+ *
+ * Local interpolants are blended by the partition of unity weights
+ * w_i(x) = W(|x-c_i|/r_i) / sum_k W(|x-c_k|/r_k), where W is the Wendland C2
+ * function and c_i, r_i are the center and the radius of the i-th patch.
+ * Patches overlapping a point are found through the same tree.
+ *
+ * Nodes and data are handled as in bitpit::RBF. Only the INTERP mode is
+ * supported by the partition of unity; in PARAM mode the class behaves as
+ * bitpit::RBF.
+ */
+
+/*!
+ * Default constructor. Requires optionally statements of type of RBFBasisFunction
+ * which must be used by the local interpolants.
+ */
+RBFPartitionOfUnity::RBFPartitionOfUnity( RBFBasisFunction bfunc ) : RBF( bfunc ) {
+
+    m_patchNodeCount = 50 ;
+    m_overlap        = 1.2 ;
+};
+
+/*!
+ * Sets the maximum number of nodes in the leaves of the partition. Patches
+ * also include the nodes of the neighbouring leaves that fall inside them.
+ * @param[in] count number of nodes, values lower than one are treated as one.
+ */
+void RBFPartitionOfUnity::setPatchNodeCount( int count ){
+    m_patchNodeCount = std::max( count, 1 ) ;
+};
+
+/*!
+ * Gets the maximum number of nodes in the leaves of the partition.
+ * @return number of nodes
+ */
+int RBFPartitionOfUnity::getPatchNodeCount(){
+    return m_patchNodeCount ;
+};
+
+/*!
+ * Sets the overlap of the patches, i.e. the ratio between the radius of
+ * a patch and the half diagonal of the bounding box of its leaf.
+ * @param[in] overlap overlap, values lower than one are treated as one.
+ */
+void RBFPartitionOfUnity::setPatchOverlap( double overlap ){
+    m_overlap = std::max( overlap, 1. ) ;
+};
+
+/*!
+ * Gets the overlap of the patches.
+ * @return overlap
+ */
+double RBFPartitionOfUnity::getPatchOverlap(){
+    return m_overlap ;
+};
+
+/*!
+ * Gets the number of patches created by the last call to solve().
+ * @return number of patches
+ */
+int RBFPartitionOfUnity::getPatchCount(){
+    return m_patchCenters.size() ;
+};
+
+/*!
+ * Evaluates the memory used by the RBF, including the partition of the
+ * nodes and the local interpolants of the patches.
+ * @return memory used by the RBF
+ */
+MemoryUsage RBFPartitionOfUnity::getMemoryUsage( ) const{
+
+    MemoryUsage usage = RBF::getMemoryUsage() ;
+
+    std::size_t partitionBytes = utils::evalMemorySize(m_partition) ;
+    partitionBytes += utils::evalMemorySize(m_sortedNodes) ;
+    usage.addComponent("partition", partitionBytes) ;
+
+    std::size_t patchBytes = utils::evalMemorySize(m_patchCenters) ;
+    patchBytes += utils::evalMemorySize(m_patchRadii) ;
+    patchBytes += utils::evalMemorySize(m_patchOffsets) ;
+    patchBytes += utils::evalMemorySize(m_patchNodes) ;
+    patchBytes += utils::evalMemorySize(m_patchWeights) ;
+    usage.addComponent("patches", patchBytes) ;
+
+    return usage ;
+};
+
+/*!
+ * Partitions the active nodes and calculates the weights of the local
+ * interpolants, solving the dense system of each patch with a regular
+ * LU solver (LAPACKE dgesv). Patches are split among the threads of the
+ * pool shared by the library.
+ * Supported ONLY in INTERP mode.
+ *
+ * @return integer error flag . If 0-successfull computation, if 1-errors occurred, if -1 dummy method call
+ */
+int RBFPartitionOfUnity::solve(){
+	if(getMode() == RBFMode::PARAM)	return -1;
+
+    int nFields = getDataCount() ;
+
+    // Partition
+    m_partition.clear() ;
+    m_patchCenters.clear() ;
+    m_patchRadii.clear() ;
+
+    m_sortedNodes = getActiveSet() ;
+    if( !m_sortedNodes.empty() ){
+        buildPartition( 0, m_sortedNodes.size() ) ;
+    }
+
+    int nPatches = m_patchCenters.size() ;
+
+    // Patch nodes
+    m_patchOffsets.assign( 1, 0 ) ;
+    m_patchNodes.clear() ;
+    std::vector<int> patchNodes ;
+    for( int p = 0; p < nPatches; ++p ){
+        findPatchNodes( m_patchCenters[p], m_patchRadii[p], patchNodes ) ;
+        m_patchNodes.insert( m_patchNodes.end(), patchNodes.begin(), patchNodes.end() ) ;
+        m_patchOffsets.push_back( m_patchNodes.size() ) ;
+    }
+
+    // Local weights
+    double supportRadius = getSupportRadius() ;
+
+    m_patchWeights.resize( m_patchNodes.size() * nFields ) ;
+    std::vector<int> status( nPatches, 0 ) ;
+
+    auto solvePatches = [&]( std::size_t begin, std::size_t end ){
+        std::vector<int>    ipiv ;
+        std::vector<double> a, b ;
+        for( std::size_t p = begin; p < end; ++p ){
+            const int *nodes = m_patchNodes.data() + m_patchOffsets[p] ;
+            int nS = m_patchOffsets[p + 1] - m_patchOffsets[p] ;
+
+            ipiv.resize( nS ) ;
+            a.resize( (std::size_t) nS * nS ) ;
+            b.resize( (std::size_t) nS * nFields ) ;
+
+            for( int i = 0; i < nS; ++i ){
+                for( int j = 0; j < nS; ++j ){
+                    a[(std::size_t) i * nS + j] = evalBasis( norm2( m_node[nodes[j]] - m_node[nodes[i]] ) / supportRadius ) ;
+                }
+
+                for( int j = 0; j < nFields; ++j ){
+                    b[(std::size_t) j * nS + i] = m_value[j][nodes[i]] ;
+                }
+            }
+
+            status[p] = LAPACKE_dgesv( LAPACK_COL_MAJOR, nS, nFields, a.data(), nS, ipiv.data(), b.data(), nS ) ;
+            if( status[p] != 0 ) continue ;
+
+            double *weights = m_patchWeights.data() + m_patchOffsets[p] * nFields ;
+            for( int i = 0; i < nS; ++i ){
+                for( int j = 0; j < nFields; ++j ){
+                    weights[(std::size_t) i * nFields + j] = b[(std::size_t) j * nS + i] ;
+                }
+            }
+        }
+    } ;
+
+    threads::parallelFor( threads::getThreadCount(), nPatches, solvePatches ) ;
+
+    for( int p = 0; p < nPatches; ++p ){
+        if( status[p] != 0 ){
+            printf( "The local system of patch %i is singular;\n", p );
+            printf( "the solution could not be computed.\n" );
+            return 1;
+        }
+    }
+
+	return 0;
+};
+
+/*!
+ * Evaluates the RBF. In INTERP mode, the local interpolants are blended
+ * with the partition of unity weights.
+ * @param[in] point point where to evaluate the basis
+ * @return vector containing interpolated/parameterized values.
+ */
+std::vector<double> RBFPartitionOfUnity::evalRBF( const std::array<double,3> &point ){
+
+    if( getMode() == RBFMode::PARAM ) return RBF::evalRBF( point ) ;
+
+    std::vector<double> values( getDataCount() ) ;
+    evalPartition( point, values.data() ) ;
+
+    return values ;
+};
+
+/*!
+ * Evaluates the RBF on a set of points, see RBF::evalRBF( std::size_t, const std::array<double,3> *, double * ).
+ * In INTERP mode, the local interpolants are blended with the partition of
+ * unity weights. Points are split among the threads of the pool shared by
+ * the library.
+ * @param[in] nPoints number of points
+ * @param[in] points points where to evaluate the RBF
+ * @param[out] values interpolated/parameterized values
+ */
+void RBFPartitionOfUnity::evalRBF( std::size_t nPoints, const std::array<double,3> *points, double *values ){
+
+    if( getMode() == RBFMode::PARAM ){
+        RBF::evalRBF( nPoints, points, values ) ;
+        return ;
+    }
+
+    int nFields = getDataCount() ;
+    if( nFields == 0 ) return ;
+
+    auto evaluate = [&]( std::size_t begin, std::size_t end ){
+        for( std::size_t p = begin; p < end; ++p ){
+            evalPartition( points[p], values + p * nFields ) ;
+        }
+    } ;
+
+    threads::parallelFor( threads::getThreadCount(), nPoints, evaluate ) ;
+};
+
+/*!
+ * Builds the subtree of the partition containing the specified range of
+ * sorted nodes. Nodes in the range are reordered.
+ * @param[in] begin begin of the range
+ * @param[in] end end of the range
+ * @return index of the root of the subtree
+ */
+int RBFPartitionOfUnity::buildPartition( int begin, int end ){
+
+    int index = m_partition.size() ;
+    m_partition.emplace_back() ;
+
+    PartitionNode node ;
+    node.begin = begin ;
+    node.end   = end ;
+    node.nodeMin.fill( std::numeric_limits<double>::max() ) ;
+    node.nodeMax.fill( - std::numeric_limits<double>::max() ) ;
+    for( int n = begin; n < end; ++n ){
+        const std::array<double,3> &coords = m_node[m_sortedNodes[n]] ;
+        for( int d = 0; d < 3; ++d ){
+            node.nodeMin[d] = std::min( node.nodeMin[d], coords[d] ) ;
+            node.nodeMax[d] = std::max( node.nodeMax[d], coords[d] ) ;
+        }
+    }
+
+    if( end - begin <= m_patchNodeCount ){
+        std::array<double,3> center = 0.5 * ( node.nodeMin + node.nodeMax ) ;
+        double radius = 0.5 * m_overlap * norm2( node.nodeMax - node.nodeMin ) ;
+        if( radius <= 0. ) radius = getSupportRadius() ;
+
+        node.patch    = m_patchCenters.size() ;
+        node.children = {{ -1, -1 }} ;
+        node.patchMin = center - radius ;
+        node.patchMax = center + radius ;
+
+        m_patchCenters.push_back( center ) ;
+        m_patchRadii.push_back( radius ) ;
+    } else {
+        std::array<double,3> size = node.nodeMax - node.nodeMin ;
+        int axis = std::max_element( size.begin(), size.end() ) - size.begin() ;
+
+        int middle = begin + ( end - begin ) / 2 ;
+        std::nth_element( m_sortedNodes.begin() + begin, m_sortedNodes.begin() + middle, m_sortedNodes.begin() + end,
+                          [this, axis]( int i, int j ){ return ( m_node[i][axis] < m_node[j][axis] ) || ( m_node[i][axis] == m_node[j][axis] && i < j ) ; } ) ;
+
+        node.patch       = -1 ;
+        node.children[0] = buildPartition( begin, middle ) ;
+        node.children[1] = buildPartition( middle, end ) ;
+
+        const PartitionNode &left  = m_partition[node.children[0]] ;
+        const PartitionNode &right = m_partition[node.children[1]] ;
+        for( int d = 0; d < 3; ++d ){
+            node.patchMin[d] = std::min( left.patchMin[d], right.patchMin[d] ) ;
+            node.patchMax[d] = std::max( left.patchMax[d], right.patchMax[d] ) ;
+        }
+    }
+
+    m_partition[index] = node ;
+
+    return index ;
+};
+
+/*!
+ * Finds the active nodes that lie inside the specified sphere.
+ * @param[in] center center of the sphere
+ * @param[in] radius radius of the sphere
+ * @param[out] nodes nodes inside the sphere
+ */
+void RBFPartitionOfUnity::findPatchNodes( const std::array<double,3> &center, double radius, std::vector<int> &nodes ) const {
+
+    nodes.clear() ;
+    if( m_partition.empty() ) return ;
+
+    std::vector<int> stack( 1, 0 ) ;
+    while( !stack.empty() ){
+        const PartitionNode &node = m_partition[stack.back()] ;
+        stack.pop_back() ;
+
+        double boxDistance2 = 0. ;
+        for( int d = 0; d < 3; ++d ){
+            double delta = std::max( std::max( node.nodeMin[d] - center[d], center[d] - node.nodeMax[d] ), 0. ) ;
+            boxDistance2 += delta * delta ;
+        }
+        if( boxDistance2 > radius * radius ) continue ;
+
+        if( node.patch >= 0 ){
+            for( int n = node.begin; n < node.end; ++n ){
+                int candidate = m_sortedNodes[n] ;
+                if( norm2( m_node[candidate] - center ) <= radius ) nodes.push_back( candidate ) ;
+            }
+        } else {
+            stack.push_back( node.children[1] ) ;
+            stack.push_back( node.children[0] ) ;
+        }
+    }
+};
+
+/*!
+ * Evaluates the partition of unity interpolant.
+ * @param[in] point point where to evaluate the interpolant
+ * @param[out] values interpolated values, the storage must hold getDataCount() elements
+ */
+void RBFPartitionOfUnity::evalPartition( const std::array<double,3> &point, double *values ){
+
+    int    nFields       = getDataCount() ;
+    double supportRadius = getSupportRadius() ;
+
+    std::fill( values, values + nFields, 0. ) ;
+    if( m_partition.empty() ) return ;
+
+    // The depth of the tree is logarithmic in the number of nodes
+    std::array<int,128> stack ;
+    int stackSize = 0 ;
+    stack[stackSize++] = 0 ;
+
+    double weightSum = 0. ;
+    while( stackSize > 0 ){
+        const PartitionNode &node = m_partition[stack[--stackSize]] ;
+
+        bool inside = true ;
+        for( int d = 0; d < 3; ++d ){
+            inside = inside && ( point[d] >= node.patchMin[d] ) && ( point[d] <= node.patchMax[d] ) ;
+        }
+        if( !inside ) continue ;
+
+        if( node.patch < 0 ){
+            stack[stackSize++] = node.children[1] ;
+            stack[stackSize++] = node.children[0] ;
+            continue ;
+        }
+
+        int patch = node.patch ;
+        double weight = rbf::wendlandc2( norm2( point - m_patchCenters[patch] ) / m_patchRadii[patch] ) ;
+        if( weight <= 0. ) continue ;
+
+        weightSum += weight ;
+        for( long k = m_patchOffsets[patch]; k < m_patchOffsets[patch + 1]; ++k ){
+            double basis = weight * evalBasis( norm2( point - m_node[m_patchNodes[k]] ) / supportRadius ) ;
+            if( basis == 0. ) continue ;
+
+            const double *nodeWeights = m_patchWeights.data() + k * nFields ;
+            for( int j = 0; j < nFields; ++j ){
+                values[j] += basis * nodeWeights[j] ;
+            }
+        }
+    }
+
+    if( weightSum > 0. ){
+        for( int j = 0; j < nFields; ++j ){
+            values[j] /= weightSum ;
+        }
+    }
+};
+
 //RBF NAMESPACE UTILITIES 
 
 /*! 
@@ -930,6 +2015,63 @@ double rbf::wendlandc2( const double &dist ){
 	
 }; 
 
+/*! 
+ * Evaluates the displacements defined by a list of RBFs. The fields/weights
+ * of the RBFs are taken in order as the components of the displacement (e.g.,
+ * three RBFs with one field each or a single RBF with three fields), hence
+ * their total number must be three.
+ * 
+ * Each RBF is evaluated on all the points with a single batched call, using
+ * the thread pool shared by the library. The displacements can be applied to
+ * the vertices of a patch with PatchKernel::displaceVertices, evaluating them
+ * on the vertex coordinates listed in the order of getVertices(). In a
+ * partitioned patch each process displaces its own vertices; vertices shared
+ * among processes have the same coordinates, hence they receive the same
+ * displacement as long as all processes use the same RBFs.
+ * 
+ * @param[in] rbfs RBFs defining the displacements
+ * @param[in] nPoints number of points
+ * @param[in] points coordinates of the points
+ * @param[out] displacements displacements of the points
+ * @return true if the displacements have been evaluated, false otherwise
+ */
+bool rbf::evalDisplacements( const std::vector<RBF *> &rbfs, std::size_t nPoints, const std::array<double,3> *points, std::array<double,3> *displacements ){
+
+    int nComponents = 0 ;
+    for( RBF *rbf : rbfs ){
+        nComponents += rbf->getDataCount() ;
+    }
+
+    if( nComponents != 3 ){
+        std::cout<<"The RBFs used for the displacements should define three displacement components."<<std::endl;
+        std::cout<<"The displacements could not be evaluated"<<std::endl;
+        return false;
+    }
+
+    if( rbfs.size() == 1 ){
+        rbfs[0]->evalRBF( nPoints, points, reinterpret_cast<double *>( displacements ) ) ;
+    } else {
+        std::vector<double> values ;
+        int offset = 0 ;
+        for( RBF *rbf : rbfs ){
+            int nFields = rbf->getDataCount() ;
+            if( nFields == 0 ) continue ;
+
+            values.resize( nPoints * nFields ) ;
+            rbf->evalRBF( nPoints, points, values.data() ) ;
+            for( std::size_t n = 0; n < nPoints; ++n ){
+                for( int j = 0; j < nFields; ++j ){
+                    displacements[n][offset + j] = values[n * nFields + j] ;
+                }
+            }
+
+            offset += nFields ;
+        }
+    }
+
+    return true ;
+};
+
 
 /*! 
  * @} 
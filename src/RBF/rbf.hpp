@@ -29,6 +29,8 @@
 #include <vector>
 #include <array>
 
+#include "memory_usage.hpp"
+
 
 namespace bitpit{
 
@@ -63,6 +65,7 @@ class RBF{
     int     m_nodes ;
 	RBFMode	m_mode;
     double  m_supportRadius ;
+    bool    m_compactSupport ;
 
     double  (*m_fPtr)( const double &);
 
@@ -77,7 +80,7 @@ class RBF{
 	std::vector<std::array<double,3>>   m_node ;    /**< list of RBF nodes */
 	
     public:
-    ~RBF();
+    virtual ~RBF();
     RBF( RBFBasisFunction = RBFBasisFunction::WENDLANDC2 ) ;
 	RBF(const RBF & other);
 	RBF & operator=(const RBF & other);
@@ -104,6 +107,8 @@ class RBF{
 	
 	void					setMode(RBFMode mode);
 	RBFMode					getMode();
+
+	virtual MemoryUsage		getMemoryUsage() const;
 	
 	void                    setDataToNode ( const int &, const std::vector<double> & ) ;
 	void                    setDataToAllNodes( const int &, const std::vector<double> & ) ; 
@@ -123,21 +128,76 @@ class RBF{
 	void					fitDataToNodes();
 	void 					fitDataToNodes(int);
 	
-    std::vector<double>     evalRBF( const std::array<double,3> &) ;
+    virtual std::vector<double> evalRBF( const std::array<double,3> &) ;
+    virtual void            evalRBF( std::size_t, const std::array<double,3> *, double * ) ;
 	double                  evalBasis( const double &) ;
 
-	int                    solve() ; 
-	int                    greedy( const double &) ;
+	virtual int            solve() ; 
+	int                    greedy( const double &, int = 1 ) ;
 
 protected:
 	
 	double                  evalError() ;
 	double                  initGreedy( const int &) ;
 	int                     addGreedyPoint() ;
+	std::vector<int>        addGreedyPoints( int ) ;
 	int                     solveLSQ() ;	
+	int                     solveDense( const std::vector<int> & ) ;
+	int                     solveSparse( const std::vector<int> &, const std::vector<long> &, const std::vector<int> &, const std::vector<double> & ) ;
+	void                    assembleSparse( const std::vector<int> &, std::vector<long> &, std::vector<int> &, std::vector<double> & ) ;
 	
 };
 
+class RBFPartitionOfUnity : public RBF {
+
+    private:
+    /*!
+     * @brief Node of the tree used to partition the RBF nodes
+     */
+    struct PartitionNode {
+        std::array<double,3>    nodeMin ;       /**< Lower corner of the bounding box of the RBF nodes */
+        std::array<double,3>    nodeMax ;       /**< Upper corner of the bounding box of the RBF nodes */
+        std::array<double,3>    patchMin ;      /**< Lower corner of the bounding box of the patches */
+        std::array<double,3>    patchMax ;      /**< Upper corner of the bounding box of the patches */
+        int                     begin ;         /**< Begin of the RBF nodes in the sorted node list */
+        int                     end ;           /**< End of the RBF nodes in the sorted node list */
+        std::array<int,2>       children ;      /**< Children of the node, negative for leaves */
+        int                     patch ;         /**< Patch associated with a leaf, negative for internal nodes */
+    };
+
+    int                                 m_patchNodeCount ;  /**< Maximum number of RBF nodes in the leaves of the partition */
+    double                              m_overlap ;         /**< Ratio between the radius of a patch and the half diagonal of its leaf */
+
+    std::vector<PartitionNode>          m_partition ;       /**< Tree partitioning the RBF nodes, the root is the first node */
+    std::vector<int>                    m_sortedNodes ;     /**< Active RBF nodes sorted by leaf */
+    std::vector<std::array<double,3>>   m_patchCenters ;    /**< Centers of the patches */
+    std::vector<double>                 m_patchRadii ;      /**< Radii of the patches */
+    std::vector<long>                   m_patchOffsets ;    /**< Offsets of the patches in the patch node list */
+    std::vector<int>                    m_patchNodes ;      /**< RBF nodes of each patch */
+    std::vector<double>                 m_patchWeights ;    /**< Local weights of the patch nodes, interleaved by field */
+
+    public:
+    RBFPartitionOfUnity( RBFBasisFunction = RBFBasisFunction::WENDLANDC2 ) ;
+
+    void                    setPatchNodeCount( int ) ;
+    int                     getPatchNodeCount() ;
+    void                    setPatchOverlap( double ) ;
+    double                  getPatchOverlap() ;
+    int                     getPatchCount() ;
+
+    MemoryUsage             getMemoryUsage() const ;
+
+    std::vector<double>     evalRBF( const std::array<double,3> &) ;
+    void                    evalRBF( std::size_t, const std::array<double,3> *, double * ) ;
+
+    int                     solve() ;
+
+    private:
+    int                     buildPartition( int, int ) ;
+    void                    findPatchNodes( const std::array<double,3> &, double, std::vector<int> & ) const ;
+    void                    evalPartition( const std::array<double,3> &, double * ) ;
+};
+
 
 
 /*!
@@ -146,6 +206,8 @@ protected:
  */
 namespace rbf{
 double                          wendlandc2( const double &) ;
+
+bool                            evalDisplacements( const std::vector<RBF *> &, std::size_t, const std::array<double,3> *, std::array<double,3> * ) ;
 }
 
 }
@@ -0,0 +1,687 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+// ========================================================================== //
+//                         - SORTING ALGORITHMS -                             //
+//                                                                            //
+// Balanced kd-tree built in bulk.                                            //
+// ========================================================================== //
+
+namespace bitpit{
+
+/*!
+ \ingroup   SortAlgorithms
+ \{
+ */
+
+// ========================================================================== //
+// TEMPLATE IMPLEMENTATIONS FOR BALANCEDKDTREE                                //
+// ========================================================================== //
+
+/*!
+
+    \ingroup   SortAlgorithms
+    \class BalancedKdTree
+    \brief class for balanced kd-tree data structure.
+
+    Sort vertices in a d-dimensional Euclidean space into a balanced kd-tree.
+
+    Unlike KdTree, which is filled by successive insertions and whose depth
+    depends on the insertion order, the tree is built in bulk from the whole
+    set of nodes. Nodes are stored by value in a single contiguous array
+    arranged as an implicit tree: the subtree of the range [begin, end) has
+    its root at position begin + (end - begin) / 2, the left subtree is the
+    range before the root and the right subtree is the range after it. Each
+    range is split along the direction of its largest extent, hence the depth
+    of the tree is log2(n) regardless of the distribution of the nodes and no
+    child pointers need to be stored.
+
+    The tree is immutable once built. All queries are const, do not allocate
+    memory other than their output and can be safely performed concurrently
+    from several threads.
+
+    Template parameters are:
+    - d, number dimensions (i.e. number of coordinates for vertices)
+    - T1, label type associated to each node in the kd-tree.
+
+    Template parameters can be any type fulfilling the following requirements:
+    1. T1 must be a copy-constructible type.
+
+*/
+
+// Constructors ============================================================= //
+
+// -------------------------------------------------------------------------- //
+/*!
+    Default constructor for class BalancedKdTree.
+
+    Initialize an empty kd-tree structure.
+*/
+template<int d, class T1>
+BalancedKdTree<d, T1>::BalancedKdTree(
+    void
+) {
+}
+
+// -------------------------------------------------------------------------- //
+/*!
+    Bulk constructor for class BalancedKdTree.
+
+    Build a balanced kd-tree from the specified set of nodes.
+
+    \param[in] points coordinates of the nodes
+    \param[in] labels labels of the nodes
+*/
+template<int d, class T1>
+BalancedKdTree<d, T1>::BalancedKdTree(
+    const std::vector< std::array<double, d> >  &points,
+    const std::vector< T1 >                     &labels
+) {
+
+build(points, labels);
+
+}
+
+// Methods ================================================================== //
+
+// -------------------------------------------------------------------------- //
+/*!
+    Build the kd-tree from the specified set of nodes, previous content of
+    the tree is discarded.
+
+    Subtrees of the top levels are built concurrently on the thread pool
+    shared by the library. The layout of the tree depends only on the input
+    nodes, hence it is the same for any number of threads.
+
+    \param[in] points coordinates of the nodes
+    \param[in] labels labels of the nodes, must have the same size of points
+*/
+template<int d, class T1>
+void BalancedKdTree<d, T1>::build(
+    const std::vector< std::array<double, d> >  &points,
+    const std::vector< T1 >                     &labels
+) {
+
+// ========================================================================== //
+// VARIABLES DECLARATION                                                      //
+// ========================================================================== //
+
+// Local variables
+std::size_t                     n = points.size();
+
+// Counters
+std::size_t                     i;
+
+// ========================================================================== //
+// COPY NODES                                                                 //
+// ========================================================================== //
+if (labels.size() != n) {
+    throw std::runtime_error("Number of labels does not match the number of points.");
+}
+
+m_nodes.clear();
+m_nodes.resize(n);
+for (i = 0; i < n; ++i) {
+    m_nodes[i].coords = points[i];
+    m_nodes[i].label  = labels[i];
+    m_nodes[i].dim    = 0;
+} //next i
+
+// ========================================================================== //
+// BUILD THE TREE                                                             //
+// ========================================================================== //
+buildRange(0, n, threads::getThreadCount());
+
+return; }
+
+// -------------------------------------------------------------------------- //
+/*!
+    Build the subtree associated to a range of nodes.
+
+    The range is split along the direction of its largest extent and the
+    median node, found by partial sorting, becomes the root of the subtree.
+
+    \param[in] begin begin of the range
+    \param[in] end end of the range
+    \param[in] nThreads number of threads available for the subtree
+*/
+template<int d, class T1>
+void BalancedKdTree<d, T1>::buildRange(
+    std::size_t                  begin,
+    std::size_t                  end,
+    int                          nThreads
+) {
+
+// ========================================================================== //
+// VARIABLES DECLARATION                                                      //
+// ========================================================================== //
+
+// Parameters
+const std::size_t               THREAD_THRESHOLD = 16384;
+
+// Local variables
+std::array<double, d>           xMin, xMax;
+std::size_t                     median;
+int                             dim;
+double                          extent;
+
+// Counters
+std::size_t                     i;
+int                             j;
+
+// ========================================================================== //
+// CHECK INPUT                                                                //
+// ========================================================================== //
+if (end <= begin) return;
+
+median = begin + (end - begin) / 2;
+if (end - begin == 1) return;
+
+// ========================================================================== //
+// SPLITTING DIRECTION                                                        //
+// ========================================================================== //
+xMin = m_nodes[begin].coords;
+xMax = m_nodes[begin].coords;
+for (i = begin + 1; i < end; ++i) {
+    const std::array<double, d> &coords = m_nodes[i].coords;
+    for (j = 0; j < d; ++j) {
+        xMin[j] = std::min(xMin[j], coords[j]);
+        xMax[j] = std::max(xMax[j], coords[j]);
+    } //next j
+} //next i
+
+dim    = 0;
+extent = xMax[0] - xMin[0];
+for (j = 1; j < d; ++j) {
+    if (xMax[j] - xMin[j] > extent) {
+        dim    = j;
+        extent = xMax[j] - xMin[j];
+    }
+} //next j
+
+// ========================================================================== //
+// SPLIT THE RANGE                                                            //
+// ========================================================================== //
+std::nth_element(m_nodes.begin() + begin, m_nodes.begin() + median, m_nodes.begin() + end,
+    [dim] (const Node &node_1, const Node &node_2) -> bool
+    {
+        return (node_1.coords[dim] < node_2.coords[dim]);
+    });
+m_nodes[median].dim = dim;
+
+// ========================================================================== //
+// BUILD THE SUBTREES                                                         //
+// ========================================================================== //
+if (nThreads > 1 && (end - begin) > THREAD_THRESHOLD) {
+    int leftThreads = nThreads / 2;
+    threads::parallelFor(2, 2, [&] (std::size_t first, std::size_t last) {
+        for (std::size_t side = first; side < last; ++side) {
+            if (side == 0) {
+                buildRange(begin, median, leftThreads);
+            }
+            else {
+                buildRange(median + 1, end, nThreads - leftThreads);
+            }
+        } //next side
+    });
+}
+else {
+    buildRange(begin, median, 1);
+    buildRange(median + 1, end, 1);
+}
+
+return; }
+
+// -------------------------------------------------------------------------- //
+/*!
+    Clear kd-tree content and release memory.
+*/
+template<int d, class T1>
+void BalancedKdTree<d, T1>::clear(
+    void
+) {
+
+std::vector< Node >().swap(m_nodes);
+
+return; }
+
+// -------------------------------------------------------------------------- //
+/*!
+    Get the number of nodes in the kd-tree.
+
+    \result number of nodes
+*/
+template<int d, class T1>
+std::size_t BalancedKdTree<d, T1>::size(
+    void
+) const {
+
+return m_nodes.size();
+
+}
+
+// -------------------------------------------------------------------------- //
+/*!
+    Get a node of the kd-tree.
+
+    Queries identify nodes by their index in the kd-tree, this function
+    gives access to the coordinates and the label of the node.
+
+    \param[in] index index of the node
+    \result node of the kd-tree
+*/
+template<int d, class T1>
+const typename BalancedKdTree<d, T1>::Node & BalancedKdTree<d, T1>::getNode(
+    std::size_t                  index
+) const {
+
+return m_nodes[index];
+
+}
+
+// -------------------------------------------------------------------------- //
+/*!
+    Find the node of the kd-tree nearest to a given point.
+
+    Ties are broken in favour of the node with the lowest index, so the
+    result does not depend on the traversal order.
+
+    \param[in] point query point
+    \param[out] distance if not NULL, on output stores the distance between
+    the query point and the nearest node
+    \result index of the nearest node, -1 if the tree is empty
+*/
+template<int d, class T1>
+int BalancedKdTree<d, T1>::nearest(
+    const std::array<double, d> &point,
+    double                      *distance
+) const {
+
+// ========================================================================== //
+// VARIABLES DECLARATION                                                      //
+// ========================================================================== //
+
+// Local variables
+std::array<std::size_t, 2*128>  stack;
+std::array<double, 128>         stackDistance;
+int                             stackSize;
+int                             best;
+double                          bestDistance;
+
+// Counters
+int                             j;
+
+// ========================================================================== //
+// TRAVERSE THE TREE                                                          //
+// ========================================================================== //
+
+// The depth of a balanced tree is log2(n), the stack can never hold more
+// than one pending subtree per level.
+best         = -1;
+bestDistance = std::numeric_limits<double>::max();
+
+stackSize        = 1;
+stack[0]         = 0;
+stack[1]         = m_nodes.size();
+stackDistance[0] = 0.;
+while (stackSize > 0) {
+    --stackSize;
+    std::size_t begin = stack[2 * stackSize];
+    std::size_t end   = stack[2 * stackSize + 1];
+    if (end <= begin || stackDistance[stackSize] > bestDistance) continue;
+
+    std::size_t median = begin + (end - begin) / 2;
+    const Node &node   = m_nodes[median];
+
+    double nodeDistance = 0.;
+    for (j = 0; j < d; ++j) {
+        double delta = point[j] - node.coords[j];
+        nodeDistance += delta * delta;
+    } //next j
+
+    if (nodeDistance < bestDistance || (nodeDistance == bestDistance && (int) median < best)) {
+        best         = median;
+        bestDistance = nodeDistance;
+    }
+
+    // Push the far subtree first, so that the near one is visited first
+    double delta      = point[node.dim] - node.coords[node.dim];
+    double planeDistance = delta * delta;
+    if (delta <= 0.) {
+        stack[2 * stackSize] = median + 1; stack[2 * stackSize + 1] = end;
+        stackDistance[stackSize++] = planeDistance;
+        stack[2 * stackSize] = begin; stack[2 * stackSize + 1] = median;
+        stackDistance[stackSize++] = 0.;
+    }
+    else {
+        stack[2 * stackSize] = begin; stack[2 * stackSize + 1] = median;
+        stackDistance[stackSize++] = planeDistance;
+        stack[2 * stackSize] = median + 1; stack[2 * stackSize + 1] = end;
+        stackDistance[stackSize++] = 0.;
+    }
+} //next item
+
+if (distance != NULL) {
+    *distance = (best >= 0) ? std::sqrt(bestDistance) : std::numeric_limits<double>::max();
+}
+
+return best; }
+
+// -------------------------------------------------------------------------- //
+/*!
+    Find the k nodes of the kd-tree nearest to a given point.
+
+    Nodes are returned sorted by increasing distance from the query point,
+    ties are broken in favour of the node with the lowest index. If the tree
+    holds less than k nodes, all the nodes are returned.
+
+    \param[in] point query point
+    \param[in] k number of nodes to find
+    \param[out] neighs on output stores the indices of the nearest nodes
+    \param[out] distances if not NULL, on output stores the distances
+    between the query point and the nearest nodes
+*/
+template<int d, class T1>
+void BalancedKdTree<d, T1>::kNearest(
+    const std::array<double, d> &point,
+    int                          k,
+    std::vector<int>            &neighs,
+    std::vector<double>         *distances
+) const {
+
+// ========================================================================== //
+// VARIABLES DECLARATION                                                      //
+// ========================================================================== //
+
+// Local variables
+typedef std::pair<double, int>  Candidate;
+
+std::array<std::size_t, 2*128>  stack;
+std::array<double, 128>         stackDistance;
+int                             stackSize;
+std::vector<Candidate>          heap;
+double                          bound;
+
+// Counters
+int                             j;
+
+// ========================================================================== //
+// INITIALIZE OUTPUT                                                          //
+// ========================================================================== //
+neighs.clear();
+if (distances != NULL) distances->clear();
+
+k = std::min(k, (int) m_nodes.size());
+if (k <= 0) return;
+
+// ========================================================================== //
+// TRAVERSE THE TREE                                                          //
+// ========================================================================== //
+
+// Candidates are kept in a max-heap ordered by (distance, index), the top
+// of the heap is the worst candidate found so far.
+heap.reserve(k);
+bound = std::numeric_limits<double>::max();
+
+stackSize        = 1;
+stack[0]         = 0;
+stack[1]         = m_nodes.size();
+stackDistance[0] = 0.;
+while (stackSize > 0) {
+    --stackSize;
+    std::size_t begin = stack[2 * stackSize];
+    std::size_t end   = stack[2 * stackSize + 1];
+    if (end <= begin || stackDistance[stackSize] > bound) continue;
+
+    std::size_t median = begin + (end - begin) / 2;
+    const Node &node   = m_nodes[median];
+
+    double nodeDistance = 0.;
+    for (j = 0; j < d; ++j) {
+        double delta = point[j] - node.coords[j];
+        nodeDistance += delta * delta;
+    } //next j
+
+    Candidate candidate(nodeDistance, (int) median);
+    if ((int) heap.size() < k) {
+        heap.push_back(candidate);
+        std::push_heap(heap.begin(), heap.end());
+        if ((int) heap.size() == k) bound = heap.front().first;
+    }
+    else if (candidate < heap.front()) {
+        std::pop_heap(heap.begin(), heap.end());
+        heap.back() = candidate;
+        std::push_heap(heap.begin(), heap.end());
+        bound = heap.front().first;
+    }
+
+    // Push the far subtree first, so that the near one is visited first
+    double delta         = point[node.dim] - node.coords[node.dim];
+    double planeDistance = delta * delta;
+    if (delta <= 0.) {
+        stack[2 * stackSize] = median + 1; stack[2 * stackSize + 1] = end;
+        stackDistance[stackSize++] = planeDistance;
+        stack[2 * stackSize] = begin; stack[2 * stackSize + 1] = median;
+        stackDistance[stackSize++] = 0.;
+    }
+    else {
+        stack[2 * stackSize] = begin; stack[2 * stackSize + 1] = median;
+        stackDistance[stackSize++] = planeDistance;
+        stack[2 * stackSize] = median + 1; stack[2 * stackSize + 1] = end;
+        stackDistance[stackSize++] = 0.;
+    }
+} //next item
+
+// ========================================================================== //
+// SORT CANDIDATES                                                            //
+// ========================================================================== //
+std::sort_heap(heap.begin(), heap.end());
+
+neighs.reserve(heap.size());
+for (const Candidate &candidate : heap) {
+    neighs.push_back(candidate.second);
+} //next candidate
+
+if (distances != NULL) {
+    distances->reserve(heap.size());
+    for (const Candidate &candidate : heap) {
+        distances->push_back(std::sqrt(candidate.first));
+    } //next candidate
+}
+
+return; }
+
+// -------------------------------------------------------------------------- //
+/*!
+    Find the nodes of the kd-tree whose distance from a given point is less
+    than or equal to the specified radius.
+
+    Nodes are returned in the order they are found by the traversal, which
+    depends only on the content of the tree and on the query point.
+
+    \param[in] point center of the ball
+    \param[in] radius radius of the ball
+    \param[out] neighs on output stores the indices of the nodes in the ball
+*/
+template<int d, class T1>
+void BalancedKdTree<d, T1>::radiusSearch(
+    const std::array<double, d> &point,
+    double                       radius,
+    std::vector<int>            &neighs
+) const {
+
+// ========================================================================== //
+// VARIABLES DECLARATION                                                      //
+// ========================================================================== //
+
+// Local variables
+std::array<std::size_t, 2*128>  stack;
+int                             stackSize;
+double                          radius2 = radius * radius;
+
+// Counters
+int                             j;
+
+// ========================================================================== //
+// TRAVERSE THE TREE                                                          //
+// ========================================================================== //
+neighs.clear();
+
+stackSize = 1;
+stack[0]  = 0;
+stack[1]  = m_nodes.size();
+while (stackSize > 0) {
+    --stackSize;
+    std::size_t begin = stack[2 * stackSize];
+    std::size_t end   = stack[2 * stackSize + 1];
+    if (end <= begin) continue;
+
+    std::size_t median = begin + (end - begin) / 2;
+    const Node &node   = m_nodes[median];
+
+    double nodeDistance = 0.;
+    for (j = 0; j < d; ++j) {
+        double delta = point[j] - node.coords[j];
+        nodeDistance += delta * delta;
+    } //next j
+
+    if (nodeDistance <= radius2) {
+        neighs.push_back((int) median);
+    }
+
+    // Nodes equal to the splitting coordinate may lie on both sides
+    double delta = point[node.dim] - node.coords[node.dim];
+    if (delta >= -radius) {
+        stack[2 * stackSize] = median + 1; stack[2 * stackSize + 1] = end;
+        ++stackSize;
+    }
+    if (delta <= radius) {
+        stack[2 * stackSize] = begin; stack[2 * stackSize + 1] = median;
+        ++stackSize;
+    }
+} //next item
+
+return; }
+
+// -------------------------------------------------------------------------- //
+/*!
+    Find the nodes of the kd-tree whose distance from a set of points is less
+    than or equal to the specified radius.
+
+    Results are stored in compressed form: the nodes found for the i-th
+    point are neighs[offsets[i]], ..., neighs[offsets[i+1] - 1]. Points are
+    split in contiguous chunks among the threads of the pool shared by the
+    library and the results of the chunks are concatenated in order, hence
+    the output is the same for any number of threads.
+
+    \param[in] nPoints number of points
+    \param[in] points centers of the balls
+    \param[in] radius radius of the balls
+    \param[out] offsets on output stores the offsets of each point in the
+    list of nodes, its size is nPoints + 1
+    \param[out] neighs on output stores the indices of the nodes in the balls
+*/
+template<int d, class T1>
+void BalancedKdTree<d, T1>::radiusSearch(
+    std::size_t                  nPoints,
+    const std::array<double, d> *points,
+    double                       radius,
+    std::vector<long>           &offsets,
+    std::vector<int>            &neighs
+) const {
+
+// ========================================================================== //
+// VARIABLES DECLARATION                                                      //
+// ========================================================================== //
+
+// Local variables
+int                                         nThreads;
+std::size_t                                 chunkSize;
+int                                         nChunks;
+std::vector< std::vector<long> >            chunkCounts;
+std::vector< std::vector<int> >             chunkNeighs;
+
+// Counters
+int                                         n;
+std::size_t                                 i;
+
+// ========================================================================== //
+// SEARCH CHUNKS OF POINTS                                                    //
+// ========================================================================== //
+offsets.assign(nPoints + 1, 0);
+neighs.clear();
+if (nPoints == 0) return;
+
+nThreads  = std::min(threads::getThreadCount(), (int) nPoints);
+chunkSize = (nPoints + nThreads - 1) / nThreads;
+nChunks   = (int) ((nPoints + chunkSize - 1) / chunkSize);
+
+chunkCounts.resize(nChunks);
+chunkNeighs.resize(nChunks);
+
+auto searchChunk = [&] (int chunk) {
+    std::size_t begin = chunk * chunkSize;
+    std::size_t end   = std::min(nPoints, begin + chunkSize);
+
+    std::vector<int>  pointNeighs;
+    std::vector<long> &counts = chunkCounts[chunk];
+    std::vector<int>  &found  = chunkNeighs[chunk];
+    counts.resize(end - begin);
+    for (std::size_t p = begin; p < end; ++p) {
+        radiusSearch(points[p], radius, pointNeighs);
+        counts[p - begin] = pointNeighs.size();
+        found.insert(found.end(), pointNeighs.begin(), pointNeighs.end());
+    } //next p
+};
+
+threads::parallelFor(nChunks, nChunks, [&] (std::size_t first, std::size_t last) {
+    for (std::size_t chunk = first; chunk < last; ++chunk) {
+        searchChunk(chunk);
+    } //next chunk
+});
+
+// ========================================================================== //
+// MERGE RESULTS                                                              //
+// ========================================================================== //
+i = 0;
+for (n = 0; n < nChunks; ++n) {
+    for (long count : chunkCounts[n]) {
+        offsets[i + 1] = offsets[i] + count;
+        ++i;
+    } //next count
+} //next n
+
+neighs.reserve(offsets[nPoints]);
+for (n = 0; n < nChunks; ++n) {
+    neighs.insert(neighs.end(), chunkNeighs[n].begin(), chunkNeighs[n].end());
+    std::vector<int>().swap(chunkNeighs[n]);
+} //next n
+
+return; }
+
+/*!
+ \}
+ */
+
+}
@@ -46,12 +46,16 @@
 # include <vector>
 # include <string>
 # include <iostream>
+# include <algorithm>
+# include <limits>
+# include <stdexcept>
 
 // Classes
 // none
 
 // bitpit
 # include "Operators.hpp"
+# include "thread_pool.hpp"
 
 namespace bitpit{
 
@@ -161,6 +165,82 @@ class KdTree {
 
 };
 
+// Balanced kd-tree --------------------------------------------------------- //
+template <int d, class T1 = long>
+class BalancedKdTree {
+
+    // Members ============================================================== //
+    public:
+    /*!
+        \brief Node of a balanced kd-tree.
+    */
+    struct Node {
+        std::array<double, d>           coords;                               /**< coordinates of the node */
+        T1                              label;                                /**< label of the node */
+        int                             dim;                                  /**< splitting direction */
+    };
+
+    private:
+    std::vector< Node >                 m_nodes;                              /**< kd-tree nodes, sorted as an implicit balanced tree */
+
+    // Constructors ========================================================= //
+    public:
+    BalancedKdTree(                                                           // Default constructor for BalancedKdTree
+        void                                                                  // (input) none
+    );
+    BalancedKdTree(                                                           // Bulk constructor for BalancedKdTree
+        const std::vector< std::array<double, d> >  &,                        // (input) coordinates of the nodes
+        const std::vector< T1 >                     &                         // (input) labels of the nodes
+    );
+
+    // Methods ============================================================== //
+    public:
+    void build(                                                               // Build the kd-tree from a set of nodes
+        const std::vector< std::array<double, d> >  &,                        // (input) coordinates of the nodes
+        const std::vector< T1 >                     &                         // (input) labels of the nodes
+    );
+    void clear(                                                               // Clear kd-tree content
+        void                                                                  // (input) none
+    );
+    std::size_t size(                                                         // Number of nodes in the kd-tree
+        void                                                                  // (input) none
+    ) const;
+    const Node & getNode(                                                     // Get a node of the kd-tree
+        std::size_t                                                           // (input) index of the node
+    ) const;
+
+    int nearest(                                                              // Find the nearest node
+        const std::array<double, d>                 &,                        // (input) query point
+        double                                      *distance = NULL          // (output/optional) distance of the nearest node
+    ) const;
+    void kNearest(                                                            // Find the k nearest nodes
+        const std::array<double, d>                 &,                        // (input) query point
+        int                                          ,                        // (input) number of nodes
+        std::vector<int>                            &,                        // (output) nodes sorted by distance
+        std::vector<double>                         *distances = NULL         // (output/optional) distances of the nodes
+    ) const;
+    void radiusSearch(                                                        // Find the nodes in a ball
+        const std::array<double, d>                 &,                        // (input) center of the ball
+        double                                       ,                        // (input) radius of the ball
+        std::vector<int>                            &                         // (output) nodes in the ball
+    ) const;
+    void radiusSearch(                                                        // Find the nodes in a set of balls
+        std::size_t                                  ,                        // (input) number of balls
+        const std::array<double, d>                 *,                        // (input) centers of the balls
+        double                                       ,                        // (input) radius of the balls
+        std::vector<long>                           &,                        // (output) offsets of each ball in the node list
+        std::vector<int>                            &                         // (output) nodes in the balls
+    ) const;
+
+    private:
+    void buildRange(                                                          // Build the subtree of a range of nodes
+        std::size_t                                  ,                        // (input) begin of the range
+        std::size_t                                  ,                        // (input) end of the range
+        int                                                                   // (input) number of threads
+    );
+
+};
+
 // min PQUEUE --------------------------------------------------------------- //
 template <class T, class T1 = T>
 class MinPQueue {
@@ -386,6 +466,7 @@ class LIFOStack {
 # include "LIFOStack.tpp"
 # include "PQueue.tpp"
 # include "KdTree.tpp"
+# include "BalancedKdTree.tpp"
 
 
 
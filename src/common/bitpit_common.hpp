@@ -41,5 +41,7 @@
 #include "compiler.hpp"
 #include "utils.hpp"
 #include "utils.tpp"
+#include "thread_pool.hpp"
+#include "memory_usage.hpp"
 
 #endif
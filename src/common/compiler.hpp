@@ -49,6 +49,15 @@ do {                         \
 #define BITPIT_UNREACHABLE(str)
 #endif
 
+/*!
+ * Deprecated macro. Marks the declaration of a function as deprecated.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define BITPIT_DEPRECATED(func) func __attribute__((deprecated))
+#else
+#define BITPIT_DEPRECATED(func) func
+#endif
+
 /*!
  * Unused macro.
  */
@@ -0,0 +1,246 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+#include "memory_usage.hpp"
+
+namespace bitpit {
+
+/*!
+	\ingroup commonUtils
+	@{
+*/
+
+/*!
+	\class MemoryUsage
+
+	\brief The MemoryUsage class describes the memory used by an object,
+	broken down by component.
+
+	A memory usage has a name, an amount of memory owned directly and a
+	list of components, that are memory usages themselves. The memory used
+	by an object is the sum of the memory it owns directly and of the
+	memory used by its components.
+
+	Memory is evaluated from the capacity of the containers, hence the
+	memory that is allocated but not used (e.g., the holes of a pierced
+	vector or the capacity reserved by a vector) is accounted for. The
+	memory used by node-based containers is estimated.
+*/
+
+/*!
+	Formats the specified amount of memory using binary prefixes.
+
+	\param bytes is the amount of memory, expressed in bytes
+	\result The formatted amount of memory.
+*/
+std::string MemoryUsage::formatBytes(double bytes)
+{
+	static const std::vector<std::string> UNITS = {"B", "KiB", "MiB", "GiB", "TiB"};
+
+	std::size_t unit = 0;
+	while (bytes >= 1024. && unit < UNITS.size() - 1) {
+		bytes /= 1024.;
+		++unit;
+	}
+
+	std::ostringstream stream;
+	if (unit == 0) {
+		stream << std::fixed << std::setprecision(0) << bytes << " " << UNITS[unit];
+	} else {
+		stream << std::fixed << std::setprecision(2) << bytes << " " << UNITS[unit];
+	}
+
+	return stream.str();
+}
+
+/*!
+	Creates a new memory usage.
+
+	\param name is the name of the object
+	\param bytes is the memory, expressed in bytes, owned directly by the
+	object
+*/
+MemoryUsage::MemoryUsage(const std::string &name, std::size_t bytes)
+	: m_name(name), m_bytes(bytes)
+{
+}
+
+/*!
+	Gets the name of the object.
+
+	\result The name of the object.
+*/
+const std::string & MemoryUsage::getName() const
+{
+	return m_name;
+}
+
+/*!
+	Sets the name of the object.
+
+	\param name is the name of the object
+*/
+void MemoryUsage::setName(const std::string &name)
+{
+	m_name = name;
+}
+
+/*!
+	Gets the memory used by the object, including the memory used by its
+	components.
+
+	\result The memory, expressed in bytes, used by the object.
+*/
+std::size_t MemoryUsage::getBytes() const
+{
+	std::size_t bytes = m_bytes;
+	for (const MemoryUsage &component : m_components) {
+		bytes += component.getBytes();
+	}
+
+	return bytes;
+}
+
+/*!
+	Adds the specified amount to the memory owned directly by the object.
+
+	\param bytes is the memory, expressed in bytes, to add
+*/
+void MemoryUsage::addBytes(std::size_t bytes)
+{
+	m_bytes += bytes;
+}
+
+/*!
+	Adds a component.
+
+	\param name is the name of the component
+	\param bytes is the memory, expressed in bytes, owned directly by the
+	component
+	\result The component that has been added.
+*/
+MemoryUsage & MemoryUsage::addComponent(const std::string &name, std::size_t bytes)
+{
+	m_components.emplace_back(name, bytes);
+
+	return m_components.back();
+}
+
+/*!
+	Adds a component.
+
+	\param name is the name of the component
+	\param usage is the memory usage of the component, its name is replaced
+	by the specified name
+	\result The component that has been added.
+*/
+MemoryUsage & MemoryUsage::addComponent(const std::string &name, const MemoryUsage &usage)
+{
+	m_components.push_back(usage);
+	m_components.back().setName(name);
+
+	return m_components.back();
+}
+
+/*!
+	Gets the components.
+
+	\result The components.
+*/
+const std::vector<MemoryUsage> & MemoryUsage::getComponents() const
+{
+	return m_components;
+}
+
+/*!
+	Displays the memory usage, each component is displayed below its
+	parent.
+
+	\param out is the output stream
+	\param padding is the number of leading spaces
+*/
+void MemoryUsage::display(std::ostream &out, unsigned int padding) const
+{
+	display(out, std::string(padding, ' '), 0, evalNameWidth(0));
+}
+
+/*!
+	Evaluates the width needed for displaying the names of the object and
+	of its components.
+
+	\param depth is the depth of the object
+	\result The width needed for displaying the names.
+*/
+std::size_t MemoryUsage::evalNameWidth(std::size_t depth) const
+{
+	std::size_t width = 2 * depth + m_name.size();
+	for (const MemoryUsage &component : m_components) {
+		width = std::max(width, component.evalNameWidth(depth + 1));
+	}
+
+	return width;
+}
+
+/*!
+	Displays the memory usage.
+
+	\param out is the output stream
+	\param indent is the indentation
+	\param depth is the depth of the object
+	\param width is the width of the names
+*/
+void MemoryUsage::display(std::ostream &out, const std::string &indent, std::size_t depth, std::size_t width) const
+{
+	std::string name = std::string(2 * depth, ' ') + m_name;
+	out << indent << std::left << std::setw(width + 2) << name << std::right << formatBytes(getBytes()) << std::endl;
+
+	for (const MemoryUsage &component : m_components) {
+		component.display(out, indent, depth + 1, width);
+	}
+}
+
+/*!
+	@}
+*/
+
+namespace utils {
+
+/*!
+	Evaluates the memory allocated by a vector of booleans.
+
+	\param container is the vector
+	\result The memory, expressed in bytes, allocated by the vector.
+*/
+std::size_t evalMemorySize(const std::vector<bool> &container)
+{
+	return (container.capacity() + 7) / 8;
+}
+
+}
+
+}
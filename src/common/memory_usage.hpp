@@ -0,0 +1,90 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#ifndef __BITPIT_MEMORY_USAGE_HPP__
+#define __BITPIT_MEMORY_USAGE_HPP__
+
+#include <cstddef>
+#include <map>
+#include <ostream>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace bitpit {
+
+class MemoryUsage {
+
+public:
+	static std::string formatBytes(double bytes);
+
+	MemoryUsage(const std::string &name = "", std::size_t bytes = 0);
+
+	const std::string & getName() const;
+	void setName(const std::string &name);
+
+	std::size_t getBytes() const;
+	void addBytes(std::size_t bytes);
+
+	MemoryUsage & addComponent(const std::string &name, std::size_t bytes = 0);
+	MemoryUsage & addComponent(const std::string &name, const MemoryUsage &usage);
+	const std::vector<MemoryUsage> & getComponents() const;
+
+	void display(std::ostream &out, unsigned int padding = 0) const;
+
+private:
+	std::string m_name;
+	std::size_t m_bytes;
+	std::vector<MemoryUsage> m_components;
+
+	std::size_t evalNameWidth(std::size_t depth) const;
+	void display(std::ostream &out, const std::string &indent, std::size_t depth, std::size_t width) const;
+
+};
+
+namespace utils {
+
+template<typename T>
+std::size_t evalMemorySize(const std::vector<T> &container);
+std::size_t evalMemorySize(const std::vector<bool> &container);
+
+template<typename Key, typename T, typename Hash, typename Equal, typename Allocator>
+std::size_t evalMemorySize(const std::unordered_map<Key, T, Hash, Equal, Allocator> &container);
+template<typename Key, typename Hash, typename Equal, typename Allocator>
+std::size_t evalMemorySize(const std::unordered_set<Key, Hash, Equal, Allocator> &container);
+
+template<typename Key, typename T, typename Compare, typename Allocator>
+std::size_t evalMemorySize(const std::map<Key, T, Compare, Allocator> &container);
+template<typename Key, typename Compare, typename Allocator>
+std::size_t evalMemorySize(const std::set<Key, Compare, Allocator> &container);
+
+}
+
+}
+
+#include "memory_usage.tpp"
+
+#endif
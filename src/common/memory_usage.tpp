@@ -0,0 +1,115 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#ifndef __BITPIT_MEMORY_USAGE_TPP__
+#define __BITPIT_MEMORY_USAGE_TPP__
+
+namespace bitpit {
+
+namespace utils {
+
+/*!
+	Evaluates the memory allocated by a vector.
+
+	Only the storage of the vector is accounted for, memory allocated by
+	the elements themselves is not.
+
+	\param container is the vector
+	\result The memory, expressed in bytes, allocated by the vector.
+*/
+template<typename T>
+std::size_t evalMemorySize(const std::vector<T> &container)
+{
+	return container.capacity() * sizeof(T);
+}
+
+/*!
+	Estimates the memory allocated by an unordered map.
+
+	The estimate accounts for the buckets and for a node for each element,
+	the node contains the element, the link to the next node and the hash
+	of the key.
+
+	\param container is the unordered map
+	\result An estimate of the memory, expressed in bytes, allocated by the
+	unordered map.
+*/
+template<typename Key, typename T, typename Hash, typename Equal, typename Allocator>
+std::size_t evalMemorySize(const std::unordered_map<Key, T, Hash, Equal, Allocator> &container)
+{
+	typedef typename std::unordered_map<Key, T, Hash, Equal, Allocator>::value_type value_type;
+
+	return (container.bucket_count() * sizeof(void *) + container.size() * (sizeof(value_type) + sizeof(void *) + sizeof(std::size_t)));
+}
+
+/*!
+	Estimates the memory allocated by an unordered set.
+
+	\param container is the unordered set
+	\result An estimate of the memory, expressed in bytes, allocated by the
+	unordered set.
+*/
+template<typename Key, typename Hash, typename Equal, typename Allocator>
+std::size_t evalMemorySize(const std::unordered_set<Key, Hash, Equal, Allocator> &container)
+{
+	return (container.bucket_count() * sizeof(void *) + container.size() * (sizeof(Key) + sizeof(void *) + sizeof(std::size_t)));
+}
+
+/*!
+	Estimates the memory allocated by a map.
+
+	The estimate accounts for a node for each element, the node contains
+	the element, the links to the parent and to the children and the color
+	of the node.
+
+	\param container is the map
+	\result An estimate of the memory, expressed in bytes, allocated by the
+	map.
+*/
+template<typename Key, typename T, typename Compare, typename Allocator>
+std::size_t evalMemorySize(const std::map<Key, T, Compare, Allocator> &container)
+{
+	typedef typename std::map<Key, T, Compare, Allocator>::value_type value_type;
+
+	return (container.size() * (sizeof(value_type) + 4 * sizeof(void *)));
+}
+
+/*!
+	Estimates the memory allocated by a set.
+
+	\param container is the set
+	\result An estimate of the memory, expressed in bytes, allocated by the
+	set.
+*/
+template<typename Key, typename Compare, typename Allocator>
+std::size_t evalMemorySize(const std::set<Key, Compare, Allocator> &container)
+{
+	return (container.size() * (sizeof(Key) + 4 * sizeof(void *)));
+}
+
+}
+
+}
+
+#endif
@@ -0,0 +1,361 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <exception>
+#include <memory>
+
+#include "thread_pool.hpp"
+
+namespace bitpit {
+
+namespace {
+
+/*!
+	State of a parallel loop shared among the threads that process its
+	chunks.
+*/
+struct ParallelLoop {
+	ParallelLoop(std::size_t n, std::size_t nChunks, std::size_t chunkSize,
+	             const ThreadPool::ChunkFunction &function)
+		: n(n), nChunks(nChunks), chunkSize(chunkSize), function(function),
+		  nextChunk(0), nCompleted(0), errors(nChunks)
+	{
+	}
+
+	std::size_t n;
+	std::size_t nChunks;
+	std::size_t chunkSize;
+	const ThreadPool::ChunkFunction &function;
+
+	std::atomic<std::size_t> nextChunk;
+	std::size_t nCompleted;
+	std::vector<std::exception_ptr> errors;
+
+	std::mutex mutex;
+	std::condition_variable completed;
+
+	/*!
+		Processes chunks until there are chunks left to be processed.
+
+		The function is accessed only after having taken a chunk, hence
+		helpers that start after the loop has ended do not access it.
+	*/
+	void process()
+	{
+		while (true) {
+			std::size_t chunk = nextChunk++;
+			if (chunk >= nChunks) {
+				return;
+			}
+
+			std::size_t begin = chunk * chunkSize;
+			std::size_t end   = std::min(begin + chunkSize, n);
+			try {
+				function(begin, end);
+			} catch (...) {
+				errors[chunk] = std::current_exception();
+			}
+
+			std::lock_guard<std::mutex> lock(mutex);
+			++nCompleted;
+			if (nCompleted == nChunks) {
+				completed.notify_all();
+			}
+		}
+	}
+};
+
+}
+
+/*!
+	\ingroup commonUtils
+	@{
+*/
+
+/*!
+	\class ThreadPool
+
+	\brief The ThreadPool class runs parallel loops on a set of persistent
+	threads.
+
+	Loops are split in contiguous chunks whose bounds depend only on the
+	size of the loop and on the number of chunks, chunks are dispatched to
+	the threads of the pool and to the calling thread. The threads are
+	created once, when the pool is created, hence a loop only pays the
+	cost of waking up the workers.
+
+	Parallel loops can be nested: a thread that runs a loop from inside a
+	chunk processes the chunks of the inner loop itself, while the idle
+	threads of the pool help it.
+
+	The pool shared by the library is accessed through the functions of
+	the threads namespace. Its number of threads is read from the
+	BITPIT_NUM_THREADS environment variable, if it is defined, otherwise
+	the pool runs on the calling thread only: threads are never started
+	unless the user asks for them, hence serial programs and MPI jobs
+	that already fill the cores of the nodes are not oversubscribed. The
+	number of threads can be changed with threads::setThreadCount, for
+	example to run one process per socket and one thread per core.
+
+	Within the library, the pool runs the collapse of coincident vertices
+	and the renumbering of PatchKernel, the parsing of STL and DGF files,
+	the build and the batched queries of BalancedKdTree, the evaluation of
+	the narrow band of LevelSetSegmentation, the fast sweeping of
+	LevelSetCartesian, the batched evaluation of the RBFs and the solution
+	of the patches of RBFPartitionOfUnity. The update of adjacencies and
+	interfaces, and the global solve of RBF, are serial. Code of the library
+	that needs threads should run its loops on the shared pool rather than
+	starting threads of its own, so that the number of threads of the
+	process is controlled from a single place.
+
+	Thread safety: functions passed to a parallel loop may call, from
+	different threads at the same time, all the const member functions of
+	the library objects they use, as long as no thread modifies those
+	objects during the loop. In particular, the queries of PatchKernel
+	that do not modify the patch are safe. Functions that modify an object
+	(for example adding, deleting or updating elements of a patch, or
+	writing the patch) need external synchronization.
+*/
+
+/*!
+	Evaluates the size of the chunks used to split a range.
+
+	\param nChunks is the requested number of chunks, it is limited to the
+	size of the range
+	\param n is the size of the range
+	\result The size of the chunks, only the last chunk can be smaller.
+*/
+std::size_t ThreadPool::evalChunkSize(int nChunks, std::size_t n)
+{
+	if (n == 0) {
+		return 0;
+	}
+
+	std::size_t nEffectiveChunks = std::max(1, nChunks);
+	nEffectiveChunks = std::min(nEffectiveChunks, n);
+
+	return (n + nEffectiveChunks - 1) / nEffectiveChunks;
+}
+
+/*!
+	Creates a new thread pool.
+
+	The calling thread takes part in the loops, hence the pool creates
+	nThreads - 1 workers.
+
+	\param nThreads is the number of threads of the pool
+*/
+ThreadPool::ThreadPool(int nThreads)
+	: m_stop(false)
+{
+	for (int k = 1; k < nThreads; ++k) {
+		m_workers.emplace_back(&ThreadPool::work, this);
+	}
+}
+
+/*!
+	Destroys the thread pool.
+
+	Pending loops should be completed before the destruction of the pool.
+*/
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_condition.notify_all();
+
+	for (std::thread &worker : m_workers) {
+		worker.join();
+	}
+}
+
+/*!
+	Gets the number of threads of the pool, including the calling thread.
+
+	\result The number of threads of the pool.
+*/
+int ThreadPool::getThreadCount() const
+{
+	return (m_workers.size() + 1);
+}
+
+/*!
+	Applies a function to contiguous chunks of the range [0, n).
+
+	\param nChunks is the number of chunks
+	\param n is the size of the range
+	\param function is the function to apply, it receives the begin and
+	the end of the chunk
+*/
+void ThreadPool::run(int nChunks, std::size_t n, const ChunkFunction &function)
+{
+	if (n == 0) {
+		return;
+	}
+
+	std::size_t chunkSize = evalChunkSize(nChunks, n);
+	std::size_t nEffectiveChunks = (n + chunkSize - 1) / chunkSize;
+
+	// Serial loop
+	if (nEffectiveChunks == 1 || m_workers.empty()) {
+		for (std::size_t begin = 0; begin < n; begin += chunkSize) {
+			function(begin, std::min(begin + chunkSize, n));
+		}
+
+		return;
+	}
+
+	// Parallel loop
+	//
+	// The loop is shared with the helpers, that may start processing it
+	// after it has been completed by the other threads.
+	std::shared_ptr<ParallelLoop> loop = std::make_shared<ParallelLoop>(n, nEffectiveChunks, chunkSize, function);
+
+	std::size_t nHelpers = std::min(nEffectiveChunks - 1, m_workers.size());
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (std::size_t k = 0; k < nHelpers; ++k) {
+			m_tasks.emplace_back([loop] () { loop->process(); });
+		}
+	}
+	m_condition.notify_all();
+
+	loop->process();
+
+	{
+		std::unique_lock<std::mutex> lock(loop->mutex);
+		loop->completed.wait(lock, [&loop] () { return (loop->nCompleted == loop->nChunks); });
+	}
+
+	for (const std::exception_ptr &error : loop->errors) {
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
+}
+
+/*!
+	Processes the tasks of the pool until the pool is destroyed.
+*/
+void ThreadPool::work()
+{
+	while (true) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_condition.wait(lock, [this] () { return (m_stop || !m_tasks.empty()); });
+			if (m_tasks.empty()) {
+				return;
+			}
+
+			task = std::move(m_tasks.front());
+			m_tasks.pop_front();
+		}
+
+		task();
+	}
+}
+
+/*!
+	@}
+*/
+
+namespace threads {
+
+namespace {
+
+std::mutex poolMutex;
+std::unique_ptr<ThreadPool> pool;
+
+/*!
+	Evaluates the default number of threads of the pool of the library.
+
+	\result The value of the BITPIT_NUM_THREADS environment variable, if it
+	is defined, otherwise one thread.
+*/
+int evalDefaultThreadCount()
+{
+	const char *value = std::getenv("BITPIT_NUM_THREADS");
+	if (value) {
+		int nThreads = std::atoi(value);
+		if (nThreads > 0) {
+			return nThreads;
+		}
+	}
+
+	return 1;
+}
+
+}
+
+/*!
+	Gets the thread pool shared by the library.
+
+	The pool is created the first time it is accessed.
+
+	\result The thread pool shared by the library.
+*/
+ThreadPool & getPool()
+{
+	std::lock_guard<std::mutex> lock(poolMutex);
+	if (!pool) {
+		pool.reset(new ThreadPool(evalDefaultThreadCount()));
+	}
+
+	return *pool;
+}
+
+/*!
+	Gets the number of threads of the pool shared by the library.
+
+	\result The number of threads of the pool shared by the library.
+*/
+int getThreadCount()
+{
+	return getPool().getThreadCount();
+}
+
+/*!
+	Sets the number of threads of the pool shared by the library.
+
+	The pool is recreated, hence this function should not be called while
+	a parallel loop is running.
+
+	\param nThreads is the number of threads, including the calling thread
+*/
+void setThreadCount(int nThreads)
+{
+	std::lock_guard<std::mutex> lock(poolMutex);
+	pool.reset();
+	pool.reset(new ThreadPool(std::max(1, nThreads)));
+}
+
+}
+
+}
@@ -0,0 +1,87 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#ifndef __BITPIT_THREAD_POOL_HPP__
+#define __BITPIT_THREAD_POOL_HPP__
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace bitpit {
+
+class ThreadPool {
+
+public:
+	typedef std::function<void(std::size_t, std::size_t)> ChunkFunction;
+
+	static std::size_t evalChunkSize(int nChunks, std::size_t n);
+
+	ThreadPool(int nThreads);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool &other) = delete;
+	ThreadPool & operator=(const ThreadPool &other) = delete;
+
+	int getThreadCount() const;
+
+	template<typename Function>
+	void parallelFor(int nChunks, std::size_t n, Function function);
+
+private:
+	std::vector<std::thread> m_workers;
+	std::deque<std::function<void()>> m_tasks;
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+	bool m_stop;
+
+	void run(int nChunks, std::size_t n, const ChunkFunction &function);
+	void work();
+
+};
+
+/*!
+	\brief Functions for accessing the thread pool shared by the library.
+*/
+namespace threads {
+
+ThreadPool & getPool();
+
+int getThreadCount();
+void setThreadCount(int nThreads);
+
+template<typename Function>
+void parallelFor(int nChunks, std::size_t n, Function function);
+
+}
+
+}
+
+#include "thread_pool.tpp"
+
+#endif
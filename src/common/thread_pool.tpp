@@ -0,0 +1,82 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#ifndef __BITPIT_THREAD_POOL_TPP__
+#define __BITPIT_THREAD_POOL_TPP__
+
+namespace bitpit {
+
+/*!
+	Applies a function to contiguous chunks of the range [0, n).
+
+	The range is split in chunks of evalChunkSize(nChunks, n) elements,
+	hence the bounds of the chunks depend only on the size of the range and
+	on the number of chunks, not on the number of threads of the pool nor
+	on the order in which the chunks are processed. Functions that write
+	the results of each chunk in a separate storage give the same results
+	regardless of how they are scheduled. The number of chunks is always
+	chosen by the caller: loops whose results depend on the bounds of the
+	chunks, for example loops that reduce the results of each chunk, should
+	use a number of chunks that does not depend on the number of threads.
+
+	The calling thread processes chunks as well and the function returns
+	when all the chunks have been processed. If the function throws, the
+	exception thrown by the first chunk is rethrown once all the chunks
+	have been processed.
+
+	\param nChunks is the number of chunks
+	\param n is the size of the range
+	\param function is the function to apply, it receives the begin and
+	the end of the chunk
+*/
+template<typename Function>
+void ThreadPool::parallelFor(int nChunks, std::size_t n, Function function)
+{
+	run(nChunks, n, ChunkFunction(function));
+}
+
+namespace threads {
+
+/*!
+	Applies a function to contiguous chunks of the range [0, n) using the
+	thread pool of the library.
+
+	See ThreadPool::parallelFor for the details on how the range is split.
+
+	\param nChunks is the number of chunks
+	\param n is the size of the range
+	\param function is the function to apply, it receives the begin and
+	the end of the chunk
+*/
+template<typename Function>
+void parallelFor(int nChunks, std::size_t n, Function function)
+{
+	getPool().parallelFor(nChunks, n, function);
+}
+
+}
+
+}
+
+#endif
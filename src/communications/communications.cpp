@@ -24,6 +24,10 @@
 
 #if BITPIT_ENABLE_MPI==1
 
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
 #include "bitpit_IO.hpp"
 
 #include "communications.hpp"
@@ -40,6 +44,16 @@ namespace bitpit {
 
     \brief The DataCommunicator class provides the infrastructure needed to
     exchange data among processors.
+
+    Receives can be discovered automatically from the sends (see
+    discoverRecvs). The discovery uses the non-blocking consensus algorithm
+    (NBX): every processor sends the size of its messages using synchronous
+    mode sends, and, once all its sends have been matched, it enters a
+    non-blocking barrier. While waiting for the barrier to complete, the
+    processor keeps receiving the incoming sizes. When the barrier completes
+    all the messages have been received. The cost of the discovery is
+    proportional to the number of neighbours plus a logarithmic term for the
+    barrier, rather than to the number of processors.
 */
 
 int DataCommunicator::DEFAULT_TAG = 0;
@@ -49,12 +63,29 @@ int DataCommunicator::DEFAULT_TAG = 0;
 */
 DataCommunicator::DataCommunicator(MPI_Comm communicator)
     : m_communicator(communicator), m_rank(-1),
-    m_tag(DEFAULT_TAG), m_recvsContinuous(false)
+    m_tag(DEFAULT_TAG), m_recvsContinuous(false),
+    m_discoverCommunicator(MPI_COMM_NULL), m_discoverRound(0)
 {
     // Get MPI information
     MPI_Comm_rank(m_communicator, &m_rank);
 }
 
+/*!
+    Destroys the communicator.
+*/
+DataCommunicator::~DataCommunicator()
+{
+    if (m_discoverCommunicator == MPI_COMM_NULL) {
+        return;
+    }
+
+    int finalizedCalled;
+    MPI_Finalized(&finalizedCalled);
+    if (!finalizedCalled) {
+        MPI_Comm_free(&m_discoverCommunicator);
+    }
+}
+
 /*!
     Finalizes the communicator
 */
@@ -147,60 +178,166 @@ void DataCommunicator::discoverRecvs()
 */
 void DataCommunicator::discoverRecvs(int discoverTag)
 {
+	discoverRecvs(discoverTag, -1);
+}
+
+/*!
+    Discover the receives inspecting the sends that the user has already set.
+
+    The discovery messages travel on a private duplicate of the communicator,
+    therefore they will never be mistaken for data messages, whatever tag is
+    used. The duplicate is created the first time the function is called.
+
+    Sends whose size is not greater than the specified threshold are
+    piggy-backed on the discovery messages: the data currently contained
+    in the send buffer is delivered together with its size. When this
+    happens the data has to be written in the send buffer before calling
+    this function, the following call to startSend will not send anything
+    and the following call to startRecv will not post any receive, the
+    data will be already available in the receive buffer. Piggy-backing
+    is not available for receives in "continuous" mode.
+
+    This is a collective call: all the processors of the communicator should
+    call it with the same arguments.
+
+    \param discoverTag is the tag to be used for the communications needed
+    to discover the receives
+    \param maxPiggybackSize is the maximum size, expressed in bytes, of the
+    sends that will be piggy-backed on the discovery messages, a negative
+    value disables piggy-backing
+*/
+void DataCommunicator::discoverRecvs(int discoverTag, long maxPiggybackSize)
+{
+	if (maxPiggybackSize >= 0 && areRecvsContinuous()) {
+		throw std::runtime_error("Piggy-backing is not available for continuous receives");
+	}
+
 	// Cancel current receives
 	clearAllRecvs();
 
-	// Send the size of the messages that will be send
-	for (auto &entry : m_sendIds) {
-		int rank = entry.first;
-		SendBuffer &buffer = getSendBuffer(rank);
+	// Create the communicator for the discovery
+	if (m_discoverCommunicator == MPI_COMM_NULL) {
+		MPI_Comm_dup(m_communicator, &m_discoverCommunicator);
+	}
+
+	++m_discoverRound;
+
+	// Start the synchronous sends of the discovery messages
+	//
+	// Each message contains the index of the discovery round, the size of
+	// the data that will be sent and, if the data is small enough, the data
+	// itself.
+	const int HEADER_SIZE = 3 * sizeof(long);
+
+	int nSends = m_sendRanks.size();
+	std::vector<std::vector<char>> discoverMessages(nSends);
+	std::vector<MPI_Request> discoverRequests(nSends);
+	for (int id = 0; id < nSends; ++id) {
+		RawSendBuffer &buffer = m_sendBuffers[id].getFront();
 		long dataSize = buffer.capacity();
+		long piggyback = (dataSize <= maxPiggybackSize) ? 1 : 0;
+
+		std::vector<char> &message = discoverMessages[id];
+		message.resize(HEADER_SIZE + (piggyback ? dataSize : 0));
+
+		long header[3] = {m_discoverRound, dataSize, piggyback};
+		std::memcpy(message.data(), header, HEADER_SIZE);
+		if (piggyback && dataSize > 0) {
+			std::memcpy(message.data() + HEADER_SIZE, buffer.rawData(), dataSize);
+		}
 
-		MPI_Request dataSizeRequest;
-		MPI_Isend(&dataSize, 1, MPI_LONG, rank, discoverTag, m_communicator, &dataSizeRequest);
+		MPI_Issend(message.data(), message.size(), MPI_CHAR, m_sendRanks[id],
+		           discoverTag, m_discoverCommunicator, &discoverRequests[id]);
 
-		// MPI_Isend initiates an asynchronous (background) data transfer.
-		// The actual data transfer might not happen unless one of the
-		// MPI_Wait* or MPI_Test* calls has been made on the request.
-		int completeFlag;
-		MPI_Test(&dataSizeRequest, &completeFlag, MPI_STATUS_IGNORE);
+		m_sendDelivered[id] = (piggyback == 1);
 	}
 
-	// Raise a barrier to make sure that all the sends starts
-	MPI_Barrier(m_communicator);
+	// Process the messages of this round that were received during the
+	// previous round
+	//
+	// A processor can leave a round and start sending the messages of the
+	// following one while other processors are still probing for messages,
+	// hence, messages of the following round can be received. These messages
+	// are kept aside until the following round starts.
+	std::vector<std::pair<int, std::vector<char>>> earlyMessages;
+	earlyMessages.swap(m_discoverEarlyMessages);
+	for (auto &entry : earlyMessages) {
+		receiveDiscoverMessage(entry.first, entry.second);
+	}
 
-	// Receive the data size of the sends
-	std::unordered_map<int, long> dataSizes;
+	// Receive the messages until all processors have received theirs
+	bool barrierActive = false;
+	MPI_Request barrierRequest = MPI_REQUEST_NULL;
 	while (true) {
 		// Probe for messages
 		int messageAvailable;
 		MPI_Status status;
+		MPI_Iprobe(MPI_ANY_SOURCE, discoverTag, m_discoverCommunicator, &messageAvailable, &status);
+		if (messageAvailable) {
+			int messageSize;
+			MPI_Get_count(&status, MPI_CHAR, &messageSize);
 
-		MPI_Iprobe(MPI_ANY_SOURCE, discoverTag, m_communicator, &messageAvailable, &status);
-		if (!messageAvailable) {
-			break;
+			std::vector<char> message(messageSize);
+			MPI_Recv(message.data(), messageSize, MPI_CHAR, status.MPI_SOURCE, discoverTag,
+			         m_discoverCommunicator, MPI_STATUS_IGNORE);
+
+			receiveDiscoverMessage(status.MPI_SOURCE, message);
 		}
 
-		// Receive the data size that will be received from the source
-		long dataSize;
-		MPI_Recv(&dataSize, 1, MPI_LONG, status.MPI_SOURCE, discoverTag, m_communicator, MPI_STATUS_IGNORE);
-		dataSizes[status.MPI_SOURCE] = dataSize;
+		// When all the sends have been matched, start the barrier; when the
+		// barrier completes, all the messages have been received.
+		if (!barrierActive) {
+			int sendsCompleted;
+			MPI_Testall(nSends, discoverRequests.data(), &sendsCompleted, MPI_STATUSES_IGNORE);
+			if (sendsCompleted) {
+				MPI_Ibarrier(m_discoverCommunicator, &barrierRequest);
+				barrierActive = true;
+			}
+		} else {
+			int barrierCompleted;
+			MPI_Test(&barrierRequest, &barrierCompleted, MPI_STATUS_IGNORE);
+			if (barrierCompleted) {
+				break;
+			}
+		}
 	}
+}
 
-	// Wait that all processors correctly receive the data to communicate.
-	//
-	// Without the barrier some processors may start the receives while other
-	// are still waiting to receive the data sizes. Since the probe for the
-	// data size will accept message for all sources, if a processor start
-	// receiveing data it will intefere with the other processors still
-	// receiving the data sizes.
-	if (discoverTag == m_tag) {
-		MPI_Barrier(m_communicator);
+/*!
+    Process a message received during the discovery of the receives.
+
+    \param source is the rank of the processor that sent the message
+    \param message is the message
+*/
+void DataCommunicator::receiveDiscoverMessage(int source, const std::vector<char> &message)
+{
+	const int HEADER_SIZE = 3 * sizeof(long);
+
+	long header[3];
+	std::memcpy(header, message.data(), HEADER_SIZE);
+
+	// Messages of the following round are kept aside
+	long round = header[0];
+	if (round != m_discoverRound) {
+		m_discoverEarlyMessages.emplace_back(source, message);
+		return;
 	}
 
-	// Set the receives
-	for (auto &entry : dataSizes) {
-		setRecv(entry.first, entry.second);
+	// Set the receive
+	long dataSize = header[1];
+	setRecv(source, dataSize);
+
+	// Copy the data piggy-backed on the message
+	long piggyback = header[2];
+	if (piggyback) {
+		int id = m_recvIds.at(source);
+		RawRecvBuffer &buffer = m_recvBuffers[id].getFront();
+		if (dataSize > 0) {
+			std::memcpy(buffer.rawData(), message.data() + HEADER_SIZE, dataSize);
+		}
+		buffer.seekg(0);
+
+		m_recvDelivered[id] = true;
 	}
 }
 
@@ -230,6 +367,7 @@ void DataCommunicator::clearSend(int rank)
     m_sendRanks.erase(m_sendRanks.begin() + id);
     m_sendRequests.erase(m_sendRequests.begin() + id);
     m_sendBuffers.erase(m_sendBuffers.begin() + id);
+    m_sendDelivered.erase(m_sendDelivered.begin() + id);
 }
 
 /*!
@@ -258,6 +396,14 @@ void DataCommunicator::clearRecv(int rank)
     m_recvRanks.erase(m_recvRanks.begin() + id);
     m_recvRequests.erase(m_recvRequests.begin() + id);
     m_recvBuffers.erase(m_recvBuffers.begin() + id);
+    m_recvDelivered.erase(m_recvDelivered.begin() + id);
+
+    m_recvsReady.erase(std::remove(m_recvsReady.begin(), m_recvsReady.end(), id), m_recvsReady.end());
+    for (int &readyId : m_recvsReady) {
+        if (readyId > id) {
+            readyId--;
+        }
+    }
 }
 
 /*!
@@ -273,6 +419,7 @@ void DataCommunicator::clearAllSends()
     m_sendIds.clear();
     m_sendRequests.clear();
     m_sendBuffers.clear();
+    m_sendDelivered.clear();
 }
 
 /*!
@@ -288,7 +435,8 @@ void DataCommunicator::clearAllRecvs()
     m_recvIds.clear();
     m_recvRequests.clear();
     m_recvBuffers.clear();
-    m_recvBuffers.clear();
+    m_recvDelivered.clear();
+    m_recvsReady.clear();
 }
 
 /*!
@@ -309,6 +457,7 @@ void DataCommunicator::setSend(int rank, long length)
     m_sendRanks.push_back(rank);
     m_sendRequests.push_back(MPI_REQUEST_NULL);
     m_sendBuffers.emplace_back(length);
+    m_sendDelivered.push_back(false);
 }
 
 /*!
@@ -329,6 +478,7 @@ void DataCommunicator::setRecv(int rank, long length)
     m_recvRanks.push_back(rank);
     m_recvRequests.push_back(MPI_REQUEST_NULL);
     m_recvBuffers.emplace_back(length);
+    m_recvDelivered.push_back(false);
 
     // If the receives are continous start the receive
     if (areRecvsContinuous()) {
@@ -357,6 +507,7 @@ void DataCommunicator::resizeSend(int rank, long size)
     // Resize the buffer
     int id = m_sendIds[rank];
     m_sendBuffers[id].setCapacity(size);
+    m_sendDelivered[id] = false;
 }
 
 /*!
@@ -380,6 +531,7 @@ void DataCommunicator::resizeRecv(int rank, long size)
     // Resize the buffer
     int id = m_recvIds[rank];
     m_recvBuffers[id].setCapacity(size);
+    m_recvDelivered[id] = false;
 }
 
 /*!
@@ -441,6 +593,13 @@ void DataCommunicator::startSend(int dstRank)
     // Id of the buffer
     int id = m_sendIds.at(dstRank);
 
+    // Data piggy-backed on the discovery messages has already been sent
+    if (m_sendDelivered[id]) {
+        m_sendDelivered[id] = false;
+        m_sendBuffers[id].seekg(0);
+        return;
+    }
+
     // If the buffer is a double buffer, swap it
     SendBuffer &sendBuffer = m_sendBuffers[id];
     if (sendBuffer.isDouble()) {
@@ -474,8 +633,16 @@ void DataCommunicator::startRecv(int srcRank)
     // Wait for the previous receive to finish
     waitRecv(srcRank);
 
-    // Reset the position of the buffer
+    // Data piggy-backed on the discovery messages has already been received
     int id = m_recvIds.at(srcRank);
+    if (m_recvDelivered[id]) {
+        m_recvDelivered[id] = false;
+        m_recvBuffers[id].seekg(0);
+        m_recvsReady.push_back(id);
+        return;
+    }
+
+    // Reset the position of the buffer
     IBinaryStream &buffer = m_recvBuffers[id].getBack();
     buffer.seekg(0);
 
@@ -563,6 +730,14 @@ void DataCommunicator::waitAllSends()
 */
 int DataCommunicator::waitAnyRecv()
 {
+    // Receives already completed
+    if (!m_recvsReady.empty()) {
+        int id = m_recvsReady.back();
+        m_recvsReady.pop_back();
+
+        return m_recvRanks[id];
+    }
+
     // Wait for a receive to complete
     int id;
     MPI_Waitany(m_recvRequests.size(), m_recvRequests.data(), &id, MPI_STATUS_IGNORE);
@@ -598,6 +773,8 @@ void DataCommunicator::waitRecv(int rank)
 {
     // Wait for the receive to complete
     int id = m_recvIds.at(rank);
+    m_recvsReady.erase(std::remove(m_recvsReady.begin(), m_recvsReady.end(), id), m_recvsReady.end());
+
     auto request = m_recvRequests[id];
     if (request == MPI_REQUEST_NULL) {
         return;
@@ -623,6 +800,8 @@ void DataCommunicator::waitRecv(int rank)
 void DataCommunicator::waitAllRecvs()
 {
     // Wait for all the receives to complete
+    m_recvsReady.clear();
+
     MPI_Waitall(m_recvRequests.size(), m_recvRequests.data(), MPI_STATUS_IGNORE);
 
     // Swap double buffers
@@ -42,6 +42,10 @@ class DataCommunicator
 
 public:
     DataCommunicator(MPI_Comm communicator);
+    ~DataCommunicator();
+
+    DataCommunicator(const DataCommunicator &other) = delete;
+    DataCommunicator & operator=(const DataCommunicator &other) = delete;
 
     void finalize();
 
@@ -65,6 +69,7 @@ public:
 
     void discoverRecvs();
     void discoverRecvs(int discoverTag);
+    void discoverRecvs(int discoverTag, long maxPiggybackSize);
 
     int getSendCount();
     int getRecvCount();
@@ -100,15 +105,24 @@ private:
     int m_tag;
     bool m_recvsContinuous;
 
+    MPI_Comm m_discoverCommunicator;
+    long m_discoverRound;
+    std::vector<std::pair<int, std::vector<char>>> m_discoverEarlyMessages;
+
     std::vector<int> m_recvRanks;
     std::unordered_map<int, int> m_recvIds;
     std::vector<MPI_Request> m_recvRequests;
     std::vector<RecvBuffer> m_recvBuffers;
+    std::vector<bool> m_recvDelivered;
+    std::vector<int> m_recvsReady;
 
     std::vector<int> m_sendRanks;
     std::unordered_map<int, int> m_sendIds;
     std::vector<MPI_Request> m_sendRequests;
     std::vector<SendBuffer> m_sendBuffers;
+    std::vector<bool> m_sendDelivered;
+
+    void receiveDiscoverMessage(int source, const std::vector<char> &message);
 
 };
 
@@ -25,6 +25,8 @@
 // ========================================================================== //
 // INCLUDES                                                                   //
 // ========================================================================== //
+#include <algorithm>
+
 #include "binary_stream.hpp"
 
 // ========================================================================== //
@@ -58,6 +60,8 @@ namespace bitpit{
 IBinaryStream::IBinaryStream(
     void
 ) {
+    view_data = nullptr;
+    view_size = 0;
     current_pos = 0;
 }
 
@@ -71,6 +75,8 @@ IBinaryStream::IBinaryStream(
 IBinaryStream::IBinaryStream(
     size_t                      capacity
 ) {
+    view_data = nullptr;
+    view_size = 0;
     current_pos = 0;
     buffer.clear();
     buffer.reserve(capacity);
@@ -90,6 +96,8 @@ IBinaryStream::IBinaryStream(
     const char                  *buf_,
     size_t                       capacity
 ) {
+    view_data = nullptr;
+    view_size = 0;
     current_pos = 0;
     buffer.clear();
     buffer.reserve(capacity);
@@ -107,6 +115,8 @@ IBinaryStream::IBinaryStream(
 IBinaryStream::IBinaryStream(
     const std::vector<char>          &vec
 ) {
+    view_data = nullptr;
+    view_size = 0;
     current_pos = 0;
     buffer.clear();
     buffer.reserve(vec.size());
@@ -131,6 +141,8 @@ IBinaryStream::IBinaryStream(
 void IBinaryStream::setCapacity(
     size_t                       capacity
 ) {
+    view_data = nullptr;
+    view_size = 0;
     buffer.resize(capacity);
 }
 
@@ -144,6 +156,10 @@ void IBinaryStream::setCapacity(
 size_t IBinaryStream::capacity(
     void
 ) const {
+    if (view_data) {
+        return view_size;
+    }
+
     return buffer.size();
 }
 
@@ -160,12 +176,46 @@ void IBinaryStream::open(
     const char                  *mem,
     size_t                       capacity
 ) {
+    view_data = nullptr;
+    view_size = 0;
     current_pos = 0;
     buffer.clear();
     buffer.reserve(capacity);
     buffer.assign(mem, mem + capacity);
 }
 
+// -------------------------------------------------------------------------- //
+/*!
+        Open stream reading directly from memory. The memory is not copied,
+        it should remain valid until the stream is reopened or destroyed.
+
+        \param[in] mem pointer to memory location
+        \param[in] capacity capacity (in bytes) of memory location to be
+        streamed
+*/
+void IBinaryStream::openView(
+    const char                  *mem,
+    size_t                       capacity
+) {
+    current_pos = 0;
+    buffer.clear();
+    view_data = mem;
+    view_size = capacity;
+}
+
+// -------------------------------------------------------------------------- //
+/*!
+        Returns true if the stream reads directly from external memory.
+
+        \result boolean flag (true) if the stream is a view of external memory,
+        (false) otherwise
+*/
+bool IBinaryStream::isView(
+    void
+) const
+{
+    return (view_data != nullptr);
+}
 // -------------------------------------------------------------------------- //
 /*!
         Returns true if end of file condition is met.
@@ -177,7 +227,7 @@ bool IBinaryStream::eof(
     void
 ) const
 {
-    return current_pos >= buffer.size();
+    return current_pos >= capacity();
 }
 
 // -------------------------------------------------------------------------- //
@@ -205,7 +255,7 @@ ifstream::pos_type IBinaryStream::tellg(
 bool IBinaryStream::seekg (
     size_t                       pos
 ) {
-    if(pos<buffer.size())
+    if(pos<capacity())
         current_pos = pos;
     else
         return false;
@@ -227,12 +277,12 @@ bool IBinaryStream::seekg (
     std::streamoff               offset,
     std::ios_base::seekdir       way
 ) {
-    if ( ( way == ios_base::beg ) && ( offset < (long) buffer.size() ) )
+    if ( ( way == ios_base::beg ) && ( offset < (long) capacity() ) )
         current_pos = offset;
-    else if ( ( way == ios_base::cur ) && ( current_pos + offset < buffer.size() ) )
+    else if ( ( way == ios_base::cur ) && ( current_pos + offset < capacity() ) )
         current_pos += offset;
-    else if ( ( way == ios_base::end ) && ( (long) buffer.size() - offset >= 0 ) )
-        current_pos = buffer.size() - offset;
+    else if ( ( way == ios_base::end ) && ( (long) capacity() - offset >= 0 ) )
+        current_pos = capacity() - offset;
     else
         return false;
 
@@ -253,11 +303,13 @@ void IBinaryStream::read(
     char                        *p,
     size_t                       size
 ) {
-    if ( eof() || (current_pos + size) > buffer.size() ) {
+    if ( (current_pos + size) > capacity() ) {
         throw std::runtime_error("Bad memory access!");
     }
 
-    std::memcpy(reinterpret_cast<void*>( p ), &buffer[current_pos], size);
+    if (size > 0) {
+        std::memcpy(reinterpret_cast<void*>( p ), readData() + current_pos, size);
+    }
     current_pos += size;
 }
 
@@ -271,12 +323,7 @@ void IBinaryStream::read(
 void IBinaryStream::read(
     std::vector<char>           &vec
 ) {
-    if ( eof() || ( current_pos + vec.size() ) > buffer.size() ) {
-        throw std::runtime_error("Bad memory access!");
-    }
-
-    std::memcpy(reinterpret_cast<void*>(&vec[0]), &buffer[current_pos], vec.size());
-    current_pos += vec.size();
+    read(vec.data(), vec.size());
 }
 
 /*!
@@ -307,6 +354,7 @@ void IBinaryStream::read(
 OBinaryStream::OBinaryStream(
     void
 ) {
+    data_size = 0;
     current_pos = 0;
 }
 
@@ -320,6 +368,7 @@ OBinaryStream::OBinaryStream(
 OBinaryStream::OBinaryStream(
     size_t                       capacity
 ) {
+    data_size = 0;
     current_pos = 0;
     open(capacity);
 }
@@ -342,7 +391,10 @@ OBinaryStream::OBinaryStream(
 void OBinaryStream::setCapacity(
     size_t                       capacity
 ) {
-    buffer.resize(capacity);
+    if (capacity > buffer.size()) {
+        buffer.resize(capacity);
+    }
+    data_size = capacity;
 }
 
 // -------------------------------------------------------------------------- //
@@ -355,7 +407,7 @@ void OBinaryStream::setCapacity(
 size_t OBinaryStream::capacity(
     void
 ) const {
-    return buffer.size();
+    return data_size;
 }
 
 // -------------------------------------------------------------------------- //
@@ -368,8 +420,7 @@ size_t OBinaryStream::capacity(
 void OBinaryStream::open(
     size_t                       capacity
 ) {
-    buffer.reserve(capacity);
-    buffer.resize(capacity);
+    setCapacity(capacity);
 }
 
 // -------------------------------------------------------------------------- //
@@ -383,7 +434,7 @@ bool OBinaryStream::eof(
     void
 ) const
 {
-    return current_pos >= buffer.size();
+    return current_pos >= data_size;
 }
 
 // -------------------------------------------------------------------------- //
@@ -411,7 +462,7 @@ ifstream::pos_type OBinaryStream::tellg(
 bool OBinaryStream::seekg (
     size_t                       pos
 ) {
-    if(pos < buffer.size())
+    if(pos < data_size)
         current_pos = pos;
     else
         return false;
@@ -433,12 +484,12 @@ bool OBinaryStream::seekg (
     std::streamoff               offset,
     std::ios_base::seekdir       way
 ) {
-    if ( ( way == ios_base::beg ) && ( offset < (long) buffer.size() ) )
+    if ( ( way == ios_base::beg ) && ( offset < (long) data_size ) )
         current_pos = offset;
-    else if ( ( way == ios_base::cur ) && ( current_pos + offset < buffer.size() ) )
+    else if ( ( way == ios_base::cur ) && ( current_pos + offset < data_size ) )
         current_pos += offset;
-    else if ( ( way == ios_base::end ) && ( (long) buffer.size() - offset >= 0 ) )
-        current_pos = buffer.size() - offset;
+    else if ( ( way == ios_base::end ) && ( (long) data_size - offset >= 0 ) )
+        current_pos = data_size - offset;
     else
         return false;
 
@@ -455,6 +506,8 @@ void OBinaryStream::squeeze (
     void
 ) {
     setCapacity(current_pos);
+    buffer.resize(data_size);
+    buffer.shrink_to_fit();
 }
 
 // -------------------------------------------------------------------------- //
@@ -470,34 +523,30 @@ void OBinaryStream::write(
     const char                  *p,
     size_t                       size
 ) {
-    if ( buffer.size() - current_pos < size ) {
-        buffer.resize( size + current_pos );
+    size_t end_pos = current_pos + size;
+    if ( end_pos > buffer.size() ) {
+        grow( end_pos );
     }
-    for (size_t i = 0;  i < size; ++i) {
-        buffer[current_pos] = p[i];
-        ++current_pos;
-    } // next i
+
+    if (size > 0) {
+        std::memcpy(&buffer[current_pos], p, size);
+    }
+    current_pos = end_pos;
+    data_size = std::max( end_pos, data_size );
 }
 
 // -------------------------------------------------------------------------- //
 /*!
-        Write vector of char to internal buffer
-
-        \param[in] vec vector of char to be written in the internal buffer
-        buffer
+        Grow the storage of the stream. The storage is grown geometrically,
+        so that a sequence of writes needs a logarithmic number of
+        reallocations.
 
+        \param[in] size minimum size (in bytes) of the storage
 */
-
-void OBinaryStream::write(
-    const vector<char>          &vec
+void OBinaryStream::grow(
+    size_t                       size
 ) {
-    if ( buffer.size() - current_pos < vec.size() ) {
-        buffer.resize( vec.size() + current_pos );
-    }
-    for(size_t i = 0; i < vec.size(); ++i) {
-        buffer[current_pos] = vec[i];
-        ++current_pos;
-    } //next i
+    buffer.resize( std::max( size, 2 * buffer.size() ) );
 }
 
 }
@@ -508,13 +557,12 @@ void OBinaryStream::write(
 
 // -------------------------------------------------------------------------- //
 /*!
-        Explicit template specialization for stream operator for class IBinaryStream
+        Stream std::string from input stream.
 
         \param[in] istm input stream
         \param[in] val std::string to be streamed
 
 */
-template<>
 bitpit::IBinaryStream& operator>>(
         bitpit::IBinaryStream             &istm,
         std::string                  &val)
@@ -525,9 +573,8 @@ bitpit::IBinaryStream& operator>>(
 
     if(size<=0)         return istm;
 
-    std::vector<char> vec((size_t)size);
-    istm.read(vec);
-    val.assign(&vec[0], (size_t)size);
+    val.resize((size_t)size);
+    istm.read(&val[0], (size_t)size);
 
     return istm;
 }
@@ -540,7 +587,6 @@ bitpit::IBinaryStream& operator>>(
         \param[in] val string
 
 */
-template<>
 bitpit::OBinaryStream& operator << (
     bitpit::OBinaryStream                 & ostm,
     const std::string                & val
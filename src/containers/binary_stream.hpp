@@ -36,6 +36,7 @@
 #include <cstring>
 #include <iostream>
 #include <stdexcept>
+#include <type_traits>
 
 // Bitpit
 // none
@@ -61,8 +62,7 @@ bitpit::IBinaryStream& operator>>(
     bitpit::IBinaryStream                     &istm,                                // (input) input stream
     T                               &val                                  // (input) value to be streamed
 );
-template<>
-bitpit::IBinaryStream& operator>>(                                                  // Explicit specialization of input stream operator for std::string
+bitpit::IBinaryStream& operator>>(                                                  // Input stream operator for std::string
     bitpit::IBinaryStream                     &istm,                                // (input) input stream
     std::string                     &val                                  // (input) string to be streamed
 );
@@ -71,8 +71,7 @@ bitpit::OBinaryStream& operator<<(
     bitpit::OBinaryStream                     &ostm,                                // (input) output stream
     const T                         &val                                  // (input) value to be streamed
 );
-template<>
-bitpit::OBinaryStream& operator<<(                                                  // Explicit specialization of input stream operator for std::string
+bitpit::OBinaryStream& operator<<(                                                  // Output stream operator for std::string
     bitpit::OBinaryStream                     &ostm,                                // (input) output stream
     const std::string               &val                                  // (input) string to be streamed
 );
@@ -90,6 +89,8 @@ class IBinaryStream {
     private:
 
     std::vector<char>               buffer;                               // stream buffer
+    const char                     *view_data;                            // External memory read by the stream (if any)
+    size_t                          view_size;                            // Size (in bytes) of the external memory
     size_t                          current_pos;                          // Cursor position
 
     // Constructor(s) =================================================== //
@@ -124,6 +125,13 @@ class IBinaryStream {
         const char                  *mem,                                 // (input) pointer to memory location
         size_t                       capacity                             // (input) capacity (in bytes) of memory chunk
     );
+    void openView(                                                        // Open input stream reading directly from memory location (no copy)
+        const char                  *mem,                                 // (input) pointer to memory location
+        size_t                       capacity                             // (input) capacity (in bytes) of memory chunk
+    );
+    bool isView(                                                          // Flag for streams reading from external memory
+        void                                                              // (input) none
+    ) const;
     bool eof(                                                             // Flag for eof
         void                                                              // (input) none
     ) const;
@@ -143,6 +151,15 @@ class IBinaryStream {
     char* rawData(                                                     // Returns pointer to buffer
         void                                                              // (input) none
     ) { return( buffer.data() ); }
+    template<typename T>
+    void read(                                                            // Read an array of trivially copyable values from the stream
+        T                           *values,                              // (input) pointer to the first value
+        size_t                       count                                // (input) number of values to be read
+    );
+    void read(                                                            // Read data from stream buffer and store into memory location pointed by p
+        char                        *p,                                   // (input) pointer to memory location
+        size_t                       size                                 // (input) size (in bytes) of data to be read
+    );
 
     // Private methods(s) =============================================== //
     private:
@@ -154,15 +171,14 @@ class IBinaryStream {
     void read(                                                            // Explicit template specialization of IBinaryStream::read for vector<char>
         std::vector<char>           &vec                                  // (input) source vector
     );
-    void read(                                                                // Read data from memory location pointed by p and store into stream buffer
-        char                        *p,                                   // (input) pointer to memory location
-        size_t                       size                                 // (input) size (in bytes) of data to be read
-    );
+    const char* readData(                                                 // Returns pointer to the memory read by the stream
+        void                                                              // (input) none
+    ) const { return( view_data ? view_data : buffer.data() ); }
 
     // Friendships ====================================================== //
     template< typename T >
     friend IBinaryStream& (::operator >>) (IBinaryStream&, T& );
-    friend IBinaryStream& (::operator >> <>) (IBinaryStream&, std::string& );
+    friend IBinaryStream& (::operator >>) (IBinaryStream&, std::string& );
 };
 
 // Class OBinaryStream ---------------------------------------------------- //
@@ -172,7 +188,8 @@ class OBinaryStream {
     private:
 
     size_t                           current_pos;                         // Cursor current position
-    std::vector<char>                buffer;                              // Buffer
+    size_t                           data_size;                           // Size (in bytes) of the data in the stream
+    std::vector<char>                buffer;                              // Buffer (storage may be larger than the data)
 
     // Constructor(s) =================================================== //
     public:
@@ -213,12 +230,21 @@ class OBinaryStream {
     void squeeze(                                                         // Squeeze the stream to fit the data
         void                                                              // (input) none
     );
-    const std::vector<char>& data(                                        // Returns reference to buffer
+    const std::vector<char>& data(                                        // Returns reference to buffer (resized to fit the data)
         void                                                              // (input) none
-    ) { return(buffer); }
+    ) { buffer.resize(data_size); return(buffer); }
     char* rawData(                                                     // Returns pointer to buffer
         void                                                              // (input) none
     ) { return( buffer.data() ); }
+    template<typename T>
+    void write(                                                           // Write an array of trivially copyable values to internal buffer
+        const T                     *values,                              // (input) pointer to the first value
+        size_t                       count                                // (input) number of values to be written
+    );
+    void write(                                                           // Write char array to internal buffer
+        const char                  *p,                                   // (input) pointer to char array
+        size_t                       size                                 // (input) size of data chunk to be written in the internal buffer
+    );
 
     // Private method(s) ================================================ //
     private:
@@ -227,18 +253,14 @@ class OBinaryStream {
     void write(                                                           // Write data to internal buffer
         const T                     &t                                    // (input) data to be written in the internal buffer
     );
-    void write(                                                           // Write char array to internal buffer
-        const char                  *p,                                   // (input) pointer to char array
-        size_t                       size                                 // (input) size of data chunk to be written in the internal buffer
-    );
-    void write(                                                           // Write vector of char to internal buffer
-        const std::vector<char>     &vec                                  // (input) vector of char to be written in the internal buffer
+    void grow(                                                            // Grow the storage of the stream
+        size_t                       size                                 // (input) minimum size (in bytes) of the storage
     );
 
     // Friendship(s) ==================================================== //
     template<typename T>
     friend OBinaryStream& (::operator<<) ( OBinaryStream&, const T& );
-    friend OBinaryStream& (::operator<< <>) ( OBinaryStream&, const std::string& );
+    friend OBinaryStream& (::operator<<) ( OBinaryStream&, const std::string& );
     friend OBinaryStream& (::operator<<) ( OBinaryStream&, const char* );
 };
 
@@ -39,14 +39,33 @@ template<typename T>
 void IBinaryStream::read(
     T                           &t
 ) {
-    if ( eof() || ( current_pos + sizeof(T) ) > buffer.size() ) {
+    if ( ( current_pos + sizeof(T) ) > capacity() ) {
         throw std::runtime_error("Bad memory access!");
     }
 
-    std::memcpy(reinterpret_cast<void*>( &t ), &buffer[current_pos], sizeof(T));
+    std::memcpy(reinterpret_cast<void*>( &t ), readData() + current_pos, sizeof(T));
     current_pos += sizeof(T);
 }
 
+// -------------------------------------------------------------------------- //
+/*!
+        Read an array of values from the stream buffer. Values are copied
+        bitwise with a single copy, hence they should be trivially copyable.
+
+        \param[in] values pointer to the first value
+        \param[in] count number of values to be read
+
+*/
+template<typename T>
+void IBinaryStream::read(
+    T                           *values,
+    size_t                       count
+) {
+    static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable values can be read as arrays");
+
+    read(reinterpret_cast<char*>( values ), count * sizeof(T));
+}
+
 // ========================================================================== //
 // TEMPLATE IMPLEMENTATIONS FOR CLASS OBinaryStream                             //
 // ========================================================================== //
@@ -62,9 +81,35 @@ template<typename T>
 void OBinaryStream::write(
     const T                     &t
 ) {
-    std::vector<char> vec(sizeof(T));
-    memcpy( reinterpret_cast<void*>( &vec[0] ), reinterpret_cast<const void*>( &t ), sizeof(T) );
-    write(vec);
+    size_t end_pos = current_pos + sizeof(T);
+    if ( end_pos > buffer.size() ) {
+        grow( end_pos );
+    }
+
+    std::memcpy(&buffer[current_pos], reinterpret_cast<const void*>( &t ), sizeof(T));
+    current_pos = end_pos;
+    if ( end_pos > data_size ) {
+        data_size = end_pos;
+    }
+}
+
+// -------------------------------------------------------------------------- //
+/*!
+        Write an array of values to internal buffer. Values are copied
+        bitwise with a single copy, hence they should be trivially copyable.
+
+        \param[in] values pointer to the first value
+        \param[in] count number of values to be written
+
+*/
+template<typename T>
+void OBinaryStream::write(
+    const T                     *values,
+    size_t                       count
+) {
+    static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable values can be written as arrays");
+
+    write(reinterpret_cast<const char*>( values ), count * sizeof(T));
 }
 
 }
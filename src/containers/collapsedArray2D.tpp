@@ -185,8 +185,8 @@ public:
 	*/
 	void swap(CollapsedArray2D &other)
 	{
-		std::swap(m_index.get(), other.m_index.get());
-		std::swap(m_v.get(), other.m_v.get());
+		m_index.swap(other.m_index);
+		m_v.swap(other.m_v);
 		std::swap(m_capacity, other.m_capacity);
 	}
 
@@ -51,16 +51,9 @@ namespace bitpit{
 template<class T>
 bitpit::OBinaryStream& operator<<(bitpit::OBinaryStream &buffer, const bitpit::CollapsedVector2D<T> &vector)
 {
-	typename std::vector<T>::const_iterator           it;
-	typename std::vector<size_t>::const_iterator      jt;
-
 	buffer << vector.m_index.size() << vector.m_v.size();
-	for (jt = vector.m_index.begin(); jt != vector.m_index.end(); ++jt) {
-	    buffer << *(jt);
-	}
-	for (it = vector.m_v.begin(); it != vector.m_v.end(); ++it) {
-	    buffer << *(it);
-	}
+	buffer.write(vector.m_index.data(), vector.m_index.size());
+	buffer.write(vector.m_v.data(), vector.m_v.size());
 
 	return buffer;
 }
@@ -77,7 +70,6 @@ template<class T>
 bitpit::IBinaryStream& operator>>(bitpit::IBinaryStream &buffer, bitpit::CollapsedVector2D<T> &vector)
 {
     size_t                      size_m_v, size_m_index;
-    size_t                      i;
 
     buffer >> size_m_index;
     buffer >> size_m_v;
@@ -85,13 +77,8 @@ bitpit::IBinaryStream& operator>>(bitpit::IBinaryStream &buffer, bitpit::Collaps
     vector.m_index.resize(size_m_index, 0);
     vector.m_v.resize(size_m_v);
 
-    for (i = 0; i < size_m_index; ++i) {
-        buffer >> vector.m_index[i];
-    }
-
-    for (i = 0; i < size_m_v; ++i) {
-        buffer >> vector.m_v[i];
-    }
+    buffer.read(vector.m_index.data(), size_m_index);
+    buffer.read(vector.m_v.data(), size_m_v);
 
     return buffer;
 }
@@ -386,7 +373,7 @@ public:
 	*/
 	void push_back()
 	{
-		push_back(0, NULL);
+		push_back(0, T());
 	}
 
 	/*!
@@ -688,12 +675,24 @@ public:
 		return m_v.capacity();
 	}
 
+	/*!
+		Returns the size (in bytes) of the memory allocated by the
+		container.
+
+		\return The size (in bytes) of the memory allocated by the
+		container.
+	*/
+	size_t get_memory_size() const
+	{
+		return (m_v.capacity() * sizeof(T) + m_index.capacity() * sizeof(size_t));
+	}
+
 	/*!
 	    Returns the buffer size (in bytes) required to store the container.
 
 	    \result The buffer size (in bytes) required to store the container.
 	*/
-	size_t get_binary_size()
+	size_t get_binary_size() const
 	{
 	     return ((2 + m_index.size())*sizeof(size_t) + m_v.size() * sizeof(T));
 	}
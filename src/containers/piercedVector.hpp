@@ -34,6 +34,8 @@
 #include <type_traits>
 #include <vector>
 
+#include "memory_usage.hpp"
+
 namespace bitpit{
 
 template<typename value_t, typename id_t>
@@ -313,6 +315,7 @@ public:
 	bool isIteratorSlow();
 	std::size_t maxSize() const;
 	std::size_t size() const;
+	MemoryUsage getMemoryUsage() const;
 
 	// Methods that extract information on the contents of the container
 	bool exists(id_t id) const;
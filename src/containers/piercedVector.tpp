@@ -724,6 +724,7 @@ void PiercedVector<value_t, id_t>::reserve(std::size_t n)
 {
 	m_ids.reserve(n);
 	m_v.reserve(n);
+	m_pos.reserve(n);
 }
 
 /*!
@@ -815,6 +816,11 @@ void PiercedVector<value_t, id_t>::sort()
 	// Sort the container
 	reorderVector<id_t>(id_permutation, m_ids, containerSize);
 	reorderVector<value_t>(value_permutation, m_v, containerSize);
+
+	// Update the positions of the ids
+	for (size_t pos = 0; pos < containerSize; ++pos) {
+		m_pos[m_ids[pos]] = pos;
+	}
 }
 
 /*!
@@ -1045,6 +1051,32 @@ std::size_t PiercedVector<value_t, id_t>::size() const
 	return m_pos.size();
 }
 
+/*!
+	Evaluates the memory used by the vector.
+
+	The memory is broken down in the storage of the elements, the storage
+	of the holes, the storage reserved for future elements, the ids, the
+	list of the holes and the map between ids and positions. Memory
+	allocated by the elements themselves is not accounted for.
+
+	\result The memory used by the vector.
+*/
+template<typename value_t, typename id_t>
+MemoryUsage PiercedVector<value_t, id_t>::getMemoryUsage() const
+{
+	std::size_t nHoles = m_v.size() - size();
+
+	MemoryUsage usage;
+	usage.addComponent("elements", size() * sizeof(value_t));
+	usage.addComponent("holes", nHoles * sizeof(value_t));
+	usage.addComponent("reserved", (m_v.capacity() - m_v.size()) * sizeof(value_t));
+	usage.addComponent("ids", utils::evalMemorySize(m_ids));
+	usage.addComponent("hole list", utils::evalMemorySize(m_holes));
+	usage.addComponent("id map", utils::evalMemorySize(m_pos));
+
+	return usage;
+}
+
 /*!
 	Checks if a given id exists in the vector.
 
@@ -26,6 +26,7 @@
 # include <mpi.h>
 # endif
 
+# include <algorithm>
 # include <unordered_set>
 
 # include "bitpit_SA.hpp"
@@ -69,6 +70,8 @@ LevelSet::LevelSet() {
     m_propagateS  = false;
     m_propagateV  = false;
 
+    m_eikonal     = LevelSetEikonalSolver::FAST_MARCHING;
+
 };
 
 /*!
@@ -102,8 +105,11 @@ void LevelSet::setMesh( VolumeKernel* mesh ) {
     
     } else{
         log::cout() << "Mesh non supported in LevelSet::setMesh()" << std::endl ;
+        return;
     }; 
 
+    m_kernel->setEikonalSolver(m_eikonal) ;
+
     return;
 };
 
@@ -114,6 +120,7 @@ void LevelSet::setMesh( VolumeKernel* mesh ) {
 void LevelSet::setMesh( VolCartesian* cartesian ) {
 
     m_kernel = new LevelSetCartesian( *cartesian) ;
+    m_kernel->setEikonalSolver(m_eikonal) ;
 
     return;
 };
@@ -125,6 +132,7 @@ void LevelSet::setMesh( VolCartesian* cartesian ) {
 void LevelSet::setMesh( VolOctree* octree ) {
 
     m_kernel = new LevelSetOctree( *octree) ;
+    m_kernel->setEikonalSolver(m_eikonal) ;
 
     return;
 };
@@ -304,6 +312,25 @@ double LevelSet::getSizeNarrowBand()const{
     return( m_kernel->getSizeNarrowBand() ) ;
 };
 
+/*!
+ * Evaluate the memory used by the levelset, broken down into the memory
+ * used by the kernel and the memory used by each object.
+ * @return Memory used by the levelset.
+ */
+MemoryUsage LevelSet::getMemoryUsage()const{
+
+    MemoryUsage usage("levelset") ;
+    if( m_kernel != nullptr ){
+        usage.addComponent("kernel", m_kernel->getMemoryUsage()) ;
+    }
+
+    for( const auto &object : m_object ){
+        usage.addComponent("object " + std::to_string(object.first), object.second->getMemoryUsage()) ;
+    }
+
+    return usage ;
+};
+
 /*!
  * Set if the signed or unsigned levelset function should be computed.
  * @param[in] flag true/false for signed /unsigned Level-Set function .
@@ -323,12 +350,28 @@ void LevelSet::setPropagateSign(bool flag){
 
 /*!
  * Set if the levelset value has to be propagated from the narrow band to the whole domain.
+ * The propagation of the value needs the sign of the cells outside the narrow band,
+ * hence, when the value is propagated, the sign is propagated as well.
  * @param[in] flag True/false to active/disable the propagation.
  */
 void LevelSet::setPropagateValue(bool flag){
     m_propagateV = flag;
 };
 
+/*!
+ * Set the solver used for propagating the levelset value from the narrow band to the whole domain.
+ * The fast sweeping method is available only on cartesian meshes, on the other meshes
+ * the fast marching method is used.
+ * @param[in] solver Eikonal solver.
+ */
+void LevelSet::setEikonalSolver(LevelSetEikonalSolver solver){
+    m_eikonal = solver;
+
+    if( m_kernel != NULL ){
+        m_kernel->setEikonalSolver(m_eikonal) ;
+    }
+};
+
 /*!
  * Manually set the physical size of the narrow band.
  * @param[in] r Size of the narrow band.
@@ -354,6 +397,9 @@ void LevelSet::compute(){
 
         m_kernel->setSizeNarrowBand(RSearch) ;
 
+    } else {
+        RSearch = m_kernel->getSizeNarrowBand() ;
+
     }
 
     for( const auto &visitor : m_object ){
@@ -361,8 +407,8 @@ void LevelSet::compute(){
     }
 
 
-    if( m_propagateS ) m_kernel->propagateSign( m_object ) ;
-//    if( propagateV ) propagateValue( ) ;
+    if( m_propagateS || m_propagateV ) m_kernel->propagateSign( m_object ) ;
+    if( m_propagateV ) m_kernel->propagateValue( ) ;
 
     return ;
 }
@@ -392,11 +438,12 @@ void LevelSet::update( const std::vector<adaption::Info> &mapper ){
     exchangeGhosts() ;
 #endif
 
-    if( m_propagateS ) m_kernel->propagateSign( m_object ) ;
-//TODO    if( propagateV ) updatePropagatedValue() ;
+    if( m_propagateS || m_propagateV ) m_kernel->propagateSign( m_object ) ;
 
     m_kernel->setSizeNarrowBand(newRSearch) ;
 
+    if( m_propagateV ) m_kernel->propagateValue( ) ;
+
     return;
 
 };
@@ -50,10 +50,18 @@ namespace levelSetDefaults{
     const std::array<double,3>              GRADIENT = {{0.,0.,0.}};    /**< Default value for levelset gradient */
     const short                             SIGN = 1;                   /**< Default value for the sign */
     const int                               OBJECT = -1 ;               /**< Default value for closest object id */
-    const std::unordered_set<long>          LIST;                       /**< Default value for closest segment */
+    const std::vector<long>                 LIST;                       /**< Default value for list of segments in narrow band */
     const long                              ELEMENT = -1 ;              /**< Default value for segmments in narrow band */
 };
 
+/*!
+ * Solvers available for propagating the levelset value outside the narrow band
+ */
+enum class LevelSetEikonalSolver{
+    FAST_MARCHING = 0,      /**< Fast marching method, available on all meshes */
+    FAST_SWEEPING = 1       /**< Fast sweeping method, available on cartesian meshes only */
+};
+
 class LevelSet{
 
     private:
@@ -64,6 +72,7 @@ class LevelSet{
     bool                                        m_signedDF;             /**< Flag for sigend/unsigned distance function (default = true) */
     bool                                        m_propagateS;           /**< Flag for sign propagation from narrow band (default = false) */
     bool                                        m_propagateV;           /**< Flag for value propagation from narrow band (default = false) */
+    LevelSetEikonalSolver                       m_eikonal;              /**< Solver used for propagating the levelset value (default = FAST_MARCHING) */
 
     public:
     ~LevelSet() ;
@@ -91,10 +100,13 @@ class LevelSet{
 
     double                                      getSizeNarrowBand() const;
 
+    MemoryUsage                                 getMemoryUsage() const;
+
     void                                        setSizeNarrowBand(double) ;
     void                                        setSign(bool);
     void                                        setPropagateSign(bool) ;
     void                                        setPropagateValue(bool) ;
+    void                                        setEikonalSolver(LevelSetEikonalSolver) ;
 
     void                                        dump( std::fstream &);
     void                                        restore( std::fstream &);
@@ -128,11 +140,27 @@ class LevelSetKernel{
     VolumeKernel*                               m_mesh ;        /**< Pointer to underlying mesh*/
 
     double                                      m_RSearch;      /**< Size of narrow band */
+    LevelSetEikonalSolver                       m_eikonal;      /**< Solver used for propagating the levelset value */
 
 # if BITPIT_ENABLE_MPI
     MPI_Comm                                    m_commMPI ;     /**< MPI communicator */
 # endif
 
+    /*!
+     * Flat description of the mesh used by the fast marching method.
+     * Cells are identified by their position in the storage order of the mesh.
+     */
+    struct EikonalStencil{
+        std::vector<long>                       ids ;           /**< Id of the cell at each position */
+        std::vector<long>                       neighOffsets ;  /**< Offset of the neighbours of each position, the last entry is the total number of neighbours */
+        std::vector<long>                       neighs ;        /**< Positions of the neighbours listed face by face (-1 if there is no neighbour) */
+    };
+
+    static const short                          EIKONAL_KNOWN = 0 ;     /**< The value of the cell is known */
+    static const short                          EIKONAL_TRIAL = 1 ;     /**< The cell is in the heap of the fast marching method */
+    static const short                          EIKONAL_FAR = 2 ;       /**< The value of the cell has not been evaluated yet */
+    static const short                          EIKONAL_EXCLUDED = 3 ;  /**< The cell does not take part to the propagation */
+
     public:
     virtual ~LevelSetKernel() ;
     LevelSetKernel() ;
@@ -150,6 +178,11 @@ class LevelSetKernel{
 
     void                                        setSizeNarrowBand(double) ;
 
+    MemoryUsage                                 getMemoryUsage() const;
+
+    LevelSetEikonalSolver                       getEikonalSolver() const;
+    void                                        setEikonalSolver(LevelSetEikonalSolver) ;
+
     virtual double                              computeSizeNarrowBand( LevelSetObject * )=0;
     virtual double                              updateSizeNarrowBand( const std::vector<adaption::Info> & )=0;
 
@@ -158,7 +191,7 @@ class LevelSetKernel{
     void                                        filterOutsideNarrowBand( double ) ;
 
     void                                        propagateSign( std::unordered_map<int,LevelSetObject*> ) ;
-    void                                        propagateValue( LevelSetObject *) ;
+    void                                        propagateValue( ) ;
 
     void                                        dump( std::fstream &);
     void                                        restore( std::fstream &);
@@ -173,8 +206,11 @@ class LevelSetKernel{
 # endif
 
     protected:
-    void                                        solveEikonal( double, double );
-    virtual double                              updateEikonal( double, double, const long &, const std::unordered_map<long,short> & ) ; 
+    void                                        buildEikonalStencil( EikonalStencil & ) const ;
+    bool                                        isEikonalCandidate( const long &, double ) const ;
+    virtual void                                solveEikonal( double, double );
+    virtual double                              updateEikonal( double, long, const EikonalStencil &, const std::vector<double> &, const std::vector<short> & ) const ;
+    static double                               solveEikonalQuadratic( int, std::array<double,3>, std::array<double,3>, double ) ;
 
     std::array<double,3>                        computeGradientUpwind(const long &) ;
     std::array<double,3>                        computeGradientCentral(const long &) ;
@@ -190,7 +226,9 @@ class LevelSetCartesian : public LevelSetKernel{
 
     private:
     double                                      updateSizeNarrowBand( const std::vector<adaption::Info> & );
-    double                                      updateEikonal( double, double, const long &, const std::unordered_map<long,short> & ) ; 
+    double                                      updateEikonal( double, long, const EikonalStencil &, const std::vector<double> &, const std::vector<short> & ) const ;
+    void                                        solveEikonal( double, double );
+    void                                        sweepEikonal( double, double );
 
     public:
     virtual ~LevelSetCartesian();
@@ -235,6 +273,8 @@ class LevelSetObject{
     virtual void                                updateLSInNarrowBand( LevelSetKernel *, const std::vector<adaption::Info> &, const double &, const bool &)=0 ;
     virtual void                                clearAfterMeshMovement( const std::vector<adaption::Info> & ) ;
 
+    virtual MemoryUsage                         getMemoryUsage() const ;
+
     virtual void                                dumpDerived( std::fstream &) =0 ;
     virtual void                                restoreDerived( std::fstream &) =0 ;
 
@@ -254,13 +294,12 @@ class LevelSetSegmentation : public LevelSetObject {
 
     private:
     struct SegInfo{
-        std::unordered_set<long>                m_segments ;                /**< list of segments within narrow band */
+        int                                     m_segments ;                /**< index of the list of segments within narrow band */
         long                                    m_support ;                 /**< closest segment to cell centroid */
         bool                                    m_checked ;                 /**< true if list of segments has been processed */
 
         SegInfo( ) ;
-        SegInfo( const std::unordered_set<long> & ) ;
-        SegInfo( const std::unordered_set<long> &, const long & ) ;
+        SegInfo( const long & ) ;
     };
 
     int                                         m_dimension ;               /**< number of space dimensions */
@@ -268,6 +307,7 @@ class LevelSetSegmentation : public LevelSetObject {
     SurfUnstructured*                           m_segmentation;             /**< surface segmentation */
     std::unordered_map< long, std::vector< std::array<double,3>> > m_vertexNormal;            /**< vertex normals */
     PiercedVector<SegInfo>                      m_seg;                      /**< cell -> segment association information */
+    CollapsedVector2D<long>                     m_segLists;                 /**< sorted lists of segments within narrow band of the cells */
 
 
     public:
@@ -277,7 +317,7 @@ class LevelSetSegmentation : public LevelSetObject {
 
     LevelSetSegmentation*                       clone() const ;
 
-    const std::unordered_set<long> &            getSimplexList(const long &) const ;
+    std::vector<long>                           getSimplexList(const long &) const ;
     long                                        getSupportSimplex(const long &) const;
     long                                        getSupport(const long &) const  ;
     bool                                        isInNarrowBand( const long &) ;
@@ -294,6 +334,8 @@ class LevelSetSegmentation : public LevelSetObject {
     void                                        updateLSInNarrowBand( LevelSetKernel *, const std::vector<adaption::Info> &, const double &, const bool & ) ;
     void                                        clearAfterMeshMovement( const std::vector<adaption::Info> & ) ;
 
+    MemoryUsage                                 getMemoryUsage() const ;
+
 # if BITPIT_ENABLE_MPI
     void                                        writeCommunicationBuffer( const std::vector<long> &, SendBuffer &, SendBuffer & ) ;
     void                                        readCommunicationBuffer(  const std::vector<long> &, const long &, RecvBuffer & ) ;
@@ -308,6 +350,8 @@ class LevelSetSegmentation : public LevelSetObject {
 
     void                                        updateSimplexToCell( LevelSetOctree *, const std::vector<adaption::Info> &, const double & ) ;
 
+    void                                        updateSimplexLists( std::vector<std::pair<long,long>> & ) ;
+
 };
 
 }
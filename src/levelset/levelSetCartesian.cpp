@@ -22,6 +22,8 @@
  *
 \*---------------------------------------------------------------------------*/
 
+# include <algorithm>
+
 # include "levelSet.hpp"
 
 # include "bitpit_SA.hpp"
@@ -85,65 +87,223 @@ double LevelSetCartesian::updateSizeNarrowBand( const std::vector<adaption::Info
 };
 
 /*! 
- * Update scalar field value at mesh vertex on a by locally solving the 3D Eikonal equation.
- * @param[in] s flag for inwards/outwards propagation (s = -+1).
- * @param[in] g propagation speed for the 3D Eikonal equation.
- * @param[in] I index of the cartesian cell to be updated.
- * @param[in] active list with dead/ alive/ far information
+ * Update scalar field value at mesh cell by locally solving the Eikonal equation
+ * with a first order upwind discretization.
+ * @param[in] g propagation speed for the Eikonal equation.
+ * @param[in] pos position of the cell to be updated.
+ * @param[in] stencil flat description of the mesh
+ * @param[in] values values of the cells
+ * @param[in] state state of the cells
  * @return updated value at cell centroid
  */
-double LevelSetCartesian::updateEikonal( double s, double g, const long &I, const std::unordered_map<long,short> &active ){
+double LevelSetCartesian::updateEikonal( double g, long pos, const EikonalStencil &stencil, const std::vector<double> &values, const std::vector<short> &state ) const {
 
-    int                d;
-    long               J;
-    double             h2, delta, value, a(0), b(0), c(0);
+    int                     dim( m_cartesian->getDimension() ) ;
+    std::array<double,3>    upwind, spacing ;
 
-    Cell&   cell = m_cartesian->getCell(I) ;
+    // Neighbours are listed face by face and each face of a cartesian cell has
+    // exactly one neighbour.
+    const long *neighs = stencil.neighs.data() + stencil.neighOffsets[pos] ;
 
-    for( d=0; d<m_cartesian->getDimension(); ++d){ // COMPUTE QUADRATIC FORM COEFFICIENTS FROM UPWIND STENCIL
+    for( int d=0; d<dim; ++d){
+        upwind[d]  = levelSetDefaults::VALUE ;
+        spacing[d] = m_cartesian->getSpacing(d) ;
 
-        value   = levelSetDefaults::VALUE ;
+        for( int side=0; side<2; ++side ){
+            long neigh = neighs[2*d+side] ;
+            if( neigh >= 0 && state[neigh] == EIKONAL_KNOWN ){
+                upwind[d] = std::min( upwind[d], values[neigh] ) ;
+            }
+        }
+    }
 
-        // Left neighbor
-        J   = cell.getAdjacency( 2*d, 0) ;
+    return solveEikonalQuadratic( dim, upwind, spacing, g ) ;
 
-        LSInfo  &lsInfo = m_ls[J] ;
+};
 
-        if( J >= 0 && active.at(J) == 0){
-            value = std::min(s*lsInfo.value, value);
-        };
+/*! 
+ * Solve the Eikonal equation |grad(u)| = g outside the narrow band.
+ * The fast sweeping method is used if it has been selected, otherwise the
+ * fast marching method of the base class is used.
+ * @param[in] g propagation speed.
+ * @param[in] s propagation sign (+1 --> propagate outwards, -1 --> propagate inwards).
+ */
+void LevelSetCartesian::solveEikonal( double g, double s ){
 
+    if( m_eikonal == LevelSetEikonalSolver::FAST_SWEEPING ){
+        sweepEikonal( g, s ) ;
+    } else {
+        LevelSetKernel::solveEikonal( g, s ) ;
+    }
 
-        // Right neighbor
-        J   = cell.getAdjacency( 2*d+1, 0) ;
+};
 
-        if( J >= 0 && active.at(J) == 0){
-            value = std::min(s*lsInfo.value, value);
-        };
+/*! 
+ * Solve the Eikonal equation |grad(u)| = g outside the narrow band using a
+ * fast sweeping method.
+ *
+ * Each iteration performs a Gauss-Seidel sweep for each of the 2^dim
+ * orderings of the grid. Cells are visited by hyperplanes orthogonal to the
+ * sweep direction: the cells on the same hyperplane do not depend on each
+ * other, hence they are split among the threads of the pool shared by the
+ * library, and the values are the same obtained by the serial sweep whatever
+ * is the number of threads.
+ * Iterations stop when no value changes by more than a small fraction of the
+ * grid spacing.
+ *
+ * @param[in] g propagation speed.
+ * @param[in] s propagation sign (+1 --> propagate outwards, -1 --> propagate inwards).
+ */
+void LevelSetCartesian::sweepEikonal( double g, double s ){
 
+    const int               MAX_ITERATIONS = 100 ;
 
-        // Update coeffs in the quadratic form
-        if (value < levelSetDefaults::VALUE) {
-            h2 = pow(m_cartesian->getSpacing(d), 2);
+    int                     dim( m_cartesian->getDimension() ) ;
+    long                    N( m_cartesian->getCellCount() ) ;
 
-            a += 1.0/h2;
-            b += -2.0 * value/h2;
-            c += std::pow(value, 2)/h2;
-        }
+    if( N == 0 ){
+        return ;
+    }
 
-    };
+    // Grid size
+    std::array<int,3>       nCells = m_cartesian->getCellCartesianId(N-1) ;
+    std::array<long,3>      strides ;
+    std::array<double,3>    spacing ;
+    double                  minSpacing = levelSetDefaults::VALUE ;
+
+    for( int d=0; d<3; ++d ){
+        nCells[d] = ( d < dim ) ? nCells[d] + 1 : 1 ;
+    }
 
+    strides[0] = 1 ;
+    strides[1] = nCells[0] ;
+    strides[2] = (long) nCells[0] *nCells[1] ;
 
-    { // SOLVE THE QUADRATIC FORM
-        // Quadratic form determinant
-        delta = pow(b, 2) - 4.0*a*(c - pow(g, 2));
+    for( int d=0; d<dim; ++d ){
+        spacing[d] = m_cartesian->getSpacing(d) ;
+        minSpacing = std::min( minSpacing, spacing[d] ) ;
+    }
+
+    double tolerance = 1.e-9 *minSpacing ;
+
+    // Initialize the values
+    std::vector<double>     values( N, levelSetDefaults::VALUE ) ;
+    std::vector<char>       fixed( N, 1 ) ;
 
-        // Solution
-        value = -(b - sqrt(delta))/(2.0*a);
+    for( long id=0; id<N; ++id ){
+        if( isInNarrowBand(id) ){
+            double value = s *m_ls[id].value ;
+            if( value >= 0. ){
+                values[id] = value ;
+            }
 
+        } else if( isEikonalCandidate(id, s) ){
+            fixed[id] = 0 ;
+
+        }
     }
 
-    return(value); 
+    // Sweeps
+    int nPlanes  = 1 ;
+    for( int d=0; d<dim; ++d ){
+        nPlanes += nCells[d] - 1 ;
+    }
+
+    int nChunks = threads::getThreadCount() ;
+
+    std::vector<std::array<int,2>> rows ;
+    std::vector<double>     changes ;
+
+    for( int iteration=0; iteration<MAX_ITERATIONS; ++iteration ){
+        double maxChange = 0. ;
+
+        for( int ordering=0; ordering<(1<<dim); ++ordering ){
+            for( int plane=0; plane<nPlanes; ++plane ){
+
+                // Rows of the hyperplane
+                rows.clear() ;
+
+                int kBegin = std::max( 0, plane - (nCells[0]-1) - (nCells[1]-1) ) ;
+                int kEnd   = std::min( nCells[2]-1, plane ) ;
+                for( int kk=kBegin; kk<=kEnd; ++kk ){
+                    int jBegin = std::max( 0, plane - kk - (nCells[0]-1) ) ;
+                    int jEnd   = std::min( nCells[1]-1, plane - kk ) ;
+                    for( int jj=jBegin; jj<=jEnd; ++jj ){
+                        rows.push_back( {{jj, kk}} ) ;
+                    }
+                }
+
+                // Update the cells of the hyperplane, each chunk of rows
+                // keeps track of its own largest change.
+                std::size_t nRows = rows.size() ;
+                changes.assign( std::min<std::size_t>( nChunks, nRows ), 0. ) ;
+                std::size_t chunkSize = ThreadPool::evalChunkSize( nChunks, nRows ) ;
+
+                threads::parallelFor( nChunks, nRows, [&]( std::size_t begin, std::size_t end ){
+
+                    std::array<int,3>   ijk ;
+                    std::array<double,3> upwind ;
+
+                    double &change = changes[begin / chunkSize] ;
+                    for( std::size_t row=begin; row<end; ++row ){
+                        int jj = rows[row][0] ;
+                        int kk = rows[row][1] ;
+                        int ii = plane - kk - jj ;
+
+                        ijk[0] = ( ordering & 1 ) ? nCells[0] - 1 - ii : ii ;
+                        ijk[1] = ( ordering & 2 ) ? nCells[1] - 1 - jj : jj ;
+                        ijk[2] = ( ordering & 4 ) ? nCells[2] - 1 - kk : kk ;
+
+                        long id = ijk[0] *strides[0] + ijk[1] *strides[1] + ijk[2] *strides[2] ;
+                        if( fixed[id] ){
+                            continue ;
+                        }
+
+                        for( int d=0; d<dim; ++d ){
+                            upwind[d] = levelSetDefaults::VALUE ;
+                            if( ijk[d] > 0 ){
+                                upwind[d] = std::min( upwind[d], values[id - strides[d]] ) ;
+                            }
+                            if( ijk[d] < nCells[d] - 1 ){
+                                upwind[d] = std::min( upwind[d], values[id + strides[d]] ) ;
+                            }
+                        }
+
+                        double value = solveEikonalQuadratic( dim, upwind, spacing, g ) ;
+                        if( value < values[id] ){
+                            change = std::max( change, values[id] - value ) ;
+                            values[id] = value ;
+                        }
+                    }
+                });
+
+                for( double change : changes ){
+                    maxChange = std::max( maxChange, change ) ;
+                }
+            }
+        }
+
+        // Check convergence
+        if( maxChange <= tolerance ){
+            break ;
+        }
+    }
+
+    // Store the values
+    for( long id=0; id<N; ++id ){
+        if( fixed[id] || values[id] >= levelSetDefaults::VALUE ){
+            continue ;
+        }
+
+        PiercedIterator<LSInfo> infoItr = m_ls.find(id) ;
+        if( infoItr == m_ls.end() ){
+            infoItr = m_ls.reclaim(id) ;
+            infoItr->gradient = levelSetDefaults::GRADIENT ;
+            infoItr->object   = levelSetDefaults::OBJECT ;
+        }
+
+        infoItr->value = s *values[id] ;
+    }
 
 };
 
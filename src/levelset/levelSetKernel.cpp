@@ -29,6 +29,7 @@
 # endif
 
 # include <stack>
+# include <algorithm>
 # include <unordered_set>
 
 # include "bitpit_SA.hpp"
@@ -45,6 +46,11 @@ namespace bitpit {
 
 */
 
+const short LevelSetKernel::EIKONAL_KNOWN ;
+const short LevelSetKernel::EIKONAL_TRIAL ;
+const short LevelSetKernel::EIKONAL_FAR ;
+const short LevelSetKernel::EIKONAL_EXCLUDED ;
+
 /*!
  * Default constructor.
  */
@@ -52,6 +58,8 @@ LevelSetKernel::LevelSetKernel() {
 
     m_mesh = NULL ;
 
+    m_eikonal  = LevelSetEikonalSolver::FAST_MARCHING ;
+
 #if BITPIT_ENABLE_MPI
     m_commMPI = MPI_COMM_NULL;
 # endif
@@ -178,6 +186,17 @@ double LevelSetKernel::getSizeNarrowBand()const{
     return m_RSearch;
 };
 
+/*!
+ * Evaluate the memory used by the levelset information of the cells.
+ * @return memory used by the kernel
+ */
+MemoryUsage LevelSetKernel::getMemoryUsage()const{
+    MemoryUsage usage("kernel") ;
+    usage.addComponent("cell info", m_ls.getMemoryUsage()) ;
+
+    return usage ;
+};
+
 /*!
  * Manually set the size of the narrow band.
  * @param[in] r size of the narrow band.
@@ -186,6 +205,23 @@ void LevelSetKernel::setSizeNarrowBand(double r){
     m_RSearch = r;
 };
 
+/*!
+ * Get the solver used for propagating the levelset value outside the narrow band.
+ * @return Eikonal solver
+ */
+LevelSetEikonalSolver LevelSetKernel::getEikonalSolver()const{
+    return m_eikonal;
+};
+
+/*!
+ * Set the solver used for propagating the levelset value outside the narrow band.
+ * Kernels which do not support the requested solver use the fast marching method.
+ * @param[in] solver Eikonal solver
+ */
+void LevelSetKernel::setEikonalSolver(LevelSetEikonalSolver solver){
+    m_eikonal = solver;
+};
+
 /*!
  * Computes the Level Set Gradient on on cell by first order finite-volume upwind stencil
  * @param[in] I index of cell 
@@ -403,10 +439,12 @@ void LevelSetKernel::propagateSign( std::unordered_map<int,LevelSetObject*> visi
 
 /*!
  * Driver routine for propagtaing levelset value by a fast marching method
+ * or, if selected and supported by the mesh, by a fast sweeping method.
+ * The value is propagated first in the region with positive levelset and
+ * then in the region with negative levelset, the sign of the cells outside
+ * the narrow band should have been already propagated.
  */
-void LevelSetKernel::propagateValue( LevelSetObject *visitor ){
-
-    BITPIT_UNUSED(visitor) ;
+void LevelSetKernel::propagateValue( ){
 
     // Propagate outwards ------------------------------------------------------- //
     solveEikonal(1.0, 1.0);
@@ -419,168 +457,318 @@ void LevelSetKernel::propagateValue( LevelSetObject *visitor ){
 
 };
 
-/*! 
- * Solve the 3D Eikonal equation |grad(u)| = g, using  a fast marching method
- * (Function in the unknown region must be set to the value 1.0e+18)
- * @param[in] g Propagation speed.
- * @param[in] s Velocity sign (+1 --> propagate outwards, -1 --> propagate inwards).
+/*!
+ * Builds the flat description of the mesh used by the fast marching method.
+ * Cells are numbered according to their position in the mesh storage and the
+ * face neighbours of each cell are stored in compressed row format.
+ * @param[out] stencil flat description of the mesh
  */
-void LevelSetKernel::solveEikonal( double g, double s ){
+void LevelSetKernel::buildEikonalStencil( EikonalStencil &stencil ) const {
+
+    const PiercedVector<Cell>   &cells = m_mesh->getCells() ;
+    long                        N( m_mesh->getCellCount() ) ;
 
-    long                            N( m_mesh->getCellCount()) ;
-    std::unordered_map<long,short>   active ;
+    // Position of the cells
+    std::size_t                 rawSize = 0 ;
+    std::vector<std::size_t>    rawIndexes ;
 
-    { //FLAG ALIVE, DEAD AND FAR AWAY VERTEXES
-        long    m(0), myId ;
-        bool    check;
+    stencil.ids.clear() ;
+    stencil.ids.reserve(N) ;
+    rawIndexes.reserve(N) ;
+    for( const Cell &cell : cells ){
+        long id = cell.getId() ;
+        std::size_t raw = cells.rawIndex(id) ;
 
-        std::vector<long>               neighs ;
-        std::vector<long>::iterator     it, itbeg, itend ;
+        stencil.ids.push_back(id) ;
+        rawIndexes.push_back(raw) ;
+        rawSize = std::max( rawSize, raw + 1 ) ;
+    }
 
-        for ( const auto &cell : m_mesh->getCells() ){ 
+    std::vector<long>           rawToPosition( rawSize, -1 ) ;
+    for( long pos=0; pos<N; ++pos ){
+        rawToPosition[rawIndexes[pos]] = pos ;
+    }
 
-            myId           = cell.getId() ;
+    // Neighbours
+    stencil.neighOffsets.resize(N + 1) ;
+    stencil.neighs.clear() ;
+    stencil.neighs.reserve( 2 * m_mesh->getDimension() * N ) ;
+
+    for( long pos=0; pos<N; ++pos ){
+        const Cell &cell = cells[stencil.ids[pos]] ;
+
+        stencil.neighOffsets[pos] = stencil.neighs.size() ;
+
+        int nFaces = cell.getFaceCount() ;
+        for( int face=0; face<nFaces; ++face ){
+            int nFaceAdjacencies = cell.getAdjacencyCount(face) ;
+            const long *faceAdjacencies = cell.getAdjacencies(face) ;
+            for( int k=0; k<nFaceAdjacencies; ++k ){
+                long neighId = faceAdjacencies[k] ;
+                if( neighId < 0 ){
+                    stencil.neighs.push_back(-1) ;
+                } else {
+                    stencil.neighs.push_back( rawToPosition[cells.rawIndex(neighId)] ) ;
+                }
+            }
+        }
+    }
+
+    stencil.neighOffsets[N] = stencil.neighs.size() ;
+
+    return ;
+
+};
 
-            if ( isInNarrowBand(myId) ){ // dead vertex
-                active.insert( {{myId, 0}} ) ;
+/*!
+ * Checks if the levelset value of a cell should be evaluated by the
+ * propagation, i.e. if the cell is outside the narrow band and its
+ * levelset has the sign of the propagation.
+ * @param[in] id cell index
+ * @param[in] s propagation sign (+1 --> propagate outwards, -1 --> propagate inwards).
+ * @return true if the cell takes part to the propagation
+ */
+bool LevelSetKernel::isEikonalCandidate( const long &id, double s ) const {
 
-            } else{
+    return ( !isInNarrowBand(id) && s *getSign(id) > 0. ) ;
 
-                // Loop over neighbors
-                check   = false;
-                neighs = m_mesh->findCellFaceNeighs(myId) ;
+};
 
-                it    = neighs.begin() ;
-                itend = neighs.end() ;
+/*! 
+ * Solve the 3D Eikonal equation |grad(u)| = g, using  a fast marching method.
+ *
+ * The state of the method is stored in flat arrays indexed by the position
+ * of the cells in the mesh storage and the trial cells are kept in an
+ * indexed binary heap. Cells in the narrow band provide the boundary
+ * condition, cells outside the narrow band whose sign is equal to the
+ * propagation sign are evaluated, all other cells are left untouched.
+ *
+ * @param[in] g Propagation speed.
+ * @param[in] s Velocity sign (+1 --> propagate outwards, -1 --> propagate inwards).
+ */
+void LevelSetKernel::solveEikonal( double g, double s ){
 
-                while( !check &&  it != itend  ){
+    EikonalStencil                  stencil ;
+    buildEikonalStencil(stencil) ;
 
-                    check = (s*m_ls[*it].value >= 0.0) && (abs(m_ls[*it].value) < levelSetDefaults::VALUE) ;
-                    ++it ;
+    long                            N( stencil.ids.size() ) ;
 
-                };
+    std::vector<double>             values( N, levelSetDefaults::VALUE ) ;
+    std::vector<short>              state( N, EIKONAL_EXCLUDED ) ;
 
-                active.insert( {{ myId, 2 - (int) check }} )  ;
-                m += (int) check  ;
+    // Initialize the state
+    for( long pos=0; pos<N; ++pos ){
+        long id = stencil.ids[pos] ;
 
+        if( isInNarrowBand(id) ){
+            double value = s *m_ls[id].value ;
+            if( value >= 0. ){
+                state[pos]  = EIKONAL_KNOWN ;
+                values[pos] = value ;
             }
-        } //next i
-    }
 
+        } else if( isEikonalCandidate(id, s) ){
+            state[pos] = EIKONAL_FAR ;
 
-    { // Construct min heap data structure 
-        long                            m(0), I(0), myId, J ;
-        double                          value ;
+        }
+    }
 
-        std::vector<long>               neighs ;
-        std::vector<long>::iterator     it, itbeg, itend ;
+    // Initialize the heap with the cells next to the known ones
+    std::vector<std::array<int,2>>  map(N) ;
+    MinPQueue<double, long>         heap( 1024, false, &map ) ;
 
-        std::unordered_map<long,long>   contiguos ;
-        std::vector<std::array<int,2>>  map(N), *mapPtr = &map;
-        MinPQueue<double, long> heap(m, true, mapPtr);
+    for( long pos=0; pos<N; ++pos ){
+        if( state[pos] != EIKONAL_FAR ){
+            continue ;
+        }
 
-        for ( const auto &cell : m_mesh->getCells() ){ 
+        bool nextToKnown = false ;
+        for( long n=stencil.neighOffsets[pos]; n<stencil.neighOffsets[pos+1]; ++n ){
+            long neigh = stencil.neighs[n] ;
+            if( neigh >= 0 && state[neigh] == EIKONAL_KNOWN ){
+                nextToKnown = true ;
+                break ;
+            }
+        }
 
-            myId = cell.getId() ;
-            contiguos.insert( {{myId,I}} ) ;
+        if( nextToKnown ){
+            double value = updateEikonal(g, pos, stencil, values, state) ;
 
-            if (active[myId] == 1) {
+            state[pos] = EIKONAL_TRIAL ;
+            map[heap.heap_size][0] = pos ;
+            map[pos][1] = heap.heap_size ;
+            heap.insert(value) ;
+        }
+    }
 
-                // Solve the quadratic form
-                value = updateEikonal(s, g, myId, active);
+    // Fast marching
+    while (heap.heap_size > 0) {
 
-                // Store value into heap
-                map[m][0] = I;
-                map[I][1] = m; 
+        // Extract root
+        long    pos = map[0][0] ;
+        double  value ;
 
+        heap.extract(value) ;
 
-                heap.keys[m] = value;
-                heap.labels[m] = myId;
+        state[pos]  = EIKONAL_KNOWN ;
+        values[pos] = value ;
 
-                // Update counter
-                m++;
+        // Update the neighbours
+        for( long n=stencil.neighOffsets[pos]; n<stencil.neighOffsets[pos+1]; ++n ){
+            long neigh = stencil.neighs[n] ;
+            if( neigh < 0 ){
+                continue ;
             }
 
-            ++I;
-
-        } //next i
+            short neighState = state[neigh] ;
+            if( neighState == EIKONAL_TRIAL ){
+                double neighValue = updateEikonal(g, neigh, stencil, values, state) ;
+                int heapIndex = map[neigh][1] ;
+                if( neighValue < heap.keys[heapIndex] ){
+                    heap.modify( heapIndex, neighValue ) ;
+                }
 
-        // Build min-heap 
-        heap.heap_size = m;
-        heap.buildHeap();
+            } else if( neighState == EIKONAL_FAR ){
+                double neighValue = updateEikonal(g, neigh, stencil, values, state) ;
 
-        // FAST MARCHING
-        while (heap.heap_size > 0) {
+                state[neigh] = EIKONAL_TRIAL ;
+                map[heap.heap_size][0] = neigh ;
+                map[neigh][1] = heap.heap_size ;
+                heap.insert(neighValue) ;
+            }
+        }
 
+    } //next item
 
-            // Extract root
-            heap.extract(value, myId);
+    // Store the values
+    for( long pos=0; pos<N; ++pos ){
+        if( state[pos] != EIKONAL_KNOWN || values[pos] >= levelSetDefaults::VALUE ){
+            continue ;
+        }
 
-            LSInfo &lsInfo = m_ls[myId] ;
+        long id = stencil.ids[pos] ;
+        if( isInNarrowBand(id) ){
+            continue ;
+        }
 
-            // Update level set value
-            lsInfo.value = s*updateEikonal(s, g, myId, active);
+        PiercedIterator<LSInfo> infoItr = m_ls.find(id) ;
+        if( infoItr == m_ls.end() ){
+            infoItr = m_ls.reclaim(id) ;
+            infoItr->gradient = levelSetDefaults::GRADIENT ;
+            infoItr->object   = levelSetDefaults::OBJECT ;
+        }
 
-            // Update m_activeNode to dead node
-            active.at(myId) = 0;
+        infoItr->value = s *values[pos] ;
+    }
 
-            // Upadate far-away neighboors
-            neighs = m_mesh->findCellFaceNeighs(myId) ;
+    return; 
+};
 
-            itbeg = neighs.begin() ;
-            itend = neighs.end() ;
+/*! 
+ * Update scalar field value at mesh cell by locally solving the Eikonal equation.
+ *
+ * Known neighbours are grouped according to the coordinate axis closest to
+ * the segment that joins their centroid to the centroid of the cell, and the
+ * first order upwind discretization is solved as on a cartesian cell. The
+ * value is also limited by the one obtained assuming that the front reaches
+ * the cell directly from a single known neighbour, which provides a fallback
+ * for meshes that are not aligned with the axes.
+ *
+ * @param[in] g Propagation speed for the Eikonal equation.
+ * @param[in] pos position of the cell to be updated.
+ * @param[in] stencil flat description of the mesh
+ * @param[in] values values of the cells
+ * @param[in] state state of the cells
+ * @return Updated value at mesh cell
+ */
+double LevelSetKernel::updateEikonal( double g, long pos, const EikonalStencil &stencil, const std::vector<double> &values, const std::vector<short> &state ) const {
 
-            for( it=itbeg; it != itend; ++it){
+    int                     dim( m_mesh->getDimension() ) ;
+    double                  value = levelSetDefaults::VALUE ;
+    std::array<double,3>    centroid = m_mesh->evalCellCentroid( stencil.ids[pos] ) ;
 
-                J = *it;
+    std::array<double,3>    upwind, spacing ;
+    upwind.fill( levelSetDefaults::VALUE ) ;
+    spacing.fill( 0. ) ;
 
-                // Update the local value
-                value = updateEikonal(s, g, J, active);
+    for( long n=stencil.neighOffsets[pos]; n<stencil.neighOffsets[pos+1]; ++n ){
+        long neigh = stencil.neighs[n] ;
+        if( neigh < 0 || state[neigh] != EIKONAL_KNOWN ){
+            continue ;
+        }
 
-                if (active.at(J) == 1) { // Update value in min-heap
-                    I = contiguos[J] ;
-                    heap.modify( map[I][1], value, J );
-                }
+        std::array<double,3> offset = m_mesh->evalCellCentroid( stencil.ids[neigh] ) - centroid ;
 
-                else if (active.at(J) == 2) {
+        // Front coming directly from the neighbour
+        value = std::min( value, values[neigh] + g *norm2(offset) ) ;
 
-                    // Update m_activeNode for neighbor
-                    active.at(J) = 1;
+        // Upwind value along the closest axis
+        int axis = 0 ;
+        for( int d=1; d<dim; ++d ){
+            if( std::abs(offset[d]) > std::abs(offset[axis]) ){
+                axis = d ;
+            }
+        }
 
-                    I = contiguos[J] ;
+        if( values[neigh] < upwind[axis] ){
+            upwind[axis]  = values[neigh] ;
+            spacing[axis] = std::abs(offset[axis]) ;
+        }
+    }
 
-                    // Insert neighbor into the min heap
-                    map[heap.heap_size][0] = I ;
-                    map[I][1] = heap.heap_size;
+    // Directions without known neighbours are moved at the end by the solver
+    return std::min( value, solveEikonalQuadratic( dim, upwind, spacing, g ) ) ;
+};
 
-                    heap.insert(value, J);
+/*!
+ * Solves the first order upwind discretization of the Eikonal equation
+ * |grad(u)| = g on a cell whose neighbours are aligned with the coordinate axes.
+ * Directions whose upwind value is not smaller than the solution do not
+ * contribute to the gradient and are discarded.
+ * @param[in] dim number of dimensions
+ * @param[in] upwind smallest neighbour value along each direction
+ * @param[in] spacing grid spacing along each direction
+ * @param[in] g propagation speed
+ * @return solution
+ */
+double LevelSetKernel::solveEikonalQuadratic( int dim, std::array<double,3> upwind, std::array<double,3> spacing, double g ){
 
-                };
-            };
+    // Sort directions by upwind value
+    for( int i=1; i<dim; ++i ){
+        for( int j=i; j>0 && upwind[j] < upwind[j-1]; --j ){
+            std::swap( upwind[j], upwind[j-1] ) ;
+            std::swap( spacing[j], spacing[j-1] ) ;
+        }
+    }
 
-        } //next item
+    if( upwind[0] >= levelSetDefaults::VALUE ){
+        return levelSetDefaults::VALUE ;
     }
 
+    double value = upwind[0] + g *spacing[0] ;
 
-    return; 
-};
+    double a(0), b(0), c(0) ;
+    for( int d=0; d<dim; ++d ){
+        if( upwind[d] >= levelSetDefaults::VALUE || value <= upwind[d] ){
+            break ;
+        }
 
-/*! 
- * Update scalar field value at mesh vertex on a by locally solving the 3D Eikonal equation.
- * @param[in] s Flag for inwards/outwards propagation (s = -+1).
- * @param[in] g Propagation speed for the 3D Eikonal equation.
- * @param[in] I index of the cartesian cell to be updated.
- * @param[in] active list with dead/ alive/ far information
- * @return Updated value at mesh vertex
- */
-double LevelSetKernel::updateEikonal( double s, double g, const long &I, const std::unordered_map<long,short> &active ){
+        double h2 = spacing[d] *spacing[d] ;
+
+        a += 1.0 /h2 ;
+        b += upwind[d] /h2 ;
+        c += upwind[d] *upwind[d] /h2 ;
+
+        double delta = b *b - a *( c - g *g ) ;
+        if( delta < 0. ){
+            break ;
+        }
+
+        value = ( b + std::sqrt(delta) ) /a ;
+    }
 
-    BITPIT_UNUSED(s) ;
-    BITPIT_UNUSED(g) ;
-    BITPIT_UNUSED(I) ;
-    BITPIT_UNUSED(active) ;
+    return value ;
 
-    return levelSetDefaults::VALUE;
 };
 
 /*! 
@@ -69,6 +69,16 @@ void LevelSetObject::clearAfterMeshMovement( const std::vector<adaption::Info> &
     return;
 }
 
+/*!
+ * Evaluate the memory used by the object.
+ * The base object holds no data, derived objects should report the memory
+ * used by their own data structures.
+ * @return memory used by the object
+ */
+MemoryUsage LevelSetObject::getMemoryUsage( ) const{
+    return MemoryUsage("object " + std::to_string(m_id)) ;
+}
+
 /*!
  * Writes LevelSetObject to stream in binary format
  * @param[in] stream output stream
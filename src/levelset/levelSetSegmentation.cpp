@@ -22,6 +22,9 @@
  *
 \*---------------------------------------------------------------------------*/
 
+# include <algorithm>
+# include <limits>
+
 # include "levelSet.hpp"
 
 # include "bitpit_common.hpp"
@@ -39,22 +42,14 @@ namespace bitpit {
 /*!
  * Default constructor 
  */
-LevelSetSegmentation::SegInfo::SegInfo( ) : m_segments(levelSetDefaults::LIST), m_support(levelSetDefaults::ELEMENT), m_checked(false){
-};
-
-/*!
- * Constructor
- * @param[in] list list of simplices
- */
-LevelSetSegmentation::SegInfo::SegInfo( const std::unordered_set<long> &list) :m_segments(list), m_support(levelSetDefaults::ELEMENT), m_checked(false) {
+LevelSetSegmentation::SegInfo::SegInfo( ) : m_segments(-1), m_support(levelSetDefaults::ELEMENT), m_checked(false){
 };
 
 /*!
  * Constructor
- * @param[in] list list of simplices
  * @param[in] support index of closest simplex
  */
-LevelSetSegmentation::SegInfo::SegInfo( const std::unordered_set<long> &list, const long &support) :m_segments(list), m_support(support), m_checked(false){
+LevelSetSegmentation::SegInfo::SegInfo( const long &support) : m_segments(-1), m_support(support), m_checked(false){
 };
 
 /*!
@@ -127,14 +122,16 @@ LevelSetSegmentation* LevelSetSegmentation::clone() const {
 /*!
  * Get the list of simplices wich contain the cell centroid in their narrow band.
  * @param[in] i cell index
- * @return set with indices of simplices
+ * @return sorted indices of simplices
  */
-const std::unordered_set<long> & LevelSetSegmentation::getSimplexList(const long &i) const{
+std::vector<long> LevelSetSegmentation::getSimplexList(const long &i) const{
 
     if( !m_seg.exists(i) ){
         return levelSetDefaults::LIST;
     } else {
-        return ( m_seg[i].m_segments );
+        int list = m_seg[i].m_segments ;
+        const long *segments = m_segLists.get(list) ;
+        return ( std::vector<long>( segments, segments + m_segLists.sub_array_size(list) ) );
     };
 
 };
@@ -188,7 +185,15 @@ std::vector<std::array<double,3>> LevelSetSegmentation::getSimplexVertices( cons
 };
 
 /*!
- * Update the levelset function of whole mesh by using associated simplices
+ * Update the levelset function of whole mesh by using associated simplices.
+ *
+ * The cells that have not been checked yet are evaluated concurrently using
+ * the thread pool shared by the library. The evaluation of a cell only reads
+ * the mesh, the segmentation and the associated simplices, and writes its
+ * result in a private slot; levelset and segment containers are modified only
+ * afterwards, by the calling thread, in the order the cells are stored.
+ * Therefore the result does not depend on the number of threads.
+ *
  * @param[in] visitee visited mesh 
  * @param[in] search size of narrow band
  * @param[in] signd if signed- or unsigned- distance function should be calculated
@@ -199,83 +204,162 @@ void LevelSetSegmentation::lsFromSimplex( LevelSetKernel *visitee, const double
     VolumeKernel                &mesh  = *(visitee->getMesh() ) ;
 
     long                        id ;
-    double                      s, d, value;
-    std::array<double,3>        n, xP, P;
+    int                         k, nSegs ;
 
-    std::unordered_set<long>::iterator    it, itend ;
     PiercedIterator<SegInfo>    segIt ;
     PiercedVector<LevelSetKernel::LSInfo>       &lsInfo = visitee->getLSInfo() ;
 
-    for( segIt=m_seg.begin(); segIt!=m_seg.end(); ++segIt ){
+    // Results of the evaluation of one cell
+    struct CellEval {
+        long                    id ;            /**< Id of the cell */
+        SegInfo                 *segInfo ;      /**< Segment information of the cell */
+        std::size_t             flagOffset ;    /**< Offset of the cell in the flags of the segments */
+        bool                    found ;         /**< True if the levelset of the cell has been improved */
+        double                  distance ;      /**< Distance of the closest simplex */
+        double                  value ;         /**< Levelset value */
+        std::array<double,3>    gradient ;      /**< Levelset gradient */
+    };
 
+    // Collect the cells to be evaluated and the data they need, each cell
+    // gets its own slot for the results and its own range of flags for
+    // marking the segments that are within the narrow band.
+    std::vector<CellEval>       evals ;
+    std::size_t                 nFlags = 0 ;
+
+    evals.reserve( m_seg.size() ) ;
+    for( segIt=m_seg.begin(); segIt!=m_seg.end(); ++segIt ){
         SegInfo                 &segInfo = *segIt ;
+        if( segInfo.m_checked ){
+            continue ;
+        }
 
-        if( segInfo.m_checked == false){
-            segInfo.m_checked = true ;
+        CellEval                eval ;
 
-            std::unordered_set<long>    &segs = segInfo.m_segments ;
-            long                        &supp = segInfo.m_support ;
+        eval.id         = segIt.getId() ;
+        eval.segInfo    = &segInfo ;
+        eval.flagOffset = nFlags ;
+        eval.found      = false ;
 
-            id    = segIt.getId() ;
+        auto lsInfoItr = lsInfo.find(eval.id) ;
+        if( lsInfoItr != lsInfo.end() ){
+            eval.distance = abs( lsInfoItr->value );
+        } else {
+            eval.distance = 1e18;
+        }
 
-            it    = segs.begin();
-            itend = segs.end() ;
+        evals.push_back(eval) ;
+        nFlags += m_segLists.sub_array_size(segInfo.m_segments) ;
+    }
 
-            P = mesh.evalCellCentroid(id) ;
+    std::vector<char>           inBand( nFlags, 0 ) ;
 
-            auto lsInfoItr = lsInfo.find(id) ;
-            if( lsInfoItr != lsInfo.end() ){
-                value = abs( lsInfoItr->value );
-            } else {
-                value = 1e18;
-            }
+    // Evaluate the cells
+    auto evaluate = [&]( std::size_t begin, std::size_t end ){
 
-            while( it != itend ){
+        int                     nCellSegs ;
+        double                  s, d ;
+        std::array<double,3>    n, xP, P ;
 
-                infoFromSimplex(P, *it, d, s, xP, n);
+        for( std::size_t i=begin; i<end; ++i ){
+            CellEval            &eval = evals[i] ;
+            SegInfo             &segInfo = *(eval.segInfo) ;
 
-                if ( d <= search ){
+            const long          *segs = m_segLists.get(segInfo.m_segments) ;
+            nCellSegs = m_segLists.sub_array_size(segInfo.m_segments) ;
 
-                    if( d<value ) {
-                        if (lsInfoItr == lsInfo.end()) {
-                            lsInfoItr = lsInfo.reclaim(id) ;
-                        }
+            segInfo.m_checked = true ;
 
-                        value   = d ;
+            P = mesh.evalCellCentroid(eval.id) ;
 
-                        lsInfoItr->object   = getId();
-                        lsInfoItr->value    = ( signd *s  + (!signd) *1.) *d; 
-                        lsInfoItr->gradient = ( signd *1. + (!signd) *s ) *n ;
-                        supp                = *it ;
-                    }
+            for( int j=0; j<nCellSegs; ++j ){
 
-                    ++it ;
+                infoFromSimplex(P, segs[j], d, s, xP, n);
 
-                } //end if distance
+                if ( d <= search ){
 
-                else {
-                    if( filter){ 
-                        it = segs.erase(it) ; 
+                    if( d<eval.distance ) {
+                        eval.found      = true ;
+                        eval.distance   = d ;
+                        eval.value      = ( signd *s  + (!signd) *1.) *d; 
+                        eval.gradient   = ( signd *1. + (!signd) *s ) *n ;
+                        segInfo.m_support = segs[j] ;
                     }
 
-                    else{
-                        ++it ;
-                    };
-                };
+                    inBand[eval.flagOffset + j] = 1 ;
 
+                } //end if distance
 
             } //end foreach triangle
+        }
+    };
 
-            if( segs.size() == 0 ){
-                m_seg.erase(id,true) ;
-            };
+    std::size_t nEvals = evals.size() ;
+    threads::parallelFor( threads::getThreadCount(), nEvals, evaluate ) ;
+
+    // Store the results
+    lsInfo.reserve( lsInfo.size() + nEvals ) ;
+    for( const CellEval &eval : evals ){
+        if( !eval.found ){
+            continue ;
+        }
+
+        auto lsInfoItr = lsInfo.find(eval.id) ;
+        if (lsInfoItr == lsInfo.end()) {
+            lsInfoItr = lsInfo.reclaim(eval.id) ;
+        }
+
+        lsInfoItr->object   = getId();
+        lsInfoItr->value    = eval.value ;
+        lsInfoItr->gradient = eval.gradient ;
+    }
+
+    // When filtering, the lists of the segments are rebuilt keeping only the
+    // segments within the narrow band
+    CollapsedVector2D<long>     filteredLists ;
+    if( filter ){
+        filteredLists.reserve( m_segLists.size(), m_segLists.sub_arrays_total_size() ) ;
+    }
+
+    std::vector<CellEval>::const_iterator evalItr = evals.begin() ;
+    for( segIt=m_seg.begin(); segIt!=m_seg.end(); ++segIt ){
 
+        SegInfo                 &segInfo = *segIt ;
+
+        const long              *segs = m_segLists.get(segInfo.m_segments) ;
+        nSegs = m_segLists.sub_array_size(segInfo.m_segments) ;
+
+        id = segIt.getId() ;
+
+        bool evaluated = ( evalItr != evals.end() && evalItr->id == id ) ;
+
+        if( filter ){
+            filteredLists.push_back() ;
+            for( k=0; k<nSegs; ++k ){
+                if( !evaluated || inBand[evalItr->flagOffset + k] ){
+                    filteredLists.push_back_in_sub_array( segs[k] ) ;
+                }
+            }
+
+            segInfo.m_segments = filteredLists.size() - 1 ;
+            nSegs = filteredLists.sub_array_size(segInfo.m_segments) ;
+        }
+
+        if( evaluated ){
+            ++evalItr ;
+        }
+
+        if( nSegs == 0 ){
+            m_seg.erase(id,true) ;
         };
 
     };// foreach cell
 
     m_seg.flush() ;
 
+    if( filter ){
+        m_segLists.swap( filteredLists ) ;
+    }
+
     return;
 
 };
@@ -484,7 +568,7 @@ void LevelSetSegmentation::associateSimplexToCell( LevelSetCartesian *visitee, c
 
     std::vector<long>                       neighs ;
 
-    PiercedVector<SegInfo>::iterator data ;
+    std::vector<std::pair<long,long>>       pairs ;
 
 
     stack.reserve(128) ;
@@ -520,12 +604,7 @@ void LevelSetSegmentation::associateSimplexToCell( LevelSetCartesian *visitee, c
             for( const auto & I : stack){
                 if ( *vit <= RSearch ) {
 
-                    if( m_seg.exists(I) ){
-                        m_seg[I].m_segments.insert(i) ;
-                    } else {
-                        data = m_seg.reclaim(I) ;
-                        data->m_segments.insert(i);
-                    };
+                    pairs.push_back( std::make_pair( (long) I, (long) i ) ) ;
 
 
                     neighs  = mesh.findCellFaceNeighs(I) ; 
@@ -551,75 +630,217 @@ void LevelSetSegmentation::associateSimplexToCell( LevelSetCartesian *visitee, c
 
     } //end for i
 
+    updateSimplexLists( pairs ) ;
+
     return;
 
 };
 
 /*!
- * Determines the list of triangles which influence each cell (i.e. cells which are within the narrow band of the triangle) for octree meshes
+ * Determines the list of triangles which influence each cell (i.e. cells which are within the narrow band of the triangle) for octree meshes.
+ * The octree is descended starting from the root and the branches which are farther than the size of the narrow band
+ * from a simplex are pruned, so only the octants inside the narrow band are visited and no auxiliary mesh is needed.
  * @param[in] visitee pointer to octree mesh
  * @param[in] RSearch size of narrow band
  */
 void LevelSetSegmentation::associateSimplexToCell( LevelSetOctree *visitee, const double &RSearch){
 
-    VolumeKernel                &mesh = *(visitee->getMesh()) ;
+    struct OctantKey{
+        uint64_t                morton ;
+        uint8_t                 level ;
+        long                    id ;
+    };
+
+    struct DescentNode{
+        uint8_t                 level ;
+        std::array<uint32_t,3>  anchor ;
+        std::size_t             begin ;
+        std::size_t             end ;
+        std::size_t             candidateBegin ;
+        std::size_t             candidateEnd ;
+    };
+
+    // The kernel of a LevelSetOctree is always built on top of an octree
+    VolOctree                   &mesh = *(static_cast<VolOctree*>(visitee->getMesh())) ;
+    PabloUniform                &tree = mesh.getTree() ;
     int                         dim(mesh.getDimension()) ;
-    long                        id, icart;
-    int                         i;
-    double                      size ;
 
-    std::array<double,3>        C, C0, C1, G0, G1, octrBB0, octrBB1, triBB0, triBB1 ;
-    PiercedVector<SegInfo>::iterator data;
+    std::array<double,3>        B0, B1, S0, S1, octrBB0, octrBB1, C, xP ;
+    int                         flag ;
 
-    // mesh size corresponding to RSearch
-    size = visitee->computeSizeFromRSearch( RSearch ) ;
+    // Octants of the local mesh (ghosts included) sorted by Morton number
+    std::vector<OctantKey>      octants ;
+    octants.reserve( mesh.getCellCount() ) ;
+
+    for( auto & cell : mesh.getCells() ){
+        long id = cell.getId() ;
+
+        VolOctree::OctantInfo octantInfo = mesh.getCellOctant(id) ;
+        Octant *octant ;
+        if( octantInfo.internal ){
+            octant = tree.getOctant(octantInfo.id) ;
+        } else {
+            octant = tree.getGhostOctant(octantInfo.id) ;
+        }
+
+        octants.push_back( { tree.getMorton(octant), tree.getLevel(octant), id } ) ;
+    };
+
+    std::sort( octants.begin(), octants.end(), [](const OctantKey &a, const OctantKey &b){ return a.morton < b.morton; } ) ;
+
+    // Simplices whose narrow band intersects the local mesh
+    std::vector<long>                               simplexIds ;
+    std::vector<std::vector<std::array<double,3>>>  simplexVertices ;
+    std::vector<std::array<std::array<double,3>,2>> simplexBoxes ;
+
+    // Candidate simplices of the nodes, each node refers to a range of the
+    // list. The lists of the nodes along the current branch are stacked one
+    // after the other, siblings share the list of their parent.
+    std::vector<int>            candidates ;
+
+    std::vector<std::pair<long,long>>               pairs ;
 
     mesh.getBoundingBox(octrBB0,octrBB1) ;
-    getBoundingBox( triBB0, triBB1 );
+    for( auto & segment : m_segmentation->getCells() ){
+        long segmentId = segment.getId() ;
+        std::vector<std::array<double,3>> VS = getSimplexVertices( segmentId ) ;
+
+        CGElem::computeAABBSimplex( VS, S0, S1 ) ;
+        B0 = S0 - RSearch ;
+        B1 = S1 + RSearch ;
+        if( CGElem::intersectBoxBox(octrBB0, octrBB1, B0, B1, dim) ){
+            candidates.push_back( simplexIds.size() ) ;
+            simplexIds.push_back( segmentId ) ;
+            simplexVertices.push_back( std::move(VS) ) ;
+            simplexBoxes.push_back( {{S0, S1}} ) ;
+        }
+    };
 
-    G0 = triBB0 - RSearch ;
-    G1 = triBB1 + RSearch ;
+    if( octants.empty() || candidates.empty() ){
+        return ;
+    }
 
-    if( CGElem::intersectBoxBox(octrBB0,octrBB1,G0,G1,C0,C1) ) { //intersect two Bounding Boxes around geometry and local grid
+    // Descend the tree
+    std::array<double,3>        origin = tree.getOrigin() ;
+    uint32_t                    maxLength = tree.getMaxLength() ;
+    double                      scale = tree.getL() / maxLength ;
+
+    DescentNode                 root ;
+    root.level          = 0 ;
+    root.anchor         = {{0, 0, 0}} ;
+    root.begin          = 0 ;
+    root.end            = octants.size() ;
+    root.candidateBegin = 0 ;
+    root.candidateEnd   = candidates.size() ;
+
+    std::vector<DescentNode>    stack ;
+    stack.push_back( root ) ;
+
+    while( !stack.empty() ){
+
+        DescentNode node = stack.back() ;
+        stack.pop_back() ;
+
+        // The lists stacked after the one of the node belong to subtrees
+        // that have already been visited
+        candidates.resize( node.candidateEnd ) ;
+
+        uint32_t nodeSize = maxLength >> node.level ;
+
+        // Discard simplices that cannot be within the narrow band of any
+        // point of the node: the bounding box of the simplex should intersect
+        // the enlarged node and the distance between the simplex and the
+        // center of the node should not exceed the radius of the node plus
+        // the size of the narrow band.
+        double radius = 0.5 *sqrt( (double) dim ) *scale *nodeSize + RSearch ;
+
+        for( int d=0; d<3; ++d){
+            B0[d] = origin[d] ;
+            B1[d] = origin[d] ;
+            if( d < dim ){
+                B0[d] += scale *node.anchor[d] - RSearch ;
+                B1[d] += scale *(node.anchor[d] + nodeSize) + RSearch ;
+            }
+        }
 
-        // snap bounding box to grid and create cartesian grid
-        std::array<int,3>    nc ;
+        C = 0.5 *(B0 + B1) ;
 
-        for( i=0; i<dim; ++i){
-            C0[i] =  octrBB0[i] + size *   (int) ( ( C0[i] - octrBB0[i] ) / size ) ;
-            C1[i] =  octrBB0[i] + size * ( (int) ( ( C1[i] - octrBB0[i] ) / size ) +1 ) ;
+        std::size_t candidateBegin = candidates.size() ;
+        for( std::size_t n=node.candidateBegin; n<node.candidateEnd; ++n){
+            int k = candidates[n] ;
 
-            nc[i] = round( ( C1[i] - C0[i] ) /size ) ;
-        };
+            const std::array<std::array<double,3>,2> &box = simplexBoxes[k] ;
+            if( !CGElem::intersectBoxBox( B0, B1, box[0], box[1], dim ) ){
+                continue ;
+            }
 
-        // calculate LS triangle lists on cartesian mesh and map on pablo
-        VolCartesian            cmesh( 0, dim, C0, C1-C0, nc) ;
+            if( CGElem::distancePointSimplex( C, simplexVertices[k], xP, flag ) <= radius ){
+                candidates.push_back(k) ;
+            }
+        }
 
-        LevelSetCartesian       auxLS(cmesh) ;
-        LevelSetSegmentation    objLS(*this) ;
+        std::size_t candidateEnd = candidates.size() ;
+        if( candidateEnd == candidateBegin ){
+            continue ;
+        }
 
-        double                  localRSearch = auxLS.computeSizeNarrowBand(this) ;
+        // If the node is an octant, associate to it the simplices whose distance
+        // from the cell centroid is within the narrow band
+        const OctantKey &first = octants[node.begin] ;
+        if( node.end - node.begin == 1 && first.level == node.level ){
+            C = mesh.evalCellCentroid(first.id) ;
 
-        auxLS.setSizeNarrowBand(localRSearch);
-        objLS.associateSimplexToCell(&auxLS, auxLS.getSizeNarrowBand() ) ; 
+            for( std::size_t n=candidateBegin; n<candidateEnd; ++n){
+                int k = candidates[n] ;
+                if( CGElem::distancePointSimplex( C, simplexVertices[k], xP, flag ) <= RSearch ){
+                    pairs.push_back( std::make_pair( first.id, simplexIds[k] ) ) ;
+                }
+            }
 
-        for( auto & cell : mesh.getCells() ){
-            id = cell.getId() ;
-            C  = mesh.evalCellCentroid(id) ;
+            continue ;
+        }
 
-            if( cmesh.isPointInside(C) ){
-                icart = cmesh.locatePoint(C) ;
+        if( nodeSize == 1 ){
+            continue ;
+        }
 
-                if( objLS.isInNarrowBand(icart) ){
-                    const std::unordered_set<long> &list = objLS.getSimplexList(icart) ;
-                    data = m_seg.emplace(id, list) ;
-                };
+        // Add to the stack the children that contain local octants. Children
+        // are visited in Morton order, hence the octants of each child are a
+        // contiguous sub-range of the octants of the parent.
+        uint32_t    childSize = nodeSize >> 1 ;
+        uint64_t    childMortonRange = (uint64_t) childSize *childSize *childSize ;
+        std::size_t childBegin = node.begin ;
+
+        int nChildren = 1 << dim ;
+        for( int c=0; c<nChildren && childBegin<node.end; ++c){
+            DescentNode child ;
+            child.level  = node.level + 1 ;
+            child.anchor = node.anchor ;
+            for( int d=0; d<dim; ++d){
+                if( c & (1 << d) ){
+                    child.anchor[d] += childSize ;
+                }
+            }
 
-            };
+            uint64_t childLastMorton = mortonEncode_magicbits(child.anchor[0], child.anchor[1], child.anchor[2]) + childMortonRange - 1 ;
 
-        };
+            std::size_t childEnd = std::upper_bound( octants.begin() + childBegin, octants.begin() + node.end, childLastMorton,
+                                                     [](uint64_t morton, const OctantKey &key){ return morton < key.morton; } ) - octants.begin() ;
 
-    }; //endif intersect
+            if( childEnd > childBegin ){
+                child.begin          = childBegin ;
+                child.end            = childEnd ;
+                child.candidateBegin = candidateBegin ;
+                child.candidateEnd   = candidateEnd ;
+                stack.push_back( child ) ;
+            }
+
+            childBegin = childEnd ;
+        }
+
+    };
+
+    updateSimplexLists( pairs ) ;
 
     return;
 
@@ -640,19 +861,31 @@ void LevelSetSegmentation::updateSimplexToCell( LevelSetOctree *visitee, const s
 
     if( newSize-oldSize <= 1.e-8 ) { //size of narrow band decreased or remained the same -> mapping
 
-        std::unordered_map<long,std::unordered_set<long>> oldSegs ;
-        std::unordered_map<long,std::unordered_set<long>>::iterator oldSegsIt ;
+        std::vector<std::pair<long,long>> pairs ;
+
+        for ( auto & info : mapper ){ //forall mesh modifications
+            if( info.entity == adaption::Entity::ENTITY_CELL){ //check if changes on cells
+                for ( auto & parent : info.previous){ //take their parents
+                    if( m_seg.exists(parent) ){ //add their information if any
+                        int list = m_seg[parent].m_segments ;
+                        const long *segments = m_segLists.get(list) ;
+                        int nSegments = m_segLists.sub_array_size(list) ;
+
+                        for ( auto & child : info.current){ // forall new elements
+                            for( int k=0; k<nSegments; ++k){
+                                pairs.push_back( std::make_pair( child, segments[k] ) ) ;
+                            }
+                        }
+                    }
+                }
+            }
+        }
 
         for ( auto & info : mapper ){
             if( info.entity == adaption::Entity::ENTITY_CELL ){
-
-                for ( auto & parent : info.previous){ //save old data and delete element
+                for ( auto & parent : info.previous){ //delete old data
                     if( m_seg.exists(parent) ){
-                        SegInfo *seg =  &m_seg[parent] ;
-
-                        oldSegs.insert({{ parent, seg->m_segments }}) ;
                         m_seg.erase(parent,true) ;
-
                     }
                 }
             }
@@ -660,26 +893,12 @@ void LevelSetSegmentation::updateSimplexToCell( LevelSetOctree *visitee, const s
 
         m_seg.flush() ;
 
-        for ( auto & info : mapper ){ //forall mesh modifications
-            if( info.entity == adaption::Entity::ENTITY_CELL){ //check if changes on cells
-                for ( auto & child : info.current){ // forall new elements
-
-                    PiercedVector<SegInfo>::iterator seg =  m_seg.reclaim(child) ;
-                    seg->m_checked = false ;
-                    seg->m_segments.clear() ;
-
-                    for ( auto & parent : info.previous){ //take their parents
-                        oldSegsIt = oldSegs.find(parent);
-                        if( oldSegsIt != oldSegs.end() ) //add their information if any
-                            seg->m_segments.insert( oldSegsIt->second.begin(), oldSegsIt->second.end() ) ;
-                    }
-                }
-            }
-        }
+        updateSimplexLists( pairs ) ;
 
     } else { //size of narrow band increased -> recalculation
 
         m_seg.clear() ;
+        m_segLists.clear() ;
         visitee->clear() ;
         associateSimplexToCell( visitee, visitee->getSizeNarrowBand() ) ; 
 
@@ -690,6 +909,66 @@ void LevelSetSegmentation::updateSimplexToCell( LevelSetOctree *visitee, const s
 
 };
 
+/*!
+ * Adds segments to the lists of the cells in the narrow band.
+ * The lists of all cells are rebuilt in a single pass, keeping each list sorted and without duplicates;
+ * cells not yet in the narrow band are created. Passing an empty set of pairs only compacts the storage.
+ * @param[in,out] pairs cell-segment pairs to be added, they will be sorted
+ */
+void LevelSetSegmentation::updateSimplexLists( std::vector<std::pair<long,long>> &pairs ){
+
+    std::sort( pairs.begin(), pairs.end() ) ;
+    pairs.erase( std::unique( pairs.begin(), pairs.end() ), pairs.end() ) ;
+
+    // Create the cells that are not in the narrow band yet
+    std::vector<std::pair<long,long>>::iterator pairItr, pairEnd = pairs.end() ;
+    for( pairItr = pairs.begin(); pairItr != pairEnd; ++pairItr ){
+        if( pairItr == pairs.begin() || pairItr->first != (pairItr-1)->first ){
+            if( !m_seg.exists(pairItr->first) ){
+                m_seg.emplace(pairItr->first) ;
+            }
+        }
+    }
+
+    // Rebuild the lists
+    CollapsedVector2D<long>     lists ;
+    std::vector<long>           merged ;
+
+    lists.reserve( m_seg.size(), m_segLists.sub_arrays_total_size() + pairs.size() ) ;
+
+    for( PiercedIterator<SegInfo> segIt = m_seg.begin(); segIt != m_seg.end(); ++segIt ){
+
+        merged.clear() ;
+
+        int list = segIt->m_segments ;
+        if( list >= 0 ){
+            const long *segments = m_segLists.get(list) ;
+            merged.assign( segments, segments + m_segLists.sub_array_size(list) ) ;
+        }
+
+        std::size_t nOldSegments = merged.size() ;
+
+        long id = segIt.getId() ;
+        pairItr = std::lower_bound( pairs.begin(), pairEnd, std::make_pair(id, std::numeric_limits<long>::min()) ) ;
+        while( pairItr != pairEnd && pairItr->first == id ){
+            merged.push_back( pairItr->second ) ;
+            ++pairItr ;
+        }
+
+        if( nOldSegments > 0 && merged.size() > nOldSegments ){
+            std::inplace_merge( merged.begin(), merged.begin() + nOldSegments, merged.end() ) ;
+            merged.erase( std::unique( merged.begin(), merged.end() ), merged.end() ) ;
+        }
+
+        lists.push_back( merged ) ;
+        segIt->m_segments = lists.size() - 1 ;
+    }
+
+    m_segLists.swap( lists ) ;
+
+    return ;
+};
+
 /*! 
  * Deletes non-existing items 
  * @param[in] mapper mapping info
@@ -713,9 +992,34 @@ void LevelSetSegmentation::clearAfterMeshMovement( const std::vector<adaption::I
 
     m_seg.flush() ;
 
+    // Release the lists of the deleted cells
+    std::vector<std::pair<long,long>> pairs ;
+    updateSimplexLists( pairs ) ;
+
     return ;
 };
 
+/*!
+ * Evaluate the memory used by the object, i.e. by the segment information
+ * of the cells, by the lists of segments in the narrow band and by the
+ * vertex normals.
+ * @return memory used by the object
+ */
+MemoryUsage LevelSetSegmentation::getMemoryUsage( ) const{
+
+    MemoryUsage usage = LevelSetObject::getMemoryUsage() ;
+    usage.addComponent("segment info", m_seg.getMemoryUsage()) ;
+    usage.addComponent("segment lists", m_segLists.get_memory_size()) ;
+
+    std::size_t normalBytes = utils::evalMemorySize(m_vertexNormal) ;
+    for( const auto &normals : m_vertexNormal ){
+        normalBytes += utils::evalMemorySize(normals.second) ;
+    }
+    usage.addComponent("vertex normals", normalBytes) ;
+
+    return usage ;
+};
+
 /*!
  * Writes LevelSetSegmentation to stream in binary format
  * @param[in] stream output stream
@@ -730,10 +1034,10 @@ void LevelSetSegmentation::dumpDerived( std::fstream &stream ){
     bitpit::genericIO::flushBINARY( stream, (long) m_seg.size() ) ;
 
     for( segItr = m_seg.begin(); segItr != segEnd; ++segItr){
-        s = segItr->m_segments.size() ;
+        s = m_segLists.sub_array_size(segItr->m_segments) ;
 
-        temp.resize(s);
-        std::copy( segItr->m_segments.begin(), segItr->m_segments.end(), temp.begin() );
+        const long *segments = m_segLists.get(segItr->m_segments) ;
+        temp.assign( segments, segments + s );
 
         bitpit::genericIO::flushBINARY( stream, segItr.getId() );
         bitpit::genericIO::flushBINARY( stream, s );
@@ -753,8 +1057,8 @@ void LevelSetSegmentation::restoreDerived( std::fstream &stream ){
 
     int     s;
     long    i, n, id;
-    SegInfo cellData ;
     std::vector<long>   temp;
+    std::vector<std::pair<long,long>>   pairs;
 
     bitpit::genericIO::absorbBINARY( stream, n ) ;
 
@@ -766,15 +1070,19 @@ void LevelSetSegmentation::restoreDerived( std::fstream &stream ){
 
         temp.resize(s) ;
         bitpit::genericIO::absorbBINARY( stream, temp );
-        bitpit::genericIO::absorbBINARY( stream, cellData.m_support );
-        bitpit::genericIO::absorbBINARY( stream, cellData.m_checked );
 
-        std::copy( temp.begin(), temp.end(), std::inserter( cellData.m_segments, cellData.m_segments.end() ) );
+        PiercedVector<SegInfo>::iterator segItr = m_seg.emplace(id) ;
+        bitpit::genericIO::absorbBINARY( stream, segItr->m_support );
+        bitpit::genericIO::absorbBINARY( stream, segItr->m_checked );
 
-        m_seg.insert(id,cellData) ;
+        for( const long &segment : temp ){
+            pairs.push_back( std::make_pair( id, segment ) ) ;
+        }
 
     }
 
+    updateSimplexLists( pairs ) ;
+
     return;
 };
 
@@ -798,10 +1106,13 @@ void LevelSetSegmentation::writeCommunicationBuffer( const std::vector<long> &se
     for( const auto &index : sendList){
         if( m_seg.exists(index)){
             const auto &seginfo = m_seg[index] ;
+            const long *segments = m_segLists.get(seginfo.m_segments) ;
+            int nSegments = m_segLists.sub_array_size(seginfo.m_segments) ;
+
             dataBuffer << counter ;
-            dataBuffer << (int) seginfo.m_segments.size() ;
-            for( const long & seg : seginfo.m_segments ){
-                dataBuffer << seg ;
+            dataBuffer << nSegments ;
+            for( int k=0; k<nSegments; ++k ){
+                dataBuffer << segments[k] ;
             };
             dataBuffer << seginfo.m_support ;
             dataBuffer << seginfo.m_checked ;
@@ -829,6 +1140,8 @@ void LevelSetSegmentation::readCommunicationBuffer( const std::vector<long> &rec
     int     s, nSegs ;
     long    index, id, segment ;
 
+    std::vector<std::pair<long,long>>   pairs;
+
     for( int i=0; i<nItems; ++i){
         // Get the id of the element
         dataBuffer >> index ;
@@ -837,7 +1150,7 @@ void LevelSetSegmentation::readCommunicationBuffer( const std::vector<long> &rec
         // Assign the data of the element
         PiercedVector<SegInfo>::iterator segItr ;
         if( !m_seg.exists(id)){
-            segItr = m_seg.reclaim(id) ;
+            segItr = m_seg.emplace(id) ;
         } else {
             segItr = m_seg.getIterator(id) ;
         }
@@ -845,13 +1158,15 @@ void LevelSetSegmentation::readCommunicationBuffer( const std::vector<long> &rec
         dataBuffer >> nSegs ;
         for( s=0; s<nSegs; ++s){
             dataBuffer >> segment ;
-            segItr->m_segments.insert(segment) ;
+            pairs.push_back( std::make_pair( id, segment ) ) ;
         }
 
         dataBuffer >> segItr->m_support ;
         dataBuffer >> segItr->m_checked ;
     }
 
+    updateSimplexLists( pairs ) ;
+
     return;
 };
 # endif
@@ -35,5 +35,6 @@
 #include "surface_kernel.hpp"
 #include "volume_kernel.hpp"
 #include "adaption.hpp"
+#include "ghost_exchanger.hpp"
 
 #endif
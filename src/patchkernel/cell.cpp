@@ -419,6 +419,18 @@ int Cell::findInterface(const int &interface)
 	return -1;
 }
 
+/*!
+	Gets the size, expressed in bytes, of the memory allocated for storing
+	the interfaces of the cell.
+
+	\result The size, expressed in bytes, of the memory allocated for
+	storing the interfaces of the cell.
+*/
+std::size_t Cell::getInterfacesMemorySize() const
+{
+	return m_interfaces.get_memory_size();
+}
+
 /*!
 	Resets the adjacencies of the cell.
 
@@ -659,6 +671,18 @@ int Cell::findAdjacency(const int &adjacency)
 	return -1;
 }
 
+/*!
+	Gets the size, expressed in bytes, of the memory allocated for storing
+	the adjacencies of the cell.
+
+	\result The size, expressed in bytes, of the memory allocated for
+	storing the adjacencies of the cell.
+*/
+std::size_t Cell::getAdjacenciesMemorySize() const
+{
+	return m_adjacencies.get_memory_size();
+}
+
 /*!
 	Checks if the specified face is a border.
 
@@ -779,7 +803,7 @@ void Cell::display(std::ostream &out, unsigned short int indent) const
 
 	\result Returns the buffer size (in bytes).
 */
-unsigned int Cell::getBinarySize()
+unsigned int Cell::getBinarySize() const
 {
     return (Element::getBinarySize() + m_interfaces.get_binary_size() + m_adjacencies.get_binary_size());
 }
@@ -77,6 +77,7 @@ public:
 	const long * getInterfaces(const int &face) const;
 	int findInterface(const int &face, const int &interface);
 	int findInterface(const int &interface);
+	std::size_t getInterfacesMemorySize() const;
 
 	void resetAdjacencies(bool storeAdjacencies = true);
 	void setAdjacencies(std::vector<std::vector<long>> &adjacencies);
@@ -90,13 +91,14 @@ public:
 	const long * getAdjacencies(const int &face) const;
 	int findAdjacency(const int &face, const int &adjacency);
 	int findAdjacency(const int &adjacency);
+	std::size_t getAdjacenciesMemorySize() const;
         int findVertex(const long &vertex);
 
 	bool isFaceBorder(int face) const;
 
 	void display(std::ostream &out, unsigned short int indent) const;
 
-	unsigned int getBinarySize( );
+	unsigned int getBinarySize() const;
 
 protected:
 	void setInterior(bool interior);
@@ -41,10 +41,7 @@ bitpit::IBinaryStream& operator>>(bitpit::IBinaryStream &buffer, bitpit::Element
 	buffer >> element.m_type;
 	buffer >> element.m_id;
 	element._initialize(element.m_type);
-	int nVertices = element.getVertexCount();
-	for (int i = 0; i < nVertices; ++i) {
-	    buffer >> element.m_connect[i];
-	}
+	buffer.read(element.m_connect.get(), element.getVertexCount());
 
 	return buffer;
 }
@@ -58,12 +55,9 @@ bitpit::IBinaryStream& operator>>(bitpit::IBinaryStream &buffer, bitpit::Element
 */
 bitpit::OBinaryStream& operator<<(bitpit::OBinaryStream  &buffer, const bitpit::Element &element)
 {
-	int nVertices = element.getVertexCount();
 	buffer << element.getType();
 	buffer << element.getId();
-	for (int i = 0; i < nVertices; ++i) {
-	    buffer << element.m_connect[i];
-	}
+	buffer.write(element.m_connect.get(), element.getVertexCount());
 
 	return buffer;
 }
@@ -1279,7 +1273,7 @@ long Element::getVertex(const int &vertex) const
 
         \result buffer size (in bytes)
 */
-unsigned int Element::getBinarySize()
+unsigned int Element::getBinarySize() const
 {
 	return (sizeof(ElementInfo::Type) + (getVertexCount() + 1) * sizeof(long));
 }
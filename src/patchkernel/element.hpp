@@ -181,7 +181,7 @@ public:
 
 	static const long NULL_ID;
 
-	unsigned int getBinarySize();
+	unsigned int getBinarySize() const;
 
 private:
 	long m_id;
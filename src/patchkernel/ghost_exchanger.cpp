@@ -0,0 +1,844 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+
+#if BITPIT_ENABLE_MPI==1
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+#include "ghost_exchanger.hpp"
+
+namespace bitpit {
+
+/*!
+	\ingroup patchkernel
+	@{
+*/
+
+/*!
+	\class GhostExchanger
+
+	\brief The GhostExchanger class exchanges the ghost values of cell
+	fields among the processors.
+
+	The exchanger uses the ghost exchange information of the patch: the
+	values of the sources are sent to the neighbour processors and the
+	values of the targets are received from the owners of the ghosts.
+	Cell ids are converted once to positions in the cell storage, fields
+	are packed and unpacked using those positions and the communications
+	use persistent MPI requests. The exchange can be split in two calls
+	(startExchange/waitExchange) to overlap computations on the internal
+	cells with the communications.
+
+	The exchanger is rebuilt automatically when the ghost exchange
+	information of the patch changes or when the cells are moved inside
+	the storage. The persistent requests are rebuilt when the size of the
+	items changes, hence, an exchanger should preferably be used for
+	fields that share the same type and number of components.
+
+	Exchanges are collective operations on the communicator of the patch.
+	Exchangers that are active at the same time should use different tags.
+
+	In hierarchical mode the processes are grouped by shared-memory node.
+	Every process writes the values of its sources in a segment of an MPI
+	shared-memory window and the processes of the same node read their
+	ghost values directly from the segments of their neighbours. The values
+	exchanged between two nodes are aggregated in a single message: one
+	process of the source node packs the values of all the processes of
+	its node and sends them to one process of the destination node, which
+	receives them in its segment, where they are read by the processes of
+	its node. The number of messages exchanged among the nodes is thus
+	independent of the number of processes per node.
+*/
+
+int GhostExchanger::DEFAULT_TAG = 50;
+
+/*!
+	Creates a new ghost exchanger.
+
+	\param patch is the patch whose ghosts will be exchanged
+	\param tag is the tag that will be used for the communications
+*/
+GhostExchanger::GhostExchanger(PatchKernel &patch, int tag)
+	: m_patch(patch), m_tag(tag), m_built(false), m_revision(0),
+	  m_fieldSize(0), m_itemSize(0), m_activeItemSize(0), m_prepared(false),
+	  m_hierarchical(false), m_nodeCommunicator(MPI_COMM_NULL), m_node(-1),
+	  m_window(MPI_WIN_NULL), m_sendAreaSize(0), m_recvAreaSize(0), m_parity(0),
+	  m_nodeBarrierRequest(MPI_REQUEST_NULL)
+{
+}
+
+/*!
+	Destroys the ghost exchanger.
+
+	The destruction of an exchanger in hierarchical mode is collective on
+	the processes of the node.
+*/
+GhostExchanger::~GhostExchanger()
+{
+	int finalizedCalled;
+	MPI_Finalized(&finalizedCalled);
+	if (finalizedCalled) {
+		return;
+	}
+
+	if (isExchangeActive()) {
+		if (m_hierarchical) {
+			waitSharedExchange(nullptr);
+		} else {
+			MPI_Waitall(m_recvRequests.size(), m_recvRequests.data(), MPI_STATUSES_IGNORE);
+			MPI_Waitall(m_sendRequests.size(), m_sendRequests.data(), MPI_STATUSES_IGNORE);
+		}
+	}
+
+	freeRequests();
+	freeShared();
+	freeNodes();
+}
+
+/*!
+	Gets the tag used for the communications.
+
+	\result The tag used for the communications.
+*/
+int GhostExchanger::getTag() const
+{
+	return m_tag;
+}
+
+/*!
+	Forces the rebuild of the exchanger before the next exchange.
+
+	This is needed only if the exchange lists of the patch have been
+	modified directly.
+*/
+void GhostExchanger::update()
+{
+	if (isExchangeActive()) {
+		throw std::runtime_error("The exchanger cannot be updated while an exchange is active");
+	}
+
+	m_built    = false;
+	m_prepared = false;
+}
+
+/*!
+	Enables or disables the hierarchical communications.
+
+	In hierarchical mode the communicator of the patch is split in groups
+	of processes that share the memory, ghost values are exchanged inside
+	a group through MPI shared-memory windows and the values exchanged
+	between two groups are aggregated in a single message.
+
+	By default the processes are grouped by shared-memory node. A custom
+	grouping can be defined passing a node communicator, that should
+	contain a subset of the processes of the communicator of the patch
+	that can share memory. Groups smaller than the node are useful to
+	limit the contention on the shared segments.
+
+	This is a collective operation on the communicator of the patch.
+
+	\param enabled if true the hierarchical communications will be enabled
+	\param nodeCommunicator is the communicator that groups the processes
+	of the node, if it is MPI_COMM_NULL the processes will be grouped by
+	shared-memory node
+*/
+void GhostExchanger::setHierarchical(bool enabled, MPI_Comm nodeCommunicator)
+{
+	if (isExchangeActive()) {
+		throw std::runtime_error("The communication mode cannot be changed while an exchange is active");
+	} else if (!m_patch.isCommunicatorSet()) {
+		throw std::runtime_error("The patch has no communicator");
+	}
+
+	freeRequests();
+	freeShared();
+	freeNodes();
+
+	m_hierarchical = enabled;
+	m_built        = false;
+	m_prepared     = false;
+	if (!m_hierarchical) {
+		return;
+	}
+
+	// Node communicator
+	const MPI_Comm &communicator = m_patch.getCommunicator();
+
+	int rank;
+	int nProcs;
+	MPI_Comm_rank(communicator, &rank);
+	MPI_Comm_size(communicator, &nProcs);
+
+	if (nodeCommunicator == MPI_COMM_NULL) {
+		MPI_Comm_split_type(communicator, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &m_nodeCommunicator);
+	} else {
+		MPI_Comm_dup(nodeCommunicator, &m_nodeCommunicator);
+	}
+
+	// Ranks of the processes of the node, in the order of the node
+	// communicator
+	int nodeSize;
+	MPI_Comm_size(m_nodeCommunicator, &nodeSize);
+
+	m_nodeProcesses.resize(nodeSize);
+	MPI_Allgather(&rank, 1, MPI_INT, m_nodeProcesses.data(), 1, MPI_INT, m_nodeCommunicator);
+
+	// Nodes are identified by the lowest rank of their processes and are
+	// numbered following the order of those ranks
+	int leader = *std::min_element(m_nodeProcesses.begin(), m_nodeProcesses.end());
+
+	std::vector<int> rankLeaders(nProcs);
+	MPI_Allgather(&leader, 1, MPI_INT, rankLeaders.data(), 1, MPI_INT, communicator);
+
+	std::vector<int> leaders(rankLeaders);
+	std::sort(leaders.begin(), leaders.end());
+	leaders.erase(std::unique(leaders.begin(), leaders.end()), leaders.end());
+
+	m_rankNodes.resize(nProcs);
+	m_nodeRanks.assign(leaders.size(), std::vector<int>());
+	for (int k = 0; k < nProcs; ++k) {
+		int node = std::lower_bound(leaders.begin(), leaders.end(), rankLeaders[k]) - leaders.begin();
+
+		m_rankNodes[k] = node;
+		m_nodeRanks[node].push_back(k);
+	}
+
+	m_node = m_rankNodes[rank];
+}
+
+/*!
+	Checks if the hierarchical communications are enabled.
+
+	\result Returns true if the hierarchical communications are enabled,
+	false otherwise.
+*/
+bool GhostExchanger::isHierarchical() const
+{
+	return m_hierarchical;
+}
+
+/*!
+	Checks if an exchange has been started and not yet completed.
+
+	\result Returns true if an exchange is active, false otherwise.
+*/
+bool GhostExchanger::isExchangeActive() const
+{
+	return (m_activeItemSize > 0);
+}
+
+/*!
+	Prepares the exchanger for the exchange of items with the specified
+	size, rebuilding the positions and the requests if needed.
+
+	In hierarchical mode the processes of a node share the window, hence
+	they decide together whether the exchanger should be rebuilt. The
+	exchanger is prepared only once for each exchange.
+
+	\param itemSize is the size, expressed in bytes, of the values of a cell
+*/
+void GhostExchanger::prepare(std::size_t itemSize)
+{
+	if (isExchangeActive()) {
+		throw std::runtime_error("An exchange is already active");
+	} else if (itemSize == 0) {
+		throw std::runtime_error("The values to exchange are empty");
+	}
+
+	if (m_prepared) {
+		return;
+	}
+
+	bool outdated = (!m_built || m_revision != m_patch.getGhostExchangeRevision());
+	if (m_hierarchical) {
+		int rebuild = (outdated || itemSize != m_itemSize);
+		MPI_Allreduce(MPI_IN_PLACE, &rebuild, 1, MPI_INT, MPI_LOR, m_nodeCommunicator);
+		if (rebuild) {
+			freeShared();
+			buildPositions();
+			initShared(itemSize);
+		}
+	} else {
+		if (outdated) {
+			freeRequests();
+			buildPositions();
+		}
+
+		if (itemSize != m_itemSize) {
+			freeRequests();
+			initRequests(itemSize);
+		}
+	}
+
+	m_prepared = true;
+}
+
+/*!
+	Builds the positions in the cell storage of the sources and of the
+	targets.
+*/
+void GhostExchanger::buildPositions()
+{
+	const PiercedVector<Cell> &cells = m_patch.getCells();
+
+	m_fieldSize = 0;
+
+	// Sends
+	const std::unordered_map<int, std::vector<long>> &sources = m_patch.getGhostExchangeSources();
+
+	m_sendRanks.clear();
+	for (const auto &entry : sources) {
+		m_sendRanks.push_back(entry.first);
+	}
+
+	if (m_hierarchical) {
+		// In hierarchical mode the values sent to the processes of the
+		// same node are contiguous
+		std::sort(m_sendRanks.begin(), m_sendRanks.end(),
+			[this](int rank_1, int rank_2)
+			{
+				return (std::make_pair(m_rankNodes[rank_1], rank_1) < std::make_pair(m_rankNodes[rank_2], rank_2));
+			});
+	} else {
+		std::sort(m_sendRanks.begin(), m_sendRanks.end());
+	}
+
+	int nSends = m_sendRanks.size();
+	m_sendPositions.resize(nSends);
+	for (int k = 0; k < nSends; ++k) {
+		const std::vector<long> &rankSources = sources.at(m_sendRanks[k]);
+
+		std::vector<std::size_t> &positions = m_sendPositions[k];
+		positions.resize(rankSources.size());
+		for (std::size_t i = 0; i < rankSources.size(); ++i) {
+			positions[i] = cells.rawIndex(rankSources[i]);
+			m_fieldSize  = std::max(m_fieldSize, positions[i] + 1);
+		}
+	}
+
+	// Receives
+	const std::unordered_map<int, std::vector<long>> &targets = m_patch.getGhostExchangeTargets();
+
+	m_recvRanks.clear();
+	for (const auto &entry : targets) {
+		m_recvRanks.push_back(entry.first);
+	}
+	std::sort(m_recvRanks.begin(), m_recvRanks.end());
+
+	int nRecvs = m_recvRanks.size();
+	m_recvPositions.resize(nRecvs);
+	for (int k = 0; k < nRecvs; ++k) {
+		const std::vector<long> &rankTargets = targets.at(m_recvRanks[k]);
+
+		std::vector<std::size_t> &positions = m_recvPositions[k];
+		positions.resize(rankTargets.size());
+		for (std::size_t i = 0; i < rankTargets.size(); ++i) {
+			positions[i] = cells.rawIndex(rankTargets[i]);
+			m_fieldSize  = std::max(m_fieldSize, positions[i] + 1);
+		}
+	}
+
+	m_revision = m_patch.getGhostExchangeRevision();
+	m_built    = true;
+}
+
+/*!
+	Creates the buffers and the persistent requests for the exchange of
+	items with the specified size.
+
+	\param itemSize is the size, expressed in bytes, of the values of a cell
+*/
+void GhostExchanger::initRequests(std::size_t itemSize)
+{
+	const MPI_Comm &communicator = m_patch.getCommunicator();
+
+	int nSends = m_sendRanks.size();
+	m_sendBuffers.resize(nSends);
+	m_sendRequests.assign(nSends, MPI_REQUEST_NULL);
+	for (int k = 0; k < nSends; ++k) {
+		std::vector<char> &buffer = m_sendBuffers[k];
+		buffer.resize(m_sendPositions[k].size() * itemSize);
+
+		MPI_Send_init(buffer.data(), buffer.size(), MPI_CHAR, m_sendRanks[k], m_tag,
+		              communicator, &m_sendRequests[k]);
+	}
+
+	int nRecvs = m_recvRanks.size();
+	m_recvBuffers.resize(nRecvs);
+	m_recvRequests.assign(nRecvs, MPI_REQUEST_NULL);
+	for (int k = 0; k < nRecvs; ++k) {
+		std::vector<char> &buffer = m_recvBuffers[k];
+		buffer.resize(m_recvPositions[k].size() * itemSize);
+
+		MPI_Recv_init(buffer.data(), buffer.size(), MPI_CHAR, m_recvRanks[k], m_tag,
+		              communicator, &m_recvRequests[k]);
+	}
+
+	m_itemSize = itemSize;
+}
+
+/*!
+	Frees the persistent requests.
+*/
+void GhostExchanger::freeRequests()
+{
+	for (MPI_Request &request : m_sendRequests) {
+		if (request != MPI_REQUEST_NULL) {
+			MPI_Request_free(&request);
+		}
+	}
+	m_sendRequests.clear();
+
+	for (MPI_Request &request : m_recvRequests) {
+		if (request != MPI_REQUEST_NULL) {
+			MPI_Request_free(&request);
+		}
+	}
+	m_recvRequests.clear();
+
+	m_itemSize = 0;
+}
+
+/*!
+	Creates the shared-memory window and the aggregated messages for the
+	hierarchical exchange of items with the specified size.
+
+	The segment of every process contains a send area, where the process
+	writes the values of its sources sorted by destination node and rank,
+	followed by two receive areas, where the process receives the messages
+	it aggregates for its node. Receive areas are alternated among the
+	exchanges, so that a process can receive the values of an exchange
+	while the other processes of the node are still reading the values of
+	the previous one.
+
+	The values sent from node A to node B are packed by the process of A
+	with index (B % |A|) and received by the process of B with index
+	(A % |B|), where processes are indexed following the order of their
+	ranks. A message contains the values for the processes of B sent by
+	the processes of A, sorted by source rank and then by destination
+	rank.
+
+	This is a collective operation on the processes of the node.
+
+	\param itemSize is the size, expressed in bytes, of the values of a cell
+*/
+void GhostExchanger::initShared(std::size_t itemSize)
+{
+	const MPI_Comm &communicator = m_patch.getCommunicator();
+
+	int rank;
+	MPI_Comm_rank(communicator, &rank);
+
+	int nodeProcess;
+	int nodeSize;
+	MPI_Comm_rank(m_nodeCommunicator, &nodeProcess);
+	MPI_Comm_size(m_nodeCommunicator, &nodeSize);
+
+	std::unordered_map<int, int> processes;
+	for (int p = 0; p < nodeSize; ++p) {
+		processes[m_nodeProcesses[p]] = p;
+	}
+
+	const std::vector<int> &nodeRanks = m_nodeRanks[m_node];
+
+	// Share the number of values exchanged by the processes of the node
+	std::vector<long> table;
+	table.push_back(m_sendRanks.size());
+	for (std::size_t k = 0; k < m_sendRanks.size(); ++k) {
+		table.push_back(m_sendRanks[k]);
+		table.push_back(m_sendPositions[k].size());
+	}
+
+	table.push_back(m_recvRanks.size());
+	for (std::size_t k = 0; k < m_recvRanks.size(); ++k) {
+		table.push_back(m_recvRanks[k]);
+		table.push_back(m_recvPositions[k].size());
+	}
+
+	int tableSize = table.size();
+	std::vector<int> tableSizes(nodeSize);
+	MPI_Allgather(&tableSize, 1, MPI_INT, tableSizes.data(), 1, MPI_INT, m_nodeCommunicator);
+
+	std::vector<int> tableDispls(nodeSize, 0);
+	for (int p = 1; p < nodeSize; ++p) {
+		tableDispls[p] = tableDispls[p - 1] + tableSizes[p - 1];
+	}
+
+	std::vector<long> tables(tableDispls.back() + tableSizes.back());
+	MPI_Allgatherv(table.data(), tableSize, MPI_LONG, tables.data(), tableSizes.data(),
+	               tableDispls.data(), MPI_LONG, m_nodeCommunicator);
+
+	// Layout of the send areas
+	std::vector<std::size_t> sendAreaSizes(nodeSize, 0);
+	std::vector<std::unordered_map<int, std::size_t>> sendOffsets(nodeSize);
+	std::vector<std::unordered_map<int, std::pair<std::size_t, std::size_t>>> nodeSendRanges(nodeSize);
+	std::vector<std::unordered_map<int, std::size_t>> recvCounts(nodeSize);
+	std::vector<int> sendNodes;
+	std::vector<int> recvNodes;
+	for (int p = 0; p < nodeSize; ++p) {
+		const long *entry = tables.data() + tableDispls[p];
+
+		long nSends = *(entry++);
+		for (long k = 0; k < nSends; ++k) {
+			int destination   = *(entry++);
+			std::size_t count = *(entry++);
+
+			int node = m_rankNodes[destination];
+			auto range = nodeSendRanges[p].find(node);
+			if (range == nodeSendRanges[p].end()) {
+				nodeSendRanges[p].insert({node, {sendAreaSizes[p], count}});
+			} else {
+				range->second.second += count;
+			}
+
+			if (node != m_node) {
+				sendNodes.push_back(node);
+			}
+
+			sendOffsets[p][destination] = sendAreaSizes[p];
+			sendAreaSizes[p] += count;
+		}
+
+		long nRecvs = *(entry++);
+		for (long k = 0; k < nRecvs; ++k) {
+			int source        = *(entry++);
+			std::size_t count = *(entry++);
+
+			int node = m_rankNodes[source];
+			if (node != m_node) {
+				recvNodes.push_back(node);
+			}
+
+			recvCounts[p][source] = count;
+		}
+	}
+
+	std::sort(sendNodes.begin(), sendNodes.end());
+	sendNodes.erase(std::unique(sendNodes.begin(), sendNodes.end()), sendNodes.end());
+
+	std::sort(recvNodes.begin(), recvNodes.end());
+	recvNodes.erase(std::unique(recvNodes.begin(), recvNodes.end()), recvNodes.end());
+
+	// Layout of the receive areas
+	std::vector<std::size_t> recvAreaSizes(nodeSize, 0);
+	std::unordered_map<int, std::size_t> messageOffsets;
+	std::unordered_map<int, std::size_t> sourceOffsets;
+	int nodeIndex = std::find(nodeRanks.begin(), nodeRanks.end(), rank) - nodeRanks.begin();
+
+	m_nodeRecvMessages.clear();
+	for (int node : recvNodes) {
+		const std::vector<int> &sourceRanks = m_nodeRanks[node];
+		int aggregator = processes.at(nodeRanks[node % nodeSize]);
+
+		std::size_t messageSize = 0;
+		for (int source : sourceRanks) {
+			for (int destination : nodeRanks) {
+				const std::unordered_map<int, std::size_t> &counts = recvCounts[processes.at(destination)];
+				auto count = counts.find(source);
+				if (count == counts.end()) {
+					continue;
+				}
+
+				if (destination == rank) {
+					sourceOffsets[source] = messageSize;
+				}
+				messageSize += count->second;
+			}
+		}
+
+		messageOffsets[node] = recvAreaSizes[aggregator];
+		if (aggregator == nodeProcess) {
+			NodeMessage message;
+			message.rank   = sourceRanks[m_node % sourceRanks.size()];
+			message.offset = recvAreaSizes[aggregator];
+			message.size   = messageSize;
+			m_nodeRecvMessages.push_back(std::move(message));
+		}
+
+		recvAreaSizes[aggregator] += messageSize;
+	}
+
+	m_sendAreaSize = sendAreaSizes[nodeProcess];
+	m_recvAreaSize = recvAreaSizes[nodeProcess];
+
+	// Values read by this process
+	int nRecvs = m_recvRanks.size();
+	m_localBlocks.clear();
+	m_remoteBlocks.clear();
+	for (int k = 0; k < nRecvs; ++k) {
+		int source = m_recvRanks[k];
+		int node   = m_rankNodes[source];
+
+		SharedBlock block;
+		block.positions = m_recvPositions[k];
+		if (node == m_node) {
+			block.process = processes.at(source);
+			block.offset  = sendOffsets[block.process].at(rank);
+			block.stride  = 0;
+			m_localBlocks.push_back(std::move(block));
+		} else {
+			block.process = processes.at(nodeRanks[node % nodeSize]);
+			block.offset  = sendAreaSizes[block.process] + messageOffsets.at(node) + sourceOffsets.at(source);
+			block.stride  = recvAreaSizes[block.process];
+			m_remoteBlocks.push_back(std::move(block));
+		}
+	}
+
+	// Messages sent by this process
+	m_nodeSendMessages.clear();
+	for (int node : sendNodes) {
+		if ((node % nodeSize) != nodeIndex) {
+			continue;
+		}
+
+		const std::vector<int> &destinationRanks = m_nodeRanks[node];
+
+		NodeMessage message;
+		message.rank   = destinationRanks[m_node % destinationRanks.size()];
+		message.offset = 0;
+		message.size   = 0;
+		for (int source : nodeRanks) {
+			int process = processes.at(source);
+			auto range = nodeSendRanges[process].find(node);
+			if (range == nodeSendRanges[process].end()) {
+				continue;
+			}
+
+			message.chunks.push_back({{(std::size_t) process, range->second.first, range->second.second}});
+			message.size += range->second.second;
+		}
+
+		m_nodeSendMessages.push_back(std::move(message));
+	}
+
+	m_nodeSendBuffers.resize(m_nodeSendMessages.size());
+	for (std::size_t k = 0; k < m_nodeSendMessages.size(); ++k) {
+		m_nodeSendBuffers[k].resize(m_nodeSendMessages[k].size * itemSize);
+	}
+
+	m_nodeSendRequests.assign(m_nodeSendMessages.size(), MPI_REQUEST_NULL);
+	m_nodeRecvRequests.assign(m_nodeRecvMessages.size(), MPI_REQUEST_NULL);
+
+	// Shared window
+	MPI_Aint segmentSize = (m_sendAreaSize + 2 * m_recvAreaSize) * itemSize;
+
+	char *segment;
+	MPI_Win_allocate_shared(segmentSize, 1, MPI_INFO_NULL, m_nodeCommunicator, &segment, &m_window);
+
+	m_segments.resize(nodeSize);
+	for (int p = 0; p < nodeSize; ++p) {
+		int displacementUnit;
+		MPI_Win_shared_query(m_window, p, &segmentSize, &displacementUnit, &m_segments[p]);
+	}
+
+	MPI_Win_lock_all(MPI_MODE_NOCHECK, m_window);
+
+	m_parity   = 0;
+	m_itemSize = itemSize;
+}
+
+/*!
+	Frees the shared-memory window and the aggregated messages.
+
+	This is a collective operation on the processes of the node.
+*/
+void GhostExchanger::freeShared()
+{
+	if (m_window != MPI_WIN_NULL) {
+		MPI_Win_unlock_all(m_window);
+		MPI_Win_free(&m_window);
+
+		m_itemSize = 0;
+	}
+
+	m_segments.clear();
+	m_localBlocks.clear();
+	m_remoteBlocks.clear();
+	m_nodeSendMessages.clear();
+	m_nodeSendBuffers.clear();
+	m_nodeSendRequests.clear();
+	m_nodeRecvMessages.clear();
+	m_nodeRecvRequests.clear();
+
+	m_sendAreaSize = 0;
+	m_recvAreaSize = 0;
+	m_parity       = 0;
+}
+
+/*!
+	Frees the node communicator and the map between ranks and nodes.
+*/
+void GhostExchanger::freeNodes()
+{
+	if (m_nodeCommunicator != MPI_COMM_NULL) {
+		MPI_Comm_free(&m_nodeCommunicator);
+	}
+
+	m_node = -1;
+	m_rankNodes.clear();
+	m_nodeRanks.clear();
+	m_nodeProcesses.clear();
+}
+
+/*!
+	Starts the hierarchical exchange of the ghost values of the specified
+	field.
+
+	The receives of the aggregated messages are posted and the values of
+	the sources are written in the send area of the process.
+
+	\param field is a pointer to the first byte of the field
+*/
+void GhostExchanger::startSharedExchange(const char *field)
+{
+	const MPI_Comm &communicator = m_patch.getCommunicator();
+
+	int nodeProcess;
+	MPI_Comm_rank(m_nodeCommunicator, &nodeProcess);
+	char *segment = m_segments[nodeProcess];
+
+	// Start the receives of the aggregated messages
+	char *recvArea = segment + (m_sendAreaSize + m_parity * m_recvAreaSize) * m_itemSize;
+	for (std::size_t k = 0; k < m_nodeRecvMessages.size(); ++k) {
+		const NodeMessage &message = m_nodeRecvMessages[k];
+		MPI_Irecv(recvArea + message.offset * m_itemSize, message.size * m_itemSize, MPI_CHAR,
+		          message.rank, m_tag, communicator, &m_nodeRecvRequests[k]);
+	}
+
+	// Write the values of the sources in the send area
+	char *buffer = segment;
+	for (const std::vector<std::size_t> &positions : m_sendPositions) {
+		for (std::size_t position : positions) {
+			std::memcpy(buffer, field + position * m_itemSize, m_itemSize);
+			buffer += m_itemSize;
+		}
+	}
+
+	// Notify the processes of the node that the send area is ready
+	MPI_Win_sync(m_window);
+	MPI_Ibarrier(m_nodeCommunicator, &m_nodeBarrierRequest);
+}
+
+/*!
+	Waits for the hierarchical exchange of the ghost values of the
+	specified field to complete.
+
+	Once the send areas of the node are ready, the aggregated messages
+	are sent and the values of the sources of the node are copied in the
+	ghosts. Values coming from the other nodes are copied when all the
+	aggregated messages of the node have been received.
+
+	\param field is a pointer to the first byte of the field, if it is a
+	null pointer the exchange is completed without updating the ghosts
+*/
+void GhostExchanger::waitSharedExchange(char *field)
+{
+	const MPI_Comm &communicator = m_patch.getCommunicator();
+
+	// Wait for the send areas of the node
+	MPI_Wait(&m_nodeBarrierRequest, MPI_STATUS_IGNORE);
+	MPI_Win_sync(m_window);
+
+	// Pack and send the aggregated messages
+	for (std::size_t k = 0; k < m_nodeSendMessages.size(); ++k) {
+		const NodeMessage &message = m_nodeSendMessages[k];
+
+		char *buffer = m_nodeSendBuffers[k].data();
+		for (const std::array<std::size_t, 3> &chunk : message.chunks) {
+			std::size_t chunkSize = chunk[2] * m_itemSize;
+			std::memcpy(buffer, m_segments[chunk[0]] + chunk[1] * m_itemSize, chunkSize);
+			buffer += chunkSize;
+		}
+
+		MPI_Isend(m_nodeSendBuffers[k].data(), m_nodeSendBuffers[k].size(), MPI_CHAR,
+		          message.rank, m_tag, communicator, &m_nodeSendRequests[k]);
+	}
+
+	// Copy the values of the sources of the node
+	if (field) {
+		for (const SharedBlock &block : m_localBlocks) {
+			const char *values = m_segments[block.process] + block.offset * m_itemSize;
+			for (std::size_t position : block.positions) {
+				std::memcpy(field + position * m_itemSize, values, m_itemSize);
+				values += m_itemSize;
+			}
+		}
+	}
+
+	// Wait for the aggregated messages of the node
+	MPI_Waitall(m_nodeRecvRequests.size(), m_nodeRecvRequests.data(), MPI_STATUSES_IGNORE);
+
+	MPI_Win_sync(m_window);
+	MPI_Barrier(m_nodeCommunicator);
+	MPI_Win_sync(m_window);
+
+	// Copy the values of the sources of the other nodes
+	if (field) {
+		for (const SharedBlock &block : m_remoteBlocks) {
+			const char *values = m_segments[block.process] + (block.offset + m_parity * block.stride) * m_itemSize;
+			for (std::size_t position : block.positions) {
+				std::memcpy(field + position * m_itemSize, values, m_itemSize);
+				values += m_itemSize;
+			}
+		}
+	}
+
+	// Wait for the sends to complete
+	MPI_Waitall(m_nodeSendRequests.size(), m_nodeSendRequests.data(), MPI_STATUSES_IGNORE);
+
+	m_parity = 1 - m_parity;
+}
+
+/*!
+	Waits for any receive to complete.
+
+	\result The index of the completed receive or MPI_UNDEFINED if there
+	are no active receives.
+*/
+int GhostExchanger::waitAnyRecv()
+{
+	int k;
+	MPI_Waitany(m_recvRequests.size(), m_recvRequests.data(), &k, MPI_STATUS_IGNORE);
+
+	return k;
+}
+
+/*!
+	Waits for all the sends to complete.
+*/
+void GhostExchanger::waitAllSends()
+{
+	MPI_Waitall(m_sendRequests.size(), m_sendRequests.data(), MPI_STATUSES_IGNORE);
+}
+
+/*!
+	@}
+*/
+
+}
+
+#endif
@@ -0,0 +1,156 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+
+#if BITPIT_ENABLE_MPI==1
+
+#ifndef __BITPIT_GHOST_EXCHANGER_HPP__
+#define __BITPIT_GHOST_EXCHANGER_HPP__
+
+#include <mpi.h>
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "patch_kernel.hpp"
+
+namespace bitpit {
+
+class GhostExchanger {
+
+public:
+	GhostExchanger(PatchKernel &patch, int tag = DEFAULT_TAG);
+	~GhostExchanger();
+
+	GhostExchanger(const GhostExchanger &other) = delete;
+	GhostExchanger & operator=(const GhostExchanger &other) = delete;
+
+	int getTag() const;
+
+	void update();
+	bool isExchangeActive() const;
+
+	void setHierarchical(bool enabled, MPI_Comm nodeCommunicator = MPI_COMM_NULL);
+	bool isHierarchical() const;
+
+	template<typename T>
+	void exchange(T *field, std::size_t nComponents = 1);
+	template<typename T>
+	void exchange(std::vector<T> &field, std::size_t nComponents = 1);
+
+	template<typename T>
+	void startExchange(const T *field, std::size_t nComponents = 1);
+	template<typename T>
+	void startExchange(const std::vector<T> &field, std::size_t nComponents = 1);
+
+	template<typename T>
+	void waitExchange(T *field, std::size_t nComponents = 1);
+	template<typename T>
+	void waitExchange(std::vector<T> &field, std::size_t nComponents = 1);
+
+private:
+	static int DEFAULT_TAG;
+
+	struct SharedBlock {
+		int process;
+		std::size_t offset;
+		std::size_t stride;
+		std::vector<std::size_t> positions;
+	};
+
+	struct NodeMessage {
+		int rank;
+		std::size_t offset;
+		std::size_t size;
+		std::vector<std::array<std::size_t, 3>> chunks;
+	};
+
+	PatchKernel &m_patch;
+	int m_tag;
+
+	bool m_built;
+	unsigned long m_revision;
+	std::size_t m_fieldSize;
+
+	std::vector<int> m_sendRanks;
+	std::vector<std::vector<std::size_t>> m_sendPositions;
+	std::vector<std::vector<char>> m_sendBuffers;
+	std::vector<MPI_Request> m_sendRequests;
+
+	std::vector<int> m_recvRanks;
+	std::vector<std::vector<std::size_t>> m_recvPositions;
+	std::vector<std::vector<char>> m_recvBuffers;
+	std::vector<MPI_Request> m_recvRequests;
+
+	std::size_t m_itemSize;
+	std::size_t m_activeItemSize;
+	bool m_prepared;
+
+	bool m_hierarchical;
+	MPI_Comm m_nodeCommunicator;
+	int m_node;
+	std::vector<int> m_rankNodes;
+	std::vector<std::vector<int>> m_nodeRanks;
+	std::vector<int> m_nodeProcesses;
+
+	MPI_Win m_window;
+	std::vector<char *> m_segments;
+	std::size_t m_sendAreaSize;
+	std::size_t m_recvAreaSize;
+	int m_parity;
+	std::vector<SharedBlock> m_localBlocks;
+	std::vector<SharedBlock> m_remoteBlocks;
+	std::vector<NodeMessage> m_nodeSendMessages;
+	std::vector<std::vector<char>> m_nodeSendBuffers;
+	std::vector<MPI_Request> m_nodeSendRequests;
+	std::vector<NodeMessage> m_nodeRecvMessages;
+	std::vector<MPI_Request> m_nodeRecvRequests;
+	MPI_Request m_nodeBarrierRequest;
+
+	void prepare(std::size_t itemSize);
+	void buildPositions();
+	void initRequests(std::size_t itemSize);
+	void freeRequests();
+
+	void initShared(std::size_t itemSize);
+	void freeShared();
+	void freeNodes();
+	void startSharedExchange(const char *field);
+	void waitSharedExchange(char *field);
+
+	int waitAnyRecv();
+	void waitAllSends();
+
+	template<typename T>
+	void checkField(const std::vector<T> &field, std::size_t nComponents) const;
+
+};
+
+}
+
+#include "ghost_exchanger.tpp"
+
+#endif
+
+#endif
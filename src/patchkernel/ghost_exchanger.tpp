@@ -0,0 +1,230 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+
+#ifndef __BITPIT_GHOST_EXCHANGER_TPP__
+#define __BITPIT_GHOST_EXCHANGER_TPP__
+
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+namespace bitpit {
+
+/*!
+	Exchanges the ghost values of the specified field.
+
+	The field is stored contiguously and is indexed by the position of the
+	cells in the storage of the patch: the values of the cell stored at
+	raw position i are field[i * nComponents], ...,
+	field[i * nComponents + nComponents - 1]. On exit the values of the
+	ghost cells are updated with the values of the owning processors.
+
+	\param field is a pointer to the first value of the field
+	\param nComponents is the number of components of the field
+*/
+template<typename T>
+void GhostExchanger::exchange(T *field, std::size_t nComponents)
+{
+	startExchange(field, nComponents);
+	waitExchange(field, nComponents);
+}
+
+/*!
+	Exchanges the ghost values of the specified field.
+
+	\param field is the field, it should contain a value for each component
+	of each position of the cell storage
+	\param nComponents is the number of components of the field
+*/
+template<typename T>
+void GhostExchanger::exchange(std::vector<T> &field, std::size_t nComponents)
+{
+	startExchange(field, nComponents);
+	waitExchange(field, nComponents);
+}
+
+/*!
+	Starts the exchange of the ghost values of the specified field.
+
+	The values of the sources are copied in the send buffers, hence, the
+	field can be modified as soon as the function returns, as long as the
+	values of the ghost cells are not accessed until waitExchange is
+	called. Computations on the internal cells can be overlapped with the
+	communications.
+
+	If the ghost exchange information of the patch has changed since the
+	last exchange, the exchanger is rebuilt.
+
+	\param field is a pointer to the first value of the field
+	\param nComponents is the number of components of the field
+*/
+template<typename T>
+void GhostExchanger::startExchange(const T *field, std::size_t nComponents)
+{
+	static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable fields can be exchanged");
+
+	const std::size_t itemSize = nComponents * sizeof(T);
+	prepare(itemSize);
+
+	// Hierarchical exchange
+	if (m_hierarchical) {
+		startSharedExchange(reinterpret_cast<const char *>(field));
+		m_activeItemSize = itemSize;
+		return;
+	}
+
+	// Start the receives
+	if (!m_recvRequests.empty()) {
+		MPI_Startall(m_recvRequests.size(), m_recvRequests.data());
+	}
+
+	// Fill the buffers and start the sends
+	int nSends = m_sendRanks.size();
+	for (int k = 0; k < nSends; ++k) {
+		char *buffer = m_sendBuffers[k].data();
+		if (nComponents == 1) {
+			for (std::size_t position : m_sendPositions[k]) {
+				std::memcpy(buffer, field + position, sizeof(T));
+				buffer += sizeof(T);
+			}
+		} else {
+			for (std::size_t position : m_sendPositions[k]) {
+				std::memcpy(buffer, field + position * nComponents, itemSize);
+				buffer += itemSize;
+			}
+		}
+
+		MPI_Start(&m_sendRequests[k]);
+	}
+
+	m_activeItemSize = itemSize;
+}
+
+/*!
+	Starts the exchange of the ghost values of the specified field.
+
+	\param field is the field, it should contain a value for each component
+	of each position of the cell storage
+	\param nComponents is the number of components of the field
+*/
+template<typename T>
+void GhostExchanger::startExchange(const std::vector<T> &field, std::size_t nComponents)
+{
+	prepare(nComponents * sizeof(T));
+	checkField(field, nComponents);
+
+	startExchange(field.data(), nComponents);
+}
+
+/*!
+	Waits for the exchange of the ghost values of the specified field to
+	complete.
+
+	Data is copied in the ghost values as soon as it is received.
+
+	\param field is a pointer to the first value of the field, it should
+	be the same field passed to startExchange
+	\param nComponents is the number of components of the field
+*/
+template<typename T>
+void GhostExchanger::waitExchange(T *field, std::size_t nComponents)
+{
+	static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable fields can be exchanged");
+
+	const std::size_t itemSize = nComponents * sizeof(T);
+	if (m_activeItemSize != itemSize) {
+		throw std::runtime_error("The exchange has not been started for a field of this type");
+	}
+
+	// Hierarchical exchange
+	if (m_hierarchical) {
+		waitSharedExchange(reinterpret_cast<char *>(field));
+		m_activeItemSize = 0;
+		m_prepared       = false;
+		return;
+	}
+
+	// Copy the received values in the ghosts
+	while (true) {
+		int k = waitAnyRecv();
+		if (k == MPI_UNDEFINED) {
+			break;
+		}
+
+		const char *buffer = m_recvBuffers[k].data();
+		if (nComponents == 1) {
+			for (std::size_t position : m_recvPositions[k]) {
+				std::memcpy(field + position, buffer, sizeof(T));
+				buffer += sizeof(T);
+			}
+		} else {
+			for (std::size_t position : m_recvPositions[k]) {
+				std::memcpy(field + position * nComponents, buffer, itemSize);
+				buffer += itemSize;
+			}
+		}
+	}
+
+	// Wait for the sends to complete
+	waitAllSends();
+
+	m_activeItemSize = 0;
+	m_prepared       = false;
+}
+
+/*!
+	Waits for the exchange of the ghost values of the specified field to
+	complete.
+
+	\param field is the field, it should be the same field passed to
+	startExchange
+	\param nComponents is the number of components of the field
+*/
+template<typename T>
+void GhostExchanger::waitExchange(std::vector<T> &field, std::size_t nComponents)
+{
+	checkField(field, nComponents);
+
+	waitExchange(field.data(), nComponents);
+}
+
+/*!
+	Checks if the specified field contains the values of all the cells
+	involved in the exchange.
+
+	\param field is the field
+	\param nComponents is the number of components of the field
+*/
+template<typename T>
+void GhostExchanger::checkField(const std::vector<T> &field, std::size_t nComponents) const
+{
+	if (field.size() < m_fieldSize * nComponents) {
+		throw std::runtime_error("The field doesn't contain the values of all the exchanged cells");
+	}
+}
+
+}
+
+#endif
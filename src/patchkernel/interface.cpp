@@ -32,6 +32,52 @@
 #include "interface.hpp"
 #include "utils.hpp"
 
+/*!
+	Input stream operator for class Interface. Stream interface data from
+	memory input stream to container.
+
+	\param[in] buffer is the input stream from memory
+	\param[in] interface is the interface object
+	\result Returns the same input stream received in input.
+*/
+bitpit::IBinaryStream& operator>>(bitpit::IBinaryStream &buffer, bitpit::Interface &interface)
+{
+	// Read connectivity data ----------------------------------------------- //
+	bitpit::Element &element(interface);
+	buffer >> element;
+
+	// Read owner and neighbour data ---------------------------------------- //
+	buffer >> interface.m_owner;
+	buffer >> interface.m_ownerFace;
+	buffer >> interface.m_neigh;
+	buffer >> interface.m_neighFace;
+
+	return buffer;
+}
+
+/*!
+	Output stream operator for class Interface. Stream interface data from
+	container to output stream.
+
+	\param[in] buffer is the output stream from memory
+	\param[in] interface is the interface object
+	\result Returns the same output stream received in input.
+*/
+bitpit::OBinaryStream& operator<<(bitpit::OBinaryStream  &buffer, const bitpit::Interface &interface)
+{
+	// Write connectivity data ---------------------------------------------- //
+	const bitpit::Element &element(interface);
+	buffer << element;
+
+	// Write owner and neighbour data --------------------------------------- //
+	buffer << interface.m_owner;
+	buffer << interface.m_ownerFace;
+	buffer << interface.m_neigh;
+	buffer << interface.m_neighFace;
+
+	return buffer;
+}
+
 namespace bitpit {
 
 /*!
@@ -32,10 +32,20 @@
 
 #include "element.hpp"
 
+namespace bitpit {
+	class Interface;
+}
+
+bitpit::IBinaryStream& operator>>(bitpit::IBinaryStream &buf, bitpit::Interface& interface);
+bitpit::OBinaryStream& operator<<(bitpit::OBinaryStream &buf, const bitpit::Interface& interface);
+
 namespace bitpit {
 
 class Interface : public Element {
 
+friend bitpit::OBinaryStream& (::operator<<) (bitpit::OBinaryStream& buf, const Interface& interface);
+friend bitpit::IBinaryStream& (::operator>>) (bitpit::IBinaryStream& buf, Interface& interface);
+
 public:
 	Interface();
 	Interface(const long &id, ElementInfo::Type type = ElementInfo::UNDEFINED);
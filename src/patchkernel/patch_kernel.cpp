@@ -22,6 +22,10 @@
  *
 \*---------------------------------------------------------------------------*/
 
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
 #include <sstream>
 #include <typeinfo>
 #include <unordered_map>
@@ -35,6 +39,167 @@
 #include "patch_kernel.hpp"
 #include "utils.hpp"
 
+namespace {
+
+/*!
+	Maps the ids of the elements of a container to their positions in the
+	storage.
+
+	If the ids are dense, the positions are stored in a table indexed by
+	id, otherwise the positions are requested to the container.
+*/
+template<typename element_t>
+class PositionMap {
+
+public:
+	/*!
+		Creates the map for the specified container.
+
+		\param elements are the elements, the container should not have
+		holes
+	*/
+	PositionMap(const bitpit::PiercedVector<element_t> &elements)
+		: m_elements(elements)
+	{
+		std::size_t nElements = elements.size();
+
+		long maxId = -1;
+		for (std::size_t n = 0; n < nElements; ++n) {
+			maxId = std::max(elements.rawAt(n).getId(), maxId);
+		}
+
+		if (maxId < 0 || (std::size_t) maxId >= 2 * nElements) {
+			return;
+		}
+
+		m_positions.resize(maxId + 1);
+		for (std::size_t n = 0; n < nElements; ++n) {
+			m_positions[elements.rawAt(n).getId()] = n;
+		}
+	}
+
+	/*!
+		Gets the position of the element with the specified id.
+
+		\param id is the id of the element
+		\result The position of the element with the specified id.
+	*/
+	std::size_t operator()(long id) const
+	{
+		if (m_positions.empty()) {
+			return m_elements.rawIndex(id);
+		}
+
+		return m_positions[id];
+	}
+
+private:
+	const bitpit::PiercedVector<element_t> &m_elements;
+	std::vector<std::size_t> m_positions;
+
+};
+
+/*!
+	Evaluates a reverse Cuthill-McKee ordering of the specified graph.
+
+	Each connected component is visited with a breadth first search that
+	starts from a pseudo-peripheral node and that visits the neighbours
+	in ascending degree order.
+
+	\param offsets are the offsets of the neighbours of each node
+	\param neighs are the neighbours of the nodes
+	\result The nodes of the graph in reverse Cuthill-McKee order.
+*/
+std::vector<std::size_t> evalReverseCuthillMcKee(const std::vector<std::size_t> &offsets, const std::vector<std::size_t> &neighs)
+{
+	std::size_t nNodes = offsets.size() - 1;
+
+	auto degree = [&offsets] (std::size_t node) {
+		return offsets[node + 1] - offsets[node];
+	};
+
+	auto degreeLess = [&degree] (std::size_t node_1, std::size_t node_2) {
+		std::size_t degree_1 = degree(node_1);
+		std::size_t degree_2 = degree(node_2);
+		if (degree_1 != degree_2) {
+			return degree_1 < degree_2;
+		}
+
+		return node_1 < node_2;
+	};
+
+	// Candidate seeds, in ascending degree order
+	std::vector<std::size_t> seeds(nNodes);
+	for (std::size_t n = 0; n < nNodes; ++n) {
+		seeds[n] = n;
+	}
+	std::sort(seeds.begin(), seeds.end(), degreeLess);
+
+	// Breadth first search
+	//
+	// The visited nodes are appended to the order and the function returns
+	// the position of the first node of the last level.
+	std::vector<int> marks(nNodes, -1);
+	std::vector<std::size_t> order;
+	order.reserve(nNodes);
+
+	std::vector<std::size_t> levelNeighs;
+	auto visit = [&] (std::size_t seed, int mark) {
+		std::size_t begin = order.size();
+		std::size_t lastLevelBegin = begin;
+
+		marks[seed] = mark;
+		order.push_back(seed);
+
+		std::size_t levelBegin = begin;
+		while (levelBegin < order.size()) {
+			lastLevelBegin = levelBegin;
+			std::size_t levelEnd = order.size();
+			for (std::size_t k = levelBegin; k < levelEnd; ++k) {
+				std::size_t node = order[k];
+
+				levelNeighs.clear();
+				for (std::size_t j = offsets[node]; j < offsets[node + 1]; ++j) {
+					std::size_t neigh = neighs[j];
+					if (marks[neigh] != mark) {
+						marks[neigh] = mark;
+						levelNeighs.push_back(neigh);
+					}
+				}
+				std::sort(levelNeighs.begin(), levelNeighs.end(), degreeLess);
+				order.insert(order.end(), levelNeighs.begin(), levelNeighs.end());
+			}
+			levelBegin = levelEnd;
+		}
+
+		return lastLevelBegin;
+	};
+
+	int nComponents = 0;
+	for (std::size_t seed : seeds) {
+		if (marks[seed] >= 0) {
+			continue;
+		}
+
+		// Find a pseudo-peripheral node, i.e., the node with the lowest
+		// degree in the last level of a search started from the seed
+		std::size_t begin = order.size();
+		std::size_t lastLevelBegin = visit(seed, 2 * nComponents);
+		std::size_t peripheral = *std::min_element(order.begin() + lastLevelBegin, order.end(), degreeLess);
+		order.resize(begin);
+
+		// Visit the component
+		visit(peripheral, 2 * nComponents + 1);
+		++nComponents;
+	}
+
+	std::reverse(order.begin(), order.end());
+
+	return order;
+}
+
+}
+
 namespace bitpit {
 
 
@@ -91,6 +256,20 @@ long IndexGenerator::getLastId()
 	return m_id;
 }
 
+/*!
+	Sets the last generated index.
+
+	The trash is emptied, the next generated index will be the one that
+	follows the specified index.
+
+	\param id is the last generated index
+*/
+void IndexGenerator::setLastId(const long &id)
+{
+	m_id = id;
+	m_trash.clear();
+}
+
 /*!
 	Trashes an index.
 
@@ -112,6 +291,40 @@ void IndexGenerator::reset()
 	m_trash.clear();
 }
 
+/*!
+	Writes the state of the generator to the specified stream.
+
+	\param stream is the stream
+*/
+void IndexGenerator::dump(OBinaryStream &stream) const
+{
+	stream << m_id;
+	stream << (long) m_trash.size();
+	for (long id : m_trash) {
+		stream << id;
+	}
+}
+
+/*!
+	Restores the state of the generator from the specified stream.
+
+	\param stream is the stream
+*/
+void IndexGenerator::restore(IBinaryStream &stream)
+{
+	stream >> m_id;
+
+	long nTrashedIds;
+	stream >> nTrashedIds;
+
+	m_trash.clear();
+	for (long n = 0; n < nTrashedIds; ++n) {
+		long id;
+		stream >> id;
+		m_trash.push_back(id);
+	}
+}
+
 /*!
 	\ingroup patchkernel
 	@{
@@ -123,6 +336,18 @@ void IndexGenerator::reset()
 	\brief The PatchKernel class provides an interface for defining patches.
 
 	PatchKernel is the base class for defining patches.
+
+	Thread safety: the functions that do not modify the patch (e.g., the
+	functions that access vertices, cells and interfaces, that find the
+	neighbours of an element or that evaluate geometrical quantities) can
+	be called concurrently from multiple threads, as long as no thread is
+	modifying the patch at the same time. Functions that modify the patch,
+	including the functions that update adjacencies, interfaces, the
+	bounding box or the partitioning, are not thread-safe and should not
+	run concurrently with any other function of the same patch. Loops over
+	the elements of a patch can thus be parallelised with the thread pool
+	of the library (see threads::parallelFor), as long as each thread writes
+	only to its own storage.
 */
 
 /*!
@@ -140,7 +365,9 @@ PatchKernel::PatchKernel(const int &id, const int &dimension, bool expert)
 	  m_adaptionDirty(true), m_expert(expert), m_hasCustomTolerance(false),
 	  m_rank(0), m_nProcessors(1)
 #if BITPIT_ENABLE_MPI==1
-	  , m_communicator(MPI_COMM_NULL)
+	  , m_communicator(MPI_COMM_NULL), m_ghostExchangeRevision(0),
+	  m_cellExchangeCount(0),
+	  m_haloSize(1), m_haloConnectivity(HALO_VERTEX)
 #endif
 {
 	setId(id) ;
@@ -304,6 +531,10 @@ void PatchKernel::resetCells()
 	m_nInternals = 0;
 	m_nGhosts = 0;
 
+#if BITPIT_ENABLE_MPI==1
+	++m_ghostExchangeRevision;
+#endif
+
 	for (auto &interface : m_interfaces) {
 		interface.unsetNeigh();
 		interface.unsetOwner();
@@ -889,110 +1120,330 @@ bool PatchKernel::deleteOrphanVertices()
 	Find and collapse coincident vertices. Cell connectivity is
 	automatically updated.
 
-	\param[in] nBins (default = 128) is the number of bins used by
-	bin-sorting algorithm to sort tasselation vertices
+	Two vertices are coincident if the difference between each of their
+	coordinates is less than or equal to the geometrical tolerance of the
+	patch. Coordinates are quantised on a grid whose spacing is not smaller
+	than the tolerance, so coincident vertices always lie in the same grid
+	cell or in neighbouring ones. Vertices are sorted by grid cell and pairs
+	of coincident vertices are searched among neighbouring cells.
+
+	Vertices are then processed in the order of the vertex container: each
+	vertex is collapsed onto the first preceding vertex that is coincident
+	with it and that has not been collapsed itself. A vertex is therefore
+	always collapsed onto a vertex that lies within the tolerance, whereas
+	the vertices of a chain whose consecutive vertices are coincident, but
+	whose endpoints are not, are not all collapsed onto the same vertex.
+
+	Sorting, searching and the update of the connectivity are split among
+	the threads of the pool shared by the library, the result does not
+	depend on the number of threads.
+
 	\result The list of the of the collapsed vertices.
 */
-std::vector<long> PatchKernel::collapseCoincidentVertices(int nBins)
+std::vector<long> PatchKernel::collapseCoincidentVertices()
 {
 	std::vector<long> collapsedVertices;
 	if (!isExpert()) {
 		return collapsedVertices;
 	}
 
-	std::vector<std::vector<std::array<long, 2> > > bins;
+	typedef std::array<long, 3> GridKey;
+
+	long nVertices = getVertexCount();
+	if (nVertices == 0) {
+		return collapsedVertices;
+	}
+
+	int nThreads = threads::getThreadCount();
 
 	// ====================================================================== //
-	// INITIALIZE LOCAL VARIABLES                                             //
+	// QUANTISE VERTEX COORDINATES                                            //
 	// ====================================================================== //
+	updateBoundingBox();
 
-	// Random number generator
-	srand(1223145611);
+	double tolerance = getTol();
+	double extent    = 0.;
+	for (int k = 0; k < 3; ++k) {
+		extent = std::max(m_boxMaxPoint[k] - m_boxMinPoint[k], extent);
+	}
+
+	// The spacing is bounded from below to keep the keys representable
+	double spacing = std::max(tolerance, std::ldexp(extent, -40));
+	if (spacing <= 0.) {
+		spacing = 1.;
+	}
+
+	std::vector<long> vertexIds;
+	std::vector<const Vertex *> vertices;
+	vertexIds.reserve(nVertices);
+	vertices.reserve(nVertices);
+	for (const Vertex &vertex : m_vertices) {
+		vertexIds.push_back(vertex.getId());
+		vertices.push_back(&vertex);
+	}
 
-	// Resize variables
-	bins.resize(nBins * nBins * nBins);
+	std::vector<GridKey> keys(nVertices);
+	threads::parallelFor(nThreads, nVertices, [&] (std::size_t begin, std::size_t end) {
+		for (std::size_t n = begin; n < end; ++n) {
+			const std::array<double, 3> &coords = vertices[n]->getCoords();
+			for (int k = 0; k < 3; ++k) {
+				keys[n][k] = (long) std::floor((coords[k] - m_boxMinPoint[k]) / spacing);
+			}
+		}
+	});
 
 	// ====================================================================== //
-	// SORT VERTICES ON BINS                                                  //
+	// SORT VERTICES BY GRID CELL                                             //
 	// ====================================================================== //
 
-	// Sort vertices
-	std::unordered_map<long, long> bin_index = binSortVertex(nBins);
+	// Vertices are ordered by key and then by position in the container,
+	// chunks are sorted concurrently and merged afterwards.
+	std::vector<long> order(nVertices);
+	for (long n = 0; n < nVertices; ++n) {
+		order[n] = n;
+	}
 
-	// Sort cells
-	std::array<long, 2> binEntry;
-	for (const Cell &cell : m_cells) {
-		int nCellVertices = cell.getVertexCount();
-		for (int j = 0; j < nCellVertices; ++j) {
-			binEntry[0] = cell.getId();
-			binEntry[1] = j;
+	auto orderLess = [&keys] (long n_1, long n_2) -> bool
+	{
+		if (keys[n_1] != keys[n_2]) {
+			return (keys[n_1] < keys[n_2]);
+		}
 
-			long vertexId = cell.getVertex(j);
-			long binId = bin_index[vertexId];
-			bins[binId].push_back(binEntry);
+		return (n_1 < n_2);
+	};
+
+	std::size_t chunkSize = ThreadPool::evalChunkSize(nThreads, nVertices);
+	threads::parallelFor(nThreads, nVertices, [&] (std::size_t begin, std::size_t end) {
+		std::sort(order.begin() + begin, order.begin() + end, orderLess);
+	});
+
+	for (std::size_t width = chunkSize; width < (std::size_t) nVertices; width *= 2) {
+		for (std::size_t begin = 0; begin + width < (std::size_t) nVertices; begin += 2 * width) {
+			std::size_t middle = begin + width;
+			std::size_t end    = std::min(begin + 2 * width, (std::size_t) nVertices);
+			std::inplace_merge(order.begin() + begin, order.begin() + middle, order.begin() + end, orderLess);
 		}
 	}
 
-	// Free memory
-	bin_index.clear();
+	// Grid cells occupied by the vertices
+	std::vector<GridKey> gridKeys;
+	std::vector<long> gridOffsets;
+	for (long i = 0; i < nVertices; ++i) {
+		const GridKey &key = keys[order[i]];
+		if (gridKeys.empty() || gridKeys.back() != key) {
+			gridKeys.push_back(key);
+			gridOffsets.push_back(i);
+		}
+	}
+	gridOffsets.push_back(nVertices);
+
+	long nGridCells = gridKeys.size();
 
 	// ====================================================================== //
-	// COLLAPSE DOUBLE VERTICES                                               //
+	// FIND COINCIDENT PAIRS                                                  //
 	// ====================================================================== //
-	long collapsedVertexId;
-	std::vector<bool> flag(getVertexCount(), false);
-	for (auto &bin : bins) {
-		int nBinCells = bin.size();
-		if (nBinCells > 0) {
-			// Randomize vertex insertion
-			std::vector<int> list;
-			utils::extractWithoutReplacement(nBinCells, nBinCells - 1, list);
-
-			// Vertex insertion
-			KdTree<3, Vertex, long> kd(nBinCells);
-			for (int j = 0; j < nBinCells; ++j) {
-				long cellId = bin[list[j]][0];
-				Cell &cell  = m_cells[cellId];
-
-				long k         = bin[list[j]][1];
-				long vertexId  = cell.getVertex(k);
-				Vertex &vertex = m_vertices[vertexId];
-
-				if (kd.exist(&vertex, collapsedVertexId) >= 0) {
-					cell.setVertex(k, collapsedVertexId);
-					if (!flag[vertexId]) {
-						flag[vertexId] = true;
-						collapsedVertices.push_back(vertexId);
+
+	// Each grid cell is compared with itself and with the neighbouring
+	// cells that follow it in lexicographic order, so every pair of
+	// neighbouring cells is visited once.
+	std::vector<GridKey> neighOffsets;
+	for (long i = -1; i <= 1; ++i) {
+		for (long j = -1; j <= 1; ++j) {
+			for (long k = -1; k <= 1; ++k) {
+				GridKey offset = {{i, j, k}};
+				if (offset > GridKey{{0, 0, 0}}) {
+					neighOffsets.push_back(offset);
+				}
+			}
+		}
+	}
+
+	auto areCoincident = [&vertices, tolerance] (long n_1, long n_2) -> bool
+	{
+		const std::array<double, 3> &coords_1 = vertices[n_1]->getCoords();
+		const std::array<double, 3> &coords_2 = vertices[n_2]->getCoords();
+		for (int k = 0; k < 3; ++k) {
+			if (std::abs(coords_1[k] - coords_2[k]) > tolerance) {
+				return false;
+			}
+		}
+
+		return true;
+	};
+
+	int nGridChunks = std::max(1, std::min(nThreads, (int) nGridCells));
+	std::vector<std::vector<std::array<long, 2>>> chunkPairs(nGridChunks);
+	std::size_t gridChunkSize = ThreadPool::evalChunkSize(nGridChunks, nGridCells);
+	threads::parallelFor(nGridChunks, nGridCells, [&] (std::size_t begin, std::size_t end) {
+		std::vector<std::array<long, 2>> &pairs = chunkPairs[begin / gridChunkSize];
+		for (std::size_t cell = begin; cell < end; ++cell) {
+			long cellBegin = gridOffsets[cell];
+			long cellEnd   = gridOffsets[cell + 1];
+
+			// Pairs inside the cell
+			for (long i = cellBegin; i < cellEnd; ++i) {
+				for (long j = i + 1; j < cellEnd; ++j) {
+					if (areCoincident(order[i], order[j])) {
+						pairs.push_back({{order[i], order[j]}});
 					}
-				} else {
-					flag[vertexId] = true;
-					kd.insert(&vertex, vertexId);
 				}
 			}
+
+			// Pairs with the neighbouring cells
+			for (const GridKey &offset : neighOffsets) {
+				GridKey neighKey;
+				for (int k = 0; k < 3; ++k) {
+					neighKey[k] = gridKeys[cell][k] + offset[k];
+				}
+
+				auto neighItr = std::lower_bound(gridKeys.begin() + cell + 1, gridKeys.end(), neighKey);
+				if (neighItr == gridKeys.end() || *neighItr != neighKey) {
+					continue;
+				}
+
+				long neigh      = neighItr - gridKeys.begin();
+				long neighBegin = gridOffsets[neigh];
+				long neighEnd   = gridOffsets[neigh + 1];
+				for (long i = cellBegin; i < cellEnd; ++i) {
+					for (long j = neighBegin; j < neighEnd; ++j) {
+						if (areCoincident(order[i], order[j])) {
+							pairs.push_back({{order[i], order[j]}});
+						}
+					}
+				}
+			}
+		}
+	});
+
+	std::vector<GridKey>().swap(keys);
+	std::vector<long>().swap(order);
+
+	// ====================================================================== //
+	// CHOOSE THE TARGET OF EACH VERTEX                                       //
+	// ====================================================================== //
+
+	// Vertices are processed in the order of the container: each vertex is
+	// collapsed onto the first preceding vertex that is coincident with it
+	// and that has not been collapsed itself, otherwise it is kept. Every
+	// vertex is thus collapsed onto a vertex within the tolerance, coincidence
+	// is not propagated along chains of vertices.
+	//
+	// Pairs are stored as (vertex, preceding vertex) and sorted, so that the
+	// candidates of each vertex are listed in the order of the container.
+	std::vector<std::array<long, 2>> pairs;
+	for (std::vector<std::array<long, 2>> &chunk : chunkPairs) {
+		for (const std::array<long, 2> &pair : chunk) {
+			pairs.push_back({{std::max(pair[0], pair[1]), std::min(pair[0], pair[1])}});
+		}
+
+		std::vector<std::array<long, 2>>().swap(chunk);
+	}
+	std::sort(pairs.begin(), pairs.end());
+
+	std::vector<long> target(nVertices);
+	for (long n = 0; n < nVertices; ++n) {
+		target[n] = n;
+	}
+
+	for (std::size_t i = 0; i < pairs.size(); ++i) {
+		long n = pairs[i][0];
+		if (target[n] != n) {
+			continue;
+		}
+
+		long candidate = pairs[i][1];
+		if (target[candidate] == candidate) {
+			target[n] = candidate;
 		}
 	}
 
+	// Replacement of the collapsed vertices, indexed by raw position
+	std::size_t rawSize = m_vertices.rawEnd() - m_vertices.rawBegin();
+	std::vector<long> replacements(rawSize, Vertex::NULL_ID);
+	for (long n = 0; n < nVertices; ++n) {
+		if (target[n] != n) {
+			long vertexId = vertexIds[n];
+			replacements[m_vertices.rawIndex(vertexId)] = vertexIds[target[n]];
+			collapsedVertices.push_back(vertexId);
+		}
+	}
+
+	if (collapsedVertices.empty()) {
+		return collapsedVertices;
+	}
+
+	// ====================================================================== //
+	// UPDATE CELL CONNECTIVITY                                               //
+	// ====================================================================== //
+	std::vector<Cell *> cells;
+	cells.reserve(m_cells.size());
+	for (Cell &cell : m_cells) {
+		cells.push_back(&cell);
+	}
+
+	threads::parallelFor(nThreads, cells.size(), [&] (std::size_t begin, std::size_t end) {
+		for (std::size_t i = begin; i < end; ++i) {
+			Cell &cell = *(cells[i]);
+			int nCellVertices = cell.getVertexCount();
+			for (int j = 0; j < nCellVertices; ++j) {
+				long replacement = replacements[m_vertices.rawIndex(cell.getVertex(j))];
+				if (replacement != Vertex::NULL_ID) {
+					cell.setVertex(j, replacement);
+				}
+			}
+		}
+	});
+
 	return collapsedVertices;
 }
 
 /*!
-	Remove coincident vertices from the patch.
+	Find and collapse coincident vertices. Cell connectivity is
+	automatically updated.
+
+	\deprecated Vertices are no longer sorted on bins, use
+	collapseCoincidentVertices() instead.
 
-	\param[in] nBins (default = 128) is the number of bins used by bin
-	sorting algotrithm to sort patch vertices.
+	\param[in] nBins is ignored
+	\result The list of the of the collapsed vertices.
 */
-bool PatchKernel::deleteCoincidentVertices(int nBins)
+std::vector<long> PatchKernel::collapseCoincidentVertices(int nBins)
+{
+	BITPIT_UNUSED(nBins);
+
+	return collapseCoincidentVertices();
+}
+
+/*!
+	Remove coincident vertices from the patch.
+*/
+bool PatchKernel::deleteCoincidentVertices()
 {
 	if (!isExpert()) {
 		return false;
 	}
 
-	std::vector<long> verticesToDelete = collapseCoincidentVertices(nBins);
+	std::vector<long> verticesToDelete = collapseCoincidentVertices();
 	deleteVertices(verticesToDelete);
 
 	return true;
 }
 
+/*!
+	Remove coincident vertices from the patch.
+
+	\deprecated Vertices are no longer sorted on bins, use
+	deleteCoincidentVertices() instead.
+
+	\param[in] nBins is ignored
+*/
+bool PatchKernel::deleteCoincidentVertices(int nBins)
+{
+	BITPIT_UNUSED(nBins);
+
+	return deleteCoincidentVertices();
+}
+
 /*!
 	Gets the coordinates of the specified vertex.
 
@@ -1215,6 +1666,11 @@ PatchKernel::CellIterator PatchKernel::createCell(ElementInfo::Type type, bool i
 		id = generateCellId();
 	}
 
+	// Cells may be moved inside the storage
+#if BITPIT_ENABLE_MPI==1
+	++m_ghostExchangeRevision;
+#endif
+
 	const ElementInfo &cellTypeInfo = ElementInfo::getElementInfo(type);
 	if (cellTypeInfo.dimension > getDimension()) {
 		return cellEnd();
@@ -1464,6 +1920,9 @@ bool PatchKernel::deleteCell(const long &id, bool updateNeighs, bool delayed)
 	bool isInternal = m_cells.at(id).isInterior();
 	m_cells.erase(id, delayed);
 	m_cellIdGenerator.trashId(id);
+#if BITPIT_ENABLE_MPI==1
+	++m_ghostExchangeRevision;
+#endif
 	if (isInternal) {
 		m_nInternals--;
 		if (m_nInternals == 0) {
@@ -1558,6 +2017,10 @@ PatchKernel::CellIterator PatchKernel::moveInternal2Ghost(const long &id)
 		m_cells.swap(id, m_lastInternalId);
 	}
 
+#if BITPIT_ENABLE_MPI==1
+	++m_ghostExchangeRevision;
+#endif
+
 	// Get the iterator pointing to the updated position of the element
 	CellIterator iterator = m_cells.getIterator(id);
 
@@ -1596,6 +2059,10 @@ PatchKernel::CellIterator PatchKernel::moveGhost2Internal(const long &id)
 		m_cells.swap(id, m_firstGhostId);
 	}
 
+#if BITPIT_ENABLE_MPI==1
+	++m_ghostExchangeRevision;
+#endif
+
 	// Get the iterator pointing to the updated position of the element
 	CellIterator iterator = m_cells.getIterator(id);
 
@@ -2483,6 +2950,10 @@ bool PatchKernel::sortCells()
 
 	m_cells.sort();
 
+#if BITPIT_ENABLE_MPI==1
+	++m_ghostExchangeRevision;
+#endif
+
 	return true;
 }
 
@@ -2546,6 +3017,10 @@ bool PatchKernel::squeezeCells()
 
 	m_cells.squeeze();
 
+#if BITPIT_ENABLE_MPI==1
+	++m_ghostExchangeRevision;
+#endif
+
 	return true;
 }
 
@@ -2583,6 +3058,457 @@ bool PatchKernel::squeeze()
 	return status;
 }
 
+/*!
+	Number of bits used to quantise each coordinate when evaluating
+	space filling curve keys.
+*/
+const int PatchKernel::SFC_BITS = 21;
+
+/*!
+	Evaluates the key of the specified point along a space filling curve.
+
+	The Hilbert key is evaluated transforming the coordinates with the
+	algorithm described in "Programming the Hilbert curve" by J. Skilling
+	and then interleaving the bits of the transformed coordinates, the
+	Morton key is obtained interleaving the bits of the coordinates.
+
+	\param coords are the quantised coordinates of the point, only the
+	first SFC_BITS bits of each coordinate are considered
+	\param hilbert controls if the Hilbert or the Morton key is evaluated
+	\result The key of the point along the curve.
+*/
+uint64_t PatchKernel::evalSpaceFillingKey(std::array<uint32_t, 3> coords, bool hilbert)
+{
+	if (hilbert) {
+		// Inverse undo
+		for (uint32_t q = (1u << (SFC_BITS - 1)); q > 1; q >>= 1) {
+			uint32_t p = q - 1;
+			for (int i = 0; i < 3; ++i) {
+				if (coords[i] & q) {
+					coords[0] ^= p;
+				} else {
+					uint32_t t = (coords[0] ^ coords[i]) & p;
+					coords[0] ^= t;
+					coords[i] ^= t;
+				}
+			}
+		}
+
+		// Gray encode
+		for (int i = 1; i < 3; ++i) {
+			coords[i] ^= coords[i - 1];
+		}
+
+		uint32_t t = 0;
+		for (uint32_t q = (1u << (SFC_BITS - 1)); q > 1; q >>= 1) {
+			if (coords[2] & q) {
+				t ^= q - 1;
+			}
+		}
+
+		for (int i = 0; i < 3; ++i) {
+			coords[i] ^= t;
+		}
+	}
+
+	// Interleave the bits
+	uint64_t key = 0;
+	for (int bit = SFC_BITS - 1; bit >= 0; --bit) {
+		for (int i = 0; i < 3; ++i) {
+			key = (key << 1) | ((coords[i] >> bit) & 1u);
+		}
+	}
+
+	return key;
+}
+
+/*!
+	Renumbers cells, vertices and interfaces to improve the locality of
+	the data structures.
+
+	Cells are ordered using the specified algorithm: the space filling
+	curves order the cells by the position of their centroids along the
+	curve, whereas the reverse Cuthill-McKee algorithm orders the cells
+	visiting the graph defined by the cell adjacencies (if adjacencies
+	are not built, the order of the cells is left unchanged). Internal
+	cells are always placed before ghost cells. Vertices and interfaces
+	are ordered following the first cell that uses them, vertices and
+	interfaces that are not used by any cell are placed at the end.
+
+	After the renumbering the ids of the elements are the positions of
+	the elements in the storage, connectivity, adjacencies and interfaces
+	are updated accordingly.
+
+	\param algorithm is the algorithm that will be used to order the cells
+	\param trackRenumbering if set to true, the function will return the
+	information about the renumbering of cells, interfaces and vertices
+	\result If the renumbering is tracked, returns a vector of adaption::Info
+	with the previous and current ids of the renumbered elements, the i-th
+	previous id is renumbered to the i-th current id.
+*/
+const std::vector<adaption::Info> PatchKernel::renumber(RenumberingAlgorithm algorithm, bool trackRenumbering)
+{
+	std::vector<adaption::Info> renumberingInfo;
+	if (!isExpert()) {
+		return renumberingInfo;
+	}
+
+	// Compact the storage
+	m_vertices.squeeze();
+	m_cells.squeeze();
+	m_interfaces.squeeze();
+
+	std::size_t nVertices   = m_vertices.size();
+	std::size_t nCells      = m_cells.size();
+	std::size_t nInterfaces = m_interfaces.size();
+
+	PositionMap<Vertex> vertexPositions(m_vertices);
+	PositionMap<Cell> cellPositions(m_cells);
+	PositionMap<Interface> interfacePositions(m_interfaces);
+
+	int nThreads = threads::getThreadCount();
+
+	// Order of the cells
+	//
+	// The order contains the storage positions of the cells.
+	std::vector<std::size_t> cellOrder(nCells);
+	if (algorithm == RENUMBERING_CUTHILL_MCKEE) {
+		std::vector<std::size_t> graphOffsets(nCells + 1, 0);
+		for (std::size_t n = 0; n < nCells; ++n) {
+			const Cell &cell = m_cells.rawAt(n);
+			graphOffsets[n + 1] = graphOffsets[n] + std::max(cell.getAdjacencyCount(), 0);
+		}
+
+		std::vector<std::size_t> graphNeighs(graphOffsets.back());
+		std::vector<std::size_t> graphDegrees(nCells, 0);
+		threads::parallelFor(nThreads, nCells, [&] (std::size_t begin, std::size_t end) {
+			for (std::size_t n = begin; n < end; ++n) {
+				const Cell &cell = m_cells.rawAt(n);
+				const long *adjacencies = cell.getAdjacencies();
+				int nAdjacencies = cell.getAdjacencyCount();
+
+				std::size_t graphEnd = graphOffsets[n];
+				for (int k = 0; k < nAdjacencies; ++k) {
+					if (adjacencies[k] >= 0) {
+						graphNeighs[graphEnd++] = cellPositions(adjacencies[k]);
+					}
+				}
+				graphDegrees[n] = graphEnd - graphOffsets[n];
+			}
+		});
+
+		// Compact the graph
+		std::size_t graphSize = 0;
+		for (std::size_t n = 0; n < nCells; ++n) {
+			std::size_t graphBegin = graphOffsets[n];
+			graphOffsets[n] = graphSize;
+			for (std::size_t k = 0; k < graphDegrees[n]; ++k) {
+				graphNeighs[graphSize++] = graphNeighs[graphBegin + k];
+			}
+		}
+		graphOffsets[nCells] = graphSize;
+		graphNeighs.resize(graphSize);
+
+		cellOrder = evalReverseCuthillMcKee(graphOffsets, graphNeighs);
+	} else {
+		// Cell centroids
+		std::vector<std::array<double, 3>> centroids(nCells);
+		threads::parallelFor(nThreads, nCells, [&] (std::size_t begin, std::size_t end) {
+			for (std::size_t n = begin; n < end; ++n) {
+				centroids[n] = evalCellCentroid(m_cells.rawAt(n).getId());
+			}
+		});
+
+		// Quantise the centroids
+		//
+		// The same scale is used along all directions, this preserves the
+		// proportions of the domain.
+		std::array<double, 3> minPoint;
+		std::array<double, 3> maxPoint;
+		minPoint.fill(std::numeric_limits<double>::max());
+		maxPoint.fill(-std::numeric_limits<double>::max());
+		for (const std::array<double, 3> &centroid : centroids) {
+			for (int d = 0; d < 3; ++d) {
+				minPoint[d] = std::min(centroid[d], minPoint[d]);
+				maxPoint[d] = std::max(centroid[d], maxPoint[d]);
+			}
+		}
+
+		double extent = 0.;
+		for (int d = 0; d < 3; ++d) {
+			extent = std::max(maxPoint[d] - minPoint[d], extent);
+		}
+
+		double scale = 0.;
+		if (extent > 0.) {
+			scale = ((1u << SFC_BITS) - 1) / extent;
+		}
+
+		// Sort the cells along the curve
+		//
+		// Cells with the same key are sorted by their storage position, this
+		// makes the order independent from the number of threads.
+		bool hilbert = (algorithm == RENUMBERING_HILBERT);
+
+		std::vector<std::pair<uint64_t, std::size_t>> keys(nCells);
+		std::size_t chunkSize = ThreadPool::evalChunkSize(nThreads, nCells);
+		threads::parallelFor(nThreads, nCells, [&] (std::size_t begin, std::size_t end) {
+			for (std::size_t n = begin; n < end; ++n) {
+				std::array<uint32_t, 3> coords;
+				for (int d = 0; d < 3; ++d) {
+					coords[d] = static_cast<uint32_t>((centroids[n][d] - minPoint[d]) * scale);
+				}
+				keys[n] = std::make_pair(evalSpaceFillingKey(coords, hilbert), n);
+			}
+
+			std::sort(keys.begin() + begin, keys.begin() + end);
+		});
+
+		for (std::size_t mergeBegin = chunkSize; mergeBegin < nCells; mergeBegin += chunkSize) {
+			std::size_t mergeEnd = std::min(mergeBegin + chunkSize, nCells);
+			std::inplace_merge(keys.begin(), keys.begin() + mergeBegin, keys.begin() + mergeEnd);
+		}
+
+		for (std::size_t n = 0; n < nCells; ++n) {
+			cellOrder[n] = keys[n].second;
+		}
+	}
+
+	// Internal cells are placed before ghost cells
+	std::stable_partition(cellOrder.begin(), cellOrder.end(), [this] (std::size_t n) {
+		return m_cells.rawAt(n).isInterior();
+	});
+
+	// Order of the vertices and of the interfaces
+	//
+	// Vertices and interfaces follow the order of the first cell that uses
+	// them, unused vertices and interfaces are placed at the end.
+	std::vector<long> vertexRenumbering(nVertices, Vertex::NULL_ID);
+	std::vector<long> interfaceRenumbering(nInterfaces, Element::NULL_ID);
+	std::vector<long> cellRenumbering(nCells);
+
+	long nRenumberedVertices   = 0;
+	long nRenumberedInterfaces = 0;
+	for (std::size_t k = 0; k < nCells; ++k) {
+		std::size_t n = cellOrder[k];
+		cellRenumbering[n] = k;
+
+		const Cell &cell = m_cells.rawAt(n);
+
+		const long *connect = cell.getConnect();
+		int nCellVertices = cell.getVertexCount();
+		for (int i = 0; i < nCellVertices; ++i) {
+			std::size_t vertexPos = vertexPositions(connect[i]);
+			if (vertexRenumbering[vertexPos] < 0) {
+				vertexRenumbering[vertexPos] = nRenumberedVertices++;
+			}
+		}
+
+		const long *interfaces = cell.getInterfaces();
+		int nCellInterfaces = cell.getInterfaceCount();
+		for (int i = 0; i < nCellInterfaces; ++i) {
+			if (interfaces[i] < 0) {
+				continue;
+			}
+
+			std::size_t interfacePos = interfacePositions(interfaces[i]);
+			if (interfaceRenumbering[interfacePos] < 0) {
+				interfaceRenumbering[interfacePos] = nRenumberedInterfaces++;
+			}
+		}
+	}
+
+	for (std::size_t n = 0; n < nVertices; ++n) {
+		if (vertexRenumbering[n] < 0) {
+			vertexRenumbering[n] = nRenumberedVertices++;
+		}
+	}
+
+	for (std::size_t n = 0; n < nInterfaces; ++n) {
+		if (interfaceRenumbering[n] < 0) {
+			interfaceRenumbering[n] = nRenumberedInterfaces++;
+		}
+	}
+
+	// Track the renumbering
+	if (trackRenumbering) {
+		renumberingInfo.emplace_back(adaption::TYPE_RENUMBERING, adaption::ENTITY_CELL, m_rank);
+		renumberingInfo.emplace_back(adaption::TYPE_RENUMBERING, adaption::ENTITY_INTERFACE, m_rank);
+		renumberingInfo.emplace_back(adaption::TYPE_RENUMBERING, adaption::ENTITY_VERTEX, m_rank);
+
+		const std::vector<long> *renumberings[3] = {&cellRenumbering, &interfaceRenumbering, &vertexRenumbering};
+		for (int i = 0; i < 3; ++i) {
+			adaption::Info &info = renumberingInfo[i];
+			const std::vector<long> &renumbering = *(renumberings[i]);
+
+			std::size_t nElements = renumbering.size();
+			info.previous.resize(nElements);
+			info.current.resize(nElements);
+			for (std::size_t n = 0; n < nElements; ++n) {
+				long id;
+				if (i == 0) {
+					id = m_cells.rawAt(n).getId();
+				} else if (i == 1) {
+					id = m_interfaces.rawAt(n).getId();
+				} else {
+					id = m_vertices.rawAt(n).getId();
+				}
+
+				info.previous[renumbering[n]] = id;
+				info.current[renumbering[n]]  = renumbering[n];
+			}
+		}
+	}
+
+	// Update the ids stored in cells and interfaces
+	//
+	// Updated ids are evaluated while the containers still use the previous
+	// ids, only the contents of the elements are modified.
+	threads::parallelFor(nThreads, nCells, [&] (std::size_t begin, std::size_t end) {
+		for (std::size_t n = begin; n < end; ++n) {
+			Cell &cell = m_cells.rawAt(n);
+
+			long *connect = cell.getConnect();
+			int nCellVertices = cell.getVertexCount();
+			for (int i = 0; i < nCellVertices; ++i) {
+				connect[i] = vertexRenumbering[vertexPositions(connect[i])];
+			}
+
+			if (cell.getAdjacencyCount() <= 0 && cell.getInterfaceCount() <= 0) {
+				continue;
+			}
+
+			int nCellFaces = cell.getFaceCount();
+			for (int face = 0; face < nCellFaces; ++face) {
+				if (cell.getAdjacencyCount() > 0) {
+					int nFaceAdjacencies = cell.getAdjacencyCount(face);
+					for (int i = 0; i < nFaceAdjacencies; ++i) {
+						long adjacency = cell.getAdjacency(face, i);
+						if (adjacency >= 0) {
+							cell.setAdjacency(face, i, cellRenumbering[cellPositions(adjacency)]);
+						}
+					}
+				}
+
+				if (cell.getInterfaceCount() > 0) {
+					int nFaceInterfaces = cell.getInterfaceCount(face);
+					for (int i = 0; i < nFaceInterfaces; ++i) {
+						long interface = cell.getInterface(face, i);
+						if (interface >= 0) {
+							cell.setInterface(face, i, interfaceRenumbering[interfacePositions(interface)]);
+						}
+					}
+				}
+			}
+		}
+	});
+
+	threads::parallelFor(nThreads, nInterfaces, [&] (std::size_t begin, std::size_t end) {
+		for (std::size_t n = begin; n < end; ++n) {
+			Interface &interface = m_interfaces.rawAt(n);
+
+			long *connect = interface.getConnect();
+			int nInterfaceVertices = interface.getVertexCount();
+			for (int i = 0; i < nInterfaceVertices; ++i) {
+				connect[i] = vertexRenumbering[vertexPositions(connect[i])];
+			}
+
+			long owner = interface.getOwner();
+			if (owner >= 0) {
+				interface.setOwner(cellRenumbering[cellPositions(owner)], interface.getOwnerFace());
+			}
+
+			long neigh = interface.getNeigh();
+			if (neigh >= 0) {
+				interface.setNeigh(cellRenumbering[cellPositions(neigh)], interface.getNeighFace());
+			}
+		}
+	});
+
+#if BITPIT_ENABLE_MPI==1
+	// Update ghost information
+	//
+	// Exchange lists are sorted by cell position, hence the renumbering
+	// doesn't change their order.
+	std::unordered_map<long, int> ghostOwners;
+	for (const auto &entry : m_ghostOwners) {
+		ghostOwners.insert({cellRenumbering[cellPositions(entry.first)], entry.second});
+	}
+	m_ghostOwners.swap(ghostOwners);
+
+	for (auto &entry : m_ghostExchangeTargets) {
+		for (long &id : entry.second) {
+			id = cellRenumbering[cellPositions(id)];
+		}
+	}
+
+	for (auto &entry : m_ghostExchangeSources) {
+		for (long &id : entry.second) {
+			id = cellRenumbering[cellPositions(id)];
+		}
+	}
+
+	++m_ghostExchangeRevision;
+#endif
+
+	// Rebuild the containers
+	//
+	// Elements are moved into new containers in the renumbered order, the
+	// id of each element is its position in the storage.
+	std::vector<std::size_t> vertexOrder(nVertices);
+	for (std::size_t n = 0; n < nVertices; ++n) {
+		vertexOrder[vertexRenumbering[n]] = n;
+	}
+
+	PiercedVector<Vertex> vertices(nVertices);
+	for (std::size_t k = 0; k < nVertices; ++k) {
+		Vertex &vertex = m_vertices.rawAt(vertexOrder[k]);
+		vertex.setId(k);
+		vertices.emplaceBack(k, std::move(vertex));
+	}
+	m_vertices.swap(vertices);
+
+	std::vector<std::size_t> interfaceOrder(nInterfaces);
+	for (std::size_t n = 0; n < nInterfaces; ++n) {
+		interfaceOrder[interfaceRenumbering[n]] = n;
+	}
+
+	PiercedVector<Interface> interfaces(nInterfaces);
+	for (std::size_t k = 0; k < nInterfaces; ++k) {
+		Interface &interface = m_interfaces.rawAt(interfaceOrder[k]);
+		interface.setId(k);
+		interfaces.emplaceBack(k, std::move(interface));
+	}
+	m_interfaces.swap(interfaces);
+
+	PiercedVector<Cell> cells(nCells);
+	for (std::size_t k = 0; k < nCells; ++k) {
+		Cell &cell = m_cells.rawAt(cellOrder[k]);
+		cell.setId(k);
+		cells.emplaceBack(k, std::move(cell));
+	}
+	m_cells.swap(cells);
+
+	// Update the id generators and the markers of internal and ghost cells
+	m_vertexIdGenerator.setLastId(nVertices - 1);
+	m_interfaceIdGenerator.setLastId(nInterfaces - 1);
+	m_cellIdGenerator.setLastId(nCells - 1);
+
+	if (m_nInternals > 0) {
+		m_lastInternalId = m_nInternals - 1;
+	} else {
+		m_lastInternalId = Element::NULL_ID;
+	}
+
+	if (m_nGhosts > 0) {
+		m_firstGhostId = m_nInternals;
+	} else {
+		m_firstGhostId = Element::NULL_ID;
+	}
+
+	return renumberingInfo;
+}
+
 /*!
 	Evaluates the centroid of the specified cell.
 
@@ -3259,7 +4185,7 @@ std::unordered_map<long, long> PatchKernel::binSortVertex(int nBins)
     direction)
     \result Returns the bin index associated to each vertex.
 */
-std::unordered_map<long, long> PatchKernel::binSortVertex(PiercedVector<Vertex> vertices, int nBins)
+std::unordered_map<long, long> PatchKernel::binSortVertex(const PiercedVector<Vertex> &vertices, int nBins)
 {
     // ====================================================================== //
     // VARIABLES DECLARATION                                                  //
@@ -3270,7 +4196,7 @@ std::unordered_map<long, long> PatchKernel::binSortVertex(PiercedVector<Vertex>
 
     // Counters
     long                                i, j, k;
-    PiercedVector<Vertex>::iterator     V, E = vertices.end();
+    PiercedVector<Vertex>::const_iterator V, E = vertices.cend();
 
     // ====================================================================== //
     // ASSOCIATE EACH VERTEX WITH A BIN                                       //
@@ -3286,7 +4212,7 @@ std::unordered_map<long, long> PatchKernel::binSortVertex(PiercedVector<Vertex>
 
     // Loop over vertices
     std::unordered_map<long, long> bin_index;
-    for (V = vertices.begin(); V != E; ++V) {
+    for (V = vertices.cbegin(); V != E; ++V) {
         i = std::min(nBins - 1L, long((V->getCoords()[0] - m_boxMinPoint[0]) / dx));
         j = std::min(nBins - 1L, long((V->getCoords()[1] - m_boxMinPoint[1]) / dy));
         k = std::min(nBins - 1L, long((V->getCoords()[2] - m_boxMinPoint[2]) / dz));
@@ -3373,6 +4299,49 @@ void PatchKernel::scale(double sx, double sy, double sz)
 	scale({{sx, sy, sz}});
 }
 
+/*!
+	Displaces the vertices of the patch.
+
+	Displacements are listed in the same order in which vertices are
+	iterated (i.e., the order of getVertices()). The bounding box is
+	marked as dirty only once, after all the vertices have been moved.
+
+	Since the geometry of the patch is defined by the vertices, the
+	vertices can only be displaced when the expert mode is enabled.
+	In a partitioned patch, each process displaces its own vertices,
+	including the ones of the ghost cells.
+
+	\param[in] displacements are the displacements of the vertices
+	\result Returns true if the vertices have been displaced, false
+	otherwise (the reason is written to the log).
+*/
+bool PatchKernel::displaceVertices(const std::vector<std::array<double, 3>> &displacements)
+{
+	if (!isExpert()) {
+		log::cout() << "The patch is not in expert mode, its vertices cannot be displaced" << std::endl;
+		return false;
+	}
+
+	if ((long) displacements.size() != getVertexCount()) {
+		log::cout() << "The number of displacements does not match the number of vertices, the vertices will not be displaced" << std::endl;
+		return false;
+	}
+
+	// Displace the vertices
+	std::size_t n = 0;
+	for (auto &vertex : m_vertices) {
+		vertex.translate(displacements[n]);
+		++n;
+	}
+
+	// Update the bounding box
+	if (!isBoundingBoxFrozen()) {
+		setBoundingBoxDirty(true);
+	}
+
+	return true;
+}
+
 /*!
 	Sets the tolerance for the geometrical checks.
 
@@ -3533,6 +4502,93 @@ void PatchKernel::displayTopologyStats(std::ostream &out, unsigned int padding)
         //out << indent<< "  # free vertices   " << countDoubleCells()   << endl;
 }
 
+/*!
+	Display the memory used by the patch, broken down by component.
+
+	If the patch is partitioned, the memory used by each component is
+	reduced among the processes and its minimum, maximum and average
+	values are displayed alongside the local value. In this case this is
+	a collective operation on the communicator of the patch.
+
+	\param[in,out] out output stream
+	\param[in] padding (default = 0) number of leading spaces for
+	formatted output
+*/
+void PatchKernel::displayMemoryStats(std::ostream &out, unsigned int padding) const
+{
+	std::string indent = std::string(padding, ' ');
+
+	// Flatten the breakdown
+	std::vector<std::string> names;
+	std::vector<double> localBytes;
+
+	std::function<void(const MemoryUsage &, std::size_t)> flatten = [&] (const MemoryUsage &usage, std::size_t depth)
+	{
+		names.push_back(std::string(2 * depth, ' ') + usage.getName());
+		localBytes.push_back(usage.getBytes());
+		for (const MemoryUsage &component : usage.getComponents()) {
+			flatten(component, depth + 1);
+		}
+	};
+
+	flatten(getMemoryUsage(), 0);
+
+	std::size_t nEntries = names.size();
+	std::size_t width = 0;
+	for (const std::string &name : names) {
+		width = std::max(width, name.size());
+	}
+	width += 2;
+
+	// Reduce the breakdown among the processes
+	//
+	// The breakdown has the same structure on all the processes.
+	bool reduced = false;
+	std::vector<double> minBytes;
+	std::vector<double> maxBytes;
+	std::vector<double> avgBytes;
+#if BITPIT_ENABLE_MPI==1
+	if (isCommunicatorSet() && getProcessorCount() > 1) {
+		const MPI_Comm &communicator = getCommunicator();
+
+		minBytes.resize(nEntries);
+		maxBytes.resize(nEntries);
+		avgBytes.resize(nEntries);
+		MPI_Allreduce(localBytes.data(), minBytes.data(), nEntries, MPI_DOUBLE, MPI_MIN, communicator);
+		MPI_Allreduce(localBytes.data(), maxBytes.data(), nEntries, MPI_DOUBLE, MPI_MAX, communicator);
+		MPI_Allreduce(localBytes.data(), avgBytes.data(), nEntries, MPI_DOUBLE, MPI_SUM, communicator);
+		for (double &bytes : avgBytes) {
+			bytes /= getProcessorCount();
+		}
+
+		reduced = true;
+	}
+#endif
+
+	// Display the breakdown
+	const int COLUMN_WIDTH = 14;
+
+	out << indent<< "Memory ----------------------------------" << endl;
+	if (reduced) {
+		out << indent << "  " << std::left << std::setw(width) << " " << std::right;
+		out << std::setw(COLUMN_WIDTH) << "local";
+		out << std::setw(COLUMN_WIDTH) << "min";
+		out << std::setw(COLUMN_WIDTH) << "max";
+		out << std::setw(COLUMN_WIDTH) << "avg" << endl;
+	}
+
+	for (std::size_t n = 0; n < nEntries; ++n) {
+		out << indent << "  " << std::left << std::setw(width) << names[n] << std::right;
+		out << std::setw(COLUMN_WIDTH) << MemoryUsage::formatBytes(localBytes[n]);
+		if (reduced) {
+			out << std::setw(COLUMN_WIDTH) << MemoryUsage::formatBytes(minBytes[n]);
+			out << std::setw(COLUMN_WIDTH) << MemoryUsage::formatBytes(maxBytes[n]);
+			out << std::setw(COLUMN_WIDTH) << MemoryUsage::formatBytes(avgBytes[n]);
+		}
+		out << endl;
+	}
+}
+
 /*!
 	Display all the vertices currently stored within the patch.
 
@@ -3591,6 +4647,89 @@ VTKUnstructuredGrid & PatchKernel::getVTK()
 	return m_vtk;
 }
 
+/*!
+	Evaluates the memory used by the patch, broken down by component.
+
+	Vertices, cells and interfaces account for the memory of their pierced
+	vectors and for the memory allocated by the elements (connectivity,
+	adjacencies and interfaces of the cells). Patches add the memory used
+	by their own data structures.
+
+	\result The memory used by the patch.
+*/
+MemoryUsage PatchKernel::getMemoryUsage() const
+{
+	MemoryUsage usage("patch");
+
+	// Vertices
+	usage.addComponent("vertices", m_vertices.getMemoryUsage());
+
+	// Cells
+	std::size_t cellConnectBytes   = 0;
+	std::size_t cellAdjacencyBytes = 0;
+	std::size_t cellInterfaceBytes = 0;
+	for (const Cell &cell : m_cells) {
+		if (cell.getConnect()) {
+			cellConnectBytes += cell.getVertexCount() * sizeof(long);
+		}
+
+		cellAdjacencyBytes += cell.getAdjacenciesMemorySize();
+		cellInterfaceBytes += cell.getInterfacesMemorySize();
+	}
+
+	MemoryUsage &cellUsage = usage.addComponent("cells", m_cells.getMemoryUsage());
+	cellUsage.addComponent("connectivity", cellConnectBytes);
+	cellUsage.addComponent("adjacencies", cellAdjacencyBytes);
+	cellUsage.addComponent("interfaces", cellInterfaceBytes);
+
+	// Interfaces
+	std::size_t interfaceConnectBytes = 0;
+	for (const Interface &interface : m_interfaces) {
+		if (interface.getConnect()) {
+			interfaceConnectBytes += interface.getVertexCount() * sizeof(long);
+		}
+	}
+
+	MemoryUsage &interfaceUsage = usage.addComponent("interfaces", m_interfaces.getMemoryUsage());
+	interfaceUsage.addComponent("connectivity", interfaceConnectBytes);
+
+#if BITPIT_ENABLE_MPI==1
+	// Ghosts
+	std::size_t targetBytes = utils::evalMemorySize(m_ghostExchangeTargets);
+	for (const auto &entry : m_ghostExchangeTargets) {
+		targetBytes += utils::evalMemorySize(entry.second);
+	}
+
+	std::size_t sourceBytes = utils::evalMemorySize(m_ghostExchangeSources);
+	for (const auto &entry : m_ghostExchangeSources) {
+		sourceBytes += utils::evalMemorySize(entry.second);
+	}
+
+	MemoryUsage &ghostUsage = usage.addComponent("ghosts");
+	ghostUsage.addComponent("owners", utils::evalMemorySize(m_ghostOwners));
+	ghostUsage.addComponent("exchange targets", targetBytes);
+	ghostUsage.addComponent("exchange sources", sourceBytes);
+#endif
+
+	// Data structures of the patch
+	_evalMemoryUsage(usage);
+
+	return usage;
+}
+
+/*!
+	Adds to the specified memory usage the memory used by the data
+	structures of the patch.
+
+	Default implementation doesn't add anything.
+
+	\param usage is the memory usage of the patch
+*/
+void PatchKernel::_evalMemoryUsage(MemoryUsage &usage) const
+{
+	BITPIT_UNUSED(usage);
+}
+
 /*!
  *  Interface for writing data to stream.
  *
@@ -25,7 +25,9 @@
 #ifndef __BITPIT_PATCH_KERNEL_HPP__
 #define __BITPIT_PATCH_KERNEL_HPP__
 
+#include <array>
 #include <cstddef>
+#include <cstdint>
 #include <deque>
 #include <memory>
 #if BITPIT_ENABLE_MPI==1
@@ -51,9 +53,13 @@ public:
 
 	long generateId();
 	long getLastId();
+	void setLastId(const long &id);
 	void trashId(const long &id);
 	void reset();
 
+	void dump(OBinaryStream &stream) const;
+	void restore(IBinaryStream &stream);
+
 private:
 	long m_id;
 	std::deque<long> m_trash;
@@ -85,6 +91,22 @@ public:
 	typedef PiercedVector<Cell>::iterator CellIterator;
 	typedef PiercedVector<Interface>::iterator InterfaceIterator;
 
+	enum RenumberingAlgorithm {
+		RENUMBERING_HILBERT = 0,
+		RENUMBERING_MORTON,
+		RENUMBERING_CUTHILL_MCKEE
+	};
+
+	enum PartitioningAlgorithm {
+		PARTITIONING_SFC = 0,
+		PARTITIONING_GRAPH
+	};
+
+	enum HaloConnectivity {
+		HALO_VERTEX = 0,
+		HALO_FACE
+	};
+
 	PatchKernel(const int &id, const int &dimension, bool epxert);
 
 	virtual ~PatchKernel();
@@ -124,8 +146,10 @@ public:
 	long countOrphanVertices() const;
 	std::vector<long> findOrphanVertices();
 	bool deleteOrphanVertices();
-	std::vector<long> collapseCoincidentVertices(int nBins = 128);
-	bool deleteCoincidentVertices(int nBins = 128);
+	std::vector<long> collapseCoincidentVertices();
+	BITPIT_DEPRECATED(std::vector<long> collapseCoincidentVertices(int nBins));
+	bool deleteCoincidentVertices();
+	BITPIT_DEPRECATED(bool deleteCoincidentVertices(int nBins));
 
 	VertexIterator getVertexIterator(const long &id);
 	VertexIterator vertexBegin();
@@ -209,6 +233,8 @@ public:
 	bool squeezeCells();
 	bool squeezeInterfaces();
 
+	const std::vector<adaption::Info> renumber(RenumberingAlgorithm algorithm = RENUMBERING_HILBERT, bool trackRenumbering = true);
+
 	long locatePoint(const double &x, const double &y, const double &z);
 	virtual long locatePoint(const std::array<double, 3> &point) = 0;
         bool isSameFace(const long &, const int&, const long&, const int&);
@@ -225,7 +251,7 @@ public:
 	void addPointToBoundingBox(const std::array<double, 3> &point);
 	void removePointFromBoundingBox(const std::array<double, 3> &point, bool delayedBoxUpdate = false);
 
-	std::unordered_map<long, long> binSortVertex(PiercedVector<Vertex> vertices, int nBins = 128);
+	std::unordered_map<long, long> binSortVertex(const PiercedVector<Vertex> &vertices, int nBins = 128);
     std::unordered_map<long, long> binSortVertex(int nBins = 128);
 
 	bool isAdaptionDirty(bool global = false) const;
@@ -236,6 +262,7 @@ public:
 	virtual void scale(std::array<double, 3> scaling);
 	void scale(double scaling);
 	void scale(double sx, double sy, double sz);
+	bool displaceVertices(const std::vector<std::array<double, 3>> &displacements);
 
 	void setTol(double tolerance);
 	double getTol() const;
@@ -245,16 +272,22 @@ public:
 	void extractEnvelope(PatchKernel &envelope) const;
 
 	void displayTopologyStats(std::ostream &out, unsigned int padding = 0) const;
+	void displayMemoryStats(std::ostream &out, unsigned int padding = 0) const;
 	void displayVertices(std::ostream &out, unsigned int padding = 0) const;
 	void displayCells(std::ostream &out, unsigned int padding = 0) const;
 	void displayInterfaces(std::ostream &out, unsigned int padding = 0) const;
 
+	MemoryUsage getMemoryUsage() const;
+
 	VTKUnstructuredGrid & getVTK();
 	void write();
 	void write(std::string name);
 
 	void flushData(std::fstream &stream, std::string name, VTKFormat format );
 
+	void dump(const std::string &filename) const;
+	void restore(const std::string &filename);
+
 #if BITPIT_ENABLE_MPI==1
 	virtual void setCommunicator(MPI_Comm communicator);
 	void freeCommunicator();
@@ -275,11 +308,18 @@ public:
 	std::vector<long> & getGhostExchangeSources(int rank);
 	const std::vector<long> & getGhostExchangeSources(int rank) const;
 
+	unsigned long getGhostExchangeRevision() const;
+
+	std::size_t getHaloSize() const;
+	HaloConnectivity getHaloConnectivity() const;
+	void setHaloSize(std::size_t haloSize, HaloConnectivity connectivity = HALO_VERTEX);
+
 	const std::vector<adaption::Info> partition(MPI_Comm communicator, const std::vector<int> &cellRanks, bool trackChanges);
 	const std::vector<adaption::Info> partition(const std::vector<int> &cellRanks, bool trackChanges);
 	const std::vector<adaption::Info> partition(MPI_Comm communicator, bool trackChanges);
 	const std::vector<adaption::Info> partition(bool trackChanges);
 	const std::vector<adaption::Info> balancePartition(bool trackChanges);
+	const std::vector<adaption::Info> balancePartition(const std::vector<double> &cellWeights, PartitioningAlgorithm algorithm, bool trackChanges);
 
 	adaption::Info sendCells(const int &sendRank, const int &recvRank, const std::vector<long> &cellsToSend);
 #endif
@@ -405,11 +445,17 @@ protected:
 	virtual std::vector<long> _findCellEdgeNeighs(const long &id, const int &edge, const std::vector<long> &blackList = std::vector<long>()) const;
 	virtual std::vector<long> _findCellVertexNeighs(const long &id, const int &vertex, const std::vector<long> &blackList = std::vector<long>()) const;
 
+	virtual void _evalMemoryUsage(MemoryUsage &usage) const;
+
 	void setAdaptionDirty(bool dirty);
 	void setExpert(bool expert);
 
+	static const int SFC_BITS;
+	static uint64_t evalSpaceFillingKey(std::array<uint32_t, 3> coords, bool hilbert);
+
 #if BITPIT_ENABLE_MPI==1
 	virtual const std::vector<adaption::Info> _balancePartition(bool trackChanges);
+	virtual bool _setHaloSize(std::size_t haloSize, HaloConnectivity connectivity);
 
 	void setGhostOwner(int id, int rank, bool updateExchangeData = false);
 	void unsetGhostOwner(int id, bool updateExchangeData = false);
@@ -458,11 +504,24 @@ private:
 	std::unordered_map<int, std::vector<long>> m_ghostExchangeTargets;
 	std::unordered_map<int, std::vector<long>> m_ghostExchangeSources;
 
+	unsigned long m_ghostExchangeRevision;
+	unsigned long m_cellExchangeCount;
+
+	std::size_t m_haloSize;
+	HaloConnectivity m_haloConnectivity;
+
 	void addExchangeSources(const std::vector<long> &ghostIds);
 
-    adaption::Info sendCells_sender(const int &recvRank, const std::vector<long> &cellsToSend);
-    adaption::Info sendCells_receiver(const int &sendRank);
-    adaption::Info sendCells_notified(const int &sendRank, const int &recvRank);
+	std::vector<long> findCellHaloNeighs(const long &id) const;
+	std::vector<long> findHaloCells(const std::vector<long> &seedIds, std::size_t haloSize) const;
+
+	void growHalo();
+	void pruneHalo();
+
+	std::vector<long> exchangeCells(const std::unordered_map<int, std::vector<std::pair<long, int>>> &sendLists, std::unordered_map<int, std::vector<long>> *recvInternals);
+	std::vector<adaption::Info> migrateCells(const std::unordered_map<long, int> &sendRanks, bool trackChanges);
+
+	std::vector<int> evalBalancedCellRanks(const std::vector<double> &cellWeights, PartitioningAlgorithm algorithm);
 #endif
 
 	VertexIterator createVertex(const std::array<double, 3> &coords, long id = Vertex::NULL_ID);
@@ -475,6 +534,9 @@ private:
 	void setDimension(int dimension);
 
 	std::array<double, 3> evalElementCentroid(const Element &element);
+
+	void dumpData(OBinaryStream &stream) const;
+	void restoreData(IBinaryStream &stream);
 };
 
 }
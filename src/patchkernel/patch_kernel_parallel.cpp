@@ -28,11 +28,17 @@
 // ========================================================================== //
 #include <mpi.h>
 #include <chrono>
+#include <deque>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <set>
 #include <unordered_set>
 
 #include "bitpit_SA.hpp"
 
 #include "patch_kernel.hpp"
+#include "ghost_exchanger.hpp"
 
 // ========================================================================== //
 // NAMESPACES                                                                 //
@@ -186,66 +192,20 @@ const std::vector<adaption::Info> PatchKernel::partition(const std::vector<int>
 	}
 
 	// Build the send map
-	std::unordered_map<int, std::vector<long>> sendMap;
+	std::unordered_map<long, int> sendRanks;
 
 	auto cellItr = cellBegin();
 	for (int k = 0; k < getInternalCount(); ++k) {
 		const int &rank = cellRanks[k];
-		if (rank == getRank()) {
-			cellItr++;
-			continue;
+		if (rank != getRank()) {
+			sendRanks.insert({{cellItr->getId(), rank}});
 		}
 
-		sendMap[rank].push_back(cellItr->getId());
-
 		cellItr++;
 	}
 
-	// Local sender-receiver pairs
-	std::vector<int> localPairs;
-	localPairs.reserve(2 * sendMap.size());
-	for (const auto &entry : sendMap) {
-		localPairs.push_back(getRank());
-		localPairs.push_back(entry.first);
-	}
-
-	// Exchange the size of the communication
-	int globalPairsSize = localPairs.size();
-	std::vector<int> globalPairsSizes(getProcessorCount());
-	MPI_Allgather(&globalPairsSize, 1, MPI_INT, globalPairsSizes.data(), 1, MPI_INT, getCommunicator());
-
-	std::vector<int> globalPairsOffsets(getProcessorCount());
-	globalPairsOffsets[0] = 0;
-	for (int i = 1; i < getProcessorCount(); ++i) {
-		globalPairsOffsets[i] = globalPairsOffsets[i-1] + globalPairsSizes[i-1];
-	}
-
-	// Global sender-receiver pairs
-	std::vector<int> globalPairs;
-	globalPairs.resize(globalPairsOffsets.back() + globalPairsSizes.back());
-
-	MPI_Allgatherv(localPairs.data(), localPairs.size(), MPI_INT, globalPairs.data(),
-				   globalPairsSizes.data(), globalPairsOffsets.data(), MPI_INT,
-                   getCommunicator());
-
-	// Exchange the cells
-	std::vector<long> emptyCellList;
-	for (size_t i = 0; i < globalPairs.size(); i += 2) {
-		int srcRank = globalPairs[i];
-		int dstRank = globalPairs[i+1];
-
-		std::vector<long> *cellList;
-		if (srcRank == getRank()) {
-			cellList = &(sendMap[dstRank]);
-		} else {
-			cellList = &emptyCellList;
-		}
-
-		adaption::Info adaptionInfo = sendCells(srcRank, dstRank, *cellList);
-		if (trackChanges && adaptionInfo.type != adaption::TYPE_NONE) {
-			adaptionData.push_back(std::move(adaptionInfo));
-		}
-	}
+	// Migrate the cells
+	adaptionData = migrateCells(sendRanks, trackChanges);
 
 	return adaptionData;
 }
@@ -305,20 +265,426 @@ const std::vector<adaption::Info> PatchKernel::balancePartition(bool trackChange
 	return adaptionData;
 }
 
+/*!
+	Tries to balance the computational load among the processors redistributing
+	the cells among the processors.
+
+	Each internal cell is given a weight that measures its computational
+	load. Cells are assigned to the processors so that the sum of the
+	weights is as uniform as possible. Among the partitions with the same
+	quality, the one that requires the smallest number of cells to be
+	moved from the current partition is chosen.
+
+	Only patches that allow custom partitions can be balanced with this
+	function, other patches are balanced with their own algorithm and the
+	weights are ignored.
+
+	\param cellWeights are the weights of the internal cells, listed in the
+	same order used for iterating over the internal cells. If the list is
+	empty, all the cells will have the same weight
+	\param algorithm is the algorithm that will be used for the balancing
+	\param trackChanges if set to true, the changes to the patch will be
+	tracked
+	\result Returns a vector of adaption::Info that can be used to track
+	the changes done during the partitioning.
+*/
+const std::vector<adaption::Info> PatchKernel::balancePartition(const std::vector<double> &cellWeights, PartitioningAlgorithm algorithm, bool trackChanges)
+{
+	// Communicator has to be set
+	if (!isCommunicatorSet()) {
+		throw std::runtime_error ("There is no communicator set for the patch.");
+	}
+
+	// Check if the patch allow custom partition
+	if (!isExpert()) {
+		log::cout() << "The patch does not allow custom partition, cell weights will be ignored" << std::endl;
+
+		return balancePartition(trackChanges);
+	}
+
+	// Balance patch
+	std::vector<int> cellRanks = evalBalancedCellRanks(cellWeights, algorithm);
+	const std::vector<adaption::Info> adaptionData = partition(cellRanks, trackChanges);
+
+	// Update the bouding box
+	updateBoundingBox();
+
+	// Done
+	return adaptionData;
+}
+
 /*!
 	Internal function that tries to balance the computational load among the
 	processors moving redistributing the cells among the processors.
 
+	The default implementation is available only for patches that allow
+	custom partitions: cells are given the same weight and are distributed
+	along a space filling curve.
+
 	\result Returns a vector of adaption::Info that can be used to track
 	the changes done during the update.
 */
 const std::vector<adaption::Info> PatchKernel::_balancePartition(bool trackChanges)
 {
-	BITPIT_UNUSED(trackChanges);
+	if (!isExpert()) {
+		log::cout() << "The patch does not implement a algortihm for balacing the partition" << std::endl;
 
-	log::cout() << "The patch does not implement a algortihm for balacing the partition" << std::endl;
+		return std::vector<adaption::Info>();
+	}
+
+	std::vector<int> cellRanks = evalBalancedCellRanks(std::vector<double>(), PARTITIONING_SFC);
 
-	return std::vector<adaption::Info>();
+	return partition(cellRanks, trackChanges);
+}
+
+/*!
+	Evaluates the ranks the internal cells should be assigned to for
+	balancing the computational load among the processors.
+
+	The cells are first split among the processors along the Hilbert curve
+	that passes through the centroids of the cells: the curve is divided in
+	as many pieces as the processors, each piece containing the same weight.
+	The splitters are evaluated with a parallel bisection on the keys of the
+	curve, hence the cells don't need to be sorted globally.
+
+	If the graph algorithm is requested, the pieces of the curve are then
+	refined on the dual graph of the patch (two cells are connected if they
+	share a face): cells on the border of a piece are moved to the piece that
+	contains most of their face neighbours, as long as the load of the pieces
+	stays within the allowed imbalance. This reduces the number of faces
+	shared by different processors, i.e. the size of the communications. No
+	external graph partitioner is required.
+
+	Finally, pieces are assigned to the processors that already own most of
+	their weight, this limits the number of cells that need to be moved.
+
+	\param cellWeights are the weights of the internal cells, listed in the
+	same order used for iterating over the internal cells. If the list is
+	empty, all the cells will have the same weight
+	\param algorithm is the algorithm that will be used for the balancing
+	\result The ranks the internal cells should be assigned to, listed in the
+	same order used for iterating over the internal cells.
+*/
+std::vector<int> PatchKernel::evalBalancedCellRanks(const std::vector<double> &cellWeights, PartitioningAlgorithm algorithm)
+{
+	const double MAX_IMBALANCE = 0.05;
+	const int MAX_REFINEMENT_PASSES = 16;
+
+	long nInternals = getInternalCount();
+	if (!cellWeights.empty() && (long) cellWeights.size() != nInternals) {
+		throw std::runtime_error ("The number of weights doesn't match the number of internal cells.");
+	}
+
+	// Internal cells
+	std::vector<long> internalIds;
+	internalIds.reserve(nInternals);
+	auto cellItr = cellBegin();
+	for (long k = 0; k < nInternals; ++k) {
+		internalIds.push_back(cellItr->getId());
+		cellItr++;
+	}
+
+	std::vector<double> weights(cellWeights);
+	if (weights.empty()) {
+		weights.assign(nInternals, 1.);
+	}
+
+	double totalWeight = 0.;
+	for (double weight : weights) {
+		totalWeight += weight;
+	}
+	MPI_Allreduce(MPI_IN_PLACE, &totalWeight, 1, MPI_DOUBLE, MPI_SUM, m_communicator);
+
+	//
+	// Split the cells along the Hilbert curve
+	//
+
+	// Global bounding box of the centroids
+	std::vector<std::array<double, 3>> centroids(nInternals);
+	std::array<double, 3> minPoint;
+	std::array<double, 3> maxPoint;
+	minPoint.fill(std::numeric_limits<double>::max());
+	maxPoint.fill(-std::numeric_limits<double>::max());
+	for (long k = 0; k < nInternals; ++k) {
+		centroids[k] = evalCellCentroid(internalIds[k]);
+		for (int d = 0; d < 3; ++d) {
+			minPoint[d] = std::min(centroids[k][d], minPoint[d]);
+			maxPoint[d] = std::max(centroids[k][d], maxPoint[d]);
+		}
+	}
+
+	MPI_Allreduce(MPI_IN_PLACE, minPoint.data(), 3, MPI_DOUBLE, MPI_MIN, m_communicator);
+	MPI_Allreduce(MPI_IN_PLACE, maxPoint.data(), 3, MPI_DOUBLE, MPI_MAX, m_communicator);
+
+	double extent = 0.;
+	for (int d = 0; d < 3; ++d) {
+		extent = std::max(maxPoint[d] - minPoint[d], extent);
+	}
+
+	double scale = 0.;
+	if (extent > 0.) {
+		scale = ((1u << SFC_BITS) - 1) / extent;
+	}
+
+	// Sorted keys of the local cells
+	std::vector<uint64_t> keys(nInternals);
+	for (long k = 0; k < nInternals; ++k) {
+		std::array<uint32_t, 3> coords;
+		for (int d = 0; d < 3; ++d) {
+			coords[d] = static_cast<uint32_t>((centroids[k][d] - minPoint[d]) * scale);
+		}
+		keys[k] = evalSpaceFillingKey(coords, true);
+	}
+
+	std::vector<std::array<double, 3>>().swap(centroids);
+
+	std::vector<long> keyOrder(nInternals);
+	std::iota(keyOrder.begin(), keyOrder.end(), 0);
+	std::sort(keyOrder.begin(), keyOrder.end(), [&keys] (long k_1, long k_2) {
+		return keys[k_1] < keys[k_2];
+	});
+
+	std::vector<uint64_t> sortedKeys(nInternals);
+	std::vector<double> sortedWeightSums(nInternals + 1, 0.);
+	for (long n = 0; n < nInternals; ++n) {
+		sortedKeys[n] = keys[keyOrder[n]];
+		sortedWeightSums[n + 1] = sortedWeightSums[n] + weights[keyOrder[n]];
+	}
+
+	// Splitters
+	//
+	// The splitter of the i-th piece is the smallest key such that the
+	// weight of the cells with a smaller key is at least (i + 1) / nProcs
+	// of the total weight. All the splitters are found together with a
+	// bisection on the keys, the weights are summed among the processors
+	// at every step.
+	int nSplitters = m_nProcessors - 1;
+	std::vector<uint64_t> splitterBegin(nSplitters, 0);
+	std::vector<uint64_t> splitterEnd(nSplitters, uint64_t(1) << (3 * SFC_BITS));
+	std::vector<uint64_t> splitters(nSplitters);
+	std::vector<double> splitterWeights(nSplitters);
+	while (true) {
+		bool converged = true;
+		for (int i = 0; i < nSplitters; ++i) {
+			splitters[i] = splitterBegin[i] + (splitterEnd[i] - splitterBegin[i]) / 2;
+			converged &= (splitterBegin[i] == splitterEnd[i]);
+
+			long nBelow = std::lower_bound(sortedKeys.begin(), sortedKeys.end(), splitters[i]) - sortedKeys.begin();
+			splitterWeights[i] = sortedWeightSums[nBelow];
+		}
+
+		if (converged) {
+			break;
+		}
+
+		MPI_Allreduce(MPI_IN_PLACE, splitterWeights.data(), nSplitters, MPI_DOUBLE, MPI_SUM, m_communicator);
+
+		for (int i = 0; i < nSplitters; ++i) {
+			double targetWeight = (i + 1) * totalWeight / m_nProcessors;
+			if (splitterWeights[i] >= targetWeight) {
+				splitterEnd[i] = splitters[i];
+			} else {
+				splitterBegin[i] = splitters[i] + 1;
+			}
+		}
+	}
+
+	std::vector<int> cellParts(nInternals);
+	for (long k = 0; k < nInternals; ++k) {
+		cellParts[k] = std::upper_bound(splitters.begin(), splitters.end(), keys[k]) - splitters.begin();
+	}
+
+	//
+	// Refine the pieces on the dual graph
+	//
+	if (algorithm == PARTITIONING_GRAPH) {
+		// Storage positions of the face neighbours
+		std::size_t nRawCells = std::distance(m_cells.rawBegin(), m_cells.rawEnd());
+
+		std::vector<std::size_t> internalPositions(nInternals);
+		std::vector<std::size_t> neighOffsets(nInternals + 1, 0);
+		std::vector<std::size_t> neighPositions;
+		for (long k = 0; k < nInternals; ++k) {
+			const Cell &cell = m_cells[internalIds[k]];
+			internalPositions[k] = m_cells.rawIndex(internalIds[k]);
+
+			int nCellFaces = cell.getFaceCount();
+			for (int face = 0; face < nCellFaces; ++face) {
+				int nFaceAdjacencies = cell.getAdjacencyCount(face);
+				for (int i = 0; i < nFaceAdjacencies; ++i) {
+					long neighId = cell.getAdjacency(face, i);
+					if (neighId >= 0) {
+						neighPositions.push_back(m_cells.rawIndex(neighId));
+					}
+				}
+			}
+			neighOffsets[k + 1] = neighPositions.size();
+		}
+
+		// Pieces of all the cells, including the ghosts
+		std::vector<int> rawParts(nRawCells, -1);
+		for (long k = 0; k < nInternals; ++k) {
+			rawParts[internalPositions[k]] = cellParts[k];
+		}
+
+		GhostExchanger partExchanger(*this);
+
+		// Refinement passes
+		//
+		// To prevent two neighbouring cells owned by different processors
+		// from swapping their pieces at the same time, during even passes
+		// cells can be moved only to pieces with an higher index, during
+		// odd passes only to pieces with a lower index. The load that each
+		// processor can move in (or out of) a piece is limited to its share
+		// of the load that can be moved in (or out of) that piece.
+		double maxLoad = (1. + MAX_IMBALANCE) * totalWeight / m_nProcessors;
+		double minLoad = (1. - MAX_IMBALANCE) * totalWeight / m_nProcessors;
+
+		std::vector<double> loads(m_nProcessors);
+		std::vector<double> inBudgets(m_nProcessors);
+		std::vector<double> outBudgets(m_nProcessors);
+		std::vector<std::pair<int, int>> neighParts;
+		int nIdlePasses = 0;
+		for (int pass = 0; pass < MAX_REFINEMENT_PASSES; ++pass) {
+			std::fill(loads.begin(), loads.end(), 0.);
+			for (long k = 0; k < nInternals; ++k) {
+				loads[cellParts[k]] += weights[k];
+			}
+			MPI_Allreduce(MPI_IN_PLACE, loads.data(), m_nProcessors, MPI_DOUBLE, MPI_SUM, m_communicator);
+
+			for (int part = 0; part < m_nProcessors; ++part) {
+				inBudgets[part]  = std::max(maxLoad - loads[part], 0.) / m_nProcessors;
+				outBudgets[part] = std::max(loads[part] - minLoad, 0.) / m_nProcessors;
+			}
+
+			partExchanger.exchange(rawParts.data());
+
+			long nMoved = 0;
+			bool upwards = (pass % 2 == 0);
+			for (long k = 0; k < nInternals; ++k) {
+				int part = cellParts[k];
+
+				// Count the neighbours in each piece
+				neighParts.clear();
+				for (std::size_t n = neighOffsets[k]; n < neighOffsets[k + 1]; ++n) {
+					int neighPart = rawParts[neighPositions[n]];
+
+					auto neighPartItr = neighParts.begin();
+					while (neighPartItr != neighParts.end() && neighPartItr->first != neighPart) {
+						++neighPartItr;
+					}
+
+					if (neighPartItr == neighParts.end()) {
+						neighParts.emplace_back(neighPart, 1);
+					} else {
+						++(neighPartItr->second);
+					}
+				}
+
+				// Find the best piece
+				int nPartNeighs = 0;
+				int bestPart    = part;
+				int nBestNeighs = 0;
+				for (const std::pair<int, int> &entry : neighParts) {
+					if (entry.first == part) {
+						nPartNeighs = entry.second;
+						continue;
+					} else if ((entry.first > part) != upwards) {
+						continue;
+					}
+
+					if (entry.second > nBestNeighs || (entry.second == nBestNeighs && entry.first < bestPart)) {
+						bestPart    = entry.first;
+						nBestNeighs = entry.second;
+					}
+				}
+
+				if (bestPart == part || nBestNeighs <= nPartNeighs) {
+					continue;
+				} else if (weights[k] > inBudgets[bestPart] || weights[k] > outBudgets[part]) {
+					continue;
+				}
+
+				// Move the cell
+				inBudgets[bestPart] -= weights[k];
+				outBudgets[part]    -= weights[k];
+
+				cellParts[k] = bestPart;
+				rawParts[internalPositions[k]] = bestPart;
+				++nMoved;
+			}
+
+			// Stop when no cells are moved in both directions
+			MPI_Allreduce(MPI_IN_PLACE, &nMoved, 1, MPI_LONG, MPI_SUM, m_communicator);
+			if (nMoved > 0) {
+				nIdlePasses = 0;
+			} else if (++nIdlePasses == 2) {
+				break;
+			}
+		}
+	}
+
+	//
+	// Assign the pieces to the processors
+	//
+	// Pieces are assigned greedily: the pairs (piece, processor) are sorted
+	// by the weight of the piece already on the processor and each piece is
+	// assigned to the first free processor.
+	std::vector<double> localPartWeights(m_nProcessors, 0.);
+	for (long k = 0; k < nInternals; ++k) {
+		localPartWeights[cellParts[k]] += weights[k];
+	}
+
+	std::vector<double> partWeights(m_nProcessors * m_nProcessors);
+	MPI_Allgather(localPartWeights.data(), m_nProcessors, MPI_DOUBLE, partWeights.data(), m_nProcessors, MPI_DOUBLE, m_communicator);
+
+	std::vector<std::pair<int, int>> assignments;
+	for (int rank = 0; rank < m_nProcessors; ++rank) {
+		for (int part = 0; part < m_nProcessors; ++part) {
+			if (partWeights[rank * m_nProcessors + part] > 0.) {
+				assignments.emplace_back(part, rank);
+			}
+		}
+	}
+
+	std::stable_sort(assignments.begin(), assignments.end(), [this, &partWeights] (const std::pair<int, int> &assignment_1, const std::pair<int, int> &assignment_2) {
+		return partWeights[assignment_1.second * m_nProcessors + assignment_1.first] > partWeights[assignment_2.second * m_nProcessors + assignment_2.first];
+	});
+
+	std::vector<int> partRanks(m_nProcessors, -1);
+	std::vector<bool> assignedRanks(m_nProcessors, false);
+	for (const std::pair<int, int> &assignment : assignments) {
+		int part = assignment.first;
+		int rank = assignment.second;
+		if (partRanks[part] >= 0 || assignedRanks[rank]) {
+			continue;
+		}
+
+		partRanks[part]     = rank;
+		assignedRanks[rank] = true;
+	}
+
+	int nextRank = 0;
+	for (int part = 0; part < m_nProcessors; ++part) {
+		if (partRanks[part] >= 0) {
+			continue;
+		}
+
+		while (assignedRanks[nextRank]) {
+			++nextRank;
+		}
+
+		partRanks[part]         = nextRank;
+		assignedRanks[nextRank] = true;
+	}
+
+	// Ranks of the cells
+	std::vector<int> cellRanks(nInternals);
+	for (long k = 0; k < nInternals; ++k) {
+		cellRanks[k] = partRanks[cellParts[k]];
+	}
+
+	return cellRanks;
 }
 
 /*!
@@ -442,6 +808,153 @@ const std::vector<long> & PatchKernel::getGhostExchangeSources(int rank) const
 	return m_ghostExchangeSources.at(rank);
 }
 
+/*!
+	Gets the revision of the ghost information needed for data exchange.
+
+	The revision is increased every time the exchange lists or the
+	positions of the cells in the storage may have changed, hence, objects
+	that cache information derived from the exchange lists can check the
+	revision to know when they need to be rebuilt. Changes made directly
+	to the lists returned by getGhostExchangeTargets/Sources are not
+	tracked.
+
+	\result The revision of the ghost information needed for data exchange.
+*/
+unsigned long PatchKernel::getGhostExchangeRevision() const
+{
+	return m_ghostExchangeRevision;
+}
+
+/*!
+	Gets the size of the halo, i.e., the number of layers of ghost cells
+	that surround the internal cells of the processor.
+
+	\result The number of layers of ghost cells.
+*/
+std::size_t PatchKernel::getHaloSize() const
+{
+	return m_haloSize;
+}
+
+/*!
+	Gets the connectivity used to define the layers of the halo.
+
+	\result The connectivity used to define the layers of the halo.
+*/
+PatchKernel::HaloConnectivity PatchKernel::getHaloConnectivity() const
+{
+	return m_haloConnectivity;
+}
+
+/*!
+	Sets the size of the halo, i.e., the number of layers of ghost cells
+	that surround the internal cells of the processor.
+
+	A cell belongs to the n-th layer of the halo if it can be reached from
+	an internal cell crossing n cells, where two cells are considered
+	connected if they share a vertex (HALO_VERTEX) or a face (HALO_FACE).
+	The exchange sources of a processor contain all the internal cells
+	that are in the halo of its neighbours, hence a single exchange
+	updates all the layers. By default the halo is made by a single layer
+	of vertex neighbours.
+
+	Only patches in expert mode build their own ghosts, the halo of the
+	other patches is defined by the patch itself and can be changed only
+	if the patch supports it (for example, VolOctree supports halos of any
+	size made by vertex neighbours).
+	If the patch is already partitioned, ghosts and exchange information
+	are updated: in this case the function is collective and has to be
+	called by all the processors.
+
+	\param haloSize is the number of layers of ghost cells
+	\param connectivity is the connectivity used to define the layers
+*/
+void PatchKernel::setHaloSize(std::size_t haloSize, HaloConnectivity connectivity)
+{
+	if (haloSize == m_haloSize && connectivity == m_haloConnectivity) {
+		return;
+	}
+
+	if (haloSize < 1) {
+		throw std::runtime_error ("The halo should contain at least one layer of ghosts.");
+	}
+
+	if (!isExpert()) {
+		std::size_t previousHaloSize = m_haloSize;
+		HaloConnectivity previousHaloConnectivity = m_haloConnectivity;
+
+		m_haloSize = haloSize;
+		m_haloConnectivity = connectivity;
+		if (!_setHaloSize(haloSize, connectivity)) {
+			m_haloSize = previousHaloSize;
+			m_haloConnectivity = previousHaloConnectivity;
+
+			throw std::runtime_error ("The halo of this patch cannot be changed.");
+		}
+
+		return;
+	}
+
+	if (!isCommunicatorSet()) {
+		m_haloSize = haloSize;
+		m_haloConnectivity = connectivity;
+		return;
+	}
+
+	// Change the connectivity
+	//
+	// The first layer of face neighbours is contained in every halo, hence
+	// the current halo is reduced to that layer. The vertex halo is then
+	// obtained growing that layer with the vertex neighbours of its cells
+	// and removing the cells that are not vertex neighbours of the internal
+	// cells.
+	if (connectivity != m_haloConnectivity) {
+		m_haloSize = 1;
+		m_haloConnectivity = HALO_FACE;
+		pruneHalo();
+
+		if (connectivity != HALO_FACE) {
+			m_haloConnectivity = connectivity;
+			growHalo();
+			pruneHalo();
+		}
+	}
+
+	// Change the number of layers
+	while (m_haloSize < haloSize) {
+		growHalo();
+		++m_haloSize;
+		buildGhostExchangeData();
+	}
+
+	if (m_haloSize > haloSize) {
+		m_haloSize = haloSize;
+		pruneHalo();
+	}
+}
+
+/*!
+	Internal function to set the size of the halo of patches that are not
+	in expert mode.
+
+	The size and the connectivity of the halo are already updated when the
+	function is called, the patch should rebuild its ghosts and the exchange
+	information accordingly. The default implementation doesn't support
+	changing the halo.
+
+	\param haloSize is the number of layers of ghost cells
+	\param connectivity is the connectivity used to define the layers
+	\result Returns true if the halo has been changed, false if the patch
+	doesn't support the requested halo.
+*/
+bool PatchKernel::_setHaloSize(std::size_t haloSize, HaloConnectivity connectivity)
+{
+	BITPIT_UNUSED(haloSize);
+	BITPIT_UNUSED(connectivity);
+
+	return false;
+}
+
 /*!
 	Sets the owner of the specified ghost.
 
@@ -511,6 +1024,8 @@ void PatchKernel::deleteGhostExchangeData()
 {
 	m_ghostExchangeTargets.clear();
 	m_ghostExchangeSources.clear();
+
+	++m_ghostExchangeRevision;
 }
 
 /*!
@@ -526,6 +1041,8 @@ void PatchKernel::deleteGhostExchangeData(int rank)
 
 	m_ghostExchangeTargets.erase(rank);
 	m_ghostExchangeSources.erase(rank);
+
+	++m_ghostExchangeRevision;
 }
 
 /*!
@@ -612,6 +1129,8 @@ void PatchKernel::addGhostsToExchangeTargets(const std::vector<long> &ghostIds)
 
 	// Add the sources
 	addExchangeSources(ghostIds);
+
+	++m_ghostExchangeRevision;
 }
 
 /*!
@@ -640,10 +1159,12 @@ void PatchKernel::removeGhostsFromExchangeTargets(const std::vector<long> &ghost
 
 		// Remove targets
 		std::vector<long> &ghostTargets = m_ghostExchangeTargets[rank];
-		auto iterator = std::lower_bound(ghostTargets.begin(), ghostTargets.end(), rank, CellPositionLess(*this));
+		auto iterator = std::lower_bound(ghostTargets.begin(), ghostTargets.end(), ghostId, CellPositionLess(*this));
 		ghostTargets.erase(iterator);
 	}
 
+	++m_ghostExchangeRevision;
+
 	// Rebuild information of the sources
 	for (const int rank : ranks) {
 		m_ghostExchangeSources[rank].clear();
@@ -666,38 +1187,190 @@ void PatchKernel::removeGhostFromExchangeTargets(const long ghostId)
 	that owns the specified ghost cells and add those cells to the sources
 	for that processor.
 
+	The sources for a processor are the internal cells that are within the
+	halo of the cells owned by that processor, i.e., the internal cells that
+	are ghosts on that processor. All the cells on that path are within the
+	halo of this processor, hence the sources can be found looking at the
+	cells within the halo of the ghosts owned by the processor.
+
 	\param ghostIds are the ids of the ghosts
 */
 void PatchKernel::addExchangeSources(const std::vector<long> &ghostIds)
 {
-	// Get the sources
-	std::unordered_map<int, std::unordered_set<long>> ghostSources;
+	// Group the ghosts by owner
+	std::unordered_map<int, std::vector<long>> rankGhosts;
 	for (long ghostId : ghostIds) {
-		// Owner of the ghost
 		int rank = m_ghostOwners[ghostId];
+		rankGhosts[rank].push_back(ghostId);
+	}
 
-		// The internal neighbourss will be sources for the rank
-		for (long neighId : findCellNeighs(ghostId)) {
-			if (m_ghostOwners.count(neighId) > 0) {
+	// Add the sources
+	for (const auto &entry : rankGhosts) {
+		int rank = entry.first;
+
+		std::vector<long> &rankSources = m_ghostExchangeSources[rank];
+		std::unordered_set<long> updatedSources(rankSources.begin(), rankSources.end());
+		for (long cellId : findHaloCells(entry.second, m_haloSize)) {
+			if (m_ghostOwners.count(cellId) > 0) {
 				continue;
 			}
 
-			ghostSources[rank].insert(neighId);
+			updatedSources.insert(cellId);
 		}
+
+		rankSources = std::vector<long>(updatedSources.begin(), updatedSources.end());
+		std::sort(rankSources.begin(), rankSources.end(), CellPositionLess(*this));
 	}
+}
 
-	// Add the sources
-	for (auto entry : ghostSources) {
+/*!
+	Finds the neighbours of the specified cell according to the connectivity
+	used to define the layers of the halo.
+
+	\param id is the id of the cell
+	\result The neighbours of the specified cell.
+*/
+std::vector<long> PatchKernel::findCellHaloNeighs(const long &id) const
+{
+	if (m_haloConnectivity == HALO_FACE) {
+		return findCellFaceNeighs(id);
+	} else {
+		return findCellNeighs(id);
+	}
+}
+
+/*!
+	Finds the cells within the specified number of layers of neighbours
+	around the given seed cells.
+
+	Layers are defined using the connectivity of the halo and are visited
+	in order, hence the cells of the first layer are listed before the
+	cells of the second layer and so on. Seeds are not included in the
+	result.
+
+	\param seedIds are the ids of the seed cells
+	\param haloSize is the number of layers
+	\result The cells within the specified number of layers around the
+	seed cells.
+*/
+std::vector<long> PatchKernel::findHaloCells(const std::vector<long> &seedIds, std::size_t haloSize) const
+{
+	std::unordered_set<long> visitedCells(seedIds.begin(), seedIds.end());
+
+	std::vector<long> haloCells;
+	std::vector<long> layerCells = seedIds;
+	std::vector<long> nextLayerCells;
+	for (std::size_t layer = 0; layer < haloSize; ++layer) {
+		nextLayerCells.clear();
+		for (long cellId : layerCells) {
+			for (long neighId : findCellHaloNeighs(cellId)) {
+				if (visitedCells.insert(neighId).second) {
+					nextLayerCells.push_back(neighId);
+				}
+			}
+		}
+
+		if (nextLayerCells.empty()) {
+			break;
+		}
+
+		haloCells.insert(haloCells.end(), nextLayerCells.begin(), nextLayerCells.end());
+		layerCells.swap(nextLayerCells);
+	}
+
+	return haloCells;
+}
+
+/*!
+	Adds a layer of ghost cells to the halo.
+
+	Every processor sends to its neighbours the cells adjacent to the
+	sources of that neighbours. The sources are the internal cells that
+	are ghosts on the neighbour, hence the neighbour receives the cells
+	adjacent to its ghosts. If the ghosts of the neighbour are all the
+	cells within n layers of its internal cells, after the exchange the
+	neighbour will have all the cells within n + 1 layers.
+
+	This is a collective operation, it has to be called by all the
+	processors. Exchange information is not updated.
+*/
+void PatchKernel::growHalo()
+{
+	std::unordered_map<int, std::vector<std::pair<long, int>>> sendLists;
+	for (const auto &entry : m_ghostExchangeSources) {
 		int rank = entry.first;
-		std::unordered_set<long> &updatedSources = entry.second;
+		const std::vector<long> &rankSources = entry.second;
+
+		// Cells owned by the neighbour are already there
+		std::vector<std::pair<long, int>> &rankCells = sendLists[rank];
+		std::unordered_set<long> rankCellSet;
+		for (long sourceId : rankSources) {
+			for (long neighId : findCellHaloNeighs(sourceId)) {
+				int neighRank = m_rank;
+				auto ghostOwnerItr = m_ghostOwners.find(neighId);
+				if (ghostOwnerItr != m_ghostOwners.end()) {
+					neighRank = ghostOwnerItr->second;
+				}
 
-		std::vector<long> &rankSources = m_ghostExchangeSources[rank];
-		for (long rankSourceId : rankSources) {
-			updatedSources.insert(rankSourceId);
+				if (neighRank == rank) {
+					continue;
+				}
+
+				if (rankCellSet.insert(neighId).second) {
+					rankCells.emplace_back(neighId, neighRank);
+				}
+			}
+		}
+	}
+
+	exchangeCells(sendLists, nullptr);
+}
+
+/*!
+	Removes the ghosts that are not within the halo of the internal cells
+	and rebuilds the exchange information.
+*/
+void PatchKernel::pruneHalo()
+{
+	// Internal cells adjacent to the ghosts
+	//
+	// A ghost is in the halo if there is a path of length not greater
+	// than the size of the halo that connects it to an internal cell.
+	// The last internal cell along the shortest path is adjacent to a
+	// ghost, hence only those cells have to be used as seeds.
+	std::unordered_set<long> borderCellSet;
+	for (const auto &entry : m_ghostOwners) {
+		for (long neighId : findCellHaloNeighs(entry.first)) {
+			if (m_ghostOwners.count(neighId) == 0) {
+				borderCellSet.insert(neighId);
+			}
 		}
-		rankSources = std::vector<long>(updatedSources.begin(), updatedSources.end());
-		std::sort(rankSources.begin(), rankSources.end(), CellPositionLess(*this));
 	}
+
+	std::vector<long> borderCells(borderCellSet.begin(), borderCellSet.end());
+	std::vector<long> haloCells = findHaloCells(borderCells, m_haloSize);
+	std::unordered_set<long> haloCellSet(haloCells.begin(), haloCells.end());
+
+	// Delete the ghosts outside the halo
+	std::vector<long> deletedCells;
+	for (const auto &entry : m_ghostOwners) {
+		long ghostId = entry.first;
+		if (haloCellSet.count(ghostId) == 0) {
+			deletedCells.push_back(ghostId);
+		}
+	}
+
+	for (long cellId : deletedCells) {
+		unsetGhostOwner(cellId, false);
+		deleteCell(cellId, true, true);
+	}
+
+	m_cells.flush();
+
+	deleteOrphanVertices();
+
+	// Rebuild ghost information
+	buildGhostExchangeData();
 }
 
 /*!
@@ -706,745 +1379,636 @@ void PatchKernel::addExchangeSources(const std::vector<long> &ghostIds)
     hosting the mesh is neither the sender or the receiver, a notification is
     received in case ghost cells has changed owner.
 
+    This is a collective operation, it has to be called by all the processors.
+
     \param[in] sendRank sender rank
     \param[in] recvRank receiver rank
     \param[in] cellsToSend list of cells to be moved
  */
 adaption::Info PatchKernel::sendCells(const int &sendRank, const int &recvRank, const std::vector<long> &cellsToSend)
 {
-	adaption::Info adaptionInfo;
-	if (m_rank == sendRank) {
-		adaptionInfo = sendCells_sender(recvRank, cellsToSend);
-	} else if (m_rank == recvRank) {
-		adaptionInfo = sendCells_receiver(sendRank);
-	} else {
-		adaptionInfo = sendCells_notified(sendRank, recvRank);
+	// Only internal cells can sent
+	std::unordered_map<long, int> sendRanks;
+	if (m_rank == sendRank && recvRank != sendRank) {
+		sendRanks.reserve(cellsToSend.size());
+		for (long cellId : cellsToSend) {
+			const Cell &cell = m_cells[cellId];
+			if (!cell.isInterior()) {
+				throw std::runtime_error ("Only internal cells can sent.");
+			}
+
+			sendRanks.insert({{cellId, recvRank}});
+		}
 	}
 
-	return adaptionInfo;
+	// Migrate the cells
+	//
+	// There is only one pair of processors involved in the communication,
+	// hence every processor will get at most one adaption info.
+	std::vector<adaption::Info> adaptionData = migrateCells(sendRanks, true);
+	if (adaptionData.empty()) {
+		adaption::Info adaptionInfo;
+		adaptionInfo.type = adaption::TYPE_NONE;
+
+		return adaptionInfo;
+	}
+
+	return std::move(adaptionData.front());
 }
 
 /*!
-    Sends the given list of cells to the process with the specified rank.
-
-    \param[in] recvRank is the receiver rank
-    \param[in] cellsToSend is the list of cells to be sent
- */
-adaption::Info PatchKernel::sendCells_sender(const int &recvRank, const std::vector<long> &cellsToSend)
+	Exchanges cells among the processors.
+
+	Every processor sends a single message to each destination, containing
+	the specified cells and their vertices. Each cell is sent along with the
+	rank of the processor that owns it (or that will own it): received cells
+	owned by this processor become internal cells, the others become ghosts.
+	Cells and vertices that are already on the receiver are discarded, hence
+	a cell can be sent without knowing whether the destination already has
+	it. Messages are exchanged using non-blocking communications and the
+	received cells are connected to the existing ones once all the messages
+	are processed.
+
+	The processors a message will be received from are discovered with the
+	non-blocking consensus algorithm: only the processors that exchange
+	cells communicate with each other, there is no collective operation
+	whose cost grows with the number of processors apart from a single
+	non-blocking barrier.
+
+	This is a collective operation, it has to be called by all the
+	processors.
+
+	\param sendLists are the cells to send to each destination, for every
+	cell the list contains its id and the rank of its owner
+	\param[out] recvInternals if a valid pointer is provided, on output will
+	contain, for every processor that sent a message, the ids of the received
+	cells that are owned by this processor
+	\result The ids of the cells added to the patch.
+*/
+std::vector<long> PatchKernel::exchangeCells(const std::unordered_map<int, std::vector<std::pair<long, int>>> &sendLists, std::unordered_map<int, std::vector<long>> *recvInternals)
 {
-    //
-    // Initialize adaption info
-    //
-    adaption::Info adaptionInfo;
-    adaptionInfo.entity = adaption::ENTITY_CELL;
-    adaptionInfo.type   = adaption::TYPE_PARTITION_SEND;
-    adaptionInfo.rank   = recvRank;
-
-    //
-    // Create a set with the cells to communicate
-    //
-    // For now the set will contain the cells explicitly marked for sending.
-    // Later, a layer of surrounding cells will be added.
-    //
-    // Only internal cells can sent.
-    std::vector<long> cellsToCommunicate;
-    std::unordered_map<long, int> cellRankOnReceiver;
-
-    cellsToCommunicate.reserve(cellsToSend.size());
-    cellRankOnReceiver.reserve(cellsToSend.size());
-    for (long cellId : cellsToSend) {
-		const Cell &cell = m_cells[cellId];
-		if (!cell.isInterior()) {
-			throw std::runtime_error ("Only internal cells can sent.");
-		}
+	const int EXCHANGE_TAG = 10;
+	const int SIZE_TAGS[2] = {11, 12};
 
-		cellsToCommunicate.push_back(cellId);
-        cellRankOnReceiver.insert({{cellId, recvRank}});
-    }
-
-    //
-    // Create the notifications of ownership change
-    //
-    // Processors that have, among their ghost, cells that will be sent to
-    // the receiver need to be notified about the ownership change. We will
-    // communicate to the neighbours only the index in the exchange data
-    // structure of the cells that have change ownership.
-    //
-    // We need to create the notification now that the set with the cells
-    // to communicate contains only the cells explicitly marked for sending.
-    std::unordered_map<int, std::vector<long>> ownershipNotifications;
-    for (const auto &rankExchangeData : getGhostExchangeSources()) {
-        int neighRank = rankExchangeData.first;
-		if (neighRank == recvRank) {
+	//
+	// Pack the data to send
+	//
+	std::vector<int> sendRankList;
+	sendRankList.reserve(sendLists.size());
+	std::vector<OBinaryStream> sendBuffers(sendLists.size());
+	std::vector<long> sendSizes;
+	sendSizes.reserve(sendLists.size());
+
+	for (const auto &entry : sendLists) {
+		int rank = entry.first;
+		const std::vector<std::pair<long, int>> &rankCells = entry.second;
+		if (rankCells.empty()) {
 			continue;
 		}
 
-        std::vector<long> &notificationList = ownershipNotifications[neighRank];
-
-        auto &rankExchangeSources = rankExchangeData.second;
-        int nRankExchangeSources = rankExchangeSources.size();
-        for (long k = 0; k < nRankExchangeSources; ++k) {
-            long cellId = rankExchangeSources[k];
-			if (cellRankOnReceiver.count(cellId) == 0) {
-                continue;
-            }
-
-            notificationList.push_back(k);
-        }
-	}
-
-    // Find the frame of the cells explicitly marked for sending. These cells
-    // are the cells marked for sending that have at least one neighbour that
-    // will not be sent.
-    std::unordered_set<long> cellsToSendFrame;
-	for (long cellId : cellsToSend) {
-		auto neighs = findCellNeighs(cellId);
-		int nNeighs = neighs.size();
-		for (int j = 0; j < nNeighs; ++j) {
-			long neighId = neighs[j];
-			if (cellRankOnReceiver.count(neighId) == 0) {
-				cellsToSendFrame.insert(cellId);
+		// Vertices of the cells to send
+		std::vector<long> sendVertices;
+		std::unordered_set<long> sendVertexSet;
+		for (const auto &cellEntry : rankCells) {
+			const Cell &cell = m_cells[cellEntry.first];
+			int nCellVertices = cell.getVertexCount();
+			for (int j = 0; j < nCellVertices; ++j) {
+				long vertexId = cell.getVertex(j);
+				if (sendVertexSet.insert(vertexId).second) {
+					sendVertices.push_back(vertexId);
+				}
+			}
+		}
+
+		// Fill the buffer
+		long bufferSize = 2 * sizeof(long);
+		for (long vertexId : sendVertices) {
+			bufferSize += m_vertices[vertexId].getBinarySize();
+		}
+
+		for (const auto &cellEntry : rankCells) {
+			bufferSize += sizeof(int) + m_cells[cellEntry.first].getBinarySize();
+		}
+
+		OBinaryStream &buffer = sendBuffers[sendRankList.size()];
+		buffer.setCapacity(bufferSize);
+
+		buffer << (long) sendVertices.size();
+		for (long vertexId : sendVertices) {
+			buffer << m_vertices[vertexId];
+		}
+
+		buffer << (long) rankCells.size();
+		for (const auto &cellEntry : rankCells) {
+			buffer << cellEntry.second;
+			buffer << m_cells[cellEntry.first];
+		}
+
+		if (bufferSize != (long) buffer.capacity()) {
+			throw std::runtime_error ("Cell buffer size does not match calculated size");
+		}
+
+		sendRankList.push_back(rank);
+		sendSizes.push_back(bufferSize);
+	}
+
+	int nSendRanks = sendRankList.size();
+
+	//
+	// Exchange the data
+	//
+
+	// Discover the messages to receive
+	//
+	// The size of each message is sent with a synchronous send, hence the
+	// send completes only when it has been received. Once all its sends
+	// have completed, a processor enters a non-blocking barrier and keeps
+	// receiving the sizes sent by the others until the barrier completes:
+	// at that point all the sizes have been received by all processors.
+	//
+	// A processor may leave the barrier and start the next exchange while
+	// other processors are still receiving the sizes of the current one.
+	// It cannot go any further, because the barrier of the next exchange
+	// needs all the processors, therefore alternating between two tags is
+	// enough to keep the sizes of consecutive exchanges apart.
+	int sizeTag = SIZE_TAGS[m_cellExchangeCount % 2];
+	++m_cellExchangeCount;
+
+	std::vector<MPI_Request> sizeRequests(nSendRanks);
+	for (int k = 0; k < nSendRanks; ++k) {
+		MPI_Issend(&sendSizes[k], 1, MPI_LONG, sendRankList[k], sizeTag, m_communicator, &sizeRequests[k]);
+	}
+
+	std::vector<std::pair<int, long>> recvSizes;
+	MPI_Request barrierRequest = MPI_REQUEST_NULL;
+	bool barrierActive = false;
+	while (true) {
+		int messageAvailable;
+		MPI_Status status;
+		MPI_Iprobe(MPI_ANY_SOURCE, sizeTag, m_communicator, &messageAvailable, &status);
+		if (messageAvailable) {
+			long recvSize;
+			MPI_Recv(&recvSize, 1, MPI_LONG, status.MPI_SOURCE, sizeTag, m_communicator, MPI_STATUS_IGNORE);
+			recvSizes.emplace_back(status.MPI_SOURCE, recvSize);
+		}
+
+		if (!barrierActive) {
+			int sendsCompleted;
+			MPI_Testall(nSendRanks, sizeRequests.data(), &sendsCompleted, MPI_STATUSES_IGNORE);
+			if (sendsCompleted) {
+				MPI_Ibarrier(m_communicator, &barrierRequest);
+				barrierActive = true;
+			}
+		} else {
+			int barrierCompleted;
+			MPI_Test(&barrierRequest, &barrierCompleted, MPI_STATUS_IGNORE);
+			if (barrierCompleted) {
 				break;
 			}
 		}
 	}
 
-    // Along with the cells explicitly marked for sending, we need to send
-    // also an halo of surrounfing cells. Those cells will be used by the
-    // receiver to connect the cells it receives to the existing cells,
-    // plus some of them will become ghost cells.
-    //
-    // Some cells on the halo may be already on the receiver (becuase they
-    // are already ghosts owned by another processor). However we don't have
-    // enough information to identify those duplicate cells. The receiver
-    // needs to permorm a check to avoid inserting duplicate cells.
-    //
-    // Cells owned by receiver are already on the receiver, so there is no
-    // need to send them.
-    for (long cellId : cellsToSendFrame) {
-        auto neighs = findCellNeighs(cellId);
-        int nNeighs = neighs.size();
-        for (int j = 0; j < nNeighs; ++j) {
-            long neighId = neighs[j];
-            if (cellRankOnReceiver.count(neighId) > 0) {
-                continue;
-            }
-
-            int ownerRank;
-            if (m_ghostOwners.count(neighId) == 0) {
-                ownerRank = m_rank;
-            } else {
-                ownerRank = m_ghostOwners[neighId];
-                if (ownerRank == recvRank) {
-                    continue;
-                }
-            }
-
-			cellsToCommunicate.push_back(neighId);
-            cellRankOnReceiver.insert({{neighId, ownerRank}});
-        }
-    }
-
-    // The cells that are exchange sources for the receiver are already on
-    // the receiver (these cells are ghost owned by this processor). Mark
-    // is as such to help the receiver to remove duplicate cells.
-    std::unordered_map<long, long> senderGhostsToPromote;
-    if (getGhostExchangeSources().count(recvRank) > 0) {
-        const auto &exchangeSources = getGhostExchangeSources(recvRank);
-        long nExchangeSources = exchangeSources.size();
-        for (long k = 0; k < nExchangeSources; ++k) {
-            long cellId = exchangeSources[k];
-            if (cellRankOnReceiver.count(cellId) > 0) {
-                senderGhostsToPromote.insert({{cellId, k}});
-            }
-        }
-    }
-
-    //
-    // Create the list of vertices to send
-    //
-    std::unordered_set<long> vertexToCommunicate;
-    for (const long &cellId : cellsToCommunicate) {
-        const Cell &cell = m_cells[cellId];
-
-        int nCellVertices = cell.getVertexCount();
-        for (int j = 0; j < nCellVertices; ++j) {
-            long vertexId = cell.getVertex(j);
-            if (vertexToCommunicate.count(vertexId) > 0) {
-                continue;
-            }
-
-            vertexToCommunicate.insert(vertexId);
-        }
-    }
-
-    //
-    // Send vertex data
-    //
-    OBinaryStream vertexBuffer;
-    long vertexBufferCapacity = 0;
-
-    // Fill buffer with vertex data
-    vertexBufferCapacity += sizeof(long);
-    for (long vertexId : vertexToCommunicate) {
-        vertexBufferCapacity += m_vertices[vertexId].getBinarySize();
-    }
-    vertexBuffer.setCapacity(vertexBufferCapacity);
-
-    vertexBuffer << (long) vertexToCommunicate.size();
-    for (long vertexId : vertexToCommunicate) {
-        vertexBuffer << m_vertices[vertexId];
-    }
-
-    if (vertexBufferCapacity != (long) vertexBuffer.capacity()) {
-		throw std::runtime_error ("Cell buffer size does not match calculated size");
-	}
-
-    // Communication
-    MPI_Send(&vertexBufferCapacity, 1, MPI_LONG, recvRank, 10, m_communicator);
-    MPI_Send(vertexBuffer.rawData(), vertexBuffer.capacity(), MPI_CHAR, recvRank, 11, m_communicator);
-
-    //
-    // Send cell data
-    //
-    OBinaryStream cellBuffer;
-    long cellBufferCapacity = 0;
-
-	// Fill the buffer with information on the cells that will be send to the
-	// receiver, but are already there because they are ghosts owned by the
-	// sender. These cells will be promoted by the receiver to internal cells.
-    cellBufferCapacity += sizeof(long) + 2 * senderGhostsToPromote.size() * sizeof(long);
-    cellBuffer.setCapacity(cellBufferCapacity);
-
-    cellBuffer << (long) senderGhostsToPromote.size();
-    for (const auto &entry : senderGhostsToPromote) {
-        // Index of the cell in the exchange data structure
-		long index = entry.second;
-		cellBuffer << index;
-
-		// Id of the cell on this processor
-		long cellId = entry.first;
-		cellBuffer << cellId;
-	}
-
-    // Fill the buffer with cell data
-    cellBufferCapacity += sizeof(long);
-    for (const long &cellId : cellsToCommunicate) {
-        cellBufferCapacity += sizeof(int) + m_cells[cellId].getBinarySize();
-    }
-    cellBuffer.setCapacity(cellBufferCapacity);
-
-    cellBuffer << (long) cellsToCommunicate.size();
-    for (const long &cellId : cellsToCommunicate) {
-        // Owner of the cell
-        int cellOwner = cellRankOnReceiver[cellId];
-        cellBuffer << cellOwner;
-
-        // Cell data
-        cellBuffer << m_cells[cellId];
-    }
-
-    if (cellBufferCapacity != (long) cellBuffer.capacity()) {
-		throw std::runtime_error ("Cell buffer size does not match calculated size");
-	}
-
-    // Communication
-    MPI_Send(&cellBufferCapacity, 1, MPI_LONG, recvRank, 20, m_communicator);
-    MPI_Send(cellBuffer.rawData(), cellBuffer.capacity(), MPI_CHAR, recvRank, 21, m_communicator);
-
-    //
-    // Send ownership notifications
-    //
-    for (const auto &ownershipNotification : ownershipNotifications) {
-        int neighRank = ownershipNotification.first;
-		const auto &notificationList = ownershipNotification.second;
-
-        // Communicate the size of the notification
-        long notificationBufferCapacity = 0;
-        if (notificationList.size() > 0) {
-            notificationBufferCapacity += sizeof(long) + notificationList.size() * sizeof(long);
-        }
-        MPI_Send(&notificationBufferCapacity, 1, MPI_LONG, neighRank, 30, m_communicator);
-
-        // Fill the buffer and send the notification
-        if (notificationBufferCapacity > 0) {
-            OBinaryStream notificationBuffer(notificationBufferCapacity);
-
-			notificationBuffer << (long) notificationList.size();
-            for (long index : notificationList) {
-                notificationBuffer << index;
-            }
-
-            MPI_Send(notificationBuffer.rawData(), notificationBuffer.capacity(), MPI_CHAR, neighRank, 31, m_communicator);
-        }
-    }
-
-    //
-    // Update cells that no longer belong to this processor
-    //
-
-    // Add the sned ids int the adaption info
-    //
-    // The ids will be sorted by the position of the cells, this is the
-    // same order that will be used on the processor that has received the
-    // octants. Since the order is the same, the two processors are able
-    // to exchange cell data without any additional extra communication
-    // (they already know the list of cells for which data is needed and
-    // the order in which these data will be sent).
-    for (long cellId : cellsToSend) {
-        adaptionInfo.previous.push_back(cellId);
-    }
-
-    std::sort(adaptionInfo.previous.begin(), adaptionInfo.previous.end(), CellPositionLess(*this));
-
-    // Delete sent cells or mark them as ghosts owned by the receiver.
-    for (long cellId : cellsToSend) {
-		// Check if a cell has to be delete or is a ghost owned by the receiver
+	std::sort(recvSizes.begin(), recvSizes.end());
+
+	// Start the receives
+	int nRecvRanks = recvSizes.size();
+	std::vector<int> recvRankList(nRecvRanks);
+	std::vector<IBinaryStream> recvBuffers(nRecvRanks);
+	std::vector<MPI_Request> recvRequests(nRecvRanks);
+	for (int k = 0; k < nRecvRanks; ++k) {
+		int rank = recvSizes[k].first;
+		recvRankList[k] = rank;
+
+		IBinaryStream &buffer = recvBuffers[k];
+		buffer.setCapacity(recvSizes[k].second);
+		MPI_Irecv(buffer.rawData(), buffer.capacity(), MPI_CHAR, rank, EXCHANGE_TAG, m_communicator, &recvRequests[k]);
+	}
+
+	// Start the sends
+	std::vector<MPI_Request> sendRequests(nSendRanks);
+	for (int k = 0; k < nSendRanks; ++k) {
+		int rank = sendRankList[k];
+		OBinaryStream &buffer = sendBuffers[k];
+		MPI_Isend(buffer.rawData(), buffer.capacity(), MPI_CHAR, rank, EXCHANGE_TAG, m_communicator, &sendRequests[k]);
+	}
+
+	// Build the lookup structures for the duplicates
+	//
+	// Received cells and vertices may be already on this processor, but
+	// only if they belong to the ghosts or to the internal cells that
+	// are ghosts on other processors. Only those cells (and their
+	// vertices) have to be checked for duplicates. The structures are
+	// built while the messages are being exchanged.
+	//
+	// The kd-tree stores the pointer to the vertices. If we try to store in
+	// the kd-tree the pointers to the vertices of the patch, the first resize
+	// of the vertex container would invalidate the pointer. Create a copy of
+	// the vertices and store the pointer to that copy.
+	auto buildCellKey = [] (const Cell &cell) {
+		int nCellVertices = cell.getVertexCount();
+		const long *cellConnect = cell.getConnect();
+
+		std::vector<long> key(cellConnect, cellConnect + nCellVertices);
+		std::sort(key.begin(), key.end());
+		key.push_back((long) cell.getType());
+
+		return key;
+	};
+
+	std::unordered_set<long> borderCells;
+	borderCells.reserve(m_ghostOwners.size());
+	for (const auto &entry : m_ghostOwners) {
+		borderCells.insert(entry.first);
+	}
+
+	for (const auto &entry : m_ghostExchangeSources) {
+		borderCells.insert(entry.second.begin(), entry.second.end());
+	}
+
+	std::map<std::vector<long>, long> cellKeys;
+	std::deque<Vertex> treeVertices;
+	std::unordered_set<long> treeVertexIds;
+	//
+	// The kd-tree grows by chunks of the size specified in the constructor,
+	// vertices will be added also while processing the received cells.
+	KdTree<3, Vertex, long> vertexTree(std::max((int) borderCells.size(), 1024));
+	for (long cellId : borderCells) {
+		const Cell &cell = m_cells[cellId];
+		cellKeys.insert({{buildCellKey(cell), cellId}});
+
+		int nCellVertices = cell.getVertexCount();
+		for (int j = 0; j < nCellVertices; ++j) {
+			long vertexId = cell.getVertex(j);
+			if (treeVertexIds.insert(vertexId).second) {
+				treeVertices.push_back(m_vertices[vertexId]);
+				vertexTree.insert(&treeVertices.back(), vertexId);
+			}
+		}
+	}
+
+	std::unordered_set<long>().swap(borderCells);
+	std::unordered_set<long>().swap(treeVertexIds);
+
+	// Wait for the receives
+	if (nRecvRanks > 0) {
+		MPI_Waitall(nRecvRanks, recvRequests.data(), MPI_STATUSES_IGNORE);
+	}
+
+	//
+	// Add the received cells
+	//
+	// Messages are processed in rank order, this gives a deterministic
+	// numbering to the received cells and vertices.
+	std::vector<long> addedCells;
+	for (int k = 0; k < nRecvRanks; ++k) {
+		IBinaryStream &buffer = recvBuffers[k];
+
+		// Add vertices
+		//
+		// There are no duplicates among the vertices received from the same
+		// processor, but some of them may be already on this processor.
+		long nRecvVertices;
+		buffer >> nRecvVertices;
+
+		std::unordered_map<long, long> recvVertexMap;
+		recvVertexMap.reserve(nRecvVertices);
+		for (long i = 0; i < nRecvVertices; ++i) {
+			Vertex vertex;
+			buffer >> vertex;
+			long recvVertexId = vertex.getId();
+
+			long localVertexId;
+			if (vertexTree.exist(&vertex, localVertexId) < 0) {
+				localVertexId = generateVertexId();
+				treeVertices.push_back(vertex);
+				addVertex(std::move(vertex), localVertexId);
+				vertexTree.insert(&treeVertices.back(), localVertexId);
+			}
+
+			recvVertexMap.insert({{recvVertexId, localVertexId}});
+		}
+
+		// Add cells
 		//
-		// A cell will become a ghost if at least one of his neighbours is
-		// an internal cell. If the processors is sending all its cells
-		// there will be no ghosts cell.
-		bool moveToGhosts = false;
-		if ((long) cellsToSend.size() < m_nInternals) {
-			if (cellsToSendFrame.count(cellId) == 0) {
-				moveToGhosts = false;
+		// If a cell is already on this processor, the received copy is
+		// discarded. Adjacencies of the received cells will be rebuilt
+		// once all the cells are added.
+		std::vector<long> recvRankInternals;
+
+		long nRecvCells;
+		buffer >> nRecvCells;
+		for (long i = 0; i < nRecvCells; ++i) {
+			int recvCellRank;
+			buffer >> recvCellRank;
+
+			Cell recvCell;
+			buffer >> recvCell;
+
+			int nCellVertices = recvCell.getVertexCount();
+			for (int j = 0; j < nCellVertices; ++j) {
+				long localVertexId = recvVertexMap.at(recvCell.getVertex(j));
+				recvCell.setVertex(j, localVertexId);
+			}
+
+			std::vector<long> recvCellKey = buildCellKey(recvCell);
+			auto cellKeyItr = cellKeys.find(recvCellKey);
+
+			long localCellId;
+			if (cellKeyItr != cellKeys.end()) {
+				localCellId = cellKeyItr->second;
 			} else {
-				auto neighs = findCellNeighs(cellId);
-				int nNeighs = neighs.size();
-				for (int j = 0; j < nNeighs; ++j) {
-					long neighId = neighs[j];
-					if (m_ghostOwners.count(neighId) == 0) {
-						moveToGhosts = true;
-						break;
-					}
+				bool recvIsInterior = (recvCellRank == m_rank);
+				recvCell.setInterior(recvIsInterior);
+
+				localCellId = generateCellId();
+				addCell(std::move(recvCell), localCellId);
+				if (!recvIsInterior) {
+					setGhostOwner(localCellId, recvCellRank, false);
 				}
+
+				cellKeys.insert({{std::move(recvCellKey), localCellId}});
+				addedCells.push_back(localCellId);
 			}
-		}
 
-        // Delete the cell or mark is as a ghost owned by the receiver.
-        if (moveToGhosts) {
-            moveInternal2Ghost(cellId);
-            setGhostOwner(cellId, recvRank, false);
-        } else {
-			unsetGhostOwner(cellId, false);
-            deleteCell(cellId, true, true);
-        }
-    }
-
-    // Delete stale ghosts
-    //
-    // Loop over all the ghosts and keep only the cells that have at least
-    // one internal neighbour.
-    std::unordered_set<int> involvedRanks;
-    involvedRanks.insert(recvRank);
-
-    auto itr = m_ghostOwners.cbegin();
-    while (itr != m_ghostOwners.cend()) {
-        long ghostId = itr->first;
-
-        bool keep   = false;
-        auto neighs = findCellNeighs(ghostId);
-        int nNeighs = neighs.size();
-        for (int j = 0; j < nNeighs; ++j) {
-			long neighId = neighs[j];
-			if (m_ghostOwners.count(neighId) == 0) {
-                keep = true;
-                break;
-            }
-        }
+			if (recvInternals && recvCellRank == m_rank) {
+				recvRankInternals.push_back(localCellId);
+			}
+		}
 
-        auto nextItr = itr;
-        nextItr++;
-        if (!keep) {
-            long ghostOwner = itr->second;
-            involvedRanks.insert(ghostOwner);
+		if (recvInternals) {
+			(*recvInternals)[recvRankList[k]] = std::move(recvRankInternals);
+		}
+	}
 
-            unsetGhostOwner(ghostId, false);
-            deleteCell(ghostId, true, true);
-        }
-        itr = nextItr;
-    }
+	std::vector<IBinaryStream>().swap(recvBuffers);
+	std::map<std::vector<long>, long>().swap(cellKeys);
+	std::deque<Vertex>().swap(treeVertices);
 
-    m_cells.flush();
+	// Wait for the sends
+	if (nSendRanks > 0) {
+		MPI_Waitall(nSendRanks, sendRequests.data(), MPI_STATUSES_IGNORE);
+	}
 
-	// Delete orphan vertices
-	deleteOrphanVertices();
+	std::vector<OBinaryStream>().swap(sendBuffers);
 
-	// Rebuild ghost information
-	std::vector<int> involvedRankList(involvedRanks.begin(), involvedRanks.end());
-	buildGhostExchangeData(involvedRankList);
+	// Connect the received cells to the existing ones
+	updateAdjacencies(addedCells, true);
 
-	// Return adaption info
-    return adaptionInfo;
+	return addedCells;
 }
 
-/*!
-    Recevies a list of cells from the specified processor.
 
-    \param[in] sendRank is the rank of the processors sending the cells
- */
-adaption::Info PatchKernel::sendCells_receiver(const int &sendRank)
+/*!
+	Migrates internal cells among the processors.
+
+	All the processors take part in the migration at the same time. Cells
+	are packed in a single message for each destination, along with an
+	halo made by the cells within the halo of the sent cells that the
+	destination will not own and with the vertices of all those cells. The
+	halo is used by the receiver to connect the received cells to the
+	existing ones and to build its ghosts.
+
+	Before packing the cells, the final rank of the internal cells is sent
+	to the processors that have them as ghosts. In this way every processor
+	knows the final owner of all its cells and can update the ownership of
+	its ghosts without any further communication.
+
+	\param sendRanks are the ranks the internal cells will be sent to,
+	internal cells not listed will not be moved
+	\param trackChanges if set to true, the changes to the patch will be
+	tracked
+	\result Returns a vector of adaption::Info that can be used to track
+	the changes done during the migration.
+*/
+std::vector<adaption::Info> PatchKernel::migrateCells(const std::unordered_map<long, int> &sendRanks, bool trackChanges)
 {
-    //
-    // Initialize adaption info
-    //
-    adaption::Info adaptionInfo;
-    adaptionInfo.entity = adaption::ENTITY_CELL;
-    adaptionInfo.type   = adaption::TYPE_PARTITION_RECV;
-    adaptionInfo.rank   = sendRank;
-
-    //
-    // Add vertices
-    //
-
-    // Receive data
-    long vertexBufferCapacity;
-    MPI_Recv(&vertexBufferCapacity, 1, MPI_LONG, sendRank, 10, m_communicator, MPI_STATUS_IGNORE);
-
-    IBinaryStream vertexBuffer(vertexBufferCapacity);
-    MPI_Recv(vertexBuffer.rawData(), vertexBuffer.capacity(), MPI_CHAR, sendRank, 11, m_communicator, MPI_STATUS_IGNORE);
-
-    // Build a kd-tree with the vertices on the ghosts cells
-    //
-    // These are the only vertices to check for duplicates when receiving the
-    // list vertices from the sender.
-    //
-    // The kd-tree stores the pointer to the vertices. Ifwe try to store in the
-    // kd-tree the pointers to the vertices of the patch, the first resize of
-    // the vertex container would invalidate the pointer. Create a copy of the
-    // vertices and store the pointer to that copy.
-    long nGhostsMaxVertices = 0;
-    for (const auto &entry : m_ghostOwners) {
-        long ghostId = entry.first;
-        const Cell &ghost = m_cells[ghostId];
-        nGhostsMaxVertices += ghost.getVertexCount();
-    }
-
-    KdTree<3, Vertex, long> ghostVerticesTree(nGhostsMaxVertices);
-    std::unordered_map<long, Vertex> ghostVertices(nGhostsMaxVertices);
-    for (const auto &entry : m_ghostOwners) {
-        long ghostId = entry.first;
-        const Cell &ghost = m_cells[ghostId];
-        int nGhostVertices = ghost.getVertexCount();
-        for (int k = 0; k < nGhostVertices; ++k) {
-            long vertexId = ghost.getVertex(k);
-            if (ghostVertices.count(vertexId) == 0) {
-                ghostVertices.insert({{vertexId, m_vertices[vertexId]}});
-                ghostVerticesTree.insert(&ghostVertices.at(vertexId), vertexId);
-            }
-        }
-    }
-
-    // Receive vertices
-    //
-    // There are no duplicate in the received vertices, but some of them may
-    // be already a local vertex of a ghost cell.
-    long nRecvVertices;
-    vertexBuffer >> nRecvVertices;
-
-    std::unordered_map<long, long> recvVertexMap;
-    recvVertexMap.reserve(nRecvVertices);
-    for (long i = 0; i < nRecvVertices; ++i) {
-        Vertex vertex;
-        vertexBuffer >> vertex;
-        long recvVertexId = vertex.getId();
-
-        long localVertexId;
-        if (ghostVerticesTree.exist(&vertex, localVertexId) < 0) {
-            localVertexId = generateVertexId();
-            addVertex(std::move(vertex), localVertexId);
-        }
-
-        recvVertexMap.insert({{recvVertexId, localVertexId}});
-    }
-
-    std::unordered_map<long, Vertex>().swap(ghostVertices);
-
-    //
-    // Add cells
-    //
-
-    // Receive data
-    long cellBufferCapacity;
-    MPI_Recv(&cellBufferCapacity, 1, MPI_LONG, sendRank, 20, m_communicator, MPI_STATUS_IGNORE);
-
-    IBinaryStream cellBuffer(cellBufferCapacity);
-    MPI_Recv(cellBuffer.rawData(), cellBuffer.capacity(), MPI_CHAR, sendRank, 21, m_communicator, MPI_STATUS_IGNORE);
-
-    // Ghost owned by the receiver that will be promoted as internal cell
-    //
-    // Among all the received cells, some cells may be already here because
-    // they are ghost cells owned by the sending processor. To identify those
-    // cells, the sender is sending us the position in the ghost exchange data
-    // structures of the duplicate cells owned by this processor. These cells
-    // will be promoted to internal cells and the data received by the sender
-    // will allow to properly set the adjacencies.
-    //
-    // Other cells may be already here, i.e. ghost cells owned by a processor
-    // that is not the sender. However the sender doens't have the necessary
-    // information to tell us which ghost cells are already here. The data we
-    // receive now is only related to the ghost cells owned by the sender.
-    // Cells owned by other processors need to be check when they are received.
-    long nSenderGhostsToPromote;
-    cellBuffer >> nSenderGhostsToPromote;
-
-	unordered_map<long, long> senderGhostsToPromote;
-	senderGhostsToPromote.reserve(nSenderGhostsToPromote);
-
-	if (nSenderGhostsToPromote > 0) {
-		const auto &sendExchangeTargets = getGhostExchangeTargets(sendRank);
-		for (int n = 0; n < nSenderGhostsToPromote; ++n) {
-			long index;
-			cellBuffer >> index;
-			long localCellId = sendExchangeTargets[index];
-
-			long senderCellId;
-			cellBuffer >> senderCellId;
-
-			senderGhostsToPromote.insert({{senderCellId, localCellId}});
+	std::vector<adaption::Info> adaptionData;
+
+	//
+	// Final ranks of the cells
+	//
+	// Only the cells that will not be owned by this processor at the end of
+	// the migration are stored in the map.
+	std::unordered_map<long, int> finalRanks;
+	finalRanks.reserve(sendRanks.size());
+	for (const auto &entry : sendRanks) {
+		if (entry.second != m_rank) {
+			finalRanks.insert(entry);
 		}
 	}
 
-    // Receive cells
-    //
-    // The sender is sending also an halo surroudning the cells explicitly
-    // marked for sending. This halo will be used for connecting the received
-    // cells to the existing ones and to build the ghosts.
-    //
-    // Some cells on the halo can be duplicate. For some of these cells we
-    // already know the apping between sender cell ids and local ids. For
-    // all the other cells we need to check if they are duplicate. All halo
-    // are inserted in the cell list, if they are duplicates they will be
-    // deleted later.
-    long nRecvCells;
-    cellBuffer >> nRecvCells;
-
-    std::unordered_set<int> involvedRanks;
-	involvedRanks.insert(sendRank);
-
-    std::unordered_map<long, long> recvCellMap;
-    std::unordered_set<long> recvCells;
-	recvCells.reserve(nRecvCells);
-
-    std::unordered_map<long, CollapsedVector2D<long>> linkAdjacencies;
-
-    for (long i = 0; i < nRecvCells; ++i) {
-        // Cell data
-        int recvCellOwner;
-        cellBuffer >> recvCellOwner;
-
-        Cell recvCell;
-        cellBuffer >> recvCell;
-        long senderCellId = recvCell.getId();
-
-        // Set cell interior flag
-        bool recvIsInterior = (recvCellOwner == m_rank);
-        recvCell.setInterior(recvIsInterior);
-
-        // Remap connectivity
-        int nCellVertices = recvCell.getVertexCount();
-        for (int j = 0; j < nCellVertices; ++j) {
-            long senderVertexId = recvCell.getVertex(j);
-            long localVertexId  = recvVertexMap.at(senderVertexId);
-
-            recvCell.setVertex(j, localVertexId);
-        }
-
-        // Check if the cells is a duplicate
-        long localCellId = Cell::NULL_ID;
-        if (recvCellOwner != m_rank && getGhostExchangeTargets().count(recvCellOwner) > 0) {
-            const auto &rankExchangeTargets = getGhostExchangeTargets(recvCellOwner);
-            for (long ghostId : rankExchangeTargets) {
-                const Cell &ghostCell = m_cells[ghostId];
-                if (ghostCell.getType() != recvCell.getType()) {
-                    continue;
-                }
-
-                bool cellsCoincide = true;
-                int nGhostVertices = ghostCell.getVertexCount();
-                for (int vertex = 0; vertex < nGhostVertices; ++vertex) {
-                    long ghostVertexId = ghostCell.getVertex(vertex);
-                    long recvVertexId  = recvCell.getVertex(vertex);
-                    if (ghostVertexId != recvVertexId) {
-                        cellsCoincide = false;
-                        break;
-                    }
-                }
-
-                if (cellsCoincide) {
-                    localCellId = ghostId;
-                    break;
-                }
-            }
-        } else if (senderGhostsToPromote.count(senderCellId) > 0) {
-            localCellId = senderGhostsToPromote[senderCellId];
-        }
-
-        // If the cell is not a duplicate add it in the cell data structure,
-        // otherwise merge the connectivity of the duplicate cell to the
-        // existing cell. This ensure that the received cell will be
-        // properly connected to the received cells
-        if (localCellId < 0) {
-            // Add cell
-            localCellId = generateCellId();
-            addCell(std::move(recvCell), localCellId);
-            if (!recvIsInterior) {
-                setGhostOwner(localCellId, recvCellOwner, false);
-            }
-
-            recvCells.insert(localCellId);
-
-            // Update adaption info
-            adaptionInfo.current.push_back(localCellId);
-        } else {
-            // Check if the existing cells needs to become an internal cell
-            Cell &localCell = m_cells[localCellId];
-            if (recvIsInterior && !localCell.isInterior()) {
-                unsetGhostOwner(localCellId, false);
-                moveGhost2Internal(localCellId);
-            }
-
-            // Save the adjacencies of the received cell, this adjacencies
-            // will link together the recevied cell to the existing ones.
-            CollapsedVector2D<long> &recvAdjacencies = linkAdjacencies[localCellId];
-
-            int nCellFaces = recvCell.getFaceCount();
-            recvAdjacencies.reserve(nCellFaces);
-            for (int face = 0; face < nCellFaces; ++face) {
-                int nFaceAdjacencies = recvCell.getAdjacencyCount(face);
-
-                std::vector<long> faceAdjacencies;
-                faceAdjacencies.reserve(nFaceAdjacencies);
-                for (int k = 0; k < nFaceAdjacencies; ++k) {
-                    faceAdjacencies.push_back(recvCell.getAdjacency(face, k));
-                }
-
-                recvAdjacencies.push_back(faceAdjacencies);
-            }
-        }
-
-        // Ranks involved in the communication
-        if (recvCellOwner != m_rank) {
-            involvedRanks.insert(recvCellOwner);
-        }
-
-        // Add the cell to the cell map
-        recvCellMap.insert({{senderCellId, localCellId}});
-    }
-
-    // Remap adjacencies
-    for (auto cellId : recvCells) {
-        Cell &cell = m_cells[cellId];
-
-        int nCellFaces = cell.getFaceCount();
-        for (int face = 0; face < nCellFaces; ++face) {
-            int nFaceAdjacencies = cell.getAdjacencyCount(face);
-            for (int k = 0; k < nFaceAdjacencies; ++k) {
-                long senderAdjacencyId = cell.getAdjacency(face, k);
-                if (senderAdjacencyId < 0) {
-                    continue;
-                } else if (recvCellMap.count(senderAdjacencyId) == 0) {
-					cell.deleteAdjacency(face, k);
-                    continue;
-                } else {
-					long localAdjacencyId = recvCellMap.at(senderAdjacencyId);
-					cell.setAdjacency(face, k, localAdjacencyId);
-				}
-            }
-        }
-    }
-
-    // Link received cells with the current cells
-    for (auto &entry : linkAdjacencies) {
-        long cellId = entry.first;
-        Cell &cell = m_cells[cellId];
-
-        int nCellFaces = cell.getFaceCount();
-        CollapsedVector2D<long> &cellLinkAdjacencies = entry.second;
-        for (int face = 0; face < nCellFaces; ++face) {
-            int nFaceLinkAdjacencies = cellLinkAdjacencies.sub_array_size(face);
-            for (int k = 0; k < nFaceLinkAdjacencies; ++k) {
-                long senderAdjacencyId = cellLinkAdjacencies.get(face, k);
-                long localAdjacencyId  = recvCellMap[senderAdjacencyId];
-                if (cell.findAdjacency(face, localAdjacencyId) >= 0) {
-                    continue;
-                }
-
-                cell.pushAdjacency(face, localAdjacencyId);
-            }
-        }
-    }
-
-    // Sort the ids in the adaption info
-    //
-    // The ids will be sorted by the position of the cells, this is the
-    // same order that will be used on the processor that has received the
-    // octants. Since the order is the same, the two processors are able
-    // to exchange cell data without any additional extra communication
-    // (they already know the list of cells for which data is needed and
-    // the order in which these data will be sent).
-    std::sort(adaptionInfo.current.begin(), adaptionInfo.current.end(), CellPositionLess(*this));
-
-    // Rebuild ghost information
-    std::vector<int> involvedRankList(involvedRanks.begin(), involvedRanks.end());
-    buildGhostExchangeData(involvedRankList);
-
-    // Return adaption info
-    return adaptionInfo;
-}
+	auto getFinalRank = [this, &finalRanks] (long cellId) -> int {
+		auto finalRankItr = finalRanks.find(cellId);
+		if (finalRankItr == finalRanks.end()) {
+			return m_rank;
+		}
 
-/*!
-    Notifies the current processor of changes in ghost ownership after a
-    cell send operation.
+		return finalRankItr->second;
+	};
 
-    \param[in] sendRank is the rank of the processor sending the cells
-    \param[in] recvRank is the rank of the processor receiving the cells
- */
-adaption::Info PatchKernel::sendCells_notified(const int &sendRank, const int &recvRank)
-{
-    adaption::Info adaptionInfo;
-
-    // This processor will receive a notification only if it has ghosts owned
-    // by the sender
-    if (getGhostExchangeTargets().count(sendRank) == 0) {
-        adaptionInfo.type = adaption::TYPE_NONE;
-        return adaptionInfo;
-    }
-
-    // Receive ownership changes
-    long bufferCapacity;
-    MPI_Recv(&bufferCapacity, 1, MPI_LONG, sendRank, 30, m_communicator, MPI_STATUS_IGNORE);
-    if (bufferCapacity == 0) {
-        adaptionInfo.type = adaption::TYPE_NONE;
-        return adaptionInfo;
-    }
-
-    IBinaryStream buffer(bufferCapacity);
-    MPI_Recv(buffer.rawData(), buffer.capacity(), MPI_CHAR, sendRank, 31, m_communicator, MPI_STATUS_IGNORE);
-
-    // Initialize adaption info
-    adaptionInfo.entity = adaption::ENTITY_CELL;
-    adaptionInfo.type   = adaption::TYPE_PARTITION_NOTICE;
-    adaptionInfo.rank   = sendRank;
-
-    // Apply ownership changes
-    long nChanges;
-    buffer >> nChanges;
-
-    const auto exchangeTargets = getGhostExchangeTargets(sendRank);
-    for (long k = 0; k < nChanges; ++k) {
-        long index;
-        buffer >> index;
-
-        long cellId = exchangeTargets[index];
-        setGhostOwner(cellId, recvRank, false);
-    }
-
-    // Rebuild ghost exchagne data
-    buildGhostExchangeData(std::vector<int>{sendRank, recvRank});
-
-	// Return adaption info
-    return adaptionInfo;
+	// Get the final rank of the ghosts from their owners
+	if (!m_ghostExchangeSources.empty() || !m_ghostExchangeTargets.empty()) {
+		std::size_t nRawCells = std::distance(m_cells.rawBegin(), m_cells.rawEnd());
+		std::vector<int> rawFinalRanks(nRawCells, m_rank);
+		for (const auto &entry : finalRanks) {
+			rawFinalRanks[m_cells.rawIndex(entry.first)] = entry.second;
+		}
+
+		GhostExchanger rankExchanger(*this);
+		rankExchanger.exchange(rawFinalRanks.data());
+
+		for (const auto &entry : m_ghostOwners) {
+			long ghostId = entry.first;
+			int ghostFinalRank = rawFinalRanks[m_cells.rawIndex(ghostId)];
+			if (ghostFinalRank != m_rank) {
+				finalRanks.insert({{ghostId, ghostFinalRank}});
+			}
+		}
+	}
+
+	//
+	// Cells to send
+	//
+
+	// Cells explicitly marked for sending, grouped by destination
+	//
+	// Cells are sorted by id, this gives a deterministic order to the cells
+	// in the messages and, therefore, to the ids of the received cells.
+	std::map<int, std::vector<long>> rankSendCells;
+	for (const auto &entry : finalRanks) {
+		long cellId = entry.first;
+		if (m_ghostOwners.count(cellId) > 0) {
+			continue;
+		}
+
+		rankSendCells[entry.second].push_back(cellId);
+	}
+
+	std::unordered_map<int, std::vector<std::pair<long, int>>> sendLists;
+	for (auto &entry : rankSendCells) {
+		int rank = entry.first;
+		std::vector<long> &rankCells = entry.second;
+		std::sort(rankCells.begin(), rankCells.end());
+
+		std::vector<std::pair<long, int>> &rankList = sendLists[rank];
+		for (long cellId : rankCells) {
+			rankList.emplace_back(cellId, rank);
+		}
+
+		// Halo of the cells explicitly marked for sending
+		//
+		// Cells that will be owned by the receiver are either already on
+		// the receiver or will be sent by their current owner, there is
+		// no need to add them to the halo. Some cells on the halo may be
+		// already on the receiver (because they are already ghosts of the
+		// receiver): the receiver will discard the duplicates.
+		for (long cellId : findHaloCells(rankCells, m_haloSize)) {
+			int cellFinalRank = getFinalRank(cellId);
+			if (cellFinalRank != rank) {
+				rankList.emplace_back(cellId, cellFinalRank);
+			}
+		}
+
+		// Track the sent cells
+		//
+		// The ids will be sorted by the position of the cells, this is the
+		// same order that will be used on the processor that receives the
+		// cells. Since the order is the same, the two processors are able
+		// to exchange cell data without any additional extra communication
+		// (they already know the list of cells for which data is needed and
+		// the order in which these data will be sent).
+		if (trackChanges) {
+			adaptionData.emplace_back(adaption::TYPE_PARTITION_SEND, adaption::ENTITY_CELL, rank);
+			adaption::Info &adaptionInfo = adaptionData.back();
+			adaptionInfo.previous = rankCells;
+			std::sort(adaptionInfo.previous.begin(), adaptionInfo.previous.end(), CellPositionLess(*this));
+		}
+	}
+
+	//
+	// Exchange the cells
+	//
+	std::unordered_map<int, std::vector<long>> recvInternals;
+	std::vector<long> addedCells = exchangeCells(sendLists, trackChanges ? &recvInternals : nullptr);
+	std::unordered_map<int, std::vector<std::pair<long, int>>>().swap(sendLists);
+
+	for (long cellId : addedCells) {
+		auto ghostOwnerItr = m_ghostOwners.find(cellId);
+		if (ghostOwnerItr != m_ghostOwners.end()) {
+			finalRanks.insert(*ghostOwnerItr);
+		}
+	}
+
+	// Track the received cells
+	//
+	// Information are sorted by the rank of the sender.
+	if (trackChanges) {
+		std::vector<int> recvRanks;
+		recvRanks.reserve(recvInternals.size());
+		for (const auto &entry : recvInternals) {
+			recvRanks.push_back(entry.first);
+		}
+		std::sort(recvRanks.begin(), recvRanks.end());
+
+		for (int rank : recvRanks) {
+			adaptionData.emplace_back(adaption::TYPE_PARTITION_RECV, adaption::ENTITY_CELL, rank);
+			adaption::Info &adaptionInfo = adaptionData.back();
+			adaptionInfo.current = std::move(recvInternals.at(rank));
+		}
+	}
+
+	//
+	// Update the ownership of the cells
+	//
+	// Cells that will be owned by this processor become internal cells. The
+	// other cells are kept as ghosts only if they are within the halo of
+	// the cells owned by this processor, otherwise they are deleted. The
+	// last owned cell along the shortest path between a cell and the owned
+	// cells is adjacent to a cell that is not owned, hence only those cells
+	// have to be used as seeds for evaluating the halo.
+	std::vector<long> promotedCells;
+	for (const auto &entry : m_ghostOwners) {
+		long ghostId = entry.first;
+		if (finalRanks.count(ghostId) == 0) {
+			promotedCells.push_back(ghostId);
+		}
+	}
+
+	std::unordered_set<long> borderCellSet;
+	for (const auto &entry : finalRanks) {
+		for (long neighId : findCellHaloNeighs(entry.first)) {
+			if (getFinalRank(neighId) == m_rank) {
+				borderCellSet.insert(neighId);
+			}
+		}
+	}
+
+	std::vector<long> borderCells(borderCellSet.begin(), borderCellSet.end());
+	std::unordered_set<long>().swap(borderCellSet);
+
+	std::vector<long> haloCells = findHaloCells(borderCells, m_haloSize);
+	std::unordered_set<long> haloCellSet(haloCells.begin(), haloCells.end());
+
+	std::vector<long> ghostCells;
+	std::vector<long> deletedCells;
+	std::set<int> notifyingRanks;
+	for (const auto &entry : finalRanks) {
+		long cellId = entry.first;
+		if (haloCellSet.count(cellId) == 0) {
+			deletedCells.push_back(cellId);
+			continue;
+		}
+
+		auto ghostOwnerItr = m_ghostOwners.find(cellId);
+		if (ghostOwnerItr == m_ghostOwners.end()) {
+			ghostCells.push_back(cellId);
+		} else if (ghostOwnerItr->second != entry.second) {
+			ghostCells.push_back(cellId);
+			notifyingRanks.insert(ghostOwnerItr->second);
+		}
+	}
+
+	for (long cellId : promotedCells) {
+		unsetGhostOwner(cellId, false);
+		moveGhost2Internal(cellId);
+	}
+
+	for (long cellId : ghostCells) {
+		if (m_ghostOwners.count(cellId) == 0) {
+			moveInternal2Ghost(cellId);
+		}
+		setGhostOwner(cellId, finalRanks.at(cellId), false);
+	}
+
+	for (long cellId : deletedCells) {
+		unsetGhostOwner(cellId, false);
+		deleteCell(cellId, true, true);
+	}
+
+	m_cells.flush();
+
+	// Delete orphan vertices
+	deleteOrphanVertices();
+
+	// Rebuild ghost information
+	buildGhostExchangeData();
+
+	// Track the changes
+	if (trackChanges) {
+		for (adaption::Info &adaptionInfo : adaptionData) {
+			if (adaptionInfo.type != adaption::TYPE_PARTITION_RECV) {
+				continue;
+			}
+
+			std::sort(adaptionInfo.current.begin(), adaptionInfo.current.end(), CellPositionLess(*this));
+		}
+
+		for (int rank : notifyingRanks) {
+			adaptionData.emplace_back(adaption::TYPE_PARTITION_NOTICE, adaption::ENTITY_CELL, rank);
+		}
+	}
+
+	return adaptionData;
 }
 
 /*!
@@ -0,0 +1,504 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <fstream>
+#include <limits>
+#if BITPIT_ENABLE_MPI==1
+#	include <mpi.h>
+#endif
+
+#include "patch_kernel.hpp"
+
+namespace {
+
+/*!
+	Version of the restart format.
+*/
+const int RESTART_VERSION = 1;
+
+#if BITPIT_ENABLE_MPI==1
+/*!
+	Maximum number of bytes transferred by a single MPI-IO call.
+*/
+const long RESTART_CHUNK_SIZE = std::numeric_limits<int>::max();
+
+/*!
+	Writes the specified data to a file using collective operations.
+
+	The data is written in chunks, the count of an MPI-IO call is an int.
+
+	\param communicator is the communicator associated to the file
+	\param file is the file
+	\param offset is the offset, in bytes, at which the data will be written
+	\param data is the data
+	\param size is the size, in bytes, of the data
+*/
+void writeAtAll(MPI_Comm communicator, MPI_File file, MPI_Offset offset, const char *data, long size)
+{
+	long nChunks = (size + RESTART_CHUNK_SIZE - 1) / RESTART_CHUNK_SIZE;
+	MPI_Allreduce(MPI_IN_PLACE, &nChunks, 1, MPI_LONG, MPI_MAX, communicator);
+	for (long k = 0; k < nChunks; ++k) {
+		long chunkBegin = std::min(k * RESTART_CHUNK_SIZE, size);
+		long chunkSize  = std::min(RESTART_CHUNK_SIZE, size - chunkBegin);
+		MPI_File_write_at_all(file, offset + chunkBegin, data + chunkBegin, (int) chunkSize, MPI_CHAR, MPI_STATUS_IGNORE);
+	}
+}
+
+/*!
+	Reads the specified data from a file using collective operations.
+
+	The data is read in chunks, the count of an MPI-IO call is an int.
+
+	\param communicator is the communicator associated to the file
+	\param file is the file
+	\param offset is the offset, in bytes, at which the data will be read
+	\param[out] data on output will contain the data
+	\param size is the size, in bytes, of the data
+*/
+void readAtAll(MPI_Comm communicator, MPI_File file, MPI_Offset offset, char *data, long size)
+{
+	long nChunks = (size + RESTART_CHUNK_SIZE - 1) / RESTART_CHUNK_SIZE;
+	MPI_Allreduce(MPI_IN_PLACE, &nChunks, 1, MPI_LONG, MPI_MAX, communicator);
+	for (long k = 0; k < nChunks; ++k) {
+		long chunkBegin = std::min(k * RESTART_CHUNK_SIZE, size);
+		long chunkSize  = std::min(RESTART_CHUNK_SIZE, size - chunkBegin);
+		MPI_File_read_at_all(file, offset + chunkBegin, data + chunkBegin, (int) chunkSize, MPI_CHAR, MPI_STATUS_IGNORE);
+	}
+}
+#endif
+
+}
+
+namespace bitpit {
+
+/*!
+	\ingroup patchkernel
+	@{
+
+	\class PatchKernel
+*/
+
+/*!
+	Dumps the patch to the specified file.
+
+	The file starts with a header that contains the version of the format,
+	the number of processors and a table with the offsets of the data of
+	every processor. The data of each processor follows the header and
+	contains vertices, cells (with their adjacencies and interfaces),
+	interfaces, ghost owners and exchange information. If the patch is
+	partitioned, all the processors write in the same file using collective
+	MPI-IO operations: in this case the function is collective and has to
+	be called by all the processors.
+
+	\param filename is the name of the file
+*/
+void PatchKernel::dump(const std::string &filename) const
+{
+	// Data of the processor
+	OBinaryStream stream;
+	dumpData(stream);
+
+	const std::vector<char> &data = stream.data();
+	long dataSize = data.size();
+
+	// Write the data
+#if BITPIT_ENABLE_MPI==1
+	if (isCommunicatorSet()) {
+		long headerSize = 2 * sizeof(int) + (m_nProcessors + 1) * sizeof(long);
+
+		std::vector<long> offsets(m_nProcessors + 1);
+		MPI_Allgather(&dataSize, 1, MPI_LONG, offsets.data() + 1, 1, MPI_LONG, m_communicator);
+		offsets[0] = headerSize;
+		for (int rank = 0; rank < m_nProcessors; ++rank) {
+			offsets[rank + 1] += offsets[rank];
+		}
+
+		MPI_File file;
+		int error = MPI_File_open(m_communicator, filename.c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &file);
+		if (error != MPI_SUCCESS) {
+			throw std::runtime_error ("Unable to open file " + filename + " for writing.");
+		}
+		MPI_File_set_size(file, 0);
+
+		OBinaryStream header;
+		if (m_rank == 0) {
+			header.setCapacity(headerSize);
+			header << RESTART_VERSION;
+			header << m_nProcessors;
+			header.write(offsets.data(), offsets.size());
+		}
+		writeAtAll(m_communicator, file, 0, header.data().data(), header.data().size());
+
+		writeAtAll(m_communicator, file, offsets[m_rank], data.data(), dataSize);
+
+		MPI_File_close(&file);
+
+		return;
+	}
+#endif
+
+	std::ofstream file(filename, std::ios::binary);
+	if (!file.good()) {
+		throw std::runtime_error ("Unable to open file " + filename + " for writing.");
+	}
+
+	int header[2] = {RESTART_VERSION, 1};
+	long offsets[2];
+	offsets[0] = sizeof(header) + sizeof(offsets);
+	offsets[1] = offsets[0] + dataSize;
+
+	file.write(reinterpret_cast<const char *>(header), sizeof(header));
+	file.write(reinterpret_cast<const char *>(offsets), sizeof(offsets));
+	file.write(data.data(), dataSize);
+}
+
+/*!
+	Restores the patch from the specified file.
+
+	The current contents of the patch are replaced by the ones stored in
+	the file. Data is loaded in bulk: vertices, cells and interfaces are
+	stored in the same order they had when the patch was dumped and with
+	the same ids, adjacencies and interfaces are not rebuilt. If the patch
+	is partitioned, all the processors read from the same file using
+	collective MPI-IO operations: in this case the function is collective
+	and has to be called by all the processors. The number of processors
+	has to be the same used when the patch was dumped.
+
+	Only patches in expert mode can be restored, the other patches need
+	additional information to build their cells.
+
+	\param filename is the name of the file
+*/
+void PatchKernel::restore(const std::string &filename)
+{
+	if (!isExpert()) {
+		throw std::runtime_error ("Only patches in expert mode can be restored.");
+	}
+
+	// Read the data of the processor
+	int header[2];
+	long offsets[2];
+	std::vector<char> data;
+
+#if BITPIT_ENABLE_MPI==1
+	if (isCommunicatorSet()) {
+		MPI_File file;
+		int error = MPI_File_open(m_communicator, filename.c_str(), MPI_MODE_RDONLY, MPI_INFO_NULL, &file);
+		if (error != MPI_SUCCESS) {
+			throw std::runtime_error ("Unable to open file " + filename + " for reading.");
+		}
+
+		MPI_File_read_at_all(file, 0, header, 2, MPI_INT, MPI_STATUS_IGNORE);
+		if (header[0] != RESTART_VERSION || header[1] != m_nProcessors) {
+			MPI_File_close(&file);
+			throw std::runtime_error ("The file " + filename + " is not compatible with the patch.");
+		}
+
+		MPI_File_read_at_all(file, sizeof(header) + m_rank * sizeof(long), offsets, 2, MPI_LONG, MPI_STATUS_IGNORE);
+
+		data.resize(offsets[1] - offsets[0]);
+		readAtAll(m_communicator, file, offsets[0], data.data(), data.size());
+
+		MPI_File_close(&file);
+	} else
+#endif
+	{
+		std::ifstream file(filename, std::ios::binary);
+		if (!file.good()) {
+			throw std::runtime_error ("Unable to open file " + filename + " for reading.");
+		}
+
+		file.read(reinterpret_cast<char *>(header), sizeof(header));
+		if (header[0] != RESTART_VERSION || header[1] != 1) {
+			throw std::runtime_error ("The file " + filename + " is not compatible with the patch.");
+		}
+
+		file.read(reinterpret_cast<char *>(offsets), sizeof(offsets));
+
+		data.resize(offsets[1] - offsets[0]);
+		file.seekg(offsets[0]);
+		file.read(data.data(), data.size());
+	}
+
+	// Restore the patch
+	IBinaryStream stream;
+	stream.openView(data.data(), data.size());
+	restoreData(stream);
+}
+
+/*!
+	Writes the data of the patch owned by this processor to the specified
+	stream.
+
+	\param stream is the stream
+*/
+void PatchKernel::dumpData(OBinaryStream &stream) const
+{
+	// Patch information
+	stream << getDimension();
+	stream << m_hasCustomTolerance;
+	stream << m_tolerance;
+
+	// Id generators
+	m_vertexIdGenerator.dump(stream);
+	m_cellIdGenerator.dump(stream);
+	m_interfaceIdGenerator.dump(stream);
+
+	// Vertices
+	stream << (long) m_vertices.size();
+	for (const Vertex &vertex : m_vertices) {
+		stream << vertex;
+	}
+
+	// Cells
+	stream << (long) m_cells.size();
+	for (const Cell &cell : m_cells) {
+		stream << cell.isInterior();
+		stream << cell.getPID();
+		stream << cell;
+	}
+
+	// Interfaces
+	stream << (long) m_interfaces.size();
+	for (const Interface &interface : m_interfaces) {
+		stream << interface;
+	}
+
+	// Ghost information
+	//
+	// Ghosts are listed in the order they have in the storage, exchange
+	// lists are listed in ascending rank order.
+#if BITPIT_ENABLE_MPI==1
+	stream << (long) m_haloSize;
+	stream << (int) m_haloConnectivity;
+
+	stream << (long) m_ghostOwners.size();
+	for (const Cell &cell : m_cells) {
+		if (cell.isInterior()) {
+			continue;
+		}
+
+		long ghostId = cell.getId();
+		stream << ghostId;
+		stream << m_ghostOwners.at(ghostId);
+	}
+
+	for (const std::unordered_map<int, std::vector<long>> *exchangeLists : {&m_ghostExchangeTargets, &m_ghostExchangeSources}) {
+		std::vector<int> ranks;
+		ranks.reserve(exchangeLists->size());
+		for (const auto &entry : *exchangeLists) {
+			ranks.push_back(entry.first);
+		}
+		std::sort(ranks.begin(), ranks.end());
+
+		stream << (int) ranks.size();
+		for (int rank : ranks) {
+			const std::vector<long> &rankList = exchangeLists->at(rank);
+			stream << rank;
+			stream << (long) rankList.size();
+			stream.write(rankList.data(), rankList.size());
+		}
+	}
+#else
+	stream << 1L;
+	stream << 0;
+
+	stream << 0L;
+
+	stream << 0;
+	stream << 0;
+#endif
+}
+
+/*!
+	Restores the data of the patch owned by this processor from the
+	specified stream.
+
+	\param stream is the stream
+*/
+void PatchKernel::restoreData(IBinaryStream &stream)
+{
+	// Patch information
+	int dimension;
+	stream >> dimension;
+	if (dimension != getDimension()) {
+		throw std::runtime_error ("The dimension of the restart data does not match the dimension of the patch.");
+	}
+
+	bool hasCustomTolerance;
+	stream >> hasCustomTolerance;
+
+	double tolerance;
+	stream >> tolerance;
+
+	// Reset the patch
+	reset();
+
+#if BITPIT_ENABLE_MPI==1
+	m_ghostOwners.clear();
+	m_ghostExchangeTargets.clear();
+	m_ghostExchangeSources.clear();
+#endif
+
+	// Id generators
+	m_vertexIdGenerator.restore(stream);
+	m_cellIdGenerator.restore(stream);
+	m_interfaceIdGenerator.restore(stream);
+
+	// Vertices
+	long nVertices;
+	stream >> nVertices;
+
+	PiercedVector<Vertex> vertices(nVertices);
+	for (long n = 0; n < nVertices; ++n) {
+		Vertex vertex;
+		stream >> vertex;
+
+		long vertexId = vertex.getId();
+		vertices.emplaceBack(vertexId, std::move(vertex));
+	}
+	m_vertices.swap(vertices);
+
+	// Cells
+	//
+	// Internal cells are stored before the ghosts.
+	long nCells;
+	stream >> nCells;
+
+	m_nInternals     = 0;
+	m_nGhosts        = 0;
+	m_lastInternalId = Element::NULL_ID;
+	m_firstGhostId   = Element::NULL_ID;
+
+	PiercedVector<Cell> cells(nCells);
+	for (long n = 0; n < nCells; ++n) {
+		bool interior;
+		stream >> interior;
+
+		int pid;
+		stream >> pid;
+
+		Cell cell;
+		stream >> cell;
+		cell.setInterior(interior);
+		cell.setPID(pid);
+
+		long cellId = cell.getId();
+		cells.emplaceBack(cellId, std::move(cell));
+
+		if (interior) {
+			++m_nInternals;
+			m_lastInternalId = cellId;
+		} else {
+			++m_nGhosts;
+			if (m_firstGhostId < 0) {
+				m_firstGhostId = cellId;
+			}
+		}
+	}
+	m_cells.swap(cells);
+
+	// Interfaces
+	long nInterfaces;
+	stream >> nInterfaces;
+
+	PiercedVector<Interface> interfaces(nInterfaces);
+	for (long n = 0; n < nInterfaces; ++n) {
+		Interface interface;
+		stream >> interface;
+
+		long interfaceId = interface.getId();
+		interfaces.emplaceBack(interfaceId, std::move(interface));
+	}
+	m_interfaces.swap(interfaces);
+
+	// Ghost information
+	long haloSize;
+	stream >> haloSize;
+
+	int haloConnectivity;
+	stream >> haloConnectivity;
+
+	long nGhosts;
+	stream >> nGhosts;
+
+	std::unordered_map<long, int> ghostOwners;
+	ghostOwners.reserve(nGhosts);
+	for (long n = 0; n < nGhosts; ++n) {
+		long ghostId;
+		stream >> ghostId;
+
+		int ghostRank;
+		stream >> ghostRank;
+
+		ghostOwners.insert({{ghostId, ghostRank}});
+	}
+
+	std::unordered_map<int, std::vector<long>> exchangeLists[2];
+	for (std::unordered_map<int, std::vector<long>> &rankLists : exchangeLists) {
+		int nRanks;
+		stream >> nRanks;
+		for (int k = 0; k < nRanks; ++k) {
+			int rank;
+			stream >> rank;
+
+			long nRankCells;
+			stream >> nRankCells;
+
+			std::vector<long> &rankList = rankLists[rank];
+			rankList.resize(nRankCells);
+			stream.read(rankList.data(), nRankCells);
+		}
+	}
+
+#if BITPIT_ENABLE_MPI==1
+	m_haloSize         = haloSize;
+	m_haloConnectivity = static_cast<HaloConnectivity>(haloConnectivity);
+
+	m_ghostOwners.swap(ghostOwners);
+	m_ghostExchangeTargets.swap(exchangeLists[0]);
+	m_ghostExchangeSources.swap(exchangeLists[1]);
+
+	++m_ghostExchangeRevision;
+#else
+	if (nGhosts > 0) {
+		throw std::runtime_error ("Restart data with ghosts can be restored only by a parallel patch.");
+	}
+#endif
+
+	// Update the bounding box and the tolerance
+	updateBoundingBox(true);
+
+	if (hasCustomTolerance) {
+		setTol(tolerance);
+	} else {
+		resetTol();
+	}
+}
+
+/*!
+	@}
+*/
+
+}
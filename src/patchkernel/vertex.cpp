@@ -39,9 +39,7 @@
 bitpit::OBinaryStream& operator<<(bitpit::OBinaryStream &out_stream, const bitpit::Vertex &vertex)
 {
     out_stream << vertex.m_id;
-	out_stream << vertex[0]
-		     << vertex[1]
-		     << vertex[2];
+	out_stream.write(vertex.m_coords.data(), vertex.m_coords.size());
 
 	return out_stream;
 }
@@ -57,9 +55,7 @@ bitpit::OBinaryStream& operator<<(bitpit::OBinaryStream &out_stream, const bitpi
 bitpit::IBinaryStream& operator>>(bitpit::IBinaryStream &in_stream, bitpit::Vertex &vertex)
 {
     in_stream >> vertex.m_id;
-	in_stream >> vertex[0];
-	in_stream >> vertex[1];
-	in_stream >> vertex[2];
+	in_stream.read(vertex.m_coords.data(), vertex.m_coords.size());
 
 	return in_stream;
 }
@@ -291,7 +287,7 @@ void Vertex::display(std::ostream &out, unsigned short int indent) const
 
         \result buffer size (in bytes)
 */
-unsigned int Vertex::getBinarySize()
+unsigned int Vertex::getBinarySize() const
 {
     return (sizeof(m_id) + m_coords.size() * sizeof(double));
 }
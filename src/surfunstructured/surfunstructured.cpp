@@ -22,6 +22,11 @@
  *
 \*---------------------------------------------------------------------------*/
 
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+
 #include "bitpit_common.hpp"
 
 #include "surfunstructured.hpp"
@@ -238,14 +243,24 @@ void SurfUnstructured::extractEdgeNetwork(SurfUnstructured &net)
  *
  * If the input file is a multi-solid ASCII file, all solids will be loaded
  * and a different PID will be assigned to the PID of the different solids.
+ *
+ * Binary files are read directly from a memory-mapped view of the file.
+ * For binary files the vertices shared by adjacent facets can be welded
+ * while reading: facet vertices with the same coordinates are stored only
+ * once. Vertices are compared exactly, since in binary files the copies of
+ * a vertex are stored with the same single precision value; vertices that
+ * are only close to each other can be collapsed afterwards with
+ * collapseCoincidentVertices().
  * 
  * \param[in] stl_name name of stl file
  * \param[in] isBinary flag for binary (true), of ASCII (false) stl file
  * \param[in] PIDOffset is the offset for the PID numbering
+ * \param[in] weldVertices if set to true, facet vertices with the same
+ * coordinates are stored only once (binary files only)
  * 
  * \result on output returns an error flag for I/O error
 */
-unsigned short SurfUnstructured::importSTL(const string &stl_name, const bool &isBinary, int PIDOffset)
+unsigned short SurfUnstructured::importSTL(const string &stl_name, const bool &isBinary, int PIDOffset, bool weldVertices)
 {
     // ====================================================================== //
     // VARIABLES DECLARATION                                                  //
@@ -260,6 +275,13 @@ unsigned short SurfUnstructured::importSTL(const string &stl_name, const bool &i
         {4, ElementInfo::QUAD}
     };
 
+    // ====================================================================== //
+    // BINARY FILES ARE READ DIRECTLY                                         //
+    // ====================================================================== //
+    if (isBinary) {
+        return importBinarySTL(stl_name, PIDOffset, weldVertices);
+    }
+
     // STL Object
     STLObj STL(stl_name, isBinary);
 
@@ -340,12 +362,6 @@ unsigned short SurfUnstructured::importSTL(const string &stl_name, const bool &i
             cellIterator->setPID(pid);
         } //next c_
 
-        // ====================================================================== //
-        // Multi-body STL files are supported only in ASCII mode                        //
-        // ====================================================================== //
-        if (isBinary) {
-            break;
-        }
     }
 
     // ====================================================================== //
@@ -356,6 +372,158 @@ unsigned short SurfUnstructured::importSTL(const string &stl_name, const bool &i
     return 0;
 }
 
+namespace {
+
+/*!
+ * Hash for the single precision coordinates of a binary STL vertex.
+ */
+struct BinarySTLVertexHash
+{
+    std::size_t operator()(const std::array<float, 3> &coords) const
+    {
+        std::size_t hash = 0;
+        for (int k = 0; k < 3; ++k) {
+            uint32_t bits;
+            std::memcpy(&bits, &coords[k], sizeof(bits));
+            hash ^= bits + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+        }
+
+        return hash;
+    }
+};
+
+}
+
+/*!
+ * Import the facets of a binary S.T.L. file.
+ *
+ * The file is memory-mapped and the 50-byte facet records are read in
+ * place into a single connectivity array. The vertex storage is then
+ * filled in one pass and the cells are created writing the connectivity
+ * directly into the storage of the cells. Facet normals are ignored.
+ *
+ * \param[in] stl_name name of stl file
+ * \param[in] PID is the PID assigned to the facets
+ * \param[in] weldVertices if set to true, facet vertices with the same
+ * coordinates are stored only once
+ *
+ * \result on output returns an error flag for I/O error
+*/
+unsigned short SurfUnstructured::importBinarySTL(const string &stl_name, int PID, bool weldVertices)
+{
+    // ====================================================================== //
+    // VARIABLES DECLARATION                                                  //
+    // ====================================================================== //
+
+    // Parameters
+    const std::size_t HEADER_SIZE = 80;
+    const std::size_t FACET_SIZE  = 50;
+
+    // ====================================================================== //
+    // MAP STL FILE                                                           //
+    // ====================================================================== //
+    MappedFile file(stl_name);
+    if (!file.isOpen() || file.size() < HEADER_SIZE + sizeof(uint32_t)) {
+        return 1;
+    }
+
+    const char *buffer = file.data();
+
+    uint32_t nFacets;
+    std::memcpy(&nFacets, buffer + HEADER_SIZE, sizeof(uint32_t));
+
+    const char *facets = buffer + HEADER_SIZE + sizeof(uint32_t);
+    if (file.size() < HEADER_SIZE + sizeof(uint32_t) + FACET_SIZE * nFacets) {
+        return 1;
+    }
+
+    // ====================================================================== //
+    // READ FACETS                                                            //
+    // ====================================================================== //
+
+    // In a closed triangulation there are about half as many vertices as
+    // facets.
+    std::size_t nExpectedVertices = weldVertices ? (nFacets / 2 + 3) : (3 * (std::size_t) nFacets);
+
+    std::vector<std::array<float, 3>> vertexList;
+    vertexList.reserve(nExpectedVertices);
+
+    std::vector<long> connectivity(3 * (std::size_t) nFacets);
+
+    std::unordered_map<std::array<float, 3>, long, BinarySTLVertexHash> vertexMap;
+    if (weldVertices) {
+        vertexMap.reserve(nExpectedVertices);
+    }
+
+    std::array<float, 12> record;
+    std::array<float, 3> facetVertex;
+    for (uint32_t i = 0; i < nFacets; ++i) {
+        // Records are not aligned, normal and vertices are copied out
+        std::memcpy(record.data(), facets + FACET_SIZE * i, sizeof(record));
+
+        for (int j = 0; j < 3; ++j) {
+            // Adding zero turns negative zeros into positive ones
+            for (int k = 0; k < 3; ++k) {
+                facetVertex[k] = record[3 + 3 * j + k] + 0.f;
+            }
+
+            long &vertex = connectivity[3 * (std::size_t) i + j];
+            if (weldVertices) {
+                auto vertexItr = vertexMap.find(facetVertex);
+                if (vertexItr != vertexMap.end()) {
+                    vertex = vertexItr->second;
+                    continue;
+                }
+
+                vertexMap.insert({facetVertex, (long) vertexList.size()});
+            }
+
+            vertex = vertexList.size();
+            vertexList.push_back(facetVertex);
+        }
+    }
+
+    // ====================================================================== //
+    // ADD VERTICES TO MESH                                                   //
+    // ====================================================================== //
+    std::size_t nVertices = vertexList.size();
+
+    reserveVertices(getVertexCount() + nVertices);
+
+    std::vector<long> vertexIds(nVertices);
+    std::array<double, 3> coords;
+    for (std::size_t n = 0; n < nVertices; ++n) {
+        for (int k = 0; k < 3; ++k) {
+            coords[k] = vertexList[n][k];
+        }
+
+        vertexIds[n] = addVertex(coords)->getId();
+    }
+
+    // ====================================================================== //
+    // ADD CELLS TO MESH                                                      //
+    // ====================================================================== //
+
+    // Cells allocate their own connectivity when they are created, the
+    // ids of the vertices are written directly into it.
+    reserveCells(m_nInternals + m_nGhosts + nFacets);
+
+    const long *facetConnect = connectivity.data();
+    for (uint32_t i = 0; i < nFacets; ++i) {
+        CellIterator cellIterator = addCell(ElementInfo::TRIANGLE, true);
+
+        long *cellConnect = cellIterator->getConnect();
+        for (int j = 0; j < 3; ++j) {
+            cellConnect[j] = vertexIds[facetConnect[j]];
+        }
+        facetConnect += 3;
+
+        cellIterator->setPID(PID);
+    }
+
+    return 0;
+}
+
 //TODO: normals??
 //TODO: error flag on output
 //TODO: conversion of quad into tria
@@ -51,7 +51,7 @@ public:
         void extractEdgeNetwork(SurfUnstructured &);
 
         // I/O routines
-        unsigned short importSTL(const std::string &, const bool &, int PIDOffset = 0);
+        unsigned short importSTL(const std::string &, const bool &, int PIDOffset = 0, bool weldVertices = false);
         unsigned short exportSTL(const std::string &, const bool &, bool flag = true);
         unsigned short importDGF(const std::string &);
         unsigned short exportDGF(const std::string &);
@@ -63,6 +63,7 @@ protected:
 	bool _enableCellBalancing(const long &id, bool enabled);
 
 private:
+	unsigned short importBinarySTL(const std::string &, int PID, bool weldVertices);
 
 };
 
@@ -50,6 +50,11 @@ namespace bitpit {
 	\brief The VolOctree defines a Octree patch.
 
 	VolOctree defines a Octree patch.
+
+	When the patch is partitioned, its ghosts are the ghost octants of the
+	underlying tree. The halo is made by layers of cells that share a vertex
+	with the internal cells, the number of layers can be changed and the
+	tree will provide the corresponding layers of ghost octants.
 */
 
 /*!
@@ -459,7 +464,7 @@ const std::vector<adaption::Info> VolOctree::sync(bool trackChanges)
 		std::vector<uint32_t> mapper_octantMap;
 		std::vector<bool> mapper_ghostFlag;
 		std::vector<int> mapper_octantRank;
-		if (!importAll) {
+		if (!importAll && lastTreeOperation != OP_HALO_UPDATE) {
 			m_tree.getMapping(treeId, mapper_octantMap, mapper_ghostFlag, mapper_octantRank);
 		}
 
@@ -630,7 +635,14 @@ const std::vector<adaption::Info> VolOctree::sync(bool trackChanges)
 
 #if BITPIT_ENABLE_MPI==1
 	// Cells that have been send to other processors need to be removed
-	std::unordered_map<int, std::array<uint32_t, 4>> sendOctants = m_tree.getSentIdx();
+	//
+	// Updating the halo only changes the ghosts, the octants sent during the
+	// last load balance have already been removed.
+	std::unordered_map<int, std::array<uint32_t, 4>> sendOctants;
+	if (lastTreeOperation != OP_HALO_UPDATE) {
+		sendOctants = m_tree.getSentIdx();
+	}
+
 	for (const auto &rankEntry : sendOctants) {
 		int rank = rankEntry.first;
 
@@ -1558,6 +1570,29 @@ void VolOctree::_resetTol()
 	VolumeKernel::_setTol(tolerance);
 }
 
+/*!
+	Adds to the specified memory usage the memory used by the octree and
+	by the maps between cells and octants.
+
+	\param usage is the memory usage of the patch
+*/
+void VolOctree::_evalMemoryUsage(MemoryUsage &usage) const
+{
+	usage.addComponent("octree", m_tree.getMemoryUsage());
+
+	std::size_t mapBytes = utils::evalMemorySize(m_cellToOctant);
+	mapBytes += utils::evalMemorySize(m_cellToGhost);
+	mapBytes += utils::evalMemorySize(m_octantToCell);
+	mapBytes += utils::evalMemorySize(m_ghostToCell);
+	usage.addComponent("octant maps", mapBytes);
+
+	std::size_t geometryBytes = utils::evalMemorySize(m_tree_dh);
+	geometryBytes += utils::evalMemorySize(m_tree_area);
+	geometryBytes += utils::evalMemorySize(m_tree_volume);
+	geometryBytes += utils::evalMemorySize(m_normals);
+	usage.addComponent("octree geometry", geometryBytes);
+}
+
 /*!
 	Translates the patch.
 
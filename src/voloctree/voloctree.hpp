@@ -114,8 +114,11 @@ protected:
 	std::vector<long> _findCellEdgeNeighs(const long &id, const int &edge, const std::vector<long> &blackList = std::vector<long>()) const;
 	std::vector<long> _findCellVertexNeighs(const long &id, const int &vertex, const std::vector<long> &blackList = std::vector<long>()) const;
 
+	void _evalMemoryUsage(MemoryUsage &usage) const;
+
 #if BITPIT_ENABLE_MPI==1
 	const std::vector<adaption::Info> _balancePartition(bool trackChanges);
+	bool _setHaloSize(std::size_t haloSize, HaloConnectivity connectivity);
 #endif
 
 private:
@@ -125,7 +128,8 @@ private:
 		OP_INITIALIZATION,
 		OP_ADAPTION_MAPPED,
 		OP_ADAPTION_UNMAPPED,
-		OP_LOAD_BALANCE
+		OP_LOAD_BALANCE,
+		OP_HALO_UPDATE
 	};
 
 	struct RenumberInfo {
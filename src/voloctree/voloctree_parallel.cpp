@@ -71,6 +71,34 @@ const std::vector<adaption::Info> VolOctree::_balancePartition(bool trackChanges
 	return sync(trackChanges);
 }
 
+/*!
+	Sets the size of the halo.
+
+	The ghosts of the patch are the ghost octants of the tree, hence only
+	halos made by vertex neighbours are supported. If the patch is already
+	partitioned, the tree builds the requested layers of ghost octants and
+	the ghosts of the patch are updated accordingly.
+
+	\param haloSize is the number of layers of ghost cells
+	\param connectivity is the connectivity used to define the layers
+	\result Returns true if the halo has been changed, false if the
+	requested halo is not supported.
+*/
+bool VolOctree::_setHaloSize(std::size_t haloSize, HaloConnectivity connectivity)
+{
+	if (connectivity != HALO_VERTEX) {
+		return false;
+	}
+
+	m_tree.setNofGhostLayers(haloSize);
+	if (m_tree.getParallel()) {
+		m_lastTreeOperation = OP_HALO_UPDATE;
+		sync(false);
+	}
+
+	return true;
+}
+
 /*!
 	@}
 */
@@ -0,0 +1,272 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <array>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+#include "bitpit_common.hpp"
+#include "bitpit_operators.hpp"
+#include "bitpit_CG.hpp"
+
+using namespace bitpit;
+
+/*!
+ * Generates a random cloud of points around the unit box.
+ *
+ * \param N is the number of points
+ * \param x are the x coordinates of the points
+ * \param y are the y coordinates of the points
+ * \param z are the z coordinates of the points
+ */
+void generateCloud(int N, std::vector<double> &x, std::vector<double> &y, std::vector<double> &z)
+{
+	std::mt19937 generator(1);
+	std::uniform_real_distribution<double> distribution(-1., 2.);
+
+	x.resize(N);
+	y.resize(N);
+	z.resize(N);
+	for (int i = 0; i < N; ++i) {
+		x[i] = distribution(generator);
+		y[i] = distribution(generator);
+		z[i] = distribution(generator);
+	}
+}
+
+/*!
+ * Subtest 001
+ *
+ * Checks the batched point-triangle distance against the point-wise
+ * implementation and against the distances from the edges.
+ */
+int subtest_001()
+{
+	std::cout << "Checking batched point-triangle distance" << std::endl;
+
+	const int N = 10001;
+	const double tolerance = 1.e-12;
+
+	std::vector<double> x, y, z;
+	generateCloud(N, x, y, z);
+
+	std::vector<double> d(N), xPx(N), xPy(N), xPz(N);
+	std::vector<int> flag(N);
+
+	// Acute triangle, the point-wise implementation is exact
+	std::array<double,3> Q1 = {{0.1, 0.2, 0.3}};
+	std::array<double,3> Q2 = {{0.9, 0.1, 0.4}};
+	std::array<double,3> Q3 = {{0.4, 0.8, 0.6}};
+
+	CGElem::distanceCloudTriangle(N, x.data(), y.data(), z.data(), Q1, Q2, Q3, d.data(), xPx.data(), xPy.data(), xPz.data(), flag.data());
+
+	for (int i = 0; i < N; ++i) {
+		std::array<double,3> P = {{x[i], y[i], z[i]}};
+		std::array<double,3> xP;
+		int expectedFlag;
+		double expected = CGElem::distancePointTriangle(P, Q1, Q2, Q3, xP, expectedFlag);
+
+		std::array<double,3> closest = {{xPx[i], xPy[i], xPz[i]}};
+		if (std::abs(d[i] - expected) > tolerance || norm2(closest - xP) > tolerance || flag[i] != expectedFlag) {
+			std::cout << " Point " << i << ": distance " << d[i] << " expected " << expected;
+			std::cout << ", flag " << flag[i] << " expected " << expectedFlag << std::endl;
+			return 1;
+		}
+	}
+
+	// Obtuse triangle, the distance is checked against the distance from the edges
+	Q1 = {{0.0, 0.0, 0.0}};
+	Q2 = {{1.0, 0.0, 0.0}};
+	Q3 = {{0.5, 0.1, 0.2}};
+
+	CGElem::distanceCloudTriangle(N, x.data(), y.data(), z.data(), Q1, Q2, Q3, d.data(), nullptr, nullptr, nullptr, flag.data());
+
+	std::array<std::array<double,3>,3> V = {{Q1, Q2, Q3}};
+	for (int i = 0; i < N; ++i) {
+		std::array<double,3> P = {{x[i], y[i], z[i]}};
+		std::array<double,3> xP;
+		int segmentFlag;
+
+		double edgeDistance = std::numeric_limits<double>::max();
+		for (int k = 0; k < 3; ++k) {
+			edgeDistance = std::min(edgeDistance, CGElem::distancePointSegment(P, V[k], V[(k + 1) % 3], xP, segmentFlag));
+		}
+
+		if (d[i] > edgeDistance + tolerance || (flag[i] != 0 && std::abs(d[i] - edgeDistance) > tolerance)) {
+			std::cout << " Point " << i << ": distance " << d[i] << " edge distance " << edgeDistance;
+			std::cout << ", flag " << flag[i] << std::endl;
+			return 2;
+		}
+	}
+
+	return 0;
+}
+
+/*!
+ * Subtest 002
+ *
+ * Measures the time needed to evaluate the distance of a point cloud from a
+ * triangle using the point-wise implementation, the cloud implementation and
+ * the batched implementation.
+ */
+int subtest_002()
+{
+	std::cout << "Benchmarking point-triangle distance" << std::endl;
+
+	const int N = 200000;
+	const int nRepetitions = 10;
+
+	std::vector<double> x, y, z;
+	generateCloud(N, x, y, z);
+
+	std::vector<std::array<double,3>> cloud(N);
+	for (int i = 0; i < N; ++i) {
+		cloud[i] = {{x[i], y[i], z[i]}};
+	}
+
+	std::array<double,3> Q1 = {{0.1, 0.2, 0.3}};
+	std::array<double,3> Q2 = {{0.9, 0.1, 0.4}};
+	std::array<double,3> Q3 = {{0.4, 0.8, 0.6}};
+
+	double checksum[3] = {0., 0., 0.};
+	std::chrono::duration<double, std::milli> elapsed[3];
+
+	// Point-wise implementation
+	std::chrono::time_point<std::chrono::system_clock> start = std::chrono::system_clock::now();
+	for (int n = 0; n < nRepetitions; ++n) {
+		std::array<double,3> xP;
+		int flag;
+		for (int i = 0; i < N; ++i) {
+			checksum[0] += CGElem::distancePointTriangle(cloud[i], Q1, Q2, Q3, xP, flag);
+		}
+	}
+	elapsed[0] = std::chrono::system_clock::now() - start;
+
+	// Cloud implementation
+	start = std::chrono::system_clock::now();
+	for (int n = 0; n < nRepetitions; ++n) {
+		std::vector<std::array<double,3>> xP;
+		std::vector<int> flag;
+		std::vector<double> d = CGElem::distanceCloudTriangle(cloud, Q1, Q2, Q3, xP, flag);
+		for (int i = 0; i < N; ++i) {
+			checksum[1] += d[i];
+		}
+	}
+	elapsed[1] = std::chrono::system_clock::now() - start;
+
+	// Batched implementation
+	std::vector<double> d(N), xPx(N), xPy(N), xPz(N);
+	std::vector<int> flag(N);
+
+	start = std::chrono::system_clock::now();
+	for (int n = 0; n < nRepetitions; ++n) {
+		CGElem::distanceCloudTriangle(N, x.data(), y.data(), z.data(), Q1, Q2, Q3, d.data(), xPx.data(), xPy.data(), xPz.data(), flag.data());
+		for (int i = 0; i < N; ++i) {
+			checksum[2] += d[i];
+		}
+	}
+	elapsed[2] = std::chrono::system_clock::now() - start;
+
+	std::cout << " Point-wise : " << elapsed[0].count() << " ms" << std::endl;
+	std::cout << " Cloud      : " << elapsed[1].count() << " ms" << std::endl;
+	std::cout << " Batched    : " << elapsed[2].count() << " ms" << std::endl;
+
+	for (int k = 1; k < 3; ++k) {
+		if (std::abs(checksum[k] - checksum[0]) > 1.e-8 * checksum[0]) {
+			std::cout << " Checksum mismatch " << checksum[k] << " " << checksum[0] << std::endl;
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/*!
+ * Subtest 003
+ *
+ * Checks the vector implementation of the batched point-triangle distance
+ * against the scalar one. Points are processed with the widest pack that
+ * fits in the batch and the remaining ones with the scalar pack, hence the
+ * points evaluated one at a time use the scalar pack. When the library is
+ * compiled without vector instructions both evaluations are scalar.
+ */
+int subtest_003()
+{
+	std::cout << "Checking vector and scalar point-triangle distance" << std::endl;
+
+	const int N = 1003;
+
+	std::vector<double> x, y, z;
+	generateCloud(N, x, y, z);
+
+	std::array<double,3> Q1 = {{0.1, 0.2, 0.3}};
+	std::array<double,3> Q2 = {{0.9, 0.1, 0.4}};
+	std::array<double,3> Q3 = {{0.4, 0.8, 0.6}};
+
+	std::vector<double> d(N), xPx(N), xPy(N), xPz(N);
+	std::vector<int> flag(N);
+	CGElem::distanceCloudTriangle(N, x.data(), y.data(), z.data(), Q1, Q2, Q3, d.data(), xPx.data(), xPy.data(), xPz.data(), flag.data());
+
+	for (int i = 0; i < N; ++i) {
+		double scalarD, scalarXPx, scalarXPy, scalarXPz;
+		int scalarFlag;
+		CGElem::distanceCloudTriangle(1, &x[i], &y[i], &z[i], Q1, Q2, Q3, &scalarD, &scalarXPx, &scalarXPy, &scalarXPz, &scalarFlag);
+
+		if (d[i] != scalarD || xPx[i] != scalarXPx || xPy[i] != scalarXPy || xPz[i] != scalarXPz || flag[i] != scalarFlag) {
+			std::cout << " Point " << i << ": distance " << d[i] << " scalar " << scalarD;
+			std::cout << ", flag " << flag[i] << " scalar " << scalarFlag << std::endl;
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	BITPIT_UNUSED(argc);
+	BITPIT_UNUSED(argv);
+
+	int status = subtest_001();
+	if (status != 0) {
+		return (10 + status);
+	}
+
+	status = subtest_002();
+	if (status != 0) {
+		return (20 + status);
+	}
+
+	status = subtest_003();
+	if (status != 0) {
+		return (30 + status);
+	}
+
+	return 0;
+}
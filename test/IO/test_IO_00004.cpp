@@ -0,0 +1,215 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "bitpit_IO.hpp"
+
+using namespace std;
+using namespace bitpit;
+
+/*!
+ * Pseudo-random coordinate
+ * @param[in]   n   index of the value
+ * @return coordinate
+ */
+double evalCoordinate( long n ){
+
+    double t = std::sin( 12.9898 * ( n + 1 ) ) * 43758.5453 ;
+
+    return 200. * ( t - std::floor( t ) ) - 100. ;
+
+}
+
+/*!
+ * Writes an ASCII STL file with two solids. Numbers are written in
+ * different formats to exercise the parser.
+ * @param[in]   name        name of the file
+ * @param[in]   nFacets     number of facets of each solid
+ */
+void writeSTL( const std::string &name, int nFacets ){
+
+    std::ofstream file( name ) ;
+
+    long n = 0 ;
+    for( int solid = 0; solid < 2; ++solid ){
+        file << "solid body" << solid << "\n" ;
+        for( int i = 0; i < nFacets; ++i ){
+            if( i % 3 == 0 ) file << std::scientific << std::setprecision( 9 ) ;
+            else if( i % 3 == 1 ) file << std::fixed << std::setprecision( 6 ) ;
+            else file << std::defaultfloat << std::setprecision( 17 ) ;
+
+            double nx = evalCoordinate( n++ ) ;
+            double ny = evalCoordinate( n++ ) ;
+            file << "  facet normal " << nx << " " << ny << " 0\n" ;
+            file << "    outer loop\n" ;
+            for( int k = 0; k < 3; ++k ){
+                double x = evalCoordinate( n++ ) ;
+                double y = evalCoordinate( n++ ) ;
+                double z = evalCoordinate( n++ ) ;
+                file << "      vertex\t" << x << " " << y << "   " << z << "\r\n" ;
+            }
+            file << "    endloop\n" ;
+            file << "  endfacet\n" ;
+        }
+        file << "endsolid body" << solid << "\n" ;
+    }
+
+}
+
+/*!
+ * Writes a DGF file.
+ * @param[in]   name        name of the file
+ * @param[in]   nVertices   number of vertices
+ */
+void writeDGF( const std::string &name, int nVertices ){
+
+    std::ofstream file( name ) ;
+    file << std::setprecision( 15 ) ;
+
+    file << "DGF\n" ;
+    file << "VERTEX\n" ;
+    for( int i = 0; i < nVertices; ++i ){
+        file << evalCoordinate( 3 * i ) << " " << evalCoordinate( 3 * i + 1 ) << " " << evalCoordinate( 3 * i + 2 ) << "\n" ;
+        if( i % 1000 == 0 ) file << "\n" ;
+    }
+    file << "#\n" ;
+    file << "SIMPLEX\n" ;
+    for( int i = 0; i + 2 < nVertices; ++i ){
+        file << i << " " << i + 1 << " " << i + 2 << "\n" ;
+    }
+    file << "#\n" ;
+
+}
+
+/*!
+ * Loads STL and DGF files with the buffered parser and with the stream
+ * parser, checking that the results are the same and comparing the times.
+ */
+int main()
+{
+
+    const int N_FACETS   = 50000 ;
+    const int N_VERTICES = 100000 ;
+
+    std::chrono::time_point<std::chrono::system_clock> start, end ;
+
+    // STL file with all the solids
+    writeSTL( "test_IO_00004.stl", N_FACETS ) ;
+
+    int nV = 0, nT = 0 ;
+    std::vector<std::array<double,3>> V, N ;
+    std::vector<std::vector<int>> T ;
+
+    STLObj stl( "test_IO_00004.stl", false ) ;
+    start = std::chrono::system_clock::now() ;
+    stl.load( nV, nT, V, N, T ) ;
+    end = std::chrono::system_clock::now() ;
+    std::cout << " STL load, buffered parser : " << std::chrono::duration<double>( end - start ).count() << " s" << std::endl ;
+
+    int nStreamV = 0, nStreamT = 0 ;
+    std::vector<std::array<double,3>> streamV, streamN ;
+    std::vector<std::vector<int>> streamT ;
+
+    std::ifstream streamFile( "test_IO_00004.stl", std::ifstream::in | std::ifstream::binary ) ;
+    start = std::chrono::system_clock::now() ;
+    stl::readASCII( streamFile, nStreamV, nStreamT, streamV, streamN, streamT ) ;
+    end = std::chrono::system_clock::now() ;
+    streamFile.close() ;
+    std::cout << " STL load, stream parser   : " << std::chrono::duration<double>( end - start ).count() << " s" << std::endl ;
+
+    if( nT != 2 * N_FACETS || nV != 6 * N_FACETS ) return 1 ;
+    if( nT != nStreamT || nV != nStreamV ) return 1 ;
+    if( V != streamV || N != streamN || T != streamT ) return 2 ;
+
+    // Each facet is written with eleven values, two for the normal and nine
+    // for the vertices; the coarsest format has six decimal digits.
+    for( int i = 0; i < nT; ++i ){
+        for( int k = 0; k < 3; ++k ){
+            for( int d = 0; d < 3; ++d ){
+                double expected = evalCoordinate( 11 * (long) i + 2 + 3 * k + d ) ;
+                if( std::abs( V[3 * i + k][d] - expected ) > 1.e-6 ) return 2 ;
+            }
+        }
+    }
+
+    // STL file read solid by solid
+    std::vector<std::vector<double>> solidV, solidN ;
+    std::vector<std::vector<int>> solidT ;
+
+    stl.open( "in" ) ;
+    for( int solid = 0; solid < 3; ++solid ){
+        int nSolidV = 0, nSolidT = 0 ;
+        stl.loadSolid( nSolidV, nSolidT, solidV, solidN, solidT ) ;
+        if( solid == 2 ){
+            if( nSolidT != 0 ) return 3 ;
+            break ;
+        }
+
+        if( nSolidT != N_FACETS ) return 3 ;
+        for( int i = 0; i < nSolidV; ++i ){
+            for( int k = 0; k < 3; ++k ){
+                if( solidV[i][k] != V[solid * 3 * N_FACETS + i][k] ) return 3 ;
+            }
+        }
+    }
+    stl.close( "in" ) ;
+
+    // DGF file
+    writeDGF( "test_IO_00004.dgf", N_VERTICES ) ;
+
+    int nDGFV = 0, nDGFS = 0 ;
+    std::vector<std::array<double,3>> dgfV ;
+    std::vector<std::vector<int>> dgfS ;
+
+    DGFObj dgf( "test_IO_00004.dgf" ) ;
+    start = std::chrono::system_clock::now() ;
+    dgf.load( nDGFV, nDGFS, dgfV, dgfS ) ;
+    end = std::chrono::system_clock::now() ;
+    std::cout << " DGF load, buffered parser : " << std::chrono::duration<double>( end - start ).count() << " s" << std::endl ;
+
+    int nStreamDGFV = 0, nStreamDGFS = 0 ;
+    std::vector<std::array<double,3>> streamDGFV ;
+    std::vector<std::vector<int>> streamDGFS ;
+
+    std::ifstream dgfFile( "test_IO_00004.dgf" ) ;
+    start = std::chrono::system_clock::now() ;
+    dgf::readMesh( dgfFile, nStreamDGFV, nStreamDGFS, streamDGFV, streamDGFS ) ;
+    end = std::chrono::system_clock::now() ;
+    dgfFile.close() ;
+    std::cout << " DGF load, stream parser   : " << std::chrono::duration<double>( end - start ).count() << " s" << std::endl ;
+
+    if( nDGFV != N_VERTICES || nDGFS != N_VERTICES - 2 ) return 4 ;
+    if( nDGFV != nStreamDGFV || nDGFS != nStreamDGFS ) return 4 ;
+    if( dgfV != streamDGFV || dgfS != streamDGFS ) return 5 ;
+
+    return 0 ;
+
+}
@@ -0,0 +1,213 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "bitpit_RBF.hpp"
+
+using namespace std;
+using namespace bitpit;
+
+/*!
+ * Wendland C2 function wrapped into a user-defined function, the RBF class
+ * doesn't know about its compact support and solves the dense system.
+ */
+double userWendland( const double &dist ){
+    return rbf::wendlandc2( dist ) ;
+}
+
+/*!
+ * Creates a jittered lattice of nodes in the unit cube.
+ * @param[in] n number of nodes along each direction
+ * @return node coordinates
+ */
+std::vector<std::array<double,3>> createNodes( int n ){
+
+    std::vector<std::array<double,3>> nodes ;
+    nodes.reserve( n * n * n ) ;
+
+    double h = 1. / n ;
+    for( int k = 0; k < n; ++k ){
+        for( int j = 0; j < n; ++j ){
+            for( int i = 0; i < n; ++i ){
+                int index = i + n * ( j + n * k ) ;
+                std::array<double,3> node ;
+                node[0] = ( i + 0.5 + 0.3 * std::sin( 1.7 * index ) ) * h ;
+                node[1] = ( j + 0.5 + 0.3 * std::sin( 2.3 * index ) ) * h ;
+                node[2] = ( k + 0.5 + 0.3 * std::sin( 3.1 * index ) ) * h ;
+                nodes.push_back( node ) ;
+            }
+        }
+    }
+
+    return nodes ;
+}
+
+/*!
+ * Evaluates the field to be interpolated
+ * @param[in] nodes node coordinates
+ * @param[in] component field component
+ * @return field values at nodes
+ */
+std::vector<double> createField( const std::vector<std::array<double,3>> &nodes, int component ){
+
+    std::vector<double> field ;
+    field.reserve( nodes.size() ) ;
+    for( const auto &node : nodes ){
+        field.push_back( std::sin( 3. * node[component] ) * std::cos( 2. * node[( component + 1 ) % 3] ) ) ;
+    }
+
+    return field ;
+}
+
+/*!
+ * Sets up a RBF interpolating two fields on the given nodes
+ * @param[in] rbf RBF object
+ * @param[in] nodes node coordinates
+ * @param[in] radius support radius
+ */
+void setup( RBF &rbf, const std::vector<std::array<double,3>> &nodes, double radius ){
+
+    rbf.setSupportRadius( radius ) ;
+    rbf.addNode( nodes ) ;
+    rbf.addData( createField( nodes, 0 ) ) ;
+    rbf.addData( createField( nodes, 1 ) ) ;
+}
+
+/*!
+ * Evaluates the maximum interpolation error on the RBF nodes
+ * @param[in] rbf RBF object
+ * @param[in] nodes node coordinates
+ * @return maximum interpolation error
+ */
+double evalNodeError( RBF &rbf, const std::vector<std::array<double,3>> &nodes ){
+
+    std::vector<double> field0 = createField( nodes, 0 ) ;
+    std::vector<double> field1 = createField( nodes, 1 ) ;
+
+    std::vector<double> values( 2 * nodes.size() ) ;
+    rbf.evalRBF( nodes.size(), nodes.data(), values.data() ) ;
+
+    double error = 0. ;
+    for( std::size_t n = 0; n < nodes.size(); ++n ){
+        error = std::max( error, std::abs( values[2 * n] - field0[n] ) ) ;
+        error = std::max( error, std::abs( values[2 * n + 1] - field1[n] ) ) ;
+    }
+
+    return error ;
+}
+
+/*!
+ * Compares the sparse and the dense solution of the interpolation system
+ * on a small set of nodes, then solves a larger sparse system.
+ */
+int main()
+{
+
+    // Sparse and dense solution of the same system
+    {
+        std::vector<std::array<double,3>> nodes = createNodes( 10 ) ;
+        double radius = 0.35 ;
+
+        RBF sparseRBF ;
+        setup( sparseRBF, nodes, radius ) ;
+
+        RBF denseRBF ;
+        denseRBF.setFunction( userWendland ) ;
+        setup( denseRBF, nodes, radius ) ;
+
+        if( sparseRBF.solve() != 0 ) return 1 ;
+        if( denseRBF.solve() != 0 ) return 1 ;
+
+        double difference = 0. ;
+        for( std::size_t n = 0; n < nodes.size(); ++n ){
+            std::vector<double> sparseValues = sparseRBF.evalRBF( nodes[n] ) ;
+            std::vector<double> denseValues  = denseRBF.evalRBF( nodes[n] ) ;
+            for( int j = 0; j < 2; ++j ){
+                difference = std::max( difference, std::abs( sparseValues[j] - denseValues[j] ) ) ;
+            }
+        }
+
+        double sparseError = evalNodeError( sparseRBF, nodes ) ;
+        double denseError  = evalNodeError( denseRBF, nodes ) ;
+
+        std::cout << " Nodes                      : " << nodes.size() << std::endl ;
+        std::cout << " Sparse interpolation error : " << sparseError << std::endl ;
+        std::cout << " Dense interpolation error  : " << denseError << std::endl ;
+        std::cout << " Sparse/dense difference    : " << difference << std::endl ;
+
+        if( sparseError > 1.e-8 || denseError > 1.e-8 || difference > 1.e-8 ) return 1 ;
+    }
+
+    // Large sparse system
+    {
+        std::vector<std::array<double,3>> nodes = createNodes( 20 ) ;
+        double radius = 0.15 ;
+
+        RBF rbf ;
+        setup( rbf, nodes, radius ) ;
+
+        std::chrono::time_point<std::chrono::system_clock> start = std::chrono::system_clock::now() ;
+        if( rbf.solve() != 0 ) return 1 ;
+        std::chrono::time_point<std::chrono::system_clock> end = std::chrono::system_clock::now() ;
+        int elapsed = std::chrono::duration_cast<std::chrono::milliseconds>( end - start ).count() ;
+
+        double error = evalNodeError( rbf, nodes ) ;
+
+        std::cout << " Nodes                      : " << nodes.size() << std::endl ;
+        std::cout << " Sparse solution time (ms)  : " << elapsed << std::endl ;
+        std::cout << " Sparse interpolation error : " << error << std::endl ;
+
+        if( error > 1.e-8 ) return 1 ;
+    }
+
+    // Radii that are not positive are rejected, a single node gives a grid
+    // with no extent
+    {
+        std::vector<std::array<double,3>> nodes( 1, {{0.5, 0.5, 0.5}} ) ;
+        double radius = 0.25 ;
+
+        RBF rbf ;
+        setup( rbf, nodes, radius ) ;
+
+        rbf.setSupportRadius( 0. ) ;
+        rbf.setSupportRadius( -1. ) ;
+        if( rbf.getSupportRadius() != radius ) return 1 ;
+
+        if( rbf.solve() != 0 ) return 1 ;
+
+        double error = evalNodeError( rbf, nodes ) ;
+
+        std::cout << " Single node interpolation error : " << error << std::endl ;
+
+        if( error > 1.e-8 ) return 1 ;
+    }
+
+    return 0 ;
+}
@@ -0,0 +1,172 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "bitpit_common.hpp"
+#include "bitpit_RBF.hpp"
+
+using namespace std;
+using namespace bitpit;
+
+/*!
+ * Wendland C2 function wrapped into a user-defined function, the RBF class
+ * doesn't know about its compact support and visits all the nodes.
+ */
+double userWendland( const double &dist ){
+    return rbf::wendlandc2( dist ) ;
+}
+
+/*!
+ * Creates a pseudo-random cloud of points
+ * @param[in] nPoints number of points
+ * @param[in] seed seed of the sequence
+ * @param[in] lower lower bound of the coordinates
+ * @param[in] upper upper bound of the coordinates
+ * @return point coordinates
+ */
+std::vector<std::array<double,3>> createPoints( int nPoints, double seed, double lower, double upper ){
+
+    std::vector<std::array<double,3>> points( nPoints ) ;
+    for( int n = 0; n < nPoints; ++n ){
+        for( int d = 0; d < 3; ++d ){
+            double t = std::sin( seed * ( n + 1 ) + 1.3 * d ) * 43758.5453 ;
+            t -= std::floor( t ) ;
+            points[n][d] = lower + t * ( upper - lower ) ;
+        }
+    }
+
+    return points ;
+}
+
+/*!
+ * Compares the batched evaluation of a RBF with the evaluation point by point
+ * @param[in] rbf RBF object
+ * @param[in] points query points
+ * @return 0 if the evaluations match, 1 otherwise
+ */
+int compareEvaluations( RBF &rbf, const std::vector<std::array<double,3>> &points ){
+
+    int nFields = rbf.getDataCount() ;
+    std::size_t nValues = points.size() * nFields ;
+
+    std::chrono::time_point<std::chrono::system_clock> start, end ;
+
+    start = std::chrono::system_clock::now() ;
+    std::vector<double> pointValues ;
+    pointValues.reserve( nValues ) ;
+    for( const auto &point : points ){
+        std::vector<double> values = rbf.evalRBF( point ) ;
+        pointValues.insert( pointValues.end(), values.begin(), values.end() ) ;
+    }
+    end = std::chrono::system_clock::now() ;
+    int pointElapsed = std::chrono::duration_cast<std::chrono::milliseconds>( end - start ).count() ;
+
+    threads::setThreadCount( 1 ) ;
+    start = std::chrono::system_clock::now() ;
+    std::vector<double> serialValues( nValues ) ;
+    rbf.evalRBF( points.size(), points.data(), serialValues.data() ) ;
+    end = std::chrono::system_clock::now() ;
+    int serialElapsed = std::chrono::duration_cast<std::chrono::milliseconds>( end - start ).count() ;
+
+    threads::setThreadCount( 4 ) ;
+    start = std::chrono::system_clock::now() ;
+    std::vector<double> threadedValues( nValues ) ;
+    rbf.evalRBF( points.size(), points.data(), threadedValues.data() ) ;
+    end = std::chrono::system_clock::now() ;
+    int threadedElapsed = std::chrono::duration_cast<std::chrono::milliseconds>( end - start ).count() ;
+
+    double difference = 0. ;
+    for( std::size_t k = 0; k < nValues; ++k ){
+        difference = std::max( difference, std::abs( serialValues[k] - pointValues[k] ) ) ;
+    }
+
+    std::cout << " Point-wise evaluation (ms)       : " << pointElapsed << std::endl ;
+    std::cout << " Batched evaluation (ms)          : " << serialElapsed << std::endl ;
+    std::cout << " Batched evaluation, 4 threads    : " << threadedElapsed << std::endl ;
+    std::cout << " Batched/point-wise difference    : " << difference << std::endl ;
+
+    if( difference > 1.e-12 ) return 1 ;
+    if( threadedValues != serialValues ) return 1 ;
+
+    return 0 ;
+}
+
+/*!
+ * Compares the batched evaluation of parameterization RBFs with the
+ * evaluation point by point.
+ */
+int main()
+{
+
+    std::vector<std::array<double,3>> nodes  = createPoints( 2000, 12.9898, 0., 1. ) ;
+    std::vector<std::array<double,3>> points = createPoints( 5000, 78.233, -0.2, 1.2 ) ;
+
+    std::vector<std::vector<double>> weights( 3 ) ;
+    for( int j = 0; j < 3; ++j ){
+        for( const auto &node : nodes ){
+            weights[j].push_back( std::cos( ( j + 1 ) * node[0] ) + node[1] * node[2] ) ;
+        }
+    }
+
+    // Compact support basis
+    {
+        RBF rbf ;
+        rbf.setMode( RBFMode::PARAM ) ;
+        rbf.setSupportRadius( 0.15 ) ;
+        rbf.addNode( nodes ) ;
+        for( int j = 0; j < 3; ++j ){
+            rbf.addData( weights[j] ) ;
+        }
+
+        for( int n = 0; n < 2000; n += 7 ){
+            rbf.deactivateNode( n ) ;
+        }
+
+        std::cout << " Compact support basis" << std::endl ;
+        if( compareEvaluations( rbf, points ) != 0 ) return 1 ;
+    }
+
+    // User-defined basis
+    {
+        RBF rbf ;
+        rbf.setMode( RBFMode::PARAM ) ;
+        rbf.setFunction( userWendland ) ;
+        rbf.setSupportRadius( 0.15 ) ;
+        rbf.addNode( nodes ) ;
+        for( int j = 0; j < 3; ++j ){
+            rbf.addData( weights[j] ) ;
+        }
+
+        std::cout << " User-defined basis" << std::endl ;
+        if( compareEvaluations( rbf, points ) != 0 ) return 1 ;
+    }
+
+    return 0 ;
+}
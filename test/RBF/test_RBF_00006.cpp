@@ -0,0 +1,100 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "bitpit_RBF.hpp"
+
+using namespace std;
+using namespace bitpit;
+
+/*!
+ * Runs the greedy selection of the RBF nodes and checks that the requested
+ * tolerance is met by the interpolation.
+ * @param[in] nodes node coordinates
+ * @param[in] field field to be interpolated
+ * @param[in] tolerance tolerance of the greedy algorithm
+ * @param[in] batchSize number of nodes activated at each iteration
+ * @return 0 if the tolerance is met, 1 otherwise
+ */
+int runGreedy( const std::vector<std::array<double,3>> &nodes, const std::vector<double> &field, double tolerance, int batchSize ){
+
+    RBF rbf ;
+    rbf.setSupportRadius( 0.3 ) ;
+    rbf.addNode( nodes ) ;
+    rbf.addData( field ) ;
+
+    std::chrono::time_point<std::chrono::system_clock> start = std::chrono::system_clock::now() ;
+    int err = rbf.greedy( tolerance, batchSize ) ;
+    std::chrono::time_point<std::chrono::system_clock> end = std::chrono::system_clock::now() ;
+    int elapsed = std::chrono::duration_cast<std::chrono::milliseconds>( end - start ).count() ;
+    if( err != 0 ) return 1 ;
+
+    std::vector<double> values( nodes.size() ) ;
+    rbf.evalRBF( nodes.size(), nodes.data(), values.data() ) ;
+
+    double error = 0. ;
+    for( std::size_t n = 0; n < nodes.size(); ++n ){
+        error = std::max( error, std::abs( values[n] - field[n] ) ) ;
+    }
+
+    std::cout << " Batch size            : " << batchSize << std::endl ;
+    std::cout << " Active nodes          : " << rbf.getActiveCount() << " / " << nodes.size() << std::endl ;
+    std::cout << " Greedy time (ms)      : " << elapsed << std::endl ;
+    std::cout << " Interpolation error   : " << error << std::endl ;
+
+    if( error > 1.001 * tolerance ) return 1 ;
+
+    return 0 ;
+}
+
+/*!
+ * Greedy selection of RBF nodes activating one node or a batch of nodes
+ * at each iteration.
+ */
+int main()
+{
+
+    int n = 40 ;
+    std::vector<std::array<double,3>> nodes ;
+    std::vector<double> field ;
+    for( int j = 0; j < n; ++j ){
+        for( int i = 0; i < n; ++i ){
+            std::array<double,3> node = {{ ( i + 0.5 ) / n, ( j + 0.5 ) / n, 0. }} ;
+            nodes.push_back( node ) ;
+            field.push_back( std::exp( - 4. * ( node[0] * node[0] + node[1] ) ) * std::sin( 3. * node[0] ) ) ;
+        }
+    }
+
+    double tolerance = 1.e-4 ;
+    if( runGreedy( nodes, field, tolerance, 1 ) != 0 ) return 1 ;
+    if( runGreedy( nodes, field, tolerance, 10 ) != 0 ) return 1 ;
+
+    return 0 ;
+}
@@ -0,0 +1,192 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "bitpit_common.hpp"
+#include "bitpit_RBF.hpp"
+#include "bitpit_surfunstructured.hpp"
+
+using namespace std;
+using namespace bitpit;
+
+/*!
+ * Creates a square surface patch made of quadrilaterals
+ * @param[in,out] patch patch
+ * @param[in] n number of cells along each direction
+ */
+void createPatch( SurfUnstructured &patch, int n ){
+
+    patch.setExpert( true ) ;
+
+    for( int j = 0; j <= n; ++j ){
+        for( int i = 0; i <= n; ++i ){
+            patch.addVertex( {{ double( i ) / n, double( j ) / n, 0. }} ) ;
+        }
+    }
+
+    std::vector<long> connectivity( 4 ) ;
+    for( int j = 0; j < n; ++j ){
+        for( int i = 0; i < n; ++i ){
+            connectivity[0] = i + ( n + 1 ) * j ;
+            connectivity[1] = connectivity[0] + 1 ;
+            connectivity[2] = connectivity[1] + n + 1 ;
+            connectivity[3] = connectivity[0] + n + 1 ;
+            patch.addCell( ElementInfo::QUAD, true, connectivity ) ;
+        }
+    }
+
+    patch.updateBoundingBox( true ) ;
+}
+
+/*!
+ * Evaluates the displacement of the control nodes
+ * @param[in] node node coordinates
+ * @return displacement
+ */
+std::array<double,3> evalDisplacement( const std::array<double,3> &node ){
+    return {{ 0.1 * node[1], 0., 0.2 * std::sin( 3. * node[0] ) }} ;
+}
+
+/*!
+ * Deforms a surface patch with a RBF defining all the displacement
+ * components and with three RBFs defining one component each, checking
+ * the result against the point-wise evaluation of the RBF.
+ */
+int main()
+{
+
+    int n = 40 ;
+
+    // Control nodes on the border of the patch
+    std::vector<std::array<double,3>> nodes ;
+    for( int i = 0; i < n; ++i ){
+        double t = double( i ) / n ;
+        nodes.push_back( {{ t, 0., 0. }} ) ;
+        nodes.push_back( {{ 1., t, 0. }} ) ;
+        nodes.push_back( {{ 1. - t, 1., 0. }} ) ;
+        nodes.push_back( {{ 0., 1. - t, 0. }} ) ;
+    }
+
+    std::vector<std::vector<double>> displacements( 3 ) ;
+    for( const auto &node : nodes ){
+        std::array<double,3> displacement = evalDisplacement( node ) ;
+        for( int d = 0; d < 3; ++d ){
+            displacements[d].push_back( displacement[d] ) ;
+        }
+    }
+
+    // RBF defining all the displacement components
+    RBF rbf ;
+    rbf.setSupportRadius( 0.4 ) ;
+    threads::setThreadCount( 2 ) ;
+    rbf.addNode( nodes ) ;
+    for( int d = 0; d < 3; ++d ){
+        rbf.addData( displacements[d] ) ;
+    }
+    if( rbf.solve() != 0 ) return 1 ;
+
+    // RBFs defining one component each
+    std::vector<RBF> componentRBFs( 3 ) ;
+    std::vector<RBF *> componentPointers ;
+    for( int d = 0; d < 3; ++d ){
+        componentRBFs[d].setSupportRadius( 0.4 ) ;
+        componentRBFs[d].addNode( nodes ) ;
+        componentRBFs[d].addData( displacements[d] ) ;
+        if( componentRBFs[d].solve() != 0 ) return 1 ;
+        componentPointers.push_back( &componentRBFs[d] ) ;
+    }
+
+    // Deformation
+    SurfUnstructured patch( 0 ) ;
+    createPatch( patch, n ) ;
+
+    SurfUnstructured componentPatch( 1 ) ;
+    createPatch( componentPatch, n ) ;
+
+    std::vector<std::array<double,3>> expected ;
+    std::array<double,3> expectedMin, expectedMax ;
+    expectedMin.fill( 1.e18 ) ;
+    expectedMax.fill( -1.e18 ) ;
+    for( const auto &vertex : patch.getVertices() ){
+        std::array<double,3> coords = vertex.getCoords() ;
+        std::vector<double> displacement = rbf.evalRBF( coords ) ;
+        for( int d = 0; d < 3; ++d ){
+            coords[d] += displacement[d] ;
+            expectedMin[d] = std::min( expectedMin[d], coords[d] ) ;
+            expectedMax[d] = std::max( expectedMax[d], coords[d] ) ;
+        }
+        expected.push_back( coords ) ;
+    }
+
+    std::vector<std::array<double,3>> coords ;
+    for( const auto &vertex : patch.getVertices() ){
+        coords.push_back( vertex.getCoords() ) ;
+    }
+
+    std::vector<std::array<double,3>> vertexDisplacements( coords.size() ) ;
+    if( !rbf::evalDisplacements( std::vector<RBF *>( 1, &rbf ), coords.size(), coords.data(), vertexDisplacements.data() ) ) return 1 ;
+    if( !patch.displaceVertices( vertexDisplacements ) ) return 1 ;
+
+    if( !rbf::evalDisplacements( componentPointers, coords.size(), coords.data(), vertexDisplacements.data() ) ) return 1 ;
+    if( !componentPatch.displaceVertices( vertexDisplacements ) ) return 1 ;
+
+    double error = 0. ;
+    double componentError = 0. ;
+    std::size_t k = 0 ;
+    for( const auto &vertex : patch.getVertices() ){
+        const std::array<double,3> &coords = vertex.getCoords() ;
+        const std::array<double,3> &componentCoords = componentPatch.getVertexCoords( vertex.getId() ) ;
+        for( int d = 0; d < 3; ++d ){
+            error = std::max( error, std::abs( coords[d] - expected[k][d] ) ) ;
+            componentError = std::max( componentError, std::abs( componentCoords[d] - expected[k][d] ) ) ;
+        }
+        ++k ;
+    }
+
+    std::cout << " Deformation error                : " << error << std::endl ;
+    std::cout << " Deformation error, one RBF/field : " << componentError << std::endl ;
+    if( error > 1.e-12 || componentError > 1.e-12 ) return 1 ;
+
+    // Patches that are not in expert mode are not deformed
+    componentPatch.setExpert( false ) ;
+    if( componentPatch.displaceVertices( vertexDisplacements ) ) return 1 ;
+
+    // Bounding box
+    if( !patch.isBoundingBoxDirty() ) return 1 ;
+    patch.updateBoundingBox() ;
+
+    std::array<double,3> boxMin, boxMax ;
+    patch.getBoundingBox( boxMin, boxMax ) ;
+    for( int d = 0; d < 3; ++d ){
+        if( std::abs( boxMin[d] - expectedMin[d] ) > 1.e-12 ) return 1 ;
+        if( std::abs( boxMax[d] - expectedMax[d] ) > 1.e-12 ) return 1 ;
+    }
+
+    return 0 ;
+}
@@ -0,0 +1,145 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "bitpit_common.hpp"
+#include "bitpit_RBF.hpp"
+
+using namespace std;
+using namespace bitpit;
+
+/*!
+ * Evaluates the field to be interpolated
+ * @param[in] point point coordinates
+ * @return field value
+ */
+double evalField( const std::array<double,3> &point ){
+    return std::sin( 2. * point[0] ) * std::cos( 3. * point[1] ) + point[2] * point[2] ;
+}
+
+/*!
+ * Interpolates a field on a cloud of nodes with a partition of unity RBF
+ * and compares the results with a global RBF.
+ */
+int main()
+{
+
+    // Nodes on a jittered lattice
+    int n = 16 ;
+    double h = 1. / n ;
+    std::vector<std::array<double,3>> nodes ;
+    std::vector<double> field ;
+    for( int k = 0; k < n; ++k ){
+        for( int j = 0; j < n; ++j ){
+            for( int i = 0; i < n; ++i ){
+                int index = i + n * ( j + n * k ) ;
+                std::array<double,3> node ;
+                node[0] = ( i + 0.5 + 0.3 * std::sin( 1.7 * index ) ) * h ;
+                node[1] = ( j + 0.5 + 0.3 * std::sin( 2.3 * index ) ) * h ;
+                node[2] = ( k + 0.5 + 0.3 * std::sin( 3.1 * index ) ) * h ;
+                nodes.push_back( node ) ;
+                field.push_back( evalField( node ) ) ;
+            }
+        }
+    }
+
+    // Points inside the cloud
+    std::vector<std::array<double,3>> points ;
+    for( int p = 0; p < 2000; ++p ){
+        std::array<double,3> point ;
+        for( int d = 0; d < 3; ++d ){
+            double t = std::sin( 12.9898 * ( p + 1 ) + 1.3 * d ) * 43758.5453 ;
+            point[d] = 0.1 + 0.8 * ( t - std::floor( t ) ) ;
+        }
+        points.push_back( point ) ;
+    }
+
+    double radius = 4. * h ;
+
+    // Global RBF
+    RBF globalRBF ;
+    globalRBF.setSupportRadius( radius ) ;
+    globalRBF.addNode( nodes ) ;
+    globalRBF.addData( field ) ;
+    if( globalRBF.solve() != 0 ) return 1 ;
+
+    // Partition of unity RBF
+    RBFPartitionOfUnity puRBF ;
+    puRBF.setSupportRadius( radius ) ;
+    puRBF.setPatchNodeCount( 64 ) ;
+    puRBF.setPatchOverlap( 1.5 ) ;
+    threads::setThreadCount( 4 ) ;
+    puRBF.addNode( nodes ) ;
+    puRBF.addData( field ) ;
+
+    std::chrono::time_point<std::chrono::system_clock> start = std::chrono::system_clock::now() ;
+    if( puRBF.solve() != 0 ) return 1 ;
+    std::chrono::time_point<std::chrono::system_clock> end = std::chrono::system_clock::now() ;
+    int elapsed = std::chrono::duration_cast<std::chrono::milliseconds>( end - start ).count() ;
+
+    // Interpolation error on the nodes
+    std::vector<double> nodeValues( nodes.size() ) ;
+    puRBF.evalRBF( nodes.size(), nodes.data(), nodeValues.data() ) ;
+
+    double nodeError = 0. ;
+    for( std::size_t k = 0; k < nodes.size(); ++k ){
+        nodeError = std::max( nodeError, std::abs( nodeValues[k] - field[k] ) ) ;
+    }
+
+    // Approximation error
+    std::vector<double> globalValues( points.size() ) ;
+    globalRBF.evalRBF( points.size(), points.data(), globalValues.data() ) ;
+
+    std::vector<double> puValues( points.size() ) ;
+    puRBF.evalRBF( points.size(), points.data(), puValues.data() ) ;
+
+    double globalError = 0. ;
+    double puError     = 0. ;
+    double difference  = 0. ;
+    for( std::size_t p = 0; p < points.size(); ++p ){
+        double exact = evalField( points[p] ) ;
+        globalError = std::max( globalError, std::abs( globalValues[p] - exact ) ) ;
+        puError     = std::max( puError, std::abs( puValues[p] - exact ) ) ;
+        difference  = std::max( difference, std::abs( puValues[p] - puRBF.evalRBF( points[p] )[0] ) ) ;
+    }
+
+    std::cout << " Patches                      : " << puRBF.getPatchCount() << std::endl ;
+    std::cout << " Partition of unity solve (ms): " << elapsed << std::endl ;
+    std::cout << " Error on nodes               : " << nodeError << std::endl ;
+    std::cout << " Global RBF error             : " << globalError << std::endl ;
+    std::cout << " Partition of unity error     : " << puError << std::endl ;
+    std::cout << " Batched/point-wise difference: " << difference << std::endl ;
+
+    if( nodeError > 1.e-8 ) return 1 ;
+    if( puError > 2. * globalError + 1.e-3 ) return 1 ;
+    if( difference > 1.e-14 ) return 1 ;
+
+    return 0 ;
+}
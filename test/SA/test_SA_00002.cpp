@@ -0,0 +1,271 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <array>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "bitpit_SA.hpp"
+
+using namespace std;
+using namespace bitpit;
+
+/*!
+ * Creates a pseudo-random cloud of points
+ * \param[in] nPoints number of points
+ * \param[in] seed seed of the sequence
+ * \result point coordinates
+ */
+std::vector<std::array<double, 3>> createPoints(int nPoints, double seed)
+{
+    std::vector<std::array<double, 3>> points(nPoints);
+    for (int n = 0; n < nPoints; ++n) {
+        for (int d = 0; d < 3; ++d) {
+            double t = std::sin(seed * (n + 1) + 1.3 * d) * 43758.5453;
+            points[n][d] = t - std::floor(t);
+        }
+    }
+
+    return points;
+}
+
+/*!
+ * Squared distance between two points
+ */
+double distance2(const std::array<double, 3> &x, const std::array<double, 3> &y)
+{
+    double distance = 0.;
+    for (int d = 0; d < 3; ++d) {
+        distance += (x[d] - y[d]) * (x[d] - y[d]);
+    }
+
+    return distance;
+}
+
+/*!
+ * Subtest 001
+ *
+ * Checks nearest, k-nearest and radius queries of a balanced kd-tree against
+ * a brute force search.
+ */
+int subtest_001()
+{
+    const int N_NODES   = 5000;
+    const int N_QUERIES = 500;
+    const int K         = 8;
+    const double RADIUS = 0.08;
+
+    std::vector<std::array<double, 3>> nodes = createPoints(N_NODES, 12.9898);
+    std::vector<std::array<double, 3>> queries = createPoints(N_QUERIES, 78.233);
+
+    // Coincident nodes must be found as well
+    for (int n = 0; n < 50; ++n) {
+        nodes.push_back(nodes[7 * n]);
+    }
+
+    std::vector<long> labels(nodes.size());
+    for (std::size_t n = 0; n < nodes.size(); ++n) {
+        labels[n] = 10 * n;
+    }
+
+    BalancedKdTree<3, long> tree(nodes, labels);
+    if (tree.size() != nodes.size()) {
+        std::cout << "  Wrong number of nodes in the tree" << std::endl;
+        return 1;
+    }
+
+    // Brute force distances, indexed by label
+    std::vector<int> neighs;
+    std::vector<double> distances;
+    for (int q = 0; q < N_QUERIES; ++q) {
+        const std::array<double, 3> &point = queries[q];
+
+        std::vector<std::pair<double, long>> exact(nodes.size());
+        for (std::size_t n = 0; n < nodes.size(); ++n) {
+            exact[n] = std::make_pair(distance2(point, nodes[n]), labels[n]);
+        }
+        std::sort(exact.begin(), exact.end());
+
+        // Nearest
+        double nearestDistance;
+        int nearest = tree.nearest(point, &nearestDistance);
+        if (std::abs(nearestDistance * nearestDistance - exact[0].first) > 1e-12 ||
+                distance2(point, tree.getNode(nearest).coords) != exact[0].first) {
+            std::cout << "  Wrong nearest node for query " << q << std::endl;
+            return 1;
+        }
+
+        // k-nearest
+        tree.kNearest(point, K, neighs, &distances);
+        if (neighs.size() != K) {
+            std::cout << "  Wrong number of k-nearest nodes for query " << q << std::endl;
+            return 1;
+        }
+
+        for (int k = 0; k < K; ++k) {
+            if (std::abs(distances[k] * distances[k] - exact[k].first) > 1e-12) {
+                std::cout << "  Wrong k-nearest nodes for query " << q << std::endl;
+                return 1;
+            }
+        }
+
+        // Radius
+        tree.radiusSearch(point, RADIUS, neighs);
+
+        std::vector<long> found;
+        for (int neigh : neighs) {
+            found.push_back(tree.getNode(neigh).label);
+        }
+        std::sort(found.begin(), found.end());
+
+        std::vector<long> expected;
+        for (std::size_t n = 0; n < exact.size() && exact[n].first <= RADIUS * RADIUS; ++n) {
+            expected.push_back(exact[n].second);
+        }
+        std::sort(expected.begin(), expected.end());
+
+        if (found != expected) {
+            std::cout << "  Wrong nodes in radius for query " << q << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << "  Queries match brute force search" << std::endl;
+
+    return 0;
+}
+
+/*!
+ * Subtest 002
+ *
+ * Checks that the tree and the batched radius queries are independent of
+ * the number of threads and compares the build time with the one of the
+ * insertion-based kd-tree.
+ */
+int subtest_002()
+{
+    const int N_NODES   = 100000;
+    const int N_QUERIES = 20000;
+    const double RADIUS = 0.02;
+
+    std::vector<std::array<double, 3>> nodes = createPoints(N_NODES, 12.9898);
+    std::vector<std::array<double, 3>> queries = createPoints(N_QUERIES, 78.233);
+
+    std::vector<long> labels(N_NODES);
+    for (int n = 0; n < N_NODES; ++n) {
+        labels[n] = n;
+    }
+
+    std::chrono::time_point<std::chrono::system_clock> start, end;
+
+    // Insertion-based tree
+    start = std::chrono::system_clock::now();
+    KdTree<3, std::array<double, 3>, long> insertTree(N_NODES);
+    for (int n = 0; n < N_NODES; ++n) {
+        insertTree.insert(&nodes[n], labels[n]);
+    }
+    end = std::chrono::system_clock::now();
+    std::cout << "  Insertion build time: " << std::chrono::duration<double>(end - start).count() << " s" << std::endl;
+
+    // Balanced tree
+    start = std::chrono::system_clock::now();
+    threads::setThreadCount(1);
+    BalancedKdTree<3, long> serialTree(nodes, labels);
+    end = std::chrono::system_clock::now();
+    std::cout << "  Balanced build time (1 thread): " << std::chrono::duration<double>(end - start).count() << " s" << std::endl;
+
+    start = std::chrono::system_clock::now();
+    threads::setThreadCount(4);
+    BalancedKdTree<3, long> parallelTree(nodes, labels);
+    end = std::chrono::system_clock::now();
+    std::cout << "  Balanced build time (4 threads): " << std::chrono::duration<double>(end - start).count() << " s" << std::endl;
+
+    for (int n = 0; n < N_NODES; ++n) {
+        if (serialTree.getNode(n).label != parallelTree.getNode(n).label) {
+            std::cout << "  Tree layout depends on the number of threads" << std::endl;
+            return 1;
+        }
+    }
+
+    // Batched radius queries
+    std::vector<long> serialOffsets, parallelOffsets;
+    std::vector<int> serialNeighs, parallelNeighs;
+
+    start = std::chrono::system_clock::now();
+    threads::setThreadCount(1);
+    serialTree.radiusSearch(N_QUERIES, queries.data(), RADIUS, serialOffsets, serialNeighs);
+    end = std::chrono::system_clock::now();
+    std::cout << "  Batched radius search (1 thread): " << std::chrono::duration<double>(end - start).count() << " s" << std::endl;
+
+    start = std::chrono::system_clock::now();
+    threads::setThreadCount(4);
+    serialTree.radiusSearch(N_QUERIES, queries.data(), RADIUS, parallelOffsets, parallelNeighs);
+    end = std::chrono::system_clock::now();
+    std::cout << "  Batched radius search (4 threads): " << std::chrono::duration<double>(end - start).count() << " s" << std::endl;
+
+    if (serialOffsets != parallelOffsets || serialNeighs != parallelNeighs) {
+        std::cout << "  Batched radius search depends on the number of threads" << std::endl;
+        return 1;
+    }
+
+    // Batched queries must match single queries
+    std::vector<int> neighs;
+    for (int q = 0; q < N_QUERIES; q += 97) {
+        serialTree.radiusSearch(queries[q], RADIUS, neighs);
+        std::vector<int> batched(serialNeighs.begin() + serialOffsets[q], serialNeighs.begin() + serialOffsets[q + 1]);
+        if (neighs != batched) {
+            std::cout << "  Batched radius search differs from single search" << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << "  Found " << serialOffsets.back() << " neighbours" << std::endl;
+
+    return 0;
+}
+
+/*!
+ * Main program.
+ */
+int main()
+{
+    int status;
+
+    std::cout << "Testing balanced kd-tree queries" << std::endl;
+    status = subtest_001();
+    if (status != 0) {
+        return status;
+    }
+
+    std::cout << "Testing balanced kd-tree threading" << std::endl;
+    status = subtest_002();
+    if (status != 0) {
+        return status;
+    }
+
+    return 0;
+}
@@ -0,0 +1,176 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "bitpit_common.hpp"
+
+using namespace bitpit;
+
+/*!
+ * Evaluates the sums of the chunks of a range, each chunk is summed by a
+ * single thread.
+ */
+std::vector<double> evalChunkSums(ThreadPool &pool, int nChunks, const std::vector<double> &values)
+{
+	std::size_t chunkSize = ThreadPool::evalChunkSize(nChunks, values.size());
+
+	std::vector<double> sums((values.size() + chunkSize - 1) / chunkSize, 0.);
+	pool.parallelFor(nChunks, values.size(), [&] (std::size_t begin, std::size_t end) {
+		double &sum = sums[begin / chunkSize];
+		for (std::size_t i = begin; i < end; ++i) {
+			sum += values[i];
+		}
+	});
+
+	return sums;
+}
+
+int main()
+{
+	std::cout << "Testing thread pool" << std::endl;
+
+	ThreadPool pool(4);
+	if (pool.getThreadCount() != 4) {
+		std::cout << "  Wrong number of threads" << std::endl;
+		return 1;
+	}
+
+	// Chunks cover the range exactly once and have deterministic bounds
+	std::cout << "  Checking chunk bounds" << std::endl;
+
+	const std::size_t n = 1003;
+	const int nChunks   = 7;
+	std::size_t chunkSize = ThreadPool::evalChunkSize(nChunks, n);
+
+	std::vector<std::atomic<int>> visits(n);
+	for (std::atomic<int> &count : visits) {
+		count = 0;
+	}
+
+	std::vector<std::size_t> chunkEnds(nChunks, 0);
+	pool.parallelFor(nChunks, n, [&] (std::size_t begin, std::size_t end) {
+		chunkEnds[begin / chunkSize] = end;
+		for (std::size_t i = begin; i < end; ++i) {
+			++visits[i];
+		}
+	});
+
+	for (std::size_t i = 0; i < n; ++i) {
+		if (visits[i] != 1) {
+			std::cout << "  Element " << i << " visited " << visits[i] << " times" << std::endl;
+			return 1;
+		}
+	}
+
+	for (int k = 0; k < nChunks; ++k) {
+		if (chunkEnds[k] != std::min((k + 1) * chunkSize, n)) {
+			std::cout << "  Wrong bounds for chunk " << k << std::endl;
+			return 1;
+		}
+	}
+
+	// Results do not depend on the number of threads
+	std::cout << "  Checking determinism" << std::endl;
+
+	std::vector<double> values(n);
+	for (std::size_t i = 0; i < n; ++i) {
+		values[i] = 1. / (i + 1.);
+	}
+
+	ThreadPool serialPool(1);
+	if (evalChunkSums(pool, nChunks, values) != evalChunkSums(serialPool, nChunks, values)) {
+		std::cout << "  Results depend on the number of threads" << std::endl;
+		return 1;
+	}
+
+	// Nested loops
+	std::cout << "  Checking nested loops" << std::endl;
+
+	std::atomic<long> nVisits(0);
+	pool.parallelFor(8, 8, [&] (std::size_t begin, std::size_t end) {
+		for (std::size_t i = begin; i < end; ++i) {
+			pool.parallelFor(5, 100, [&] (std::size_t innerBegin, std::size_t innerEnd) {
+				nVisits += innerEnd - innerBegin;
+			});
+		}
+	});
+
+	if (nVisits != 800) {
+		std::cout << "  Wrong number of visits in nested loops" << std::endl;
+		return 1;
+	}
+
+	// The exception of the first failing chunk is rethrown
+	std::cout << "  Checking exceptions" << std::endl;
+
+	std::string message;
+	try {
+		pool.parallelFor(10, 10, [] (std::size_t begin, std::size_t end) {
+			for (std::size_t i = begin; i < end; ++i) {
+				if (i == 3 || i == 7) {
+					throw std::runtime_error("chunk " + std::to_string(i));
+				}
+			}
+		});
+	} catch (const std::runtime_error &error) {
+		message = error.what();
+	}
+
+	if (message != "chunk 3") {
+		std::cout << "  Wrong exception: \"" << message << "\"" << std::endl;
+		return 1;
+	}
+
+	// Pool of the library
+	std::cout << "  Checking the pool of the library" << std::endl;
+
+	if (!std::getenv("BITPIT_NUM_THREADS") && threads::getThreadCount() != 1) {
+		std::cout << "  The pool of the library should default to a single thread" << std::endl;
+		return 1;
+	}
+
+	threads::setThreadCount(3);
+	if (threads::getThreadCount() != 3) {
+		std::cout << "  Wrong number of threads in the pool of the library" << std::endl;
+		return 1;
+	}
+
+	std::atomic<long> total(0);
+	threads::parallelFor(threads::getThreadCount(), n, [&] (std::size_t begin, std::size_t end) {
+		total += end - begin;
+	});
+
+	if (total != (long) n) {
+		std::cout << "  Wrong number of visits in the pool of the library" << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,98 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <iostream>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+#include "bitpit_common.hpp"
+
+using namespace bitpit;
+
+int main()
+{
+	std::cout << "Testing memory usage" << std::endl;
+
+	// Sizes of the containers
+	std::cout << "  Checking container sizes" << std::endl;
+
+	std::vector<double> values;
+	values.reserve(100);
+	values.resize(10);
+	if (utils::evalMemorySize(values) != 100 * sizeof(double)) {
+		std::cout << "  Wrong size of the vector" << std::endl;
+		return 1;
+	}
+
+	std::unordered_map<long, double> map;
+	std::size_t emptyMapSize = utils::evalMemorySize(map);
+	for (long i = 0; i < 100; ++i) {
+		map[i] = i;
+	}
+
+	if (utils::evalMemorySize(map) < emptyMapSize + 100 * sizeof(std::pair<const long, double>)) {
+		std::cout << "  Wrong size of the map" << std::endl;
+		return 1;
+	}
+
+	// Totals of the components
+	std::cout << "  Checking totals" << std::endl;
+
+	MemoryUsage usage("root", 8);
+	usage.addComponent("first", 16);
+
+	MemoryUsage nested;
+	nested.addComponent("inner", 32);
+	nested.addComponent("other", 64);
+	usage.addComponent("second", nested).addBytes(128);
+
+	if (usage.getBytes() != 8 + 16 + 32 + 64 + 128) {
+		std::cout << "  Wrong total: " << usage.getBytes() << std::endl;
+		return 1;
+	}
+
+	if (usage.getComponents().size() != 2 || usage.getComponents()[1].getName() != "second") {
+		std::cout << "  Wrong components" << std::endl;
+		return 1;
+	}
+
+	// Report
+	std::cout << "  Checking report" << std::endl;
+
+	std::stringstream report;
+	usage.display(report, 2);
+	std::cout << report.str();
+	if (report.str().find("inner") == std::string::npos) {
+		std::cout << "  Nested components are missing from the report" << std::endl;
+		return 1;
+	}
+
+	if (MemoryUsage::formatBytes(2048) != "2.00 KiB") {
+		std::cout << "  Wrong formatting: " << MemoryUsage::formatBytes(2048) << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,151 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <mpi.h>
+
+#include <set>
+
+#include "bitpit_IO.hpp"
+#include "bitpit_communications.hpp"
+
+using namespace bitpit;
+
+/*!
+ * Auxiliary function to evaluate the number of values to send
+ */
+int getSendCount(int srcRank, int dstRank, int round)
+{
+	return ((srcRank + 2 * dstRank + round) % 5) * (1 + 100 * (round % 2));
+}
+
+/*!
+ * Auxiliary function to evaluate the values to send
+ */
+double getSendValue(int srcRank, int dstRank, int round, int n)
+{
+	return 1000. * srcRank + 10. * dstRank + round + 0.001 * n;
+}
+
+/*!
+ * Test for the discovery of the receives with sparse communication patterns.
+ *
+ * Every processor sends data to a few neighbours. The receives are discovered
+ * several times in a row, using the same tag of the data exchange, with and
+ * without piggy-backing the data on the discovery messages.
+ */
+int main(int argc, char *argv[]) {
+
+	MPI_Init(&argc,&argv);
+
+	int nProcs;
+	int	rank;
+	MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+	log::manager().initialize(log::COMBINED, true, nProcs, rank);
+	log::cout().setVisibility(log::GLOBAL);
+	log::cout() << "Testing discovery of the receives" << "\n";
+
+	DataCommunicator dataCommunicator(MPI_COMM_WORLD);
+	dataCommunicator.setTag(0);
+
+	// Neighbours
+	std::set<int> dstRanks;
+	dstRanks.insert((rank + 1) % nProcs);
+	dstRanks.insert((rank + 3) % nProcs);
+
+	std::set<int> srcRanks;
+	srcRanks.insert((rank - 1 + nProcs) % nProcs);
+	srcRanks.insert((rank - 3 + 3 * nProcs) % nProcs);
+
+	const int N_ROUNDS = 6;
+	for (int round = 0; round < N_ROUNDS; ++round) {
+		long maxPiggybackSize = (round % 3 == 0) ? -1 : 64 * sizeof(double);
+		log::cout() << "Round " << round << ", maximum piggy-back size " << maxPiggybackSize << std::endl;
+
+		// Fill the sends
+		dataCommunicator.clearAllSends();
+		for (int dstRank : dstRanks) {
+			int nValues = getSendCount(rank, dstRank, round);
+			dataCommunicator.setSend(dstRank, nValues * sizeof(double));
+
+			SendBuffer &sendBuffer = dataCommunicator.getSendBuffer(dstRank);
+			for (int n = 0; n < nValues; ++n) {
+				sendBuffer << getSendValue(rank, dstRank, round, n);
+			}
+		}
+
+		// Discover the receives
+		dataCommunicator.discoverRecvs(dataCommunicator.getTag(), maxPiggybackSize);
+		if (dataCommunicator.getRecvCount() != (int) srcRanks.size()) {
+			log::cout() << "Wrong number of receives." << std::endl;
+			MPI_Abort(MPI_COMM_WORLD, 2);
+		}
+
+		for (int srcRank : srcRanks) {
+			RecvBuffer &recvBuffer = dataCommunicator.getRecvBuffer(srcRank);
+			long dataSize = recvBuffer.capacity();
+			long expectedDataSize = getSendCount(srcRank, rank, round) * sizeof(double);
+			if (dataSize != expectedDataSize) {
+				log::cout() << "Wrong data size from " << srcRank << "." << std::endl;
+				log::cout() << "   Current data size : " << dataSize << std::endl;
+				log::cout() << "   Expected data size: " << expectedDataSize << std::endl;
+				MPI_Abort(MPI_COMM_WORLD, 2);
+			}
+		}
+
+		// Exchange data
+		dataCommunicator.startAllRecvs();
+		dataCommunicator.startAllSends();
+
+		int nCompletedRecvs = 0;
+		while (nCompletedRecvs < dataCommunicator.getRecvCount()) {
+			int srcRank = dataCommunicator.waitAnyRecv();
+
+			RecvBuffer &recvBuffer = dataCommunicator.getRecvBuffer(srcRank);
+			int nValues = recvBuffer.capacity() / sizeof(double);
+			for (int n = 0; n < nValues; ++n) {
+				double value;
+				recvBuffer >> value;
+
+				double expectedValue = getSendValue(srcRank, rank, round, n);
+				if (value != expectedValue) {
+					log::cout() << "Wrong data value from " << srcRank << "." << std::endl;
+					log::cout() << "   Current data value : " << value << std::endl;
+					log::cout() << "   Expected data value: " << expectedValue << std::endl;
+					MPI_Abort(MPI_COMM_WORLD, 2);
+				}
+			}
+
+			++nCompletedRecvs;
+		}
+
+		dataCommunicator.waitAllSends();
+	}
+
+	log::cout() << "Receives correctly discovered" << std::endl;
+
+	// Finalize MPI
+	MPI_Finalize();
+}
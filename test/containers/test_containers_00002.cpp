@@ -0,0 +1,197 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "bitpit_containers.hpp"
+
+using namespace bitpit;
+
+/*!
+	Subtest 001
+
+	Writes scalars, strings and arrays to an output stream that grows as
+	data is written and reads them back.
+*/
+int subtest_001()
+{
+	const int N_VALUES = 1000;
+
+	std::vector<long> values(N_VALUES);
+	for (int i = 0; i < N_VALUES; ++i) {
+		values[i] = 3 * i - 7;
+	}
+
+	std::array<double, 3> point = {{1.5, -2.25, 1e-300}};
+
+	OBinaryStream output;
+	output << (int) N_VALUES << std::string("bitpit") << point;
+	output.write(values.data(), values.size());
+	output << std::string("end");
+
+	// The size of the stream is the size of the written data
+	std::size_t expectedSize = 3 * sizeof(int) + 6 + sizeof(point) + N_VALUES * sizeof(long) + 3;
+	if (output.capacity() != expectedSize) {
+		std::cout << "  Wrong size of the output stream: " << output.capacity() << std::endl;
+		return 1;
+	}
+
+	// Overwrite the first value
+	output.seekg(0);
+	output << (int) (N_VALUES - 1);
+	if (output.capacity() != expectedSize) {
+		std::cout << "  Overwriting data changed the size of the stream" << std::endl;
+		return 1;
+	}
+
+	// Read the data from a copy of the buffer and from a view of the buffer
+	for (int copy = 0; copy < 2; ++copy) {
+		IBinaryStream input;
+		if (copy == 0) {
+			input.open(output.rawData(), output.capacity());
+		} else {
+			input.openView(output.rawData(), output.capacity());
+		}
+
+		if (input.isView() != (copy == 1)) {
+			std::cout << "  Wrong type of input stream" << std::endl;
+			return 1;
+		}
+
+		int nValues;
+		std::string name;
+		std::array<double, 3> readPoint;
+		input >> nValues >> name >> readPoint;
+
+		std::vector<long> readValues(N_VALUES);
+		input.read(readValues.data(), readValues.size());
+
+		std::string end;
+		input >> end;
+
+		if (nValues != N_VALUES - 1 || name != "bitpit" || readPoint != point || end != "end") {
+			std::cout << "  Wrong data read from the stream" << std::endl;
+			return 1;
+		}
+
+		if (!std::equal(readValues.begin(), readValues.end(), values.begin())) {
+			std::cout << "  Wrong array read from the stream" << std::endl;
+			return 1;
+		}
+
+		if (!input.eof()) {
+			std::cout << "  Stream should be at its end" << std::endl;
+			return 1;
+		}
+
+		// Reading past the end of the stream is an error
+		bool error = false;
+		try {
+			input >> nValues;
+		} catch (const std::runtime_error &exception) {
+			error = true;
+		}
+
+		if (!error) {
+			std::cout << "  Reading past the end of the stream should fail" << std::endl;
+			return 1;
+		}
+	}
+
+	std::cout << "  Stream data read back correctly" << std::endl;
+
+	return 0;
+}
+
+/*!
+	Subtest 002
+
+	Measures the time needed to write and read a large number of scalars.
+*/
+int subtest_002()
+{
+	const long N_VALUES = 10000000;
+
+	std::chrono::time_point<std::chrono::system_clock> start, end;
+
+	start = std::chrono::system_clock::now();
+	OBinaryStream output;
+	for (long i = 0; i < N_VALUES; ++i) {
+		output << i << (double) i;
+	}
+	end = std::chrono::system_clock::now();
+
+	std::cout << "  Writing " << N_VALUES << " pairs of scalars: " << std::chrono::duration<double>(end - start).count() << " s" << std::endl;
+
+	start = std::chrono::system_clock::now();
+	IBinaryStream input;
+	input.openView(output.rawData(), output.capacity());
+
+	long nErrors = 0;
+	for (long i = 0; i < N_VALUES; ++i) {
+		long index;
+		double value;
+		input >> index >> value;
+		if (index != i || value != (double) i) {
+			++nErrors;
+		}
+	}
+	end = std::chrono::system_clock::now();
+
+	std::cout << "  Reading " << N_VALUES << " pairs of scalars: " << std::chrono::duration<double>(end - start).count() << " s" << std::endl;
+
+	if (nErrors != 0) {
+		std::cout << "  Wrong values read from the stream" << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
+
+/*!
+	Main program.
+*/
+int main()
+{
+	int status;
+
+	std::cout << "Testing binary stream data" << std::endl;
+	status = subtest_001();
+	if (status != 0) {
+		return status;
+	}
+
+	std::cout << "Testing binary stream performance" << std::endl;
+	status = subtest_002();
+	if (status != 0) {
+		return status;
+	}
+
+	return 0;
+}
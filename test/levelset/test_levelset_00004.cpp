@@ -0,0 +1,173 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+/*!
+ *	\brief Checks the cells and the simplices associated by the narrow band
+ *	of a segmentation on an octree mesh against a brute force search.
+ */
+
+// ========================================================================== //
+// INCLUDES                                                                   //
+// ========================================================================== //
+
+//Standard Template Library
+# define _USE_MATH_DEFINES
+
+# include <algorithm>
+# include <cmath>
+# include <limits>
+# include <vector>
+
+#if BITPIT_ENABLE_MPI==1
+# include <mpi.h>
+#endif
+
+// bitpit
+# include "bitpit_CG.hpp"
+# include "bitpit_levelset.hpp"
+
+# include "test_levelset_sphere.hpp"
+
+// ========================================================================== //
+// NAMESPACES                                                                 //
+// ========================================================================== //
+using namespace bitpit;
+
+int main( int argc, char *argv[]){
+
+#if BITPIT_ENABLE_MPI==1
+    MPI_Init(&argc, &argv);
+#endif
+
+    // Input geometry
+    SurfUnstructured    sphere(0) ;
+
+    std::cout << " - Generating geometry" << std::endl;
+
+    generateSphere( sphere, 1., 12, 24 ) ;
+
+    // Octree mesh, refined once around the sphere
+    std::cout << " - Setting mesh" << std::endl;
+
+    std::array<double,3>    origin = {{-1.5, -1.5, -1.5}} ;
+    double                  length = 3. ;
+
+    VolOctree   mesh( 1, 3, origin, length, length /8. ) ;
+    mesh.update() ;
+
+    for( auto & cell : mesh.getCells() ){
+        const long &id = cell.getId() ;
+        double r = norm2( mesh.evalCellCentroid(id) ) ;
+        if( r > 0.6 && r < 1.2 ){
+            mesh.markCellForRefinement(id) ;
+        }
+    }
+
+    mesh.update() ;
+
+    std::cout << "n. cells: " << mesh.getCellCount() << std::endl;
+
+    // Narrow band
+    std::cout << " - Computing narrow band" << std::endl;
+
+    double                  RSearch = 0.3 ;
+
+    LevelSetOctree          levelset( mesh ) ;
+    LevelSetSegmentation    object( 0, &sphere ) ;
+
+    levelset.setSizeNarrowBand( RSearch ) ;
+    object.computeLSInNarrowBand( &levelset, RSearch, true ) ;
+
+    // Compare with a brute force search
+    std::cout << " - Comparing with brute force search" << std::endl;
+
+    std::vector<std::vector<std::array<double,3>>>  simplexVertices ;
+    std::vector<long>                               simplexIds ;
+    for( auto & segment : sphere.getCells() ){
+        std::vector<std::array<double,3>> VS ;
+        for( int n=0; n<segment.getVertexCount(); ++n ){
+            VS.push_back( sphere.getVertexCoords(segment.getVertex(n)) ) ;
+        }
+
+        simplexIds.push_back( segment.getId() ) ;
+        simplexVertices.push_back( VS ) ;
+    }
+
+    long                    nBandCells = 0 ;
+    std::array<double,3>    xP ;
+    int                     flag ;
+
+    for( auto & cell : mesh.getCells() ){
+        const long &id = cell.getId() ;
+        std::array<double,3> centroid = mesh.evalCellCentroid(id) ;
+
+        std::vector<long>   expected ;
+        double              minDistance = std::numeric_limits<double>::max() ;
+        for( std::size_t k=0; k<simplexIds.size(); ++k ){
+            double d = CGElem::distancePointSimplex( centroid, simplexVertices[k], xP, flag ) ;
+            if( d <= RSearch ){
+                expected.push_back( simplexIds[k] ) ;
+                minDistance = std::min( minDistance, d ) ;
+            }
+        }
+        std::sort( expected.begin(), expected.end() ) ;
+
+        if( object.isInNarrowBand(id) != !expected.empty() ){
+            std::cout << " Cell " << id << " is wrongly classified with respect to the narrow band" << std::endl;
+            return 1;
+        }
+
+        if( expected.empty() ){
+            continue ;
+        }
+
+        ++nBandCells ;
+
+        if( object.getSimplexList(id) != expected ){
+            std::cout << " Wrong list of simplices for cell " << id << std::endl;
+            return 1;
+        }
+
+        long support = object.getSupport(id) ;
+        std::size_t k = std::find( simplexIds.begin(), simplexIds.end(), support ) - simplexIds.begin() ;
+        if( k == simplexIds.size() || std::abs( CGElem::distancePointSimplex( centroid, simplexVertices[k], xP, flag ) - minDistance ) > 1.e-12 ){
+            std::cout << " Wrong support for cell " << id << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << "n. cells in narrow band: " << nBandCells << std::endl;
+
+    if( nBandCells == 0 ){
+        std::cout << " The narrow band is empty" << std::endl;
+        return 1;
+    }
+
+#if BITPIT_ENABLE_MPI==1
+    MPI_Finalize();
+#endif
+
+    return 0;
+
+};
@@ -0,0 +1,220 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+/*!
+ *	\brief Checks the lists of the simplices associated to the cells of an
+ *	octree mesh after the computation of the narrow band and after the update
+ *	of the narrow band that follows a refinement.
+ */
+
+// ========================================================================== //
+// INCLUDES                                                                   //
+// ========================================================================== //
+
+//Standard Template Library
+# define _USE_MATH_DEFINES
+
+# include <cmath>
+# include <unordered_map>
+# include <unordered_set>
+# include <vector>
+
+#if BITPIT_ENABLE_MPI==1
+# include <mpi.h>
+#endif
+
+// bitpit
+# include "bitpit_CG.hpp"
+# include "bitpit_levelset.hpp"
+
+# include "test_levelset_sphere.hpp"
+
+// ========================================================================== //
+// NAMESPACES                                                                 //
+// ========================================================================== //
+using namespace bitpit;
+
+/*!
+ * Checks that the lists of simplices of the cells are sorted and do not
+ * contain duplicates.
+ * @param[in] mesh is the mesh
+ * @param[in] object is the segmentation
+ * @return true if all the lists are sorted and do not contain duplicates
+ */
+bool checkSortedLists( VolOctree &mesh, const LevelSetSegmentation &object ){
+
+    for( auto & cell : mesh.getCells() ){
+        const long &id = cell.getId() ;
+
+        std::vector<long> list = object.getSimplexList(id) ;
+        for( std::size_t k=1; k<list.size(); ++k ){
+            if( list[k-1] >= list[k] ){
+                std::cout << " The list of simplices of cell " << id << " is not sorted or contains duplicates" << std::endl;
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+int main( int argc, char *argv[]){
+
+#if BITPIT_ENABLE_MPI==1
+    MPI_Init(&argc, &argv);
+#endif
+
+    // Input geometry
+    SurfUnstructured    sphere(0) ;
+
+    std::cout << " - Generating geometry" << std::endl;
+
+    generateSphere( sphere, 1., 12, 24 ) ;
+
+    // Octree mesh
+    std::cout << " - Setting mesh" << std::endl;
+
+    std::array<double,3>    origin = {{-1.5, -1.5, -1.5}} ;
+    double                  length = 3. ;
+
+    VolOctree   mesh( 1, 3, origin, length, length /8. ) ;
+    mesh.update() ;
+
+    // Narrow band
+    std::cout << " - Computing narrow band" << std::endl;
+
+    double                  RSearch = 0.4 ;
+
+    LevelSetOctree          levelset( mesh ) ;
+    LevelSetSegmentation    object( 0, &sphere ) ;
+
+    levelset.setSizeNarrowBand( RSearch ) ;
+    object.computeLSInNarrowBand( &levelset, RSearch, true ) ;
+
+    if( !checkSortedLists( mesh, object ) ){
+        return 1;
+    }
+
+    // Lists before the refinement
+    std::unordered_map<long, std::vector<long>> previousLists ;
+    for( auto & cell : mesh.getCells() ){
+        const long &id = cell.getId() ;
+        if( object.isInNarrowBand(id) ){
+            previousLists[id] = object.getSimplexList(id) ;
+            mesh.markCellForRefinement(id) ;
+        }
+    }
+
+    if( previousLists.empty() ){
+        std::cout << " The narrow band is empty" << std::endl;
+        return 1;
+    }
+
+    // Refine the cells in the narrow band and update the narrow band, the
+    // size of the narrow band is unchanged, hence the lists of the children
+    // are derived from the lists of their parents.
+    std::cout << " - Refining mesh" << std::endl;
+
+    std::vector<adaption::Info> mapper = mesh.update(true) ;
+
+    levelset.clearAfterMeshMovement( mapper ) ;
+    levelset.filterOutsideNarrowBand( RSearch ) ;
+    object.updateLSInNarrowBand( &levelset, mapper, RSearch, true ) ;
+
+    if( !checkSortedLists( mesh, object ) ){
+        return 1;
+    }
+
+    // The list of a child contains the simplices of the list of its parent
+    // that are within the narrow band of the child, the lists of the cells
+    // that have not been refined are unchanged.
+    std::cout << " - Checking lists after refinement" << std::endl;
+
+    std::unordered_map<long, std::vector<long>> expectedLists ;
+    std::unordered_set<long>                    children ;
+    for( const adaption::Info &info : mapper ){
+        if( info.entity != adaption::Entity::ENTITY_CELL || info.type != adaption::Type::TYPE_REFINEMENT ){
+            continue ;
+        }
+
+        const std::vector<long> &parentList = previousLists.at(info.previous[0]) ;
+        for( long child : info.current ){
+            children.insert(child) ;
+
+            std::array<double,3> centroid = mesh.evalCellCentroid(child) ;
+            std::array<double,3> xP, lambda ;
+
+            std::vector<long> &childList = expectedLists[child] ;
+            for( long segmentId : parentList ){
+                const Cell &segment = sphere.getCell(segmentId) ;
+                double d = CGElem::distancePointTriangle( centroid,
+                                                          sphere.getVertexCoords(segment.getVertex(0)),
+                                                          sphere.getVertexCoords(segment.getVertex(1)),
+                                                          sphere.getVertexCoords(segment.getVertex(2)),
+                                                          xP, lambda ) ;
+                if( d <= RSearch ){
+                    childList.push_back(segmentId) ;
+                }
+            }
+        }
+    }
+
+    if( children.empty() ){
+        std::cout << " No cells have been refined" << std::endl;
+        return 1;
+    }
+
+    for( const auto &entry : previousLists ){
+        if( children.count(entry.first) == 0 && mesh.getCells().exists(entry.first) ){
+            expectedLists.insert( entry ) ;
+        }
+    }
+
+    for( auto & cell : mesh.getCells() ){
+        const long &id = cell.getId() ;
+
+        std::vector<long> expected ;
+        auto expectedItr = expectedLists.find(id) ;
+        if( expectedItr != expectedLists.end() ){
+            expected = expectedItr->second ;
+        }
+
+        if( object.isInNarrowBand(id) != !expected.empty() ){
+            std::cout << " Cell " << id << " is wrongly classified with respect to the narrow band" << std::endl;
+            return 1;
+        }
+
+        if( object.getSimplexList(id) != expected ){
+            std::cout << " Wrong list of simplices for cell " << id << std::endl;
+            return 1;
+        }
+    }
+
+#if BITPIT_ENABLE_MPI==1
+    MPI_Finalize();
+#endif
+
+    return 0;
+
+};
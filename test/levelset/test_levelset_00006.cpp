@@ -0,0 +1,180 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+/*!
+ *	\brief Checks that the levelset computed in the narrow band does not
+ *	depend on the number of threads.
+ */
+
+// ========================================================================== //
+// INCLUDES                                                                   //
+// ========================================================================== //
+
+//Standard Template Library
+# define _USE_MATH_DEFINES
+
+# include <algorithm>
+# include <cmath>
+# include <cstring>
+# include <vector>
+
+#if BITPIT_ENABLE_MPI==1
+# include <mpi.h>
+#endif
+
+// bitpit
+# include "bitpit_common.hpp"
+# include "bitpit_levelset.hpp"
+
+# include "test_levelset_sphere.hpp"
+
+// ========================================================================== //
+// NAMESPACES                                                                 //
+// ========================================================================== //
+using namespace bitpit;
+
+/*!
+ * Results of the computation of the levelset.
+ */
+struct LevelSetResults {
+    std::vector<double>     values ;
+    std::vector<short>      signs ;
+    std::vector<long>       supports ;
+};
+
+/*!
+ * Computes the levelset of a segmentation using the specified number of
+ * threads.
+ * @param[in] mesh is the volume mesh
+ * @param[in] segmentation is the segmentation
+ * @param[in] nThreads is the number of threads
+ * @return levelset value, sign and support of each cell
+ */
+template<typename VolumeMesh>
+LevelSetResults computeLevelSet( VolumeMesh &mesh, SurfUnstructured &segmentation, int nThreads ){
+
+    threads::setThreadCount( nThreads ) ;
+
+    LevelSet    levelset ;
+    levelset.setMesh( &mesh ) ;
+    levelset.addObject( &segmentation ) ;
+    levelset.setPropagateSign( true ) ;
+    levelset.compute( ) ;
+
+    LevelSetResults results ;
+    for( auto & cell : mesh.getCells() ){
+        const long &id = cell.getId() ;
+        results.values.push_back( levelset.getLS(id) ) ;
+        results.signs.push_back( levelset.getSign(id) ) ;
+        results.supports.push_back( levelset.getSupport(id) ) ;
+    }
+
+    return results ;
+}
+
+/*!
+ * Checks that the levelset computed with one thread and with multiple
+ * threads is the same.
+ * @param[in] mesh is the volume mesh
+ * @param[in] segmentation is the segmentation
+ * @return true if the results are bit-identical
+ */
+template<typename VolumeMesh>
+bool checkThreadIndependence( VolumeMesh &mesh, SurfUnstructured &segmentation ){
+
+    LevelSetResults serial   = computeLevelSet( mesh, segmentation, 1 ) ;
+    LevelSetResults threaded = computeLevelSet( mesh, segmentation, 4 ) ;
+
+    std::size_t nCells = serial.values.size() ;
+    if( threaded.values.size() != nCells ){
+        std::cout << " Wrong number of cells" << std::endl;
+        return false;
+    }
+
+    if( std::count( serial.supports.begin(), serial.supports.end(), levelSetDefaults::ELEMENT ) == (long) nCells ){
+        std::cout << " The narrow band is empty" << std::endl;
+        return false;
+    }
+
+    if( std::memcmp( serial.values.data(), threaded.values.data(), nCells *sizeof(double) ) != 0 ){
+        std::cout << " Levelset values depend on the number of threads" << std::endl;
+        return false;
+    }
+
+    if( serial.signs != threaded.signs ){
+        std::cout << " Levelset signs depend on the number of threads" << std::endl;
+        return false;
+    }
+
+    if( serial.supports != threaded.supports ){
+        std::cout << " Levelset supports depend on the number of threads" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+int main( int argc, char *argv[]){
+
+#if BITPIT_ENABLE_MPI==1
+    MPI_Init(&argc, &argv);
+#endif
+
+    // Input geometry
+    SurfUnstructured    sphere(0) ;
+
+    std::cout << " - Generating geometry" << std::endl;
+
+    generateSphere( sphere, 1., 12, 24 ) ;
+
+    std::array<double,3>    origin = {{-1.5, -1.5, -1.5}} ;
+    double                  length = 3. ;
+
+    // Cartesian mesh
+    std::cout << " - Checking cartesian mesh" << std::endl;
+
+    VolCartesian    cartesian( 1, 3, origin, length, 24 ) ;
+    cartesian.update() ;
+
+    if( !checkThreadIndependence( cartesian, sphere ) ){
+        return 1;
+    }
+
+    // Octree mesh
+    std::cout << " - Checking octree mesh" << std::endl;
+
+    VolOctree   octree( 2, 3, origin, length, length /16. ) ;
+    octree.update() ;
+
+    if( !checkThreadIndependence( octree, sphere ) ){
+        return 1;
+    }
+
+#if BITPIT_ENABLE_MPI==1
+    MPI_Finalize();
+#endif
+
+    return 0;
+
+};
@@ -0,0 +1,206 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+/*!
+ *	\brief Checks the propagation of the levelset outside the narrow band
+ *	against the exact distance from a sphere.
+ */
+
+// ========================================================================== //
+// INCLUDES                                                                   //
+// ========================================================================== //
+
+//Standard Template Library
+# define _USE_MATH_DEFINES
+
+# include <cmath>
+# include <cstring>
+# include <vector>
+
+#if BITPIT_ENABLE_MPI==1
+# include <mpi.h>
+#endif
+
+// bitpit
+# include "bitpit_common.hpp"
+# include "bitpit_levelset.hpp"
+
+# include "test_levelset_sphere.hpp"
+
+// ========================================================================== //
+// NAMESPACES                                                                 //
+// ========================================================================== //
+using namespace bitpit;
+
+/*!
+ * Computes the levelset of a segmentation propagating the values in the
+ * whole mesh.
+ * @param[in] mesh is the volume mesh
+ * @param[in] segmentation is the segmentation
+ * @param[in] solver is the solver used for the propagation
+ * @param[in] nThreads is the number of threads
+ * @return levelset value of each cell
+ */
+template<typename VolumeMesh>
+std::vector<double> computeLevelSet( VolumeMesh &mesh, SurfUnstructured &segmentation, LevelSetEikonalSolver solver, int nThreads ){
+
+    threads::setThreadCount( nThreads ) ;
+
+    LevelSet    levelset ;
+    levelset.setMesh( &mesh ) ;
+    levelset.addObject( &segmentation ) ;
+    levelset.setPropagateSign( true ) ;
+    levelset.setPropagateValue( true ) ;
+    levelset.setEikonalSolver( solver ) ;
+    levelset.compute( ) ;
+
+    std::vector<double> values ;
+    for( auto & cell : mesh.getCells() ){
+        values.push_back( levelset.getLS(cell.getId()) ) ;
+    }
+
+    return values ;
+}
+
+/*!
+ * Checks the levelset propagated with the specified solver against the
+ * exact signed distance from a sphere of unit radius centered in the
+ * origin.
+ * @param[in] mesh is the volume mesh
+ * @param[in] sphere is the triangulation of the sphere
+ * @param[in] solver is the solver used for the propagation
+ * @param[in] tolerance is the maximum error allowed, relative to the size
+ * of the cells
+ * @return true if the error is within the tolerance
+ */
+template<typename VolumeMesh>
+bool checkPropagation( VolumeMesh &mesh, SurfUnstructured &sphere, LevelSetEikonalSolver solver, double tolerance ){
+
+    std::vector<double> values = computeLevelSet( mesh, sphere, solver, 1 ) ;
+
+    double  maxError = 0. ;
+    double  maxSize  = 0. ;
+    std::vector<double>::const_iterator valueItr = values.begin() ;
+    for( auto & cell : mesh.getCells() ){
+        const long &id = cell.getId() ;
+
+        double exact = norm2( mesh.evalCellCentroid(id) ) - 1. ;
+        maxError = std::max( maxError, std::abs( *valueItr - exact ) ) ;
+        maxSize  = std::max( maxSize, mesh.evalCellSize(id) ) ;
+        ++valueItr ;
+    }
+
+    std::cout << "   maximum error: " << maxError << ", maximum cell size: " << maxSize << std::endl;
+
+    if( maxError > tolerance *maxSize ){
+        std::cout << " The propagated levelset differs from the distance from the sphere" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+int main( int argc, char *argv[]){
+
+#if BITPIT_ENABLE_MPI==1
+    MPI_Init(&argc, &argv);
+#endif
+
+    // Input geometry
+    SurfUnstructured    sphere(0) ;
+
+    std::cout << " - Generating geometry" << std::endl;
+
+    generateSphere( sphere, 1., 24, 48 ) ;
+
+    std::array<double,3>    origin = {{-2., -2., -2.}} ;
+    double                  length = 4. ;
+
+    // Cartesian mesh
+    VolCartesian    cartesian( 1, 3, origin, length, 32 ) ;
+    cartesian.update() ;
+
+    std::cout << " - Checking fast marching on cartesian mesh" << std::endl;
+    if( !checkPropagation( cartesian, sphere, LevelSetEikonalSolver::FAST_MARCHING, 1. ) ){
+        return 1;
+    }
+
+    std::cout << " - Checking fast sweeping on cartesian mesh" << std::endl;
+    if( !checkPropagation( cartesian, sphere, LevelSetEikonalSolver::FAST_SWEEPING, 1. ) ){
+        return 1;
+    }
+
+    // Octree mesh
+    VolOctree   octree( 2, 3, origin, length, length /32. ) ;
+    octree.update() ;
+
+    std::cout << " - Checking fast marching on octree mesh" << std::endl;
+    if( !checkPropagation( octree, sphere, LevelSetEikonalSolver::FAST_MARCHING, 1. ) ){
+        return 1;
+    }
+
+    // Fast sweeping is not available on octree meshes, fast marching is used
+    std::cout << " - Checking fast sweeping on octree mesh" << std::endl;
+    if( !checkPropagation( octree, sphere, LevelSetEikonalSolver::FAST_SWEEPING, 1. ) ){
+        return 1;
+    }
+
+    // The fast sweeping gives the same values whatever is the number of threads
+    std::cout << " - Checking fast sweeping with multiple threads" << std::endl;
+
+    std::vector<double> serial   = computeLevelSet( cartesian, sphere, LevelSetEikonalSolver::FAST_SWEEPING, 1 ) ;
+    std::vector<double> threaded = computeLevelSet( cartesian, sphere, LevelSetEikonalSolver::FAST_SWEEPING, 4 ) ;
+    if( std::memcmp( serial.data(), threaded.data(), serial.size() *sizeof(double) ) != 0 ){
+        std::cout << " The fast sweeping depends on the number of threads" << std::endl;
+        return 1;
+    }
+
+    // The propagation of the value propagates the sign as well
+    std::cout << " - Checking value propagation without sign propagation" << std::endl;
+
+    threads::setThreadCount( 1 ) ;
+
+    LevelSet    valueLevelset ;
+    valueLevelset.setMesh( &cartesian ) ;
+    valueLevelset.addObject( &sphere ) ;
+    valueLevelset.setPropagateValue( true ) ;
+    valueLevelset.compute( ) ;
+
+    std::vector<double> signedValues = computeLevelSet( cartesian, sphere, LevelSetEikonalSolver::FAST_MARCHING, 1 ) ;
+    std::vector<double>::const_iterator signedItr = signedValues.begin() ;
+    for( auto & cell : cartesian.getCells() ){
+        if( valueLevelset.getLS(cell.getId()) != *signedItr ){
+            std::cout << " The value propagation depends on the propagation of the sign" << std::endl;
+            return 1;
+        }
+        ++signedItr ;
+    }
+
+#if BITPIT_ENABLE_MPI==1
+    MPI_Finalize();
+#endif
+
+    return 0;
+
+};
@@ -0,0 +1,95 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+# ifndef __BITPIT_TEST_LEVELSET_SPHERE_HPP__
+# define __BITPIT_TEST_LEVELSET_SPHERE_HPP__
+
+// ========================================================================== //
+// INCLUDES                                                                   //
+// ========================================================================== //
+
+//Standard Template Library
+# include <array>
+# include <cmath>
+# include <vector>
+
+// bitpit
+# include "bitpit_surfunstructured.hpp"
+
+/*!
+ * Generates the triangulation of a sphere centered in the origin, the
+ * triangles are oriented outwards.
+ * @param[out] mesh is the surface mesh
+ * @param[in] R is the radius of the sphere
+ * @param[in] nLat is the number of triangles along the meridians
+ * @param[in] nLon is the number of triangles along the parallels
+ */
+inline void generateSphere( bitpit::SurfUnstructured &mesh, double R, int nLat, int nLon ){
+
+    std::array<double, 3>   point ;
+    std::vector<long>       connect(3) ;
+
+    // Vertices: north pole, parallels and south pole
+    mesh.addVertex( {{0., 0., R}} ) ;
+    for( int i=1; i<nLat; ++i){
+        double theta = i *M_PI /nLat ;
+        for( int j=0; j<nLon; ++j){
+            double phi = j *2. *M_PI /nLon ;
+            point[0] = R *sin(theta) *cos(phi) ;
+            point[1] = R *sin(theta) *sin(phi) ;
+            point[2] = R *cos(theta) ;
+            mesh.addVertex( point ) ;
+        }
+    }
+    mesh.addVertex( {{0., 0., -R}} ) ;
+
+    long southPole = 1 + (nLat-1) *nLon ;
+    auto vertex = [nLon]( int i, int j ){ return (long) (1 + (i-1) *nLon + j %nLon) ; } ;
+
+    // Triangles
+    for( int j=0; j<nLon; ++j){
+        connect = {{0, vertex(1,j), vertex(1,j+1)}} ;
+        mesh.addCell( bitpit::ElementInfo::TRIANGLE, true, connect ) ;
+    }
+
+    for( int i=1; i<nLat-1; ++i){
+        for( int j=0; j<nLon; ++j){
+            connect = {{vertex(i,j), vertex(i+1,j), vertex(i+1,j+1)}} ;
+            mesh.addCell( bitpit::ElementInfo::TRIANGLE, true, connect ) ;
+
+            connect = {{vertex(i,j), vertex(i+1,j+1), vertex(i,j+1)}} ;
+            mesh.addCell( bitpit::ElementInfo::TRIANGLE, true, connect ) ;
+        }
+    }
+
+    for( int j=0; j<nLon; ++j){
+        connect = {{vertex(nLat-1,j), southPole, vertex(nLat-1,j+1)}} ;
+        mesh.addCell( bitpit::ElementInfo::TRIANGLE, true, connect ) ;
+    }
+
+    mesh.buildAdjacencies() ;
+
+}
+
+# endif
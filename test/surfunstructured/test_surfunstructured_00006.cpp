@@ -0,0 +1,213 @@
+// ========================================================================== //
+//           ** BitPit mesh ** Test 002 for class SurfUnstructured **         //
+//                                                                            //
+// Test routines for geometrical queries for class SurfUnstructured.          //
+// ========================================================================== //
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "bitpit_surfunstructured.hpp"
+
+using namespace std;
+using namespace bitpit;
+
+/*!
+	Perturbation applied to the vertices of the triangle soup.
+
+	\param[in] n is the index of the vertex
+	\param[in] d is the coordinate
+	\param[in] amplitude is the amplitude of the perturbation
+	\result The perturbation.
+*/
+double evalPerturbation(long n, int d, double amplitude)
+{
+	double t = std::sin(12.9898 * (n + 1) + 1.3 * d) * 43758.5453;
+
+	return amplitude * (2. * (t - std::floor(t)) - 1.);
+}
+
+/*!
+	Creates a triangle soup: a triangulated square in which every triangle
+	has its own copy of the vertices. Each copy is slightly perturbed.
+
+	\param[in,out] mesh is the mesh
+	\param[in] n is the number of quadrilaterals along each direction
+	\param[in] amplitude is the amplitude of the perturbation
+*/
+void createSoup(SurfUnstructured &mesh, int n, double amplitude)
+{
+	mesh.setExpert(true);
+
+	long nVertices = 0;
+	std::vector<long> connectivity(3);
+	for (int j = 0; j < n; ++j) {
+		for (int i = 0; i < n; ++i) {
+			std::array<std::array<int, 2>, 4> corners = {{ {{i, j}}, {{i + 1, j}}, {{i + 1, j + 1}}, {{i, j + 1}} }};
+			std::array<std::array<int, 3>, 2> triangles = {{ {{0, 1, 2}}, {{0, 2, 3}} }};
+			for (const std::array<int, 3> &triangle : triangles) {
+				for (int k = 0; k < 3; ++k) {
+					const std::array<int, 2> &corner = corners[triangle[k]];
+
+					std::array<double, 3> coords;
+					coords[0] = double(corner[0]) / n + evalPerturbation(nVertices, 0, amplitude);
+					coords[1] = double(corner[1]) / n + evalPerturbation(nVertices, 1, amplitude);
+					coords[2] = evalPerturbation(nVertices, 2, amplitude);
+
+					connectivity[k] = mesh.addVertex(coords)->getId();
+					++nVertices;
+				}
+				mesh.addCell(ElementInfo::TRIANGLE, true, connectivity);
+			}
+		}
+	}
+
+	mesh.updateBoundingBox(true);
+}
+
+/*!
+	Welds a triangle soup and checks the resulting connectivity.
+*/
+int main()
+{
+	const int N = 200;
+	const double TOLERANCE = 1e-8;
+	const double AMPLITUDE = 1e-10;
+
+	SurfUnstructured mesh(0);
+	createSoup(mesh, N, AMPLITUDE);
+	mesh.setTol(TOLERANCE);
+
+	// A triangle close to the soup, but farther than the tolerance
+	std::vector<long> connectivity(3);
+	connectivity[0] = mesh.addVertex({{0., 0., 10. * TOLERANCE}})->getId();
+	connectivity[1] = mesh.addVertex({{1. / N, 0., 10. * TOLERANCE}})->getId();
+	connectivity[2] = mesh.addVertex({{1. / N, 1. / N, 10. * TOLERANCE}})->getId();
+	mesh.addCell(ElementInfo::TRIANGLE, true, connectivity);
+
+	long nSoupVertices = mesh.getVertexCount();
+
+	std::chrono::time_point<std::chrono::system_clock> start, end;
+
+	start = std::chrono::system_clock::now();
+	std::vector<long> collapsed = mesh.collapseCoincidentVertices();
+	end = std::chrono::system_clock::now();
+
+	std::cout << " Welded " << nSoupVertices << " vertices in " << std::chrono::duration<double>(end - start).count() << " s" << std::endl;
+
+	long nExpected = (N + 1) * (N + 1) + 3;
+	if ((long) collapsed.size() != nSoupVertices - nExpected) {
+		std::cout << " Wrong number of collapsed vertices: " << collapsed.size() << std::endl;
+		return 1;
+	}
+
+	// Every group is collapsed onto its first vertex, the vertices of the
+	// first triangle and of the isolated one are kept.
+	std::vector<bool> isCollapsed(nSoupVertices, false);
+	for (long vertexId : collapsed) {
+		isCollapsed[vertexId] = true;
+	}
+
+	for (long vertexId : {0L, 1L, 2L, nSoupVertices - 3, nSoupVertices - 2, nSoupVertices - 1}) {
+		if (isCollapsed[vertexId]) {
+			std::cout << " Vertex " << vertexId << " should not be collapsed" << std::endl;
+			return 1;
+		}
+	}
+
+	// Cells reference only the remaining vertices
+	for (const Cell &cell : mesh.getCells()) {
+		for (int k = 0; k < cell.getVertexCount(); ++k) {
+			if (isCollapsed[cell.getVertex(k)]) {
+				std::cout << " Cell " << cell.getId() << " references a collapsed vertex" << std::endl;
+				return 1;
+			}
+		}
+	}
+
+	mesh.deleteOrphanVertices();
+	if (mesh.getVertexCount() != nExpected) {
+		std::cout << " Wrong number of vertices after welding" << std::endl;
+		return 1;
+	}
+
+	// The welded soup is a conforming mesh
+	mesh.buildAdjacencies();
+	long nBorderFaces = 0;
+	for (const Cell &cell : mesh.getCells()) {
+		for (int face = 0; face < cell.getFaceCount(); ++face) {
+			if (cell.isFaceBorder(face)) {
+				++nBorderFaces;
+			}
+		}
+	}
+
+	if (nBorderFaces != 4 * N + 3) {
+		std::cout << " Wrong number of border faces after welding: " << nBorderFaces << std::endl;
+		return 1;
+	}
+
+	// A chain of vertices spaced just under the tolerance: every vertex is
+	// collapsed onto a vertex within the tolerance, hence the chain is not
+	// collapsed onto its first vertex.
+	const int CHAIN_LENGTH = 5;
+
+	SurfUnstructured chain(1);
+	chain.setExpert(true);
+	chain.setTol(TOLERANCE);
+
+	std::vector<long> chainVertices(CHAIN_LENGTH);
+	std::vector<long> chainCells(CHAIN_LENGTH);
+	for (int i = 0; i < CHAIN_LENGTH; ++i) {
+		chainVertices[i] = chain.addVertex({{0.6 * TOLERANCE * i, 0., 0.}})->getId();
+	}
+
+	for (int i = 0; i < CHAIN_LENGTH; ++i) {
+		connectivity[0] = chainVertices[i];
+		connectivity[1] = chain.addVertex({{1., double(i), 0.}})->getId();
+		connectivity[2] = chain.addVertex({{1., double(i) + 0.5, 1.}})->getId();
+		chainCells[i] = chain.addCell(ElementInfo::TRIANGLE, true, connectivity)->getId();
+	}
+
+	collapsed = chain.collapseCoincidentVertices();
+	if (collapsed.size() != 2 || collapsed[0] != chainVertices[1] || collapsed[1] != chainVertices[3]) {
+		std::cout << " Wrong vertices collapsed in the chain" << std::endl;
+		return 1;
+	}
+
+	std::array<int, CHAIN_LENGTH> expectedTargets = {{0, 0, 2, 2, 4}};
+	for (int i = 0; i < CHAIN_LENGTH; ++i) {
+		if (chain.getCell(chainCells[i]).getVertex(0) != chainVertices[expectedTargets[i]]) {
+			std::cout << " Vertex " << i << " of the chain collapsed onto the wrong vertex" << std::endl;
+			return 1;
+		}
+	}
+
+	return 0;
+}
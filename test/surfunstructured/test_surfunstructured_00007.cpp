@@ -0,0 +1,173 @@
+// ========================================================================== //
+//           ** BitPit mesh ** Test 002 for class SurfUnstructured **         //
+//                                                                            //
+// Test routines for geometrical queries for class SurfUnstructured.          //
+// ========================================================================== //
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "bitpit_surfunstructured.hpp"
+
+using namespace std;
+using namespace bitpit;
+
+/*!
+	Creates a triangulated square with shared vertices.
+
+	\param[in,out] mesh is the mesh
+	\param[in] n is the number of quadrilaterals along each direction
+*/
+void createMesh(SurfUnstructured &mesh, int n)
+{
+	mesh.setExpert(true);
+
+	for (int j = 0; j <= n; ++j) {
+		for (int i = 0; i <= n; ++i) {
+			mesh.addVertex({{double(i) / n, double(j) / n, 0.1 * std::sin(double(i + j) / n)}});
+		}
+	}
+
+	std::vector<long> connectivity(3);
+	for (int j = 0; j < n; ++j) {
+		for (int i = 0; i < n; ++i) {
+			long corner = i + (n + 1) * j;
+
+			connectivity[0] = corner;
+			connectivity[1] = corner + 1;
+			connectivity[2] = corner + n + 2;
+			mesh.addCell(ElementInfo::TRIANGLE, true, connectivity);
+
+			connectivity[1] = corner + n + 2;
+			connectivity[2] = corner + n + 1;
+			mesh.addCell(ElementInfo::TRIANGLE, true, connectivity);
+		}
+	}
+}
+
+/*!
+	Compares the facets of two meshes, cells are expected to be stored in
+	the same order.
+
+	\param[in] mesh is the reference mesh
+	\param[in] other is the mesh to compare
+	\result The maximum distance between the vertices of the facets.
+*/
+double compareFacets(SurfUnstructured &mesh, SurfUnstructured &other)
+{
+	double error = 0.;
+
+	auto otherItr = other.getCells().cbegin();
+	for (const Cell &cell : mesh.getCells()) {
+		for (int k = 0; k < 3; ++k) {
+			const std::array<double, 3> &coords      = mesh.getVertexCoords(cell.getVertex(k));
+			const std::array<double, 3> &otherCoords = other.getVertexCoords(otherItr->getVertex(k));
+			for (int d = 0; d < 3; ++d) {
+				error = std::max(std::abs(coords[d] - otherCoords[d]), error);
+			}
+		}
+		++otherItr;
+	}
+
+	return error;
+}
+
+/*!
+	Exports a mesh to a binary STL file and imports it back, with and
+	without welding of the vertices.
+*/
+int main()
+{
+	const int N = 100;
+	const std::string FILENAME = "surfunstructured_00007.stl";
+
+	SurfUnstructured mesh(0);
+	createMesh(mesh, N);
+	if (mesh.exportSTL(FILENAME, true) != 0) {
+		return 1;
+	}
+
+	std::chrono::time_point<std::chrono::system_clock> start, end;
+
+	// Import without welding
+	SurfUnstructured soup(1);
+	soup.setExpert(true);
+
+	start = std::chrono::system_clock::now();
+	if (soup.importSTL(FILENAME, true, 3) != 0) {
+		return 1;
+	}
+	end = std::chrono::system_clock::now();
+	std::cout << " Binary import: " << std::chrono::duration<double>(end - start).count() << " s" << std::endl;
+
+	if (soup.getCellCount() != mesh.getCellCount() || soup.getVertexCount() != 3 * mesh.getCellCount()) {
+		std::cout << " Wrong number of elements after import" << std::endl;
+		return 1;
+	}
+
+	for (const Cell &cell : soup.getCells()) {
+		if (cell.getPID() != 3) {
+			std::cout << " Wrong PID after import" << std::endl;
+			return 1;
+		}
+	}
+
+	// Import with welding
+	SurfUnstructured welded(2);
+	welded.setExpert(true);
+
+	start = std::chrono::system_clock::now();
+	if (welded.importSTL(FILENAME, true, 0, true) != 0) {
+		return 1;
+	}
+	end = std::chrono::system_clock::now();
+	std::cout << " Binary import with welding: " << std::chrono::duration<double>(end - start).count() << " s" << std::endl;
+
+	if (welded.getCellCount() != mesh.getCellCount() || welded.getVertexCount() != mesh.getVertexCount()) {
+		std::cout << " Wrong number of elements after import with welding" << std::endl;
+		return 1;
+	}
+
+	// Coordinates are stored in single precision
+	double soupError   = compareFacets(mesh, soup);
+	double weldedError = compareFacets(mesh, welded);
+	std::cout << " Import error: " << soupError << ", with welding: " << weldedError << std::endl;
+	if (soupError > 1e-6 || weldedError > 1e-6) {
+		return 1;
+	}
+
+	// Missing files are reported
+	SurfUnstructured missing(3);
+	missing.setExpert(true);
+	if (missing.importSTL("missing_00007.stl", true) == 0) {
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,272 @@
+// ========================================================================== //
+//           ** BitPit mesh ** Test 002 for class SurfUnstructured **         //
+//                                                                            //
+// Test routines for geometrical queries for class SurfUnstructured.          //
+// ========================================================================== //
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+#include "bitpit_surfunstructured.hpp"
+
+using namespace std;
+using namespace bitpit;
+
+/*!
+	Creates a triangulated square. Cells are added in a scrambled order,
+	hence their ids don't follow the position of the cells.
+
+	\param[in,out] mesh is the mesh
+	\param[in] n is the number of quadrilaterals along each direction
+*/
+void createMesh(SurfUnstructured &mesh, int n)
+{
+	mesh.setExpert(true);
+
+	for (int j = 0; j <= n; ++j) {
+		for (int i = 0; i <= n; ++i) {
+			mesh.addVertex({{double(i) / n, double(j) / n, 0.}}, j * (n + 1) + i);
+		}
+	}
+
+	// Scramble the quadrilaterals multiplying their index by a number
+	// coprime with their count
+	long nQuads = n * n;
+	long stride = 7919;
+	while (nQuads % stride == 0) {
+		++stride;
+	}
+
+	std::vector<long> connectivity(3);
+	for (long k = 0; k < nQuads; ++k) {
+		long quad = (k * stride) % nQuads;
+		int i = quad % n;
+		int j = quad / n;
+
+		std::array<long, 4> corners = {{j * (n + 1) + i, j * (n + 1) + i + 1, (j + 1) * (n + 1) + i + 1, (j + 1) * (n + 1) + i}};
+
+		connectivity = {corners[0], corners[1], corners[2]};
+		mesh.addCell(ElementInfo::TRIANGLE, true, connectivity);
+
+		connectivity = {corners[0], corners[2], corners[3]};
+		mesh.addCell(ElementInfo::TRIANGLE, true, connectivity);
+	}
+
+	mesh.buildAdjacencies();
+	mesh.buildInterfaces();
+}
+
+/*!
+	Evaluates the average distance between the ids of adjacent cells.
+
+	\param[in] mesh is the mesh
+	\result The average distance between the ids of adjacent cells.
+*/
+double evalAdjacencyDistance(SurfUnstructured &mesh)
+{
+	double distance = 0.;
+	long nAdjacencies = 0;
+	for (const Cell &cell : mesh.getCells()) {
+		const long *adjacencies = cell.getAdjacencies();
+		for (int k = 0; k < cell.getAdjacencyCount(); ++k) {
+			if (adjacencies[k] >= 0) {
+				distance += std::abs(adjacencies[k] - cell.getId());
+				++nAdjacencies;
+			}
+		}
+	}
+
+	return distance / nAdjacencies;
+}
+
+/*!
+	Checks that the ids of the elements of the container are contiguous
+	and follow the order of the storage.
+
+	\param[in] elements are the elements
+	\result Returns true if the ids are contiguous, false otherwise.
+*/
+template<typename element_t>
+bool checkContiguousIds(const PiercedVector<element_t> &elements)
+{
+	long expectedId = 0;
+	for (const element_t &element : elements) {
+		if (element.getId() != expectedId) {
+			return false;
+		}
+		++expectedId;
+	}
+
+	return true;
+}
+
+/*!
+	Checks that adjacencies and interfaces are consistent.
+
+	\param[in] mesh is the mesh
+	\result Returns true if adjacencies and interfaces are consistent,
+	false otherwise.
+*/
+bool checkNeighbourhood(SurfUnstructured &mesh)
+{
+	for (const Cell &cell : mesh.getCells()) {
+		const long *adjacencies = cell.getAdjacencies();
+		for (int k = 0; k < cell.getAdjacencyCount(); ++k) {
+			if (adjacencies[k] < 0) {
+				continue;
+			}
+
+			Cell &neigh = mesh.getCell(adjacencies[k]);
+			if (neigh.findAdjacency(cell.getId()) < 0) {
+				return false;
+			}
+		}
+	}
+
+	for (const Interface &interface : mesh.getInterfaces()) {
+		Cell &owner = mesh.getCell(interface.getOwner());
+		if (owner.getInterface(interface.getOwnerFace()) != interface.getId()) {
+			return false;
+		}
+
+		long neighId = interface.getNeigh();
+		if (neighId >= 0) {
+			const Cell &neigh = mesh.getCell(neighId);
+			if (neigh.getInterface(interface.getNeighFace()) != interface.getId()) {
+				return false;
+			}
+		}
+
+		for (int k = 0; k < interface.getVertexCount(); ++k) {
+			if (owner.findVertex(interface.getVertex(k)) < 0) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+/*!
+	Renumbers a mesh with all the available algorithms and checks the
+	resulting mesh.
+*/
+int main()
+{
+	const int N = 300;
+
+	SurfUnstructured mesh(0);
+	createMesh(mesh, N);
+
+	// Centroids of the cells
+	std::unordered_map<long, std::array<double, 3>> centroids;
+	for (const Cell &cell : mesh.getCells()) {
+		centroids[cell.getId()] = mesh.evalCellCentroid(cell.getId());
+	}
+
+	long nVertices   = mesh.getVertexCount();
+	long nCells      = mesh.getCellCount();
+	long nInterfaces = mesh.getInterfaceCount();
+
+	std::cout << " Initial adjacency id distance: " << evalAdjacencyDistance(mesh) << std::endl;
+
+	std::vector<PatchKernel::RenumberingAlgorithm> algorithms = {
+		PatchKernel::RENUMBERING_MORTON,
+		PatchKernel::RENUMBERING_CUTHILL_MCKEE,
+		PatchKernel::RENUMBERING_HILBERT
+	};
+
+	std::vector<std::string> names = {"Morton", "Cuthill-McKee", "Hilbert"};
+
+	std::chrono::time_point<std::chrono::system_clock> start, end;
+
+	for (std::size_t n = 0; n < algorithms.size(); ++n) {
+		double initialDistance = evalAdjacencyDistance(mesh);
+
+		start = std::chrono::system_clock::now();
+		std::vector<adaption::Info> renumberingInfo = mesh.renumber(algorithms[n]);
+		end = std::chrono::system_clock::now();
+
+		double distance = evalAdjacencyDistance(mesh);
+
+		std::cout << " " << names[n] << " renumbering: " << std::chrono::duration<double>(end - start).count() << " s";
+		std::cout << ", adjacency id distance: " << distance << std::endl;
+
+		if (mesh.getVertexCount() != nVertices || mesh.getCellCount() != nCells || mesh.getInterfaceCount() != nInterfaces) {
+			std::cout << " Renumbering changed the number of elements" << std::endl;
+			return 1;
+		}
+
+		if (!checkContiguousIds(mesh.getVertices()) || !checkContiguousIds(mesh.getCells()) || !checkContiguousIds(mesh.getInterfaces())) {
+			std::cout << " Renumbered ids don't follow the storage order" << std::endl;
+			return 1;
+		}
+
+		if (!checkNeighbourhood(mesh)) {
+			std::cout << " Renumbered neighbourhood is not consistent" << std::endl;
+			return 1;
+		}
+
+		// The renumbering map allows to follow the cells
+		if (renumberingInfo.size() != 3 || renumberingInfo[0].entity != adaption::ENTITY_CELL) {
+			std::cout << " Wrong renumbering information" << std::endl;
+			return 1;
+		}
+
+		const adaption::Info &cellInfo = renumberingInfo[0];
+		std::unordered_map<long, std::array<double, 3>> renumberedCentroids;
+		for (std::size_t k = 0; k < cellInfo.previous.size(); ++k) {
+			std::array<double, 3> centroid = mesh.evalCellCentroid(cellInfo.current[k]);
+			if (centroid != centroids.at(cellInfo.previous[k])) {
+				std::cout << " Renumbered cell " << cellInfo.current[k] << " doesn't match its previous cell" << std::endl;
+				return 1;
+			}
+
+			renumberedCentroids[cellInfo.current[k]] = centroid;
+		}
+		centroids.swap(renumberedCentroids);
+
+		// Space filling curves and Cuthill-McKee improve locality
+		if (n == 0 && distance > 0.1 * initialDistance) {
+			std::cout << " Renumbering didn't improve locality" << std::endl;
+			return 1;
+		}
+	}
+
+	// New elements get the next available id
+	std::vector<long> connectivity = {0, 1, 2};
+	long cellId = mesh.addCell(ElementInfo::TRIANGLE, true, connectivity)->getId();
+	if (cellId != nCells) {
+		std::cout << " Wrong id for a cell added after the renumbering" << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,176 @@
+// ========================================================================== //
+//           ** BitPit mesh ** Test 009 for class SurfUnstructured **         //
+//                                                                            //
+// Test routines for the memory usage reported by class SurfUnstructured.    //
+// ========================================================================== //
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <array>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "bitpit_surfunstructured.hpp"
+
+using namespace std;
+using namespace bitpit;
+
+/*!
+	Creates a triangulated square.
+
+	\param[in,out] mesh is the mesh
+	\param[in] n is the number of quadrilaterals along each direction
+*/
+void createMesh(SurfUnstructured &mesh, int n)
+{
+	mesh.setExpert(true);
+
+	for (int j = 0; j <= n; ++j) {
+		for (int i = 0; i <= n; ++i) {
+			mesh.addVertex({{double(i) / n, double(j) / n, 0.}}, j * (n + 1) + i);
+		}
+	}
+
+	std::vector<long> connectivity(3);
+	for (int j = 0; j < n; ++j) {
+		for (int i = 0; i < n; ++i) {
+			std::array<long, 4> corners = {{j * (n + 1) + i, j * (n + 1) + i + 1, (j + 1) * (n + 1) + i + 1, (j + 1) * (n + 1) + i}};
+
+			connectivity = {corners[0], corners[1], corners[2]};
+			mesh.addCell(ElementInfo::TRIANGLE, true, connectivity);
+
+			connectivity = {corners[0], corners[2], corners[3]};
+			mesh.addCell(ElementInfo::TRIANGLE, true, connectivity);
+		}
+	}
+}
+
+/*!
+	Gets the component with the specified name.
+
+	\param[in] usage is the memory usage
+	\param[in] name is the name of the component
+	\result The component with the specified name, an empty usage if
+	there is no such component.
+*/
+MemoryUsage getComponent(const MemoryUsage &usage, const std::string &name)
+{
+	for (const MemoryUsage &component : usage.getComponents()) {
+		if (component.getName() == name) {
+			return component;
+		}
+	}
+
+	return MemoryUsage();
+}
+
+/*!
+	Checks the memory usage reported by a patch.
+*/
+int main()
+{
+	const int N = 10;
+
+	SurfUnstructured mesh(0);
+	createMesh(mesh, N);
+	mesh.buildAdjacencies();
+	mesh.buildInterfaces();
+
+	long nVertices   = mesh.getVertexCount();
+	long nCells      = mesh.getCellCount();
+	long nInterfaces = mesh.getInterfaceCount();
+
+	// Breakdown of the patch
+	std::cout << " Checking the breakdown" << std::endl;
+
+	MemoryUsage usage = mesh.getMemoryUsage();
+
+	std::size_t totalBytes = 0;
+	for (const MemoryUsage &component : usage.getComponents()) {
+		totalBytes += component.getBytes();
+	}
+
+	if (usage.getBytes() != totalBytes) {
+		std::cout << " The total differs from the sum of the components" << std::endl;
+		return 1;
+	}
+
+	MemoryUsage vertexUsage    = getComponent(usage, "vertices");
+	MemoryUsage cellUsage      = getComponent(usage, "cells");
+	MemoryUsage interfaceUsage = getComponent(usage, "interfaces");
+
+	if (getComponent(vertexUsage, "elements").getBytes() != nVertices * sizeof(Vertex)) {
+		std::cout << " Wrong memory used by the vertices" << std::endl;
+		return 1;
+	}
+
+	if (getComponent(cellUsage, "elements").getBytes() != nCells * sizeof(Cell)) {
+		std::cout << " Wrong memory used by the cells" << std::endl;
+		return 1;
+	}
+
+	if (getComponent(cellUsage, "connectivity").getBytes() != 3 * nCells * sizeof(long)) {
+		std::cout << " Wrong memory used by the connectivity of the cells" << std::endl;
+		return 1;
+	}
+
+	if (getComponent(cellUsage, "adjacencies").getBytes() == 0 || getComponent(cellUsage, "interfaces").getBytes() == 0) {
+		std::cout << " Adjacencies and interfaces of the cells are not reported" << std::endl;
+		return 1;
+	}
+
+	if (getComponent(interfaceUsage, "elements").getBytes() != nInterfaces * sizeof(Interface)) {
+		std::cout << " Wrong memory used by the interfaces" << std::endl;
+		return 1;
+	}
+
+	// Holes left by the deletion of a cell
+	std::cout << " Checking holes" << std::endl;
+
+	mesh.deleteCell(0);
+
+	cellUsage = getComponent(mesh.getMemoryUsage(), "cells");
+	if (getComponent(cellUsage, "holes").getBytes() == 0) {
+		std::cout << " Holes of the cells are not reported" << std::endl;
+		return 1;
+	}
+
+	// Report
+	std::cout << " Checking the report" << std::endl;
+
+	std::stringstream report;
+	mesh.displayMemoryStats(report, 2);
+	std::cout << report.str();
+
+	for (const char *name : {"Memory", "vertices", "adjacencies", "holes"}) {
+		if (report.str().find(name) == std::string::npos) {
+			std::cout << " \"" << name << "\" is missing from the report" << std::endl;
+			return 1;
+		}
+	}
+
+	return 0;
+}
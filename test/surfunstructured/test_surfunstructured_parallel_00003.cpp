@@ -0,0 +1,260 @@
+// ========================================================================== //
+//           ** BitPit mesh ** Test 001 for class surftri_patch **            //
+//                                                                            //
+// Test construction, modifiers and communicators for SurfUnstructured        //
+// ========================================================================== //
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <functional>
+
+#include "bitpit_common.hpp"
+#include "bitpit_IO.hpp"
+#include "bitpit_patchkernel.hpp"
+#include "bitpit_surfunstructured.hpp"
+
+using namespace bitpit;
+
+const long N_CELLS_X = 24;
+const long N_CELLS_Y = 24;
+
+typedef std::function<int(const std::array<double, 3> &)> PartitionCriterion;
+
+/*!
+ * Generates a structured quad mesh covering the unit square
+ */
+void generateQuadMesh(SurfUnstructured &mesh)
+{
+	double dx = 1. / N_CELLS_X;
+	double dy = 1. / N_CELLS_Y;
+
+	std::array<double, 3> point = {{0., 0., 0.}};
+	for (long j = 0; j <= N_CELLS_Y; ++j) {
+		point[1] = j * dy;
+		for (long i = 0; i <= N_CELLS_X; ++i) {
+			point[0] = i * dx;
+			mesh.addVertex(point);
+		}
+	}
+
+	std::vector<long> connect(4);
+	for (long j = 0; j < N_CELLS_Y; ++j) {
+		for (long i = 0; i < N_CELLS_X; ++i) {
+			connect[0] = (N_CELLS_X + 1) * j + i;
+			connect[1] = (N_CELLS_X + 1) * j + i + 1;
+			connect[2] = (N_CELLS_X + 1) * (j + 1) + i + 1;
+			connect[3] = (N_CELLS_X + 1) * (j + 1) + i;
+			mesh.addCell(ElementInfo::QUAD, true, connect);
+		}
+	}
+
+	mesh.buildAdjacencies();
+}
+
+/*!
+ * Evaluates the number of vertex neighbours the cell has in the full mesh
+ */
+std::size_t evalExpectedNeighCount(const std::array<double, 3> &centroid)
+{
+	long i = (long) std::floor(centroid[0] * N_CELLS_X);
+	long j = (long) std::floor(centroid[1] * N_CELLS_Y);
+
+	long nx = 3 - (i == 0) - (i == N_CELLS_X - 1);
+	long ny = 3 - (j == 0) - (j == N_CELLS_Y - 1);
+
+	return nx * ny - 1;
+}
+
+/*!
+ * Evaluates the reference value of a field on the cell with the given centroid
+ */
+double evalReferenceValue(const std::array<double, 3> &centroid)
+{
+	return centroid[0] + 100. * centroid[1];
+}
+
+/*!
+ * Partitions the mesh with the given criterion and checks the result
+ */
+int partitionMesh(SurfUnstructured &mesh, const PartitionCriterion &criterion)
+{
+	int rank = mesh.getRank();
+
+	// Partition the mesh
+	std::vector<int> cellRanks;
+	for (const Cell &cell : mesh.getCells()) {
+		if (!cell.isInterior()) {
+			continue;
+		}
+
+		cellRanks.push_back(criterion(mesh.evalCellCentroid(cell.getId())));
+	}
+
+	std::vector<adaption::Info> adaptionData = mesh.partition(cellRanks, true);
+
+	// The number of sent cells should match the number of received cells
+	long counts[2] = {0, 0};
+	for (const adaption::Info &adaptionInfo : adaptionData) {
+		if (adaptionInfo.type == adaption::TYPE_PARTITION_SEND) {
+			counts[0] += adaptionInfo.previous.size();
+		} else if (adaptionInfo.type == adaption::TYPE_PARTITION_RECV) {
+			counts[1] += adaptionInfo.current.size();
+		}
+	}
+
+	long globalCounts[2];
+	MPI_Allreduce(counts, globalCounts, 2, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+	log::cout() << "  Sent " << globalCounts[0] << " cells, received " << globalCounts[1] << " cells" << std::endl;
+	if (globalCounts[0] != globalCounts[1]) {
+		log::cout() << "  Sent and received cells don't match" << std::endl;
+		return 1;
+	}
+
+	// No cell should be lost
+	long nInternals = mesh.getInternalCount();
+	long nGlobalInternals;
+	MPI_Allreduce(&nInternals, &nGlobalInternals, 1, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+	if (nGlobalInternals != N_CELLS_X * N_CELLS_Y) {
+		log::cout() << "  Wrong number of internal cells: " << nGlobalInternals << std::endl;
+		return 1;
+	}
+
+	// Cells should be owned by the expected processor and internal cells
+	// should have all their neighbours
+	for (const Cell &cell : mesh.getCells()) {
+		long cellId = cell.getId();
+		std::array<double, 3> centroid = mesh.evalCellCentroid(cellId);
+
+		int owner = rank;
+		if (!cell.isInterior()) {
+			owner = -1;
+			for (const auto &entry : mesh.getGhostExchangeTargets()) {
+				const std::vector<long> &targets = entry.second;
+				if (std::find(targets.begin(), targets.end(), cellId) != targets.end()) {
+					owner = entry.first;
+					break;
+				}
+			}
+		}
+
+		if (owner != criterion(centroid)) {
+			log::cout() << "  Cell " << cellId << " has a wrong owner" << std::endl;
+			return 1;
+		}
+
+		if (cell.isInterior() && mesh.findCellNeighs(cellId).size() != evalExpectedNeighCount(centroid)) {
+			log::cout() << "  Internal cell " << cellId << " has missing neighbours" << std::endl;
+			return 1;
+		}
+	}
+
+	// Exchange a field and check the values of the ghosts
+	PiercedVector<Cell> &cells = mesh.getCells();
+	std::vector<double> field(std::distance(cells.rawBegin(), cells.rawEnd()), -1.);
+	for (const Cell &cell : cells) {
+		if (cell.isInterior()) {
+			field[cells.rawIndex(cell.getId())] = evalReferenceValue(mesh.evalCellCentroid(cell.getId()));
+		}
+	}
+
+	GhostExchanger exchanger(mesh);
+	exchanger.exchange(field);
+
+	for (const Cell &cell : cells) {
+		double expected = evalReferenceValue(mesh.evalCellCentroid(cell.getId()));
+		if (std::abs(field[cells.rawIndex(cell.getId())] - expected) > 1e-10) {
+			log::cout() << "  Wrong value for ghost " << cell.getId() << std::endl;
+			return 1;
+		}
+	}
+
+	log::cout() << "  Rank " << rank << " has " << mesh.getInternalCount() << " internal cells and ";
+	log::cout() << mesh.getGhostCount() << " ghosts" << std::endl;
+
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
+
+	MPI_Init(&argc,&argv);
+
+	int nProcs;
+	int	rank;
+	MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+	log::manager().initialize(log::COMBINED, true, nProcs, rank);
+	log::cout().setVisibility(log::GLOBAL);
+	log::cout() << "Testing concurrent cell migration" << "\n";
+
+	SurfUnstructured mesh(0);
+	mesh.setCommunicator(MPI_COMM_WORLD);
+	if (rank == 0) {
+		generateQuadMesh(mesh);
+	}
+
+	int status = 0;
+
+	// Vertical strips, all the cells are sent by the first processor
+	log::cout() << "  >> Vertical strips" << "\n";
+	status = std::max(status, partitionMesh(mesh, [nProcs] (const std::array<double, 3> &centroid) {
+		return std::min((int) (centroid[0] * nProcs), nProcs - 1);
+	}));
+
+	// Horizontal strips, every processor sends cells to all the others
+	log::cout() << "  >> Horizontal strips" << "\n";
+	status = std::max(status, partitionMesh(mesh, [nProcs] (const std::array<double, 3> &centroid) {
+		return std::min((int) (centroid[1] * nProcs), nProcs - 1);
+	}));
+
+	// Blocks, every cell is on the border of a partition
+	log::cout() << "  >> Scattered blocks" << "\n";
+	status = std::max(status, partitionMesh(mesh, [nProcs] (const std::array<double, 3> &centroid) {
+		long i = (long) std::floor(centroid[0] * N_CELLS_X / 2);
+		long j = (long) std::floor(centroid[1] * N_CELLS_Y / 2);
+		return (int) ((i + 3 * j) % nProcs);
+	}));
+
+	// Everything back on the last processor
+	log::cout() << "  >> Single processor" << "\n";
+	status = std::max(status, partitionMesh(mesh, [nProcs] (const std::array<double, 3> &) {
+		return nProcs - 1;
+	}));
+
+	// Received vertices should have been merged with the existing ones
+	if (rank == nProcs - 1 && mesh.getVertexCount() != (N_CELLS_X + 1) * (N_CELLS_Y + 1)) {
+		log::cout() << "  Wrong number of vertices: " << mesh.getVertexCount() << std::endl;
+		status = 1;
+	}
+
+	int globalStatus;
+	MPI_Allreduce(&status, &globalStatus, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+
+	MPI_Finalize();
+
+	return globalStatus;
+}
@@ -0,0 +1,236 @@
+// ========================================================================== //
+//           ** BitPit mesh ** Test 001 for class surftri_patch **            //
+//                                                                            //
+// Test construction, modifiers and communicators for SurfUnstructured        //
+// ========================================================================== //
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include "bitpit_common.hpp"
+#include "bitpit_IO.hpp"
+#include "bitpit_patchkernel.hpp"
+#include "bitpit_surfunstructured.hpp"
+
+using namespace bitpit;
+
+const long N_CELLS_X = 32;
+const long N_CELLS_Y = 32;
+
+/*!
+ * Generates a structured quad mesh covering the unit square
+ */
+void generateQuadMesh(SurfUnstructured &mesh)
+{
+	double dx = 1. / N_CELLS_X;
+	double dy = 1. / N_CELLS_Y;
+
+	std::array<double, 3> point = {{0., 0., 0.}};
+	for (long j = 0; j <= N_CELLS_Y; ++j) {
+		point[1] = j * dy;
+		for (long i = 0; i <= N_CELLS_X; ++i) {
+			point[0] = i * dx;
+			mesh.addVertex(point);
+		}
+	}
+
+	std::vector<long> connect(4);
+	for (long j = 0; j < N_CELLS_Y; ++j) {
+		for (long i = 0; i < N_CELLS_X; ++i) {
+			connect[0] = (N_CELLS_X + 1) * j + i;
+			connect[1] = (N_CELLS_X + 1) * j + i + 1;
+			connect[2] = (N_CELLS_X + 1) * (j + 1) + i + 1;
+			connect[3] = (N_CELLS_X + 1) * (j + 1) + i;
+			mesh.addCell(ElementInfo::QUAD, true, connect);
+		}
+	}
+
+	mesh.buildAdjacencies();
+}
+
+/*!
+ * Evaluates the weights of the internal cells, cells on the left of the
+ * domain are more expensive
+ */
+std::vector<double> evalCellWeights(SurfUnstructured &mesh)
+{
+	std::vector<double> weights;
+	for (const Cell &cell : mesh.getCells()) {
+		if (!cell.isInterior()) {
+			continue;
+		}
+
+		double x = mesh.evalCellCentroid(cell.getId())[0];
+		weights.push_back((x < 0.25) ? 4. : 1.);
+	}
+
+	return weights;
+}
+
+/*!
+ * Checks the balance of the partition and evaluates the number of faces
+ * shared by different processors
+ */
+int checkPartition(SurfUnstructured &mesh, const std::vector<double> &weights, long *nCutFaces)
+{
+	int nProcs = mesh.getProcessorCount();
+
+	// No cell should be lost
+	long nInternals = mesh.getInternalCount();
+	long nGlobalInternals;
+	MPI_Allreduce(&nInternals, &nGlobalInternals, 1, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+	if (nGlobalInternals != N_CELLS_X * N_CELLS_Y) {
+		log::cout() << "  Wrong number of internal cells: " << nGlobalInternals << std::endl;
+		return 1;
+	}
+
+	// Load imbalance
+	double load = 0.;
+	for (double weight : weights) {
+		load += weight;
+	}
+
+	double maxLoad;
+	double totalLoad;
+	MPI_Allreduce(&load, &maxLoad, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+	MPI_Allreduce(&load, &totalLoad, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+
+	double imbalance = maxLoad / (totalLoad / nProcs);
+	log::cout() << "  Load imbalance " << imbalance << std::endl;
+	if (imbalance > 1.06) {
+		log::cout() << "  The partition is not balanced" << std::endl;
+		return 1;
+	}
+
+	// Faces shared by different processors
+	long nLocalCutFaces = 0;
+	for (const Cell &cell : mesh.getCells()) {
+		if (!cell.isInterior()) {
+			continue;
+		}
+
+		int nCellFaces = cell.getFaceCount();
+		for (int face = 0; face < nCellFaces; ++face) {
+			int nFaceAdjacencies = cell.getAdjacencyCount(face);
+			for (int k = 0; k < nFaceAdjacencies; ++k) {
+				long neighId = cell.getAdjacency(face, k);
+				if (neighId >= 0 && !mesh.getCell(neighId).isInterior()) {
+					++nLocalCutFaces;
+				}
+			}
+		}
+	}
+
+	MPI_Allreduce(&nLocalCutFaces, nCutFaces, 1, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+	*nCutFaces /= 2;
+	log::cout() << "  Faces shared by different processors " << *nCutFaces << std::endl;
+
+	return 0;
+}
+
+/*!
+ * Counts the cells moved among the processors
+ */
+long countMovedCells(const std::vector<adaption::Info> &adaptionData)
+{
+	long nMoved = 0;
+	for (const adaption::Info &adaptionInfo : adaptionData) {
+		if (adaptionInfo.type == adaption::TYPE_PARTITION_SEND) {
+			nMoved += adaptionInfo.previous.size();
+		}
+	}
+
+	MPI_Allreduce(MPI_IN_PLACE, &nMoved, 1, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+
+	return nMoved;
+}
+
+int main(int argc, char *argv[]) {
+
+	MPI_Init(&argc,&argv);
+
+	int nProcs;
+	int	rank;
+	MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+	log::manager().initialize(log::COMBINED, true, nProcs, rank);
+	log::cout().setVisibility(log::GLOBAL);
+	log::cout() << "Testing partition balancing" << "\n";
+
+	SurfUnstructured mesh(0);
+	mesh.setCommunicator(MPI_COMM_WORLD);
+	if (rank == 0) {
+		generateQuadMesh(mesh);
+	}
+
+	int status = 0;
+	long nCutFaces;
+	std::vector<adaption::Info> adaptionData;
+
+	// Balance cells with the same weight
+	log::cout() << "  >> Uniform weights" << "\n";
+	mesh.balancePartition(false);
+	status = std::max(status, checkPartition(mesh, std::vector<double>(mesh.getInternalCount(), 1.), &nCutFaces));
+
+	// Balance weighted cells along the space filling curve
+	log::cout() << "  >> Weighted cells, space filling curve" << "\n";
+	adaptionData = mesh.balancePartition(evalCellWeights(mesh), PatchKernel::PARTITIONING_SFC, true);
+	status = std::max(status, checkPartition(mesh, evalCellWeights(mesh), &nCutFaces));
+	log::cout() << "  Moved cells " << countMovedCells(adaptionData) << std::endl;
+
+	long nSFCCutFaces = nCutFaces;
+
+	// Balancing an already balanced partition should not move cells
+	log::cout() << "  >> Weighted cells, space filling curve, balanced partition" << "\n";
+	adaptionData = mesh.balancePartition(evalCellWeights(mesh), PatchKernel::PARTITIONING_SFC, true);
+	status = std::max(status, checkPartition(mesh, evalCellWeights(mesh), &nCutFaces));
+
+	long nMoved = countMovedCells(adaptionData);
+	log::cout() << "  Moved cells " << nMoved << std::endl;
+	if (nMoved != 0) {
+		log::cout() << "  Cells of a balanced partition have been moved" << std::endl;
+		status = 1;
+	}
+
+	// Balance weighted cells refining the partition on the dual graph
+	log::cout() << "  >> Weighted cells, graph" << "\n";
+	adaptionData = mesh.balancePartition(evalCellWeights(mesh), PatchKernel::PARTITIONING_GRAPH, true);
+	status = std::max(status, checkPartition(mesh, evalCellWeights(mesh), &nCutFaces));
+	log::cout() << "  Moved cells " << countMovedCells(adaptionData) << std::endl;
+	if (nCutFaces > nSFCCutFaces) {
+		log::cout() << "  The graph partition has more shared faces than the curve partition" << std::endl;
+		status = 1;
+	}
+
+	int globalStatus;
+	MPI_Allreduce(&status, &globalStatus, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+
+	MPI_Finalize();
+
+	return globalStatus;
+}
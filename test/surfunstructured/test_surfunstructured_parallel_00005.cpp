@@ -0,0 +1,261 @@
+// ========================================================================== //
+//           ** BitPit mesh ** Test 001 for class surftri_patch **            //
+//                                                                            //
+// Test construction, modifiers and communicators for SurfUnstructured        //
+// ========================================================================== //
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+
+#include "bitpit_common.hpp"
+#include "bitpit_IO.hpp"
+#include "bitpit_patchkernel.hpp"
+#include "bitpit_surfunstructured.hpp"
+
+using namespace bitpit;
+
+const long N_CELLS_X = 24;
+const long N_CELLS_Y = 24;
+
+typedef std::function<int(long, long)> PartitionCriterion;
+
+/*!
+ * Generates a structured quad mesh covering the unit square
+ */
+void generateQuadMesh(SurfUnstructured &mesh)
+{
+	double dx = 1. / N_CELLS_X;
+	double dy = 1. / N_CELLS_Y;
+
+	std::array<double, 3> point = {{0., 0., 0.}};
+	for (long j = 0; j <= N_CELLS_Y; ++j) {
+		point[1] = j * dy;
+		for (long i = 0; i <= N_CELLS_X; ++i) {
+			point[0] = i * dx;
+			mesh.addVertex(point);
+		}
+	}
+
+	std::vector<long> connect(4);
+	for (long j = 0; j < N_CELLS_Y; ++j) {
+		for (long i = 0; i < N_CELLS_X; ++i) {
+			connect[0] = (N_CELLS_X + 1) * j + i;
+			connect[1] = (N_CELLS_X + 1) * j + i + 1;
+			connect[2] = (N_CELLS_X + 1) * (j + 1) + i + 1;
+			connect[3] = (N_CELLS_X + 1) * (j + 1) + i;
+			mesh.addCell(ElementInfo::QUAD, true, connect);
+		}
+	}
+
+	mesh.buildAdjacencies();
+}
+
+/*!
+ * Evaluates the indices of the cell with the given centroid
+ */
+std::array<long, 2> evalCellIndices(const std::array<double, 3> &centroid)
+{
+	return {{(long) std::floor(centroid[0] * N_CELLS_X), (long) std::floor(centroid[1] * N_CELLS_Y)}};
+}
+
+/*!
+ * Evaluates the distance between two cells, measured in layers of neighbours
+ */
+long evalLayerDistance(long i1, long j1, long i2, long j2, PatchKernel::HaloConnectivity connectivity)
+{
+	long di = std::abs(i1 - i2);
+	long dj = std::abs(j1 - j2);
+	if (connectivity == PatchKernel::HALO_FACE) {
+		return di + dj;
+	} else {
+		return std::max(di, dj);
+	}
+}
+
+/*!
+ * Partitions the mesh with the given criterion
+ */
+void partitionMesh(SurfUnstructured &mesh, const PartitionCriterion &criterion)
+{
+	std::vector<int> cellRanks;
+	for (const Cell &cell : mesh.getCells()) {
+		if (!cell.isInterior()) {
+			continue;
+		}
+
+		std::array<long, 2> indices = evalCellIndices(mesh.evalCellCentroid(cell.getId()));
+		cellRanks.push_back(criterion(indices[0], indices[1]));
+	}
+
+	mesh.partition(cellRanks, false);
+}
+
+/*!
+ * Checks that the ghosts are all the cells within the halo of the
+ * internal cells and that a single exchange updates all of them
+ */
+int checkHalo(SurfUnstructured &mesh, const PartitionCriterion &criterion)
+{
+	int rank = mesh.getRank();
+	std::size_t haloSize = mesh.getHaloSize();
+	PatchKernel::HaloConnectivity connectivity = mesh.getHaloConnectivity();
+
+	// Expected ghosts
+	long nExpectedGhosts = 0;
+	std::vector<long> distances(N_CELLS_X * N_CELLS_Y, -1);
+	for (long j = 0; j < N_CELLS_Y; ++j) {
+		for (long i = 0; i < N_CELLS_X; ++i) {
+			if (criterion(i, j) == rank) {
+				continue;
+			}
+
+			long distance = N_CELLS_X + N_CELLS_Y;
+			for (long m = 0; m < N_CELLS_Y; ++m) {
+				for (long n = 0; n < N_CELLS_X; ++n) {
+					if (criterion(n, m) == rank) {
+						distance = std::min(distance, evalLayerDistance(i, j, n, m, connectivity));
+					}
+				}
+			}
+
+			distances[N_CELLS_X * j + i] = distance;
+			if (distance <= (long) haloSize) {
+				++nExpectedGhosts;
+			}
+		}
+	}
+
+	if (mesh.getGhostCount() != nExpectedGhosts) {
+		log::cout() << "  Rank " << rank << " has " << mesh.getGhostCount() << " ghosts instead of " << nExpectedGhosts << std::endl;
+		return 1;
+	}
+
+	for (const Cell &cell : mesh.getCells()) {
+		std::array<long, 2> indices = evalCellIndices(mesh.evalCellCentroid(cell.getId()));
+		long distance = distances[N_CELLS_X * indices[1] + indices[0]];
+		if (cell.isInterior() != (distance < 0) || distance > (long) haloSize) {
+			log::cout() << "  Cell " << cell.getId() << " should not be on rank " << rank << std::endl;
+			return 1;
+		}
+	}
+
+	// Exchange the indices of the cells
+	PiercedVector<Cell> &cells = mesh.getCells();
+	std::vector<long> field(std::distance(cells.rawBegin(), cells.rawEnd()), -1);
+	for (const Cell &cell : cells) {
+		if (cell.isInterior()) {
+			std::array<long, 2> indices = evalCellIndices(mesh.evalCellCentroid(cell.getId()));
+			field[cells.rawIndex(cell.getId())] = N_CELLS_X * indices[1] + indices[0];
+		}
+	}
+
+	GhostExchanger exchanger(mesh);
+	exchanger.exchange(field);
+
+	for (const Cell &cell : cells) {
+		std::array<long, 2> indices = evalCellIndices(mesh.evalCellCentroid(cell.getId()));
+		if (field[cells.rawIndex(cell.getId())] != N_CELLS_X * indices[1] + indices[0]) {
+			log::cout() << "  Wrong value for ghost " << cell.getId() << std::endl;
+			return 1;
+		}
+	}
+
+	log::cout() << "  Rank " << rank << " has " << mesh.getInternalCount() << " internal cells and ";
+	log::cout() << mesh.getGhostCount() << " ghosts" << std::endl;
+
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
+
+	MPI_Init(&argc,&argv);
+
+	int nProcs;
+	int	rank;
+	MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+	log::manager().initialize(log::COMBINED, true, nProcs, rank);
+	log::cout().setVisibility(log::GLOBAL);
+	log::cout() << "Testing ghost halos of configurable size" << "\n";
+
+	SurfUnstructured mesh(0);
+	mesh.setCommunicator(MPI_COMM_WORLD);
+	mesh.setHaloSize(2);
+	if (rank == 0) {
+		generateQuadMesh(mesh);
+	}
+
+	PartitionCriterion blocks = [nProcs] (long i, long j) {
+		return (int) ((i / (N_CELLS_X / 2) + 2 * (j / (N_CELLS_Y / 2))) % nProcs);
+	};
+
+	PartitionCriterion strips = [nProcs] (long i, long) {
+		return (int) (i * nProcs / N_CELLS_X);
+	};
+
+	int status = 0;
+
+	// Two vertex layers built during the partitioning
+	log::cout() << "  >> Two vertex layers" << "\n";
+	partitionMesh(mesh, blocks);
+	status = std::max(status, checkHalo(mesh, blocks));
+
+	// Grow the halo of a partitioned patch
+	log::cout() << "  >> Three vertex layers" << "\n";
+	mesh.setHaloSize(3);
+	status = std::max(status, checkHalo(mesh, blocks));
+
+	// Change the connectivity of the halo
+	log::cout() << "  >> Two face layers" << "\n";
+	mesh.setHaloSize(2, PatchKernel::HALO_FACE);
+	status = std::max(status, checkHalo(mesh, blocks));
+
+	// Migrate cells keeping the halo
+	log::cout() << "  >> Two face layers after migration" << "\n";
+	partitionMesh(mesh, strips);
+	status = std::max(status, checkHalo(mesh, strips));
+
+	log::cout() << "  >> Three face layers after migration" << "\n";
+	partitionMesh(mesh, blocks);
+	mesh.setHaloSize(3, PatchKernel::HALO_FACE);
+	status = std::max(status, checkHalo(mesh, blocks));
+
+	// Back to the default halo
+	log::cout() << "  >> One vertex layer" << "\n";
+	mesh.setHaloSize(1);
+	status = std::max(status, checkHalo(mesh, blocks));
+
+	int globalStatus;
+	MPI_Allreduce(&status, &globalStatus, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+
+	MPI_Finalize();
+
+	return globalStatus;
+}
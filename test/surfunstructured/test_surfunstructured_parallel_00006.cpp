@@ -0,0 +1,277 @@
+// ========================================================================== //
+//           ** BitPit mesh ** Test 001 for class surftri_patch **            //
+//                                                                            //
+// Test construction, modifiers and communicators for SurfUnstructured        //
+// ========================================================================== //
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <array>
+#include <cmath>
+#include <string>
+
+#include "bitpit_common.hpp"
+#include "bitpit_IO.hpp"
+#include "bitpit_patchkernel.hpp"
+#include "bitpit_surfunstructured.hpp"
+
+using namespace bitpit;
+
+const long N_CELLS_X = 16;
+const long N_CELLS_Y = 16;
+
+/*!
+ * Generates a structured triangle mesh covering the unit square
+ */
+void generateTriangleMesh(SurfUnstructured &mesh)
+{
+	double dx = 1. / N_CELLS_X;
+	double dy = 1. / N_CELLS_Y;
+
+	std::array<double, 3> point = {{0., 0., 0.}};
+	for (long j = 0; j <= N_CELLS_Y; ++j) {
+		point[1] = j * dy;
+		for (long i = 0; i <= N_CELLS_X; ++i) {
+			point[0] = i * dx;
+			mesh.addVertex(point);
+		}
+	}
+
+	for (long j = 0; j < N_CELLS_Y; ++j) {
+		for (long i = 0; i < N_CELLS_X; ++i) {
+			long v0 = (N_CELLS_X + 1) * j + i;
+			long v1 = (N_CELLS_X + 1) * j + i + 1;
+			long v2 = (N_CELLS_X + 1) * (j + 1) + i + 1;
+			long v3 = (N_CELLS_X + 1) * (j + 1) + i;
+
+			mesh.addCell(ElementInfo::TRIANGLE, true, std::vector<long>{v0, v1, v2});
+			mesh.addCell(ElementInfo::TRIANGLE, true, std::vector<long>{v0, v2, v3});
+		}
+	}
+}
+
+/*!
+ * Checks that the restored patch matches the original one
+ */
+int comparePatches(SurfUnstructured &patch, SurfUnstructured &restored)
+{
+	// Vertices
+	if (patch.getVertexCount() != restored.getVertexCount()) {
+		log::cout() << "  Wrong number of vertices" << std::endl;
+		return 1;
+	}
+
+	auto restoredVertexItr = restored.getVertices().cbegin();
+	for (const Vertex &vertex : patch.getVertices()) {
+		const Vertex &restoredVertex = *(restoredVertexItr++);
+		if (vertex.getId() != restoredVertex.getId() || vertex.getCoords() != restoredVertex.getCoords()) {
+			log::cout() << "  Vertex " << vertex.getId() << " was not restored" << std::endl;
+			return 1;
+		}
+	}
+
+	// Cells
+	if (patch.getCellCount() != restored.getCellCount() || patch.getInternalCount() != restored.getInternalCount()) {
+		log::cout() << "  Wrong number of cells" << std::endl;
+		return 1;
+	}
+
+	auto restoredCellItr = restored.getCells().cbegin();
+	for (const Cell &cell : patch.getCells()) {
+		const Cell &restoredCell = *(restoredCellItr++);
+
+		bool matches = (cell.getId() == restoredCell.getId());
+		matches &= (cell.getType() == restoredCell.getType());
+		matches &= (cell.isInterior() == restoredCell.isInterior());
+		matches &= (cell.getPID() == restoredCell.getPID());
+		matches &= std::equal(cell.getConnect(), cell.getConnect() + cell.getVertexCount(), restoredCell.getConnect());
+
+		matches &= (cell.getAdjacencyCount() == restoredCell.getAdjacencyCount());
+		matches &= matches && std::equal(cell.getAdjacencies(), cell.getAdjacencies() + cell.getAdjacencyCount(), restoredCell.getAdjacencies());
+
+		matches &= (cell.getInterfaceCount() == restoredCell.getInterfaceCount());
+		matches &= matches && std::equal(cell.getInterfaces(), cell.getInterfaces() + cell.getInterfaceCount(), restoredCell.getInterfaces());
+
+		if (!matches) {
+			log::cout() << "  Cell " << cell.getId() << " was not restored" << std::endl;
+			return 1;
+		}
+	}
+
+	// Interfaces
+	if (patch.getInterfaceCount() != restored.getInterfaceCount()) {
+		log::cout() << "  Wrong number of interfaces" << std::endl;
+		return 1;
+	}
+
+	auto restoredInterfaceItr = restored.getInterfaces().cbegin();
+	for (const Interface &interface : patch.getInterfaces()) {
+		const Interface &restoredInterface = *(restoredInterfaceItr++);
+
+		bool matches = (interface.getId() == restoredInterface.getId());
+		matches &= (interface.getOwner() == restoredInterface.getOwner());
+		matches &= (interface.getOwnerFace() == restoredInterface.getOwnerFace());
+		matches &= (interface.getNeigh() == restoredInterface.getNeigh());
+		matches &= (interface.getNeighFace() == restoredInterface.getNeighFace());
+		matches &= std::equal(interface.getConnect(), interface.getConnect() + interface.getVertexCount(), restoredInterface.getConnect());
+
+		if (!matches) {
+			log::cout() << "  Interface " << interface.getId() << " was not restored" << std::endl;
+			return 1;
+		}
+	}
+
+	// Ghost information
+	if (patch.getHaloSize() != restored.getHaloSize()) {
+		log::cout() << "  Halo size was not restored" << std::endl;
+		return 1;
+	}
+
+	if (patch.getGhostExchangeTargets() != restored.getGhostExchangeTargets() ||
+	        patch.getGhostExchangeSources() != restored.getGhostExchangeSources()) {
+		log::cout() << "  Exchange information was not restored" << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
+
+/*!
+ * Checks that the restored patch generates the same ids of the original one
+ */
+int compareGeneratedIds(SurfUnstructured &patch, SurfUnstructured &restored)
+{
+	std::vector<long> connect = {{0, 1, N_CELLS_X + 1}};
+
+	long cellId = patch.addCell(ElementInfo::TRIANGLE, true, connect)->getId();
+	long restoredCellId = restored.addCell(ElementInfo::TRIANGLE, true, connect)->getId();
+
+	patch.deleteCell(cellId);
+	restored.deleteCell(restoredCellId);
+
+	if (cellId != restoredCellId) {
+		log::cout() << "  Restored patch generates different ids" << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
+
+	MPI_Init(&argc,&argv);
+
+	int nProcs;
+	int	rank;
+	MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+	log::manager().initialize(log::COMBINED, true, nProcs, rank);
+	log::cout().setVisibility(log::GLOBAL);
+	log::cout() << "Testing dump and restore of patches" << "\n";
+
+	int status = 0;
+
+	// Serial restart
+	//
+	// Some cells are deleted to have holes in the storage and ids to
+	// recycle.
+	log::cout() << "  >> Serial restart" << "\n";
+
+	SurfUnstructured mesh(0);
+	if (rank == 0) {
+		generateTriangleMesh(mesh);
+		for (long cellId = 0; cellId < 2 * N_CELLS_X * N_CELLS_Y; cellId += 37) {
+			mesh.deleteCell(cellId, false);
+		}
+
+		for (Cell &cell : mesh.getCells()) {
+			cell.setPID(cell.getId() % 3);
+		}
+
+		mesh.buildAdjacencies();
+		mesh.buildInterfaces();
+
+		mesh.dump("test_surfunstructured_parallel_00006_serial.dat");
+
+		SurfUnstructured restored(1);
+		restored.restore("test_surfunstructured_parallel_00006_serial.dat");
+
+		status = std::max(status, comparePatches(mesh, restored));
+		status = std::max(status, compareGeneratedIds(mesh, restored));
+	}
+
+	// Parallel restart
+	log::cout() << "  >> Parallel restart" << "\n";
+
+	mesh.resetInterfaces();
+
+	std::vector<int> cellRanks;
+	for (const Cell &cell : mesh.getCells()) {
+		std::array<double, 3> centroid = mesh.evalCellCentroid(cell.getId());
+		cellRanks.push_back(std::min((int) (centroid[0] * nProcs), nProcs - 1));
+	}
+
+	mesh.setHaloSize(2);
+	mesh.partition(MPI_COMM_WORLD, cellRanks, false);
+	mesh.buildInterfaces();
+
+	mesh.dump("test_surfunstructured_parallel_00006.dat");
+
+	SurfUnstructured restored(1);
+	restored.setCommunicator(MPI_COMM_WORLD);
+	restored.restore("test_surfunstructured_parallel_00006.dat");
+
+	status = std::max(status, comparePatches(mesh, restored));
+
+	// Exchange data on the restored patch
+	PiercedVector<Cell> &cells = restored.getCells();
+	std::vector<double> field(std::distance(cells.rawBegin(), cells.rawEnd()), -1.);
+	for (const Cell &cell : cells) {
+		if (cell.isInterior()) {
+			field[cells.rawIndex(cell.getId())] = restored.evalCellCentroid(cell.getId())[0];
+		}
+	}
+
+	GhostExchanger exchanger(restored);
+	exchanger.exchange(field);
+
+	for (const Cell &cell : cells) {
+		if (std::abs(field[cells.rawIndex(cell.getId())] - restored.evalCellCentroid(cell.getId())[0]) > 1e-12) {
+			log::cout() << "  Wrong value for ghost " << cell.getId() << std::endl;
+			status = 1;
+			break;
+		}
+	}
+
+	log::cout() << "  Rank " << rank << " restored " << restored.getInternalCount() << " internal cells and ";
+	log::cout() << restored.getGhostCount() << " ghosts" << std::endl;
+
+	int globalStatus;
+	MPI_Allreduce(&status, &globalStatus, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+
+	MPI_Finalize();
+
+	return globalStatus;
+}
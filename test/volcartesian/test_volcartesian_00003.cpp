@@ -0,0 +1,125 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <array>
+#if BITPIT_ENABLE_MPI==1
+#include <mpi.h>
+#endif
+
+#include "bitpit_common.hpp"
+#include "bitpit_volcartesian.hpp"
+
+using namespace bitpit;
+
+/*!
+	Checks the adjacencies and the interfaces of all the faces of the cells
+	against the cartesian indices of the cells.
+
+	\param patch is the patch
+	\result Returns true if the adjacencies and the interfaces are correct.
+*/
+bool checkFaces(VolCartesian &patch)
+{
+	int dimension = patch.getDimension();
+
+	for (const Cell &cell : patch.getCells()) {
+		long id = cell.getId();
+		std::array<int, 3> ijk = patch.getCellCartesianId(id);
+
+		for (int face = 0; face < 2 * dimension; ++face) {
+			int direction = face / 2;
+
+			std::array<int, 3> neighIJK = ijk;
+			neighIJK[direction] += (face % 2 == 0) ? -1 : 1;
+
+			long expectedNeigh = Element::NULL_ID;
+			if (patch.isCellCartesianIdValid(neighIJK)) {
+				expectedNeigh = patch.getCellLinearId(neighIJK);
+			}
+
+			if (cell.getAdjacency(face, 0) != expectedNeigh) {
+				log::cout() << "Wrong adjacency on face " << face << " of cell " << id << std::endl;
+				return false;
+			}
+
+			long interfaceId = cell.getInterface(face, 0);
+			if (!patch.getInterfaces().exists(interfaceId)) {
+				log::cout() << "Missing interface on face " << face << " of cell " << id << std::endl;
+				return false;
+			}
+
+			const Interface &interface = patch.getInterface(interfaceId);
+			if (interface.getOwner() == id) {
+				if (interface.getOwnerFace() != face || interface.getNeigh() != expectedNeigh) {
+					log::cout() << "Wrong interface on face " << face << " of cell " << id << std::endl;
+					return false;
+				}
+			} else if (interface.getNeigh() != id || interface.getNeighFace() != face || interface.getOwner() != expectedNeigh) {
+				log::cout() << "Wrong interface on face " << face << " of cell " << id << std::endl;
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+int main(int argc, char *argv[]) {
+
+#if BITPIT_ENABLE_MPI==1
+	MPI_Init(&argc,&argv);
+#else
+	BITPIT_UNUSED(argc);
+	BITPIT_UNUSED(argv);
+#endif
+
+	log::manager().initialize(log::COMBINED);
+	log::cout() << "Testing adjacencies and interfaces of Cartesian patches" << "\n";
+
+	std::array<double, 3> origin = {{-1., -1., -1.}};
+	std::array<double, 3> lengths = {{4., 3., 5.}};
+
+	log::cout() << "  >> 2D Cartesian patch" << "\n";
+
+	VolCartesian patch_2D(0, 2, origin, lengths, {{4, 3, 1}});
+	patch_2D.update();
+	if (!checkFaces(patch_2D)) {
+		return 1;
+	}
+
+	log::cout() << "  >> 3D Cartesian patch" << "\n";
+
+	VolCartesian patch_3D(1, 3, origin, lengths, {{4, 3, 5}});
+	patch_3D.update();
+	if (!checkFaces(patch_3D)) {
+		return 1;
+	}
+
+#if BITPIT_ENABLE_MPI==1
+	MPI_Finalize();
+#endif
+
+	return 0;
+
+}
@@ -0,0 +1,196 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <array>
+#include <cmath>
+#include <string>
+
+#include "bitpit_common.hpp"
+#include "bitpit_IO.hpp"
+#include "bitpit_voloctree.hpp"
+
+using namespace bitpit;
+
+/*!
+ * Evaluates the reference value of the field on the specified cell
+ */
+double evalReferenceValue(VolOctree *patch, long id, int component)
+{
+	std::array<double, 3> centroid = patch->evalCellCentroid(id);
+
+	return (component + 1) * (centroid[0] + 100. * centroid[1] + 10000. * centroid[2]);
+}
+
+/*!
+ * Evaluates the size of a field that contains the values of all the cells
+ */
+std::size_t evalFieldSize(VolOctree *patch)
+{
+	std::size_t size = 0;
+	for (const Cell &cell : patch->getCells()) {
+		size = std::max(size, patch->getCells().rawIndex(cell.getId()) + 1);
+	}
+
+	return size;
+}
+
+/*!
+ * Exchanges the ghosts of a field with the specified number of components
+ * and checks the values received by the ghosts.
+ */
+int checkExchange(VolOctree *patch, GhostExchanger &exchanger, int nComponents)
+{
+	PiercedVector<Cell> &cells = patch->getCells();
+
+	// Initialize the field, ghost values are invalid
+	std::vector<double> field(evalFieldSize(patch) * nComponents, -1.);
+	for (const Cell &cell : cells) {
+		if (!cell.isInterior()) {
+			continue;
+		}
+
+		std::size_t position = cells.rawIndex(cell.getId());
+		for (int k = 0; k < nComponents; ++k) {
+			field[position * nComponents + k] = evalReferenceValue(patch, cell.getId(), k);
+		}
+	}
+
+	// Exchange the ghosts, updating the internal cells in the meantime
+	exchanger.startExchange(field, nComponents);
+
+	for (const Cell &cell : cells) {
+		if (!cell.isInterior()) {
+			continue;
+		}
+
+		std::size_t position = cells.rawIndex(cell.getId());
+		for (int k = 0; k < nComponents; ++k) {
+			field[position * nComponents + k] *= 2.;
+		}
+	}
+
+	exchanger.waitExchange(field, nComponents);
+
+	// Check the ghosts
+	long nGhosts = 0;
+	for (const Cell &cell : cells) {
+		if (cell.isInterior()) {
+			continue;
+		}
+
+		std::size_t position = cells.rawIndex(cell.getId());
+		for (int k = 0; k < nComponents; ++k) {
+			double expected = evalReferenceValue(patch, cell.getId(), k);
+			if (std::abs(field[position * nComponents + k] - expected) > 1e-10) {
+				log::cout() << "  Wrong value for ghost " << cell.getId() << std::endl;
+				return 1;
+			}
+		}
+
+		++nGhosts;
+	}
+
+	log::cout() << "  Exchanged " << nComponents << " component(s) of " << nGhosts << " ghosts" << std::endl;
+
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
+
+	MPI_Init(&argc,&argv);
+
+	int nProcs;
+	int	rank;
+	MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+	log::manager().initialize(log::COMBINED, true, nProcs, rank);
+	log::cout().setVisibility(log::GLOBAL);
+	log::cout() << "Testing hierarchical ghost exchange" << "\n";
+
+	// Node communicators, groups of processes emulate nodes with
+	// different sizes
+	MPI_Comm pairCommunicator;
+	MPI_Comm_split(MPI_COMM_WORLD, rank / 2, rank, &pairCommunicator);
+
+	std::vector<MPI_Comm> nodeCommunicators = {MPI_COMM_NULL, pairCommunicator, MPI_COMM_SELF};
+	std::vector<std::string> nodeNames = {"shared-memory nodes", "nodes of two processes", "nodes of one process"};
+
+	std::array<double, 3> origin = {0., 0., 0.};
+	double length = 20;
+
+	int status = 0;
+	for (int dimension = 2; dimension <= 3; ++dimension) {
+		log::cout() << "  >> " << dimension << "D octree patch" << "\n";
+
+		double dh = (dimension == 2) ? 1. : 2.5;
+
+		// Create the patch
+		VolOctree *patch = new VolOctree(0, dimension, origin, length, dh);
+		patch->setCommunicator(MPI_COMM_WORLD);
+		patch->update();
+
+		// Partition the patch
+		patch->partition(true);
+
+		// Exchange scalar and vector fields
+		GhostExchanger exchanger(*patch);
+		for (std::size_t n = 0; n < nodeCommunicators.size(); ++n) {
+			log::cout() << "  Grouping processes in " << nodeNames[n] << std::endl;
+
+			exchanger.setHierarchical(true, nodeCommunicators[n]);
+			status = std::max(status, checkExchange(patch, exchanger, 1));
+			status = std::max(status, checkExchange(patch, exchanger, 3));
+			status = std::max(status, checkExchange(patch, exchanger, 1));
+		}
+
+		// Refine the patch, the exchanger is rebuilt automatically
+		for (const Cell &cell : patch->getCells()) {
+			if (cell.isInterior() && patch->evalCellCentroid(cell.getId())[0] < 0.5 * length) {
+				patch->markCellForRefinement(cell.getId());
+			}
+		}
+		patch->update();
+
+		status = std::max(status, checkExchange(patch, exchanger, 1));
+		status = std::max(status, checkExchange(patch, exchanger, 3));
+
+		// Switch back to the direct communications
+		log::cout() << "  Disabling hierarchical communications" << std::endl;
+
+		exchanger.setHierarchical(false);
+		status = std::max(status, checkExchange(patch, exchanger, 1));
+
+		delete patch;
+	}
+
+	MPI_Comm_free(&pairCommunicator);
+
+	int globalStatus;
+	MPI_Allreduce(&status, &globalStatus, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+
+	MPI_Finalize();
+
+	return globalStatus;
+}
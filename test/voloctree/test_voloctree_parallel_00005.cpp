@@ -0,0 +1,230 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2016 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitbit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "bitpit_common.hpp"
+#include "bitpit_voloctree.hpp"
+
+using namespace bitpit;
+
+/*!
+ * Evaluates the size of a field that contains the values of all the cells
+ */
+std::size_t evalFieldSize(VolOctree *patch)
+{
+	std::size_t size = 0;
+	for (const Cell &cell : patch->getCells()) {
+		size = std::max(size, patch->getCells().rawIndex(cell.getId()) + 1);
+	}
+
+	return size;
+}
+
+/*!
+ * Checks the halo of the patch.
+ *
+ * Every ghost should be within the requested number of layers of vertex
+ * neighbours around the internal cells. The ghosts of the inner layers
+ * should have all their neighbours: the number of neighbours evaluated
+ * on the owner is exchanged, together with the centroid, and compared
+ * with the number of neighbours the ghost has on this processor.
+ */
+int checkHalo(VolOctree *patch, std::size_t haloSize)
+{
+	PiercedVector<Cell> &cells = patch->getCells();
+
+	// Layer of the ghosts
+	std::unordered_map<long, std::size_t> layers;
+	std::vector<long> layerCells;
+	for (const Cell &cell : cells) {
+		if (cell.isInterior()) {
+			layers[cell.getId()] = 0;
+			layerCells.push_back(cell.getId());
+		}
+	}
+
+	std::vector<long> nextLayerCells;
+	for (std::size_t layer = 1; !layerCells.empty(); ++layer) {
+		nextLayerCells.clear();
+		for (long cellId : layerCells) {
+			for (long neighId : patch->findCellNeighs(cellId)) {
+				if (layers.count(neighId) == 0) {
+					layers[neighId] = layer;
+					nextLayerCells.push_back(neighId);
+				}
+			}
+		}
+		layerCells.swap(nextLayerCells);
+	}
+
+	if ((long) layers.size() != patch->getCellCount()) {
+		log::cout() << "  Some ghosts are not connected to the internal cells" << std::endl;
+		return 1;
+	}
+
+	// Exchange centroids and number of neighbours
+	const int N_COMPONENTS = 4;
+
+	std::vector<double> field(evalFieldSize(patch) * N_COMPONENTS, -1.);
+	for (const Cell &cell : cells) {
+		if (!cell.isInterior()) {
+			continue;
+		}
+
+		std::size_t position = cells.rawIndex(cell.getId());
+		std::array<double, 3> centroid = patch->evalCellCentroid(cell.getId());
+		for (int k = 0; k < 3; ++k) {
+			field[position * N_COMPONENTS + k] = centroid[k];
+		}
+		field[position * N_COMPONENTS + 3] = patch->findCellNeighs(cell.getId()).size();
+	}
+
+	GhostExchanger exchanger(*patch);
+	exchanger.startExchange(field, N_COMPONENTS);
+	exchanger.waitExchange(field, N_COMPONENTS);
+
+	// Check the ghosts
+	std::vector<long> nLayerGhosts(haloSize + 1, 0);
+	for (const Cell &cell : cells) {
+		if (cell.isInterior()) {
+			continue;
+		}
+
+		long id = cell.getId();
+		std::size_t layer = layers[id];
+		if (layer > haloSize) {
+			log::cout() << "  Ghost " << id << " is in layer " << layer << std::endl;
+			return 1;
+		}
+		++nLayerGhosts[layer];
+
+		std::size_t position = cells.rawIndex(id);
+		std::array<double, 3> centroid = patch->evalCellCentroid(id);
+		for (int k = 0; k < 3; ++k) {
+			if (std::abs(field[position * N_COMPONENTS + k] - centroid[k]) > 1e-10) {
+				log::cout() << "  Wrong centroid received by ghost " << id << std::endl;
+				return 1;
+			}
+		}
+
+		if (layer < haloSize) {
+			if (field[position * N_COMPONENTS + 3] != patch->findCellNeighs(id).size()) {
+				log::cout() << "  Ghost " << id << " of layer " << layer << " misses some neighbours" << std::endl;
+				return 1;
+			}
+		}
+	}
+
+	for (std::size_t layer = 1; layer <= haloSize; ++layer) {
+		log::cout() << "  Layer " << layer << " contains " << nLayerGhosts[layer] << " ghosts" << std::endl;
+	}
+
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
+
+	MPI_Init(&argc,&argv);
+
+	int nProcs;
+	int	rank;
+	MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+	log::manager().initialize(log::COMBINED, true, nProcs, rank);
+	log::cout().setVisibility(log::GLOBAL);
+	log::cout() << "Testing halos with multiple layers of ghosts" << "\n";
+
+	std::array<double, 3> origin = {0., 0., 0.};
+	double length = 20;
+
+	int status = 0;
+	for (int dimension = 2; dimension <= 3; ++dimension) {
+		log::cout() << "  >> " << dimension << "D octree patch" << "\n";
+
+		double dh = (dimension == 2) ? 1. : 2.5;
+
+		// Create the patch, the halo is set before partitioning
+		VolOctree *patch = new VolOctree(0, dimension, origin, length, dh);
+		patch->setCommunicator(MPI_COMM_WORLD);
+		patch->setHaloSize(2);
+		patch->update();
+
+		// Partition the patch
+		patch->partition(true);
+
+		status = std::max(status, checkHalo(patch, 2));
+
+		// Change the halo of a partitioned patch
+		patch->setHaloSize(1);
+		status = std::max(status, checkHalo(patch, 1));
+		long nFirstLayerGhosts = patch->getGhostCount();
+
+		patch->setHaloSize(3);
+		status = std::max(status, checkHalo(patch, 3));
+		if (patch->getGhostCount() <= nFirstLayerGhosts) {
+			log::cout() << "  The halo has not been enlarged" << std::endl;
+			status = 1;
+		}
+
+		// Face halos are not supported
+		try {
+			patch->setHaloSize(2, PatchKernel::HALO_FACE);
+			log::cout() << "  Face halos should not be supported" << std::endl;
+			status = 1;
+		} catch (const std::runtime_error &exception) {
+			if (patch->getHaloSize() != 3 || patch->getHaloConnectivity() != PatchKernel::HALO_VERTEX) {
+				log::cout() << "  The halo has been changed by an unsupported request" << std::endl;
+				status = 1;
+			}
+		}
+
+		// Refine the patch and balance the partition
+		for (const Cell &cell : patch->getCells()) {
+			if (cell.isInterior() && patch->evalCellCentroid(cell.getId())[0] < 0.5 * length) {
+				patch->markCellForRefinement(cell.getId());
+			}
+		}
+		patch->update();
+
+		status = std::max(status, checkHalo(patch, 3));
+
+		patch->partition(true);
+
+		status = std::max(status, checkHalo(patch, 3));
+
+		delete patch;
+	}
+
+	int globalStatus;
+	MPI_Allreduce(&status, &globalStatus, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+
+	MPI_Finalize();
+
+	return globalStatus;
+}